@@ -31,6 +31,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <signal.h>
+#include <sys/mman.h>
 #if defined (__linux__)
 #define SEND_FLAGS MSG_NOSIGNAL
 #else
@@ -47,17 +48,30 @@ static const int BRAIN_SERVER_ATTACKS_MAX         = 64 * 1024;
 static const int BRAIN_SERVER_CLIENTS_MAX         = 256;
 static const int BRAIN_SERVER_REALLOC_HASH_SIZE   = 1024 * 1024;
 static const int BRAIN_SERVER_REALLOC_ATTACK_SIZE = 1024;
+static const int BRAIN_SERVER_JOURNAL_RATIO       = 4; // compact once the journal holds 1/4 of the long-term entries
+static const int BRAIN_SERVER_HASH_SHARDS_BITS    = 8;
+static const int BRAIN_SERVER_HASH_SHARDS         = 1 << 8;
 static const int BRAIN_HASH_SIZE                  = 2 * sizeof (u32);
-static const int BRAIN_LINK_VERSION_CUR           = 1;
+static const int BRAIN_LINK_VERSION_CUR           = 3;
 static const int BRAIN_LINK_VERSION_MIN           = 1;
+static const int BRAIN_LINK_VERSION_PIPELINE      = 2; // servers which know BRAIN_OPERATION_SEAL
+static const int BRAIN_LINK_VERSION_PACKED        = 3; // servers which know BRAIN_OPERATION_HASH_LOOKUP_PACKED
+static const int BRAIN_LINK_PIPELINE_DEPTH        = 2; // sealed batches a client may have waiting for their commit
 static const int BRAIN_LINK_CHUNK_SIZE            = 4 * 1024;
 static const int BRAIN_LINK_CANDIDATES_MAX        = 128 * 1024 * 256; // units * threads * accel
+static const int BRAIN_CLIENT_JOBS                = 16;
+static const int BRAIN_CLIENT_FILTER_BITS         = 28;      // 32 MiB per device
+static const int BRAIN_CLIENT_FILTER_PROBES       = 6;
+static const int BRAIN_CLIENT_FILTER_ENTRIES      = 1 << 23; // cleared once full, keeps false positives below 1 in 30000
+static const int BRAIN_PACK_HEADER_SIZE           = sizeof (u32) + sizeof (u8);
 
 typedef enum brain_operation
 {
-  BRAIN_OPERATION_COMMIT         = 1,
-  BRAIN_OPERATION_HASH_LOOKUP    = 2,
-  BRAIN_OPERATION_ATTACK_RESERVE = 3,
+  BRAIN_OPERATION_COMMIT             = 1,
+  BRAIN_OPERATION_HASH_LOOKUP        = 2,
+  BRAIN_OPERATION_ATTACK_RESERVE     = 3,
+  BRAIN_OPERATION_SEAL               = 4,
+  BRAIN_OPERATION_HASH_LOOKUP_PACKED = 5,
 
 } brain_operation_t;
 
@@ -65,6 +79,7 @@ typedef enum brain_client_feature
 {
   BRAIN_CLIENT_FEATURE_HASHES    = 1,
   BRAIN_CLIENT_FEATURE_ATTACKS   = 2,
+  BRAIN_CLIENT_FEATURE_FILTER    = 4,
 
 } brain_client_feature_t;
 
@@ -82,6 +97,8 @@ typedef struct brain_server_attack_short
 
   int client_idx;
 
+  u32 batch;
+
 } brain_server_attack_short_t;
 
 typedef struct brain_server_hash_long
@@ -104,6 +121,17 @@ typedef struct brain_server_hash_unique
 
 } brain_server_hash_unique_t;
 
+typedef struct brain_bits
+{
+  u8     *buf;
+  size_t  size;
+  size_t  len;
+
+  u64     acc;
+  int     acc_bits;
+
+} brain_bits_t;
+
 typedef struct brain_server_db_attack
 {
   u32 brain_attack;
@@ -120,6 +148,14 @@ typedef struct brain_server_db_attack
 
   int ab;
 
+  brain_server_attack_long_t *journal_buf;
+
+  i64 journal_alloc;
+  i64 journal_cnt;
+  i64 journal_file_cnt;
+
+  bool journal_compact;
+
   hc_thread_mutex_t mux_ar;
   hc_thread_mutex_t mux_ag;
 
@@ -127,20 +163,45 @@ typedef struct brain_server_db_attack
 
 } brain_server_db_attack_t;
 
-typedef struct brain_server_db_hash
+typedef struct brain_server_db_hash_shard
 {
-  u32 brain_session;
-
   brain_server_hash_long_t *long_buf;
 
   i64 long_alloc;
   i64 long_cnt;
 
+  bool long_mapped; // long_buf points into the mapped dump until the first change
+
   int hb;
 
   hc_thread_mutex_t mux_hr;
   hc_thread_mutex_t mux_hg;
 
+} brain_server_db_hash_shard_t;
+
+typedef struct brain_server_db_hash
+{
+  u32 brain_session;
+
+  // the long-term memory is split by the highest hash bits, see brain_server_hash_shard ()
+
+  brain_server_db_hash_shard_t *shards;
+
+  i64 long_cnt;
+
+  void  *map_buf;
+  size_t map_len;
+
+  brain_server_hash_long_t *journal_buf;
+
+  i64 journal_alloc;
+  i64 journal_cnt;
+  i64 journal_file_cnt;
+
+  bool journal_compact;
+
+  hc_thread_mutex_t mux_hj; // long_cnt, journal and write_hashes
+
   bool write_hashes;
 
 } brain_server_db_hash_t;
@@ -167,6 +228,10 @@ typedef struct brain_server_dbs
 
   int *client_slots;
 
+  // new long-term entries are kept for the journal, not needed without a cyclic dump
+
+  bool journal;
+
 } brain_server_dbs_t;
 
 typedef struct brain_server_dumper_options
@@ -209,9 +274,25 @@ bool  brain_send_all                    (int sockfd, void *buf, size_t len, int
 bool  brain_client_reserve              (hc_device_param_t *device_param, const status_ctx_t *status_ctx, u64 words_off, u64 work, u64 *overlap);
 bool  brain_client_commit               (hc_device_param_t *device_param, const status_ctx_t *status_ctx);
 bool  brain_client_lookup               (hc_device_param_t *device_param, const status_ctx_t *status_ctx);
+bool  brain_client_lookup_hashes        (hc_device_param_t *device_param, const status_ctx_t *status_ctx, u32 *out_buf, u8 *in_buf, const u64 cnt);
+bool  brain_client_operation            (hc_device_param_t *device_param, const status_ctx_t *status_ctx, u8 operation);
 bool  brain_client_connect              (hc_device_param_t *device_param, const status_ctx_t *status_ctx, const char *host, const int port, const char *password, u32 brain_session, u32 brain_attack, i64 passwords_max, u64 *highest);
 void  brain_client_disconnect           (hc_device_param_t *device_param);
 void  brain_client_generate_hash        (u64 *hash, const char *line_buf, const size_t line_len);
+bool  brain_client_filter               (hc_device_param_t *device_param, const u64 hash);
+void  brain_client_filter_add           (hc_device_param_t *device_param, const u64 *hashes, const u64 cnt);
+void  brain_client_filter_reset         (hc_device_param_t *device_param);
+u64   brain_client_filter_collect       (u64 *commit_buf, const u32 *out_buf, const u8 *in_buf, const u64 cnt);
+int   brain_client_sort_hash            (const void *v1, const void *v2);
+size_t brain_pack_hashes                (u8 *buf, const size_t buf_size, const brain_link_hash_t *hashes, const u32 cnt);
+u32   brain_unpack_hashes               (brain_server_hash_unique_t *hashes, const u32 hashes_max, const u8 *buf, const size_t buf_size);
+void  brain_client_start                (hc_device_param_t *device_param, status_ctx_t *status_ctx);
+void  brain_client_stop                 (hc_device_param_t *device_param);
+u64   brain_client_post                 (hc_device_param_t *device_param, const brain_link_job_t *job);
+void  brain_client_wait                 (hc_device_param_t *device_param, const u64 ticket);
+void  brain_client_sync                 (hc_device_param_t *device_param);
+HC_API_CALL
+void *brain_client_thread               (void *p);
 
 int   brain_server                      (const char *listen_host, const int listen_port, const char *brain_password, const char *brain_session_whitelist, const u32 brain_server_timer);
 bool  brain_server_read_hash_dumps      (brain_server_dbs_t *brain_server_dbs, const char *path);
@@ -222,6 +303,11 @@ bool  brain_server_read_attack_dumps    (brain_server_dbs_t *brain_server_dbs, c
 bool  brain_server_write_attack_dumps   (brain_server_dbs_t *brain_server_dbs, const char *path);
 bool  brain_server_read_attack_dump     (brain_server_db_attack_t *brain_server_db_attack, const char *file);
 bool  brain_server_write_attack_dump    (brain_server_db_attack_t *brain_server_db_attack, const char *file);
+bool  brain_server_read_hash_journal    (brain_server_db_hash_t *brain_server_db_hash, const char *file);
+bool  brain_server_write_hash_journal   (brain_server_db_hash_t *brain_server_db_hash, const char *file);
+bool  brain_server_read_attack_journal  (brain_server_db_attack_t *brain_server_db_attack, const char *file);
+bool  brain_server_write_attack_journal (brain_server_db_attack_t *brain_server_db_attack, const char *file);
+void  brain_server_journal_file         (char *journal_file, const size_t journal_size, const char *dump_file);
 int   brain_server_get_client_idx       (brain_server_dbs_t *brain_server_dbs);
 
 u64   brain_server_highest_attack       (const brain_server_db_attack_t *buf);
@@ -229,6 +315,7 @@ u64   brain_server_highest_attack_long  (const brain_server_attack_long_t  *buf,
 u64   brain_server_highest_attack_short (const brain_server_attack_short_t *buf, const i64 cnt, const u64 start);
 u64   brain_server_find_attack_long     (const brain_server_attack_long_t  *buf, const i64 cnt, const u64 offset, const u64 length);
 u64   brain_server_find_attack_short    (const brain_server_attack_short_t *buf, const i64 cnt, const u64 offset, const u64 length);
+u64   brain_server_find_attack          (const brain_server_db_attack_t *buf, const u64 offset, const u64 length);
 i64   brain_server_find_hash_long       (const u32 *search, const brain_server_hash_long_t  *buf, const i64 cnt);
 i64   brain_server_find_hash_short      (const u32 *search, const brain_server_hash_short_t *buf, const i64 cnt);
 int   brain_server_sort_db_hash         (const void *v1, const void *v2);
@@ -245,10 +332,22 @@ void *brain_server_handle_client        (void *p);
 HC_API_CALL
 void *brain_server_handle_dumps         (void *p);
 void  brain_server_db_hash_init         (brain_server_db_hash_t *brain_server_db_hash, const u32 brain_session);
-bool  brain_server_db_hash_realloc      (brain_server_db_hash_t *brain_server_db_hash, const i64 new_long_cnt);
+u32   brain_server_hash_shard           (const u32 *hash);
+bool  brain_server_db_hash_shard_realloc (brain_server_db_hash_shard_t *brain_server_db_hash_shard, const i64 new_long_cnt);
+i64   brain_server_db_hash_shard_merge  (brain_server_db_hash_shard_t *brain_server_db_hash_shard, const brain_server_hash_long_t *new_buf, const i64 new_cnt, brain_server_hash_long_t *added_buf);
+void  brain_server_db_hash_shard_lock_read (brain_server_db_hash_shard_t *brain_server_db_hash_shard);
+void  brain_server_db_hash_shard_unlock_read (brain_server_db_hash_shard_t *brain_server_db_hash_shard);
+i64   brain_server_db_hash_merge        (brain_server_db_hash_t *brain_server_db_hash, const brain_server_hash_long_t *new_buf, const i64 new_cnt, brain_server_hash_long_t *added_buf);
+void  brain_server_db_hash_journal      (brain_server_db_hash_t *brain_server_db_hash, const brain_server_hash_long_t *added_buf, const i64 added_cnt, const bool journal);
 void  brain_server_db_hash_free         (brain_server_db_hash_t *brain_server_db_hash);
 void  brain_server_db_attack_init       (brain_server_db_attack_t *brain_server_db_attack, const u32 brain_attack);
 bool  brain_server_db_attack_realloc    (brain_server_db_attack_t *brain_server_db_attack, const i64 new_long_cnt, const i64 new_short_cnt);
+void  brain_server_db_attack_journal    (brain_server_db_attack_t *brain_server_db_attack, const brain_server_attack_long_t *entry);
+bool  brain_server_db_attack_reserve    (brain_server_db_attack_t *brain_server_db_attack, const u64 offset, const u64 length, const int client_idx, const u32 batch);
+bool  brain_server_db_attack_insert     (brain_server_db_attack_t *brain_server_db_attack, const u64 offset, const u64 length);
+void  brain_server_db_attack_coalesce   (brain_server_db_attack_t *brain_server_db_attack);
+i64   brain_server_db_attack_commit     (brain_server_db_attack_t *brain_server_db_attack, const int client_idx, const u32 batch, const bool journal);
+void  brain_server_db_attack_release    (brain_server_db_attack_t *brain_server_db_attack, const int client_idx);
 void  brain_server_db_attack_free       (brain_server_db_attack_t *brain_server_db_attack);
 
 int   brain_ctx_init                    (hashcat_ctx_t *hashcat_ctx);
@@ -9,7 +9,15 @@
 #include <stdio.h>
 #include <errno.h>
 
+// lists larger than this are read from disk for every window instead of being cached
+
+#define COMBINATOR_CACHE_MAX (256 * 1024 * 1024)
+
 int  combinator_ctx_init    (hashcat_ctx_t *hashcat_ctx);
 void combinator_ctx_destroy (hashcat_ctx_t *hashcat_ctx);
 
+int  combinator_line          (hashcat_ctx_t *hashcat_ctx, char *line_buf, size_t line_len, const bool iconv_enabled, iconv_t iconv_ctx, char *iconv_tmp, char *rule_buf_out, char **out_buf);
+int  combinator_cache_init    (hashcat_ctx_t *hashcat_ctx);
+void combinator_cache_destroy (hashcat_ctx_t *hashcat_ctx);
+
 #endif // HC_COMBINATOR_H
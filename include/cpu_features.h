@@ -19,6 +19,8 @@ int cpu_supports_ssse3 ();
 int cpu_supports_xop ();
 int cpu_supports_avx2 ();
 int cpu_supports_avx512f ();
+int cpu_supports_avx512vl ();
+int cpu_supports_avx512bw ();
 int cpu_chipset_test ();
 
 #endif // HC_CPU_FEATURES_H
@@ -13,12 +13,22 @@
 #include <sys/stat.h>
 
 #include <errno.h>
-#include <search.h>
 
-#define MAX_DICTSTAT 100000
+// above MAX_DICTSTAT entries the least recently used ones are dropped until DICTSTAT_EVICT_TO are left
+
+#define MAX_DICTSTAT        500000
+#define DICTSTAT_EVICT_TO   450000
+#define INCR_DICTSTAT       1024
+#define DICTSTAT_TOUCH_SECS 86400
 
 #define DICTSTAT_FILENAME "hashcat.dictstat2"
-#define DICTSTAT_VERSION  (0x6863646963743200 | 0x03)
+#define DICTSTAT_VERSION  (0x6863646963743200 | 0x04)
+
+#define DICTIDX_FOLDER    "dictidx"
+#define DICTIDX_VERSION   (0x6863646963696400 | 0x02)
+#define DICTIDX_STEP      65536
+
+#define GZIDX_VERSION     (0x6863677a69647800 | 0x01)
 
 int sort_by_dictstat (const void *s1, const void *s2);
 
@@ -29,4 +39,12 @@ int  dictstat_write   (hashcat_ctx_t *hashcat_ctx);
 u64  dictstat_find    (hashcat_ctx_t *hashcat_ctx, dictstat_t *d);
 void dictstat_append  (hashcat_ctx_t *hashcat_ctx, dictstat_t *d);
 
+bool dictstat_index_enabled (hashcat_ctx_t *hashcat_ctx);
+bool dictstat_index_exists  (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const u32 flags);
+int  dictstat_index_read    (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const u32 flags, dictidx_t **idx_buf, u64 *idx_cnt);
+int  dictstat_index_write   (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const u32 flags, const dictidx_t *idx_buf, const u64 idx_cnt);
+
+int  dictstat_gzidx_read    (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, gzidx_t *gzidx);
+int  dictstat_gzidx_write   (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const gzidx_t *gzidx);
+
 #endif // HC_DICTSTAT_H
@@ -34,6 +34,10 @@ char  *hc_fgets     (char *buf, int len, HCFILE *fp);
 size_t hc_fwrite    (const void *ptr, size_t size, size_t nmemb, HCFILE *fp);
 size_t hc_fread     (void *ptr, size_t size, size_t nmemb, HCFILE *fp);
 
+int    hc_gzidx_build  (gzidx_t *gzidx, const char *path);
+void   hc_gzidx_free   (gzidx_t *gzidx);
+bool   hc_gzidx_attach (HCFILE *fp, gzidx_t *gzidx);
+
 size_t fgetl        (HCFILE *fp, char *line_buf, const size_t line_sz);
 u64    count_lines  (HCFILE *fp);
 size_t in_superchop (char *buf);
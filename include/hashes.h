@@ -6,6 +6,10 @@
 #ifndef HC_HASHES_H
 #define HC_HASHES_H
 
+// plain hashfiles are parsed in parallel, in newline-aligned ranges of at least this many bytes
+
+#define HASHES_RANGE_MIN (1024 * 1024)
+
 int sort_by_digest_p0p1  (const void *v1, const void *v2, void *v3);
 int sort_by_salt         (const void *v1, const void *v2);
 int sort_by_hash         (const void *v1, const void *v2, void *v3);
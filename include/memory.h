@@ -18,6 +18,13 @@ void *hcrealloc (void *ptr, const size_t oldsz, const size_t addsz);
 char *hcstrdup  (const char *s);
 void  hcfree    (void *ptr);
 
+#define HCARENA_BLOCK_SIZE (1024 * 1024)
+
+void *hcarena_alloc  (hcarena_t *arena, const size_t sz);
+char *hcarena_strdup (hcarena_t *arena, const char *s);
+void  hcarena_merge  (hcarena_t *dst, hcarena_t *src);
+void  hcarena_free   (hcarena_t *arena);
+
 void *hcmalloc_aligned (const size_t sz, const int align);
 void  hcfree_aligned   (void *ptr);
 
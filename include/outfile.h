@@ -21,5 +21,6 @@ void outfile_destroy        (hashcat_ctx_t *hashcat_ctx);
 int  outfile_write_open     (hashcat_ctx_t *hashcat_ctx);
 void outfile_write_close    (hashcat_ctx_t *hashcat_ctx);
 int  outfile_write          (hashcat_ctx_t *hashcat_ctx, const char *out_buf, const int out_len, const unsigned char *plain_ptr, const u32 plain_len, const u64 crackpos, const unsigned char *username, const u32 user_len, const bool print_eol, char *tmp_buf);
+int  outfile_write_batch    (hashcat_ctx_t *hashcat_ctx, const u8 *buf, const size_t len);
 
 #endif // HC_OUTFILE_H
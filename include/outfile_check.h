@@ -9,6 +9,12 @@
 #include <unistd.h>
 #include <errno.h>
 
+#if defined (__linux__)
+#define OUTCHECK_INOTIFY
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
 #define OUTFILES_DIR "outfiles"
 
 HC_API_CALL void *thread_outfile_remove (void *p);
@@ -13,12 +13,21 @@
 
 #define INCR_POT 1000
 
+#define POTIDX_VERSION    (0x6863706f74696400 | 0x01)
+#define POTIDX_KEY_NONE   0
+#define POTIDX_CHUNK      65536
+
+// the unsorted tail of an index is merged into the sorted part once it grows beyond this
+
+#define POTIDX_TAIL_MAX(sorted_cnt) MAX ((u64) POTIDX_CHUNK, (sorted_cnt) / 8)
+
 int  potfile_init             (hashcat_ctx_t *hashcat_ctx);
 int  potfile_read_open        (hashcat_ctx_t *hashcat_ctx);
 void potfile_read_close       (hashcat_ctx_t *hashcat_ctx);
 int  potfile_write_open       (hashcat_ctx_t *hashcat_ctx);
 void potfile_write_close      (hashcat_ctx_t *hashcat_ctx);
 void potfile_write_append     (hashcat_ctx_t *hashcat_ctx, const char *out_buf, const int out_len, u8 *plain_ptr, unsigned int plain_len);
+int  potfile_write_batch      (hashcat_ctx_t *hashcat_ctx, const u8 *buf, const size_t len, const writer_line_t *lines_buf, const u32 lines_cnt);
 int  potfile_remove_parse     (hashcat_ctx_t *hashcat_ctx);
 void potfile_destroy          (hashcat_ctx_t *hashcat_ctx);
 int  potfile_handle_show      (hashcat_ctx_t *hashcat_ctx);
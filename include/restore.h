@@ -15,8 +15,11 @@
 #include <psapi.h>
 #endif // _WIN
 
-#define RESTORE_VERSION_MIN 600
-#define RESTORE_VERSION_CUR 611
+#define RESTORE_VERSION_MIN     600
+#define RESTORE_VERSION_CUR     612
+#define RESTORE_VERSION_RANGES  612 // completed ranges follow the arguments
+
+#define RESTORE_RANGES_MAX      (1024 * 1024)
 
 int cycle_restore (hashcat_ctx_t *hashcat_ctx);
 
@@ -26,4 +29,8 @@ int restore_ctx_init (hashcat_ctx_t *hashcat_ctx, int argc, char **argv);
 
 void restore_ctx_destroy (hashcat_ctx_t *hashcat_ctx);
 
+void restore_ranges_add   (hashcat_ctx_t *hashcat_ctx, const u64 off, const u64 fin);
+void restore_ranges_skip  (hashcat_ctx_t *hashcat_ctx, const u64 words_base, u64 *words_off, u64 *words_next, u64 *words_skip);
+void restore_ranges_reset (hashcat_ctx_t *hashcat_ctx);
+
 #endif // HC_RESTORE_H
@@ -11,6 +11,10 @@
 #define RULE_RC_SYNTAX_ERROR -1
 #define RULE_RC_REJECT_ERROR -2
 
+int  rp_cpu_compile (const char *rule, const int rule_len, rp_cpu_rule_t *rp_cpu_rule);
+void rp_cpu_destroy (rp_cpu_rule_t *rp_cpu_rule);
+int  rp_cpu_apply   (const rp_cpu_rule_t *rp_cpu_rule, char in[RP_PASSWORD_SIZE], int in_len, char out[RP_PASSWORD_SIZE]);
+
 int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE], int in_len, char out[RP_PASSWORD_SIZE]);
 
 int run_rule_engine (const int rule_len, const char *rule_buf);
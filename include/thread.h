@@ -39,6 +39,11 @@
 #define hc_thread_sem_wait(s)       WaitForSingleObject (s, INFINITE)
 #define hc_thread_sem_close(s)      CloseHandle         (s)
 
+#define hc_thread_cond_init(c)      InitializeConditionVariable (&c)
+#define hc_thread_cond_wait(c,m)    SleepConditionVariableCS    (&c, &m, INFINITE)
+#define hc_thread_cond_wake(c)      WakeAllConditionVariable    (&c)
+#define hc_thread_cond_delete(c)
+
 #else
 
 #define hc_thread_create(t,f,a)     pthread_create (&t, NULL, f, a)
@@ -56,8 +61,17 @@
 #define hc_thread_sem_wait(s)       sem_wait  (&s)
 #define hc_thread_sem_close(s)      sem_close (&s)
 
+#define hc_thread_cond_init(c)      pthread_cond_init      (&c, NULL)
+#define hc_thread_cond_wait(c,m)    pthread_cond_wait      (&c, &m)
+#define hc_thread_cond_wake(c)      pthread_cond_broadcast (&c)
+#define hc_thread_cond_delete(c)    pthread_cond_destroy   (&c)
+
 #endif
 
+// like hc_thread_cond_wait () with mux held, but gives up after msec milliseconds
+
+void hc_thread_cond_timedwait (hc_thread_cond_t *cond, hc_thread_mutex_t *mux, const u32 msec);
+
 /*
 #if defined (_WIN)
 
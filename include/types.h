@@ -77,13 +77,15 @@ typedef struct timespec   hc_timer_t;
 #endif
 
 #if defined (_WIN)
-typedef HANDLE           hc_thread_t;
-typedef CRITICAL_SECTION hc_thread_mutex_t;
-typedef HANDLE           hc_thread_semaphore_t;
+typedef HANDLE             hc_thread_t;
+typedef CRITICAL_SECTION   hc_thread_mutex_t;
+typedef HANDLE             hc_thread_semaphore_t;
+typedef CONDITION_VARIABLE hc_thread_cond_t;
 #else
-typedef pthread_t        hc_thread_t;
-typedef pthread_mutex_t  hc_thread_mutex_t;
-typedef sem_t            hc_thread_semaphore_t;
+typedef pthread_t          hc_thread_t;
+typedef pthread_mutex_t    hc_thread_mutex_t;
+typedef sem_t              hc_thread_semaphore_t;
+typedef pthread_cond_t     hc_thread_cond_t;
 #endif
 
 // enums
@@ -480,6 +482,7 @@ typedef enum opts_type
   OPTS_TYPE_STOCK_MODULE      = (1ULL << 60), // module included with hashcat default distribution
   OPTS_TYPE_MULTIHASH_DESPITE_ESALT
                               = (1ULL << 61), // overrule multihash cracking check same salt but not same esalt
+  OPTS_TYPE_HASH_DECODE_MT    = (1ULL << 62), // module_hash_decode () is reentrant, big hashfiles get parsed by several threads
 
 } opts_type_t;
 
@@ -677,6 +680,8 @@ typedef enum user_options_defaults
   BENCHMARK                = false,
   BITMAP_MAX               = 18,
   BITMAP_MIN               = 16,
+  CRACKED_FLUSH_LINES      = 1000,
+  CRACKED_FLUSH_TIMER      = 100,
   #ifdef WITH_BRAIN
   BRAIN_CLIENT             = false,
   BRAIN_CLIENT_FEATURES    = 2,
@@ -736,6 +741,7 @@ typedef enum user_options_defaults
   OUTFILE_FORMAT           = 3,
   OUTFILE_JSON             = false,
   POTFILE                  = true,
+  POTFILE_INDEX            = false,
   PROGRESS_ONLY            = false,
   QUIET                    = false,
   REMOVE                   = false,
@@ -807,6 +813,8 @@ typedef enum user_options_map
   IDX_BRIDGE_PARAMETER3         = 0xff82,
   IDX_BRIDGE_PARAMETER4         = 0xff83,
   IDX_CPU_AFFINITY              = 0xff11,
+  IDX_CRACKED_FLUSH_LINES       = 0xff59,
+  IDX_CRACKED_FLUSH_TIMER       = 0xff5a,
   IDX_CUSTOM_CHARSET_1          = '1',
   IDX_CUSTOM_CHARSET_2          = '2',
   IDX_CUSTOM_CHARSET_3          = '3',
@@ -861,6 +869,7 @@ typedef enum user_options_map
   IDX_OUTFILE_JSON              = 0xff35,
   IDX_OUTFILE                   = 'o',
   IDX_POTFILE_DISABLE           = 0xff36,
+  IDX_POTFILE_INDEX             = 0xff58,
   IDX_POTFILE_PATH              = 0xff37,
   IDX_PROGRESS_ONLY             = 0xff38,
   IDX_QUIET                     = 0xff39,
@@ -945,6 +954,23 @@ typedef void * hc_dynfunc_t;
  * structs
  */
 
+typedef struct hcarena_block
+{
+  struct hcarena_block *next;
+
+  size_t size;
+  size_t used;
+
+} hcarena_block_t;
+
+typedef struct hcarena
+{
+  // bump allocator for many small objects which are all freed together
+
+  hcarena_block_t *head;
+
+} hcarena_t;
+
 typedef struct dynamicx
 {
   char *dynamicx_buf;
@@ -1005,8 +1031,9 @@ typedef struct hash
 typedef struct outfile_data
 {
   char      *file_name;
-  off_t      seek;
-  time_t     ctime;
+  off_t      seek;  // read position, in the decompressed data for compressed files
+  off_t      size;  // file size after the last complete read, -1 while a line without EOL waits
+  ino_t      inode;
 
 } outfile_data_t;
 
@@ -1053,6 +1080,8 @@ typedef struct hashes
 
   hashinfo_t **hash_info;
 
+  hcarena_t    arena; // backs all hash_info entries and the data they point to
+
   u8          *out_buf; // allocates [HCBUFSIZ_LARGE];
   u8          *tmp_buf; // allocates [HCBUFSIZ_LARGE];
 
@@ -1178,9 +1207,100 @@ typedef struct link_speed
 
 } link_speed_t;
 
+typedef struct pws_batch
+{
+  u32      *pws_comp;
+  pw_idx_t *pws_idx;
+  u64       pws_cnt;
+
+  u64       words_start; // first claim, the batch covers [words_start, words_fin)
+  u64       words_off;   // last claim
+  u64       words_fin;
+
+  bool      ready;  // filled by the producer and owned by the device thread until it hands it back
+
+} pws_batch_t;
+
+#ifdef WITH_BRAIN
+typedef struct brain_link_hash
+{
+  u64 hash;
+  u64 idx;    // position in the batch
+
+} brain_link_hash_t;
+
+typedef struct brain_link_job
+{
+  int   operation;  // BRAIN_OPERATION_*
+
+  u32  *out_buf;    // lookup
+  u8   *in_buf;
+  u64   cnt;
+
+  u64   words_off;  // reserve
+  u64   work;
+  u64  *overlap;
+
+  bool *ok;         // set by the link thread once the job is done, can be NULL
+
+} brain_link_job_t;
+
+typedef struct brain_link_batch
+{
+  pw_pre_t *pws_pre_buf;
+  u64       pws_pre_cnt;
+
+  u8       *in_buf;
+  u32      *out_buf;
+
+  u64      *commit_buf;     // with the filter, hashes the link thread adds to it once the commit is sent
+  u64       commit_ticket;  // commit job, 0 if nothing was committed
+
+  u64       words_fin;
+  u64       ticket;   // lookup job, 0 if nothing was looked up
+  u32       epoch;    // connection the batch was sealed on
+  bool      ok;
+  bool      pending;  // sealed and not yet run
+
+} brain_link_batch_t;
+
+typedef struct brain_link_reserve
+{
+  u64       words_off;
+  u64       work;
+  u64       overlap;
+
+  u64       ticket;
+  u32       epoch;
+  bool      ok;
+  bool      pending;
+
+} brain_link_reserve_t;
+#endif
+
 // file handling
 
 typedef struct xzfile xzfile_t;
+typedef struct gzran  gzran_t;
+
+#define GZIDX_WINSIZE 32768
+
+typedef struct gzidx_point
+{
+  u64 in;   // offset in the compressed file
+  u64 out;  // offset in the decompressed stream
+  u32 bits; // number of bits of the byte at in - 1 which already belong to the deflate block
+
+  u8  window[GZIDX_WINSIZE];
+
+} gzidx_point_t;
+
+typedef struct gzidx
+{
+  gzidx_point_t *points;
+  u64            cnt;
+
+} gzidx_t;
 
 typedef struct hc_fp
 {
@@ -1191,6 +1311,9 @@ typedef struct hc_fp
   unzFile     ufp; //   zip fp
   xzfile_t   *xfp; //    xz fp
 
+  gzidx_t    *gzidx; // gzip checkpoints, optional
+  gzran_t    *gzran; // gzip random access state, active after a seek through gzidx
+
   int         bom_size;
 
   const char *mode;
@@ -1412,6 +1535,31 @@ typedef struct hc_device_param
   u64           brain_link_send_bytes;
   u8           *brain_link_in_buf;
   u32          *brain_link_out_buf;
+
+  u32           brain_link_version;   // as answered by the server, pipelining needs BRAIN_LINK_VERSION_PIPELINE
+  u32           brain_link_epoch;     // counts the connects
+
+  // hashes of a lookup on their way to the server, and what this client sent so far
+
+  brain_link_hash_t    *brain_link_sort_buf;
+  u8                   *brain_link_wire_buf;
+  u64                  *brain_link_filter_buf;
+  u64                   brain_link_filter_cnt;
+
+  // pipelined client, see dispatch.c
+
+  bool                  brain_link_pipeline;
+  hc_thread_t           brain_link_thread;
+  hc_thread_mutex_t     brain_link_mux;
+  hc_thread_cond_t      brain_link_cond;      // signaled on every post, done job and on shutdown
+  brain_link_job_t     *brain_link_jobs;
+  u64                   brain_link_jobs_posted;
+  u64                   brain_link_jobs_done;
+  bool                  brain_link_shutdown;
+  struct status_ctx    *brain_link_status_ctx;
+  brain_link_batch_t    brain_link_batches[2];
+  int                   brain_link_batch_idx;
+  brain_link_reserve_t  brain_link_reserve;
   #endif
 
   char     *scratch_buf;
@@ -1425,6 +1573,13 @@ typedef struct hc_device_param
   u32      *pws_comp;
   u64       pws_cnt;
 
+  // double buffered candidates of the wordlist based attacks, see dispatch.c
+
+  pws_batch_t        pws_batches[2];
+  hc_thread_mutex_t  pws_batch_mux;
+  hc_thread_cond_t   pws_batch_cond;  // signaled when a batch gets ready or released and on stop
+  bool               pws_batch_stop;
+
   pw_pre_t *pws_pre_buf;  // for slow candidates
   u64       pws_pre_cnt;
 
@@ -2135,6 +2290,8 @@ typedef struct dictstat
 
   u8 hash_filename[16];
 
+  u64 last_used;
+
 } dictstat_t;
 
 typedef struct hashdump
@@ -2145,19 +2302,37 @@ typedef struct hashdump
 
 } hashdump_t;
 
+typedef struct dictidx
+{
+  u64 word_pos;                 // number of words returned by get_next_word () before this one
+  u64 byte_off;                 // offset of the line in the (uncompressed) wordlist
+
+} dictidx_t;
+
 typedef struct dictstat_ctx
 {
   bool enabled;
 
   char *filename;
+  char *index_folder;
 
   dictstat_t *base;
+  u64         cnt;
+  u64         avail;
 
-  #if defined (_WIN)
-  u32    cnt;
-  #else
-  size_t cnt;
-  #endif
+  // open addressing on hash_filename and encodings, a slot holds the base index + 1
+
+  u64        *table;
+  u64         table_size;
+
+  // new and touched entries, dictstat_write () appends them to the file
+
+  dictstat_t *append_buf;
+  u64         append_cnt;
+  u64         append_avail;
+
+  u64         disk_cnt;
+  bool        rewrite;
 
 } dictstat_ctx_t;
 
@@ -2190,8 +2365,64 @@ typedef struct outfile_ctx
 
   char   *filename;
 
+  bool    is_async; // cracked hashes are written by the writer thread
+
 } outfile_ctx_t;
 
+// cracked hash lines waiting for the writer thread, see writer.c
+
+typedef struct writer_line
+{
+  u32 line_len;   // including EOL
+  u32 hash_len;   // potfile only, length of the hash part for --potfile-index
+
+} writer_line_t;
+
+typedef struct writer_queue
+{
+  u8            *buf;
+  size_t         buf_len;
+  size_t         buf_size;
+
+  writer_line_t *lines_buf;
+  u32            lines_cnt;
+  u32            lines_avail;
+
+  hc_timer_t     timer_first; // set when the first line is queued
+
+} writer_queue_t;
+
+typedef struct writer_ctx
+{
+  bool              enabled;
+  bool              shutdown;
+
+  bool              potfile;
+  bool              outfile;
+
+  u32               flush_lines;
+  u32               flush_timer;
+
+  hc_thread_t       thread;
+  hc_thread_mutex_t mux;
+  hc_thread_cond_t  cond;         // signaled on due queues, written batches, flush requests and shutdown
+
+  u32               flush_posted; // writer_flush () requests
+  u32               flush_done;
+
+  bool              display_wait; // the writer thread waits for mux_display, appending must not block
+
+  writer_queue_t    pot_queue;    // filled by check_cracked ()
+  writer_queue_t    out_queue;
+
+  writer_queue_t    pot_flush;    // swapped in by the writer thread, written without holding mux
+  writer_queue_t    out_flush;
+
+  bool              error;        // the writer thread failed to write, writer_flush () and writer_stop () log error_buf
+  char              error_buf[HCBUFSIZ_TINY];
+
+} writer_ctx_t;
+
 typedef struct pot
 {
   char     plain_buf[HCBUFSIZ_SMALL];
@@ -2201,6 +2432,38 @@ typedef struct pot
 
 } pot_t;
 
+#define POTIDX_TAIL_LEN 64
+
+typedef struct potidx
+{
+  u64 key;  // see potfile_index_key (), POTIDX_KEY_NONE for lines which do not decode
+  u64 off;  // potfile line [off, end)
+  u64 end;
+
+} potidx_t;
+
+typedef struct potidx_hdr
+{
+  u64 version;
+  u32 hash_mode;
+  u32 separator;
+
+  u64 sorted_cnt;   // records sorted by key following the header, the rest of the file is an unsorted tail
+  u64 pot_size;     // potfile bytes covered by the sorted records
+
+  u8  pot_tail[POTIDX_TAIL_LEN]; // the bytes in front of pot_size, to notice a rewritten potfile
+
+} potidx_hdr_t;
+
+// hash position grouped by module_potfile_custom_bucket (), see potfile_remove_parse ()
+
+typedef struct pot_bucket
+{
+  u64 bucket;
+  u32 pos;
+
+} pot_bucket_t;
+
 typedef struct potfile_ctx
 {
   HCFILE   fp;
@@ -2212,6 +2475,18 @@ typedef struct potfile_ctx
   u8      *out_buf; // allocates [HCBUFSIZ_LARGE];
   u8      *tmp_buf; // allocates [HCBUFSIZ_LARGE];
 
+  // --potfile-index
+
+  bool     idx_enabled;
+  char    *idx_filename;
+  HCFILE   idx_fp;
+  hash_t   idx_hash;  // scratch space to decode what potfile_write_append () writes
+
+  // module_potfile_custom_bucket ()
+
+  pot_bucket_t *bucket_buf;
+  u32           bucket_cnt;
+
 } potfile_ctx_t;
 
 // this is a linked list structure of all the hashes with the same "key" (hash or hash + salt)
@@ -2263,6 +2538,13 @@ typedef struct restore_data
 
 } restore_data_t;
 
+typedef struct restore_range
+{
+  u64 off;
+  u64 fin;
+
+} restore_range_t;
+
 typedef struct pidfile_data
 {
   u32 pid;
@@ -2287,6 +2569,14 @@ typedef struct restore_ctx
   u32  masks_pos_prev;
   u64  words_cur_prev;
 
+  // completed [off, fin) ranges above words_cur, sorted and coalesced, guarded by mux_dispatcher
+
+  restore_range_t *ranges_buf;
+  u32              ranges_cnt;
+  u32              ranges_alloc;
+  u64              ranges_ver;
+  u64              ranges_ver_prev;
+
 } restore_ctx_t;
 
 typedef struct pidfile_ctx
@@ -2348,11 +2638,23 @@ typedef struct wl_data
   bool enabled;
 
   char *buf;
+  char *buf_heap;
   u64  incr;
   u64  avail;
   u64  cnt;
   u64  pos;
 
+  bool  mmap_enabled;
+  char *mmap_buf;
+  u64   mmap_len;
+  u64   mmap_dev;
+  u64   mmap_ino;
+  u64   mmap_mtime;
+  u64   mmap_released;
+
+  dictidx_t *idx_buf;
+  u64        idx_cnt;
+
   bool    iconv_enabled;
   iconv_t iconv_ctx;
   char   *iconv_tmp;
@@ -2361,6 +2663,130 @@ typedef struct wl_data
 
 } wl_data_t;
 
+typedef struct wl_stdin_batch
+{
+  char *buf;          // finished candidates, back to back
+  u32  *len_buf;
+  u32   cnt;
+  u32   pos;          // candidates already taken by the device threads
+  u64   buf_len;
+  u64   buf_off;
+  u64   words_extra;  // lines rejected because of pw_min / pw_max
+
+} wl_stdin_batch_t;
+
+typedef struct wl_shared
+{
+  bool enabled;
+
+  // single reader of the dictionary shared by all device threads
+  // each word is tokenized exactly once, the thread which claims a range reads it
+
+  HCFILE fp;
+
+  u64  words_cur;
+
+  struct hashcat_ctx *hashcat_ctx_tmp;
+
+  hc_thread_mutex_t mux_reader;
+
+  // pipe mode: a single reader thread turns stdin into batches of finished candidates
+
+  bool              stdin_enabled;
+  bool              stdin_eof;
+  bool              stdin_shutdown;
+  hc_thread_t       stdin_thread;
+
+  char             *stdin_buf;
+  wl_stdin_batch_t *stdin_batches;
+  u32               stdin_head;
+  u32               stdin_used;
+  hc_thread_cond_t  stdin_cond_used;  // signaled when a batch is published and at eof
+  hc_thread_cond_t  stdin_cond_free;  // signaled when a batch is taken and on shutdown
+
+  bool              stdin_iconv_enabled;
+  iconv_t           stdin_iconv_ctx;
+  char             *stdin_iconv_tmp;
+
+} wl_shared_t;
+
+typedef struct wl_count
+{
+  // one newline-aligned byte range of a dictionary, counted by count_words ()
+
+  struct hashcat_ctx *hashcat_ctx;
+
+  HCFILE *fp;
+  HCFILE  fp_own;
+
+  bool ranged;
+
+  u64  beg;
+  u64  end;
+
+  u64  comp;
+  u64  words;
+  u64  cnt2;
+
+  dictidx_t *idx_buf;
+  u64        idx_cnt;
+  u64        idx_avail;
+
+  // only set for the range counted by the calling thread, which also reports progress for all of them
+
+  struct wl_count *wc_all;
+  u32              wc_cnt;
+  const char      *dictfile;
+  u64              size;
+
+} wl_count_t;
+
+typedef struct wl_gzidx
+{
+  // gzip checkpoints, built by count_words () while it inflates the same file for counting
+
+  const char *dictfile;
+
+  gzidx_t     gzidx;
+
+  int         rc;
+
+} wl_gzidx_t;
+
+typedef struct hashes_range
+{
+  // one newline-aligned byte range of a plain hashfile, parsed by hashes_init_stage1 ()
+
+  struct hashcat_ctx *hashcat_ctx;
+
+  HCFILE fp;
+
+  bool   ranged;
+  u64    beg;
+  u64    end;
+
+  u32    line_num;     // lines in front of this range
+  u32    lines_cnt;    // lines in this range, only known if ranged
+  u64    hashes_max;   // upper bound of the hashes this range can produce
+
+  u64    hashes_base;  // first slot of hashes_buf owned by this range
+  u64    hashes_avail;
+  u64    hashes_cnt;
+
+  int    parser_token_length_cnt;
+
+  hcarena_t arena;     // merged into hashes->arena once all ranges are parsed
+
+  hc_thread_mutex_t *mux_log;
+
+  // only set for the range parsed by the calling thread, which also reports progress for all of them
+
+  struct hashes_range *hr_all;
+  u32                  hr_cnt;
+  u64                  hashes_total;
+
+} hashes_range_t;
+
 typedef struct user_options
 {
   const char  *hc_bin;
@@ -2436,6 +2862,7 @@ typedef struct user_options
   bool         outfile_autohex;
   bool         outfile_json;
   bool         potfile;
+  bool         potfile_index;
   bool         progress_only;
   bool         quiet;
   bool         remove;
@@ -2497,6 +2924,8 @@ typedef struct user_options
   u32          benchmark_min;
   u32          bitmap_max;
   u32          bitmap_min;
+  u32          cracked_flush_lines;
+  u32          cracked_flush_timer;
   #ifdef WITH_BRAIN
   u32          brain_server_timer;
   u32          brain_client_features;
@@ -2542,6 +2971,24 @@ typedef struct user_options
 
 } user_options_t;
 
+typedef struct rp_cpu_op
+{
+  u8  cmd;
+  u8  argc;     // arguments found, less than the command takes means the rule ended early
+  u8  arg[3];
+  int pos[3];   // arg[] converted to a position, -1 if it isn't one
+
+} rp_cpu_op_t;
+
+typedef struct rp_cpu_rule
+{
+  int          rule_len;
+
+  rp_cpu_op_t *ops_buf;
+  int          ops_cnt;
+
+} rp_cpu_rule_t;
+
 typedef struct user_options_extra
 {
   u32 attack_kern;
@@ -2549,6 +2996,9 @@ typedef struct user_options_extra
   u32 rule_len_r;
   u32 rule_len_l;
 
+  rp_cpu_rule_t rule_cpu_r; // -k and -j, compiled once for the host side rule engine
+  rp_cpu_rule_t rule_cpu_l;
+
   u32 wordlist_mode;
 
   char   separator;
@@ -2647,6 +3097,14 @@ typedef struct combinator_ctx
   u32 combs_mode;
   u64 combs_cnt;
 
+  // the list run_cracker () combines with, parsed and encoded once per attack
+
+  bool  cache_enabled;
+  u8   *cache_buf;      // finished candidates, back to back
+  u64  *cache_off_buf;  // [cache_cnt + 1]
+  u64  *cache_rej_buf;  // [cache_cnt + 1], lines rejected by -k before each candidate
+  u64   cache_cnt;
+
 } combinator_ctx_t;
 
 typedef struct mask_ctx
@@ -3081,6 +3539,7 @@ typedef struct module_ctx
   bool        (*module_unstable_warning)        (const hashconfig_t *, const user_options_t *, const user_options_extra_t *, const hc_device_param_t *);
 
   bool        (*module_potfile_custom_check)    (const hashconfig_t *, const hash_t *, const hash_t *, const void *);
+  u64         (*module_potfile_custom_bucket)   (const hashconfig_t *, const hash_t *);
 
   u64         (*module_bridge_type)             (const hashconfig_t *, const user_options_t *, const user_options_extra_t *);
   const char *(*module_bridge_name)             (const hashconfig_t *, const user_options_t *, const user_options_extra_t *);
@@ -3119,6 +3578,8 @@ typedef struct hashcat_ctx
   user_options_extra_t  *user_options_extra;
   user_options_t        *user_options;
   wl_data_t             *wl_data;
+  wl_shared_t           *wl_shared;
+  writer_ctx_t          *writer_ctx;
 
   void (*event) (const u32, struct hashcat_ctx *, const void *, const size_t);
 
@@ -9,11 +9,24 @@
 #include <time.h>
 #include <inttypes.h>
 
+#if defined (_POSIX)
+#include <sys/mman.h>
+#endif
+
+// pipe mode: stdin is read in blocks of WL_STDIN_READ_SIZE and handed to the device threads
+// in up to WL_STDIN_BATCHES batches of at most WL_STDIN_BATCH_SIZE bytes / WL_STDIN_BATCH_WORDS candidates
+
+#define WL_STDIN_READ_SIZE    (1024 * 1024)
+#define WL_STDIN_BATCH_SIZE   (1024 * 1024)
+#define WL_STDIN_BATCH_WORDS  (64 * 1024)
+#define WL_STDIN_BATCHES      16
+
 size_t convert_from_hex (hashcat_ctx_t *hashcat_ctx, char *line_buf, const size_t line_len);
 
-void pw_pre_add  (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len, const u8 *base_buf, const int base_len, const int rule_idx);
-void pw_base_add (hc_device_param_t *device_param, pw_pre_t *pw_pre);
-void pw_add      (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len);
+void pw_pre_add   (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len, const u8 *base_buf, const int base_len, const int rule_idx);
+void pw_base_add  (hc_device_param_t *device_param, pw_pre_t *pw_pre);
+void pw_add       (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len);
+void pw_add_batch (hc_device_param_t *device_param, pws_batch_t *pws_batch, const u8 *pw_buf, const int pw_len);
 
 void get_next_word_lm  (char *buf, u64 sz, u64 *len, u64 *off);
 void get_next_word_uc  (char *buf, u64 sz, u64 *len, u64 *off);
@@ -23,7 +36,15 @@ void get_next_word   (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, char **out_buf, u3
 int  load_segment    (hashcat_ctx_t *hashcat_ctx, HCFILE *fp);
 int  count_words     (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, u64 *result);
 
+void wl_data_index_load (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile);
+u64  wl_data_seek       (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const u64 words_cur, const u64 words_dst);
+
 int  wl_data_init    (hashcat_ctx_t *hashcat_ctx);
 void wl_data_destroy (hashcat_ctx_t *hashcat_ctx);
 
+int  wl_shared_init    (hashcat_ctx_t *hashcat_ctx);
+void wl_shared_destroy (hashcat_ctx_t *hashcat_ctx);
+
+void wl_stdin_fill (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, u64 *words_extra);
+
 #endif // HC_WORDLIST_H
@@ -0,0 +1,22 @@
+/**
+ * Author......: See docs/credits.txt
+ * License.....: MIT
+ */
+
+#ifndef HC_WRITER_H
+#define HC_WRITER_H
+
+#include <stdio.h>
+#include <unistd.h>
+
+// a queue is written early once it holds this much, producers wait once it holds twice as much
+
+#define WRITER_QUEUE_SIZE (4 * 1024 * 1024)
+
+int  writer_start           (hashcat_ctx_t *hashcat_ctx);
+void writer_stop            (hashcat_ctx_t *hashcat_ctx);
+void writer_flush           (hashcat_ctx_t *hashcat_ctx);
+void writer_potfile_append  (hashcat_ctx_t *hashcat_ctx, const u8 *line_buf, const writer_line_t *line);
+void writer_outfile_append  (hashcat_ctx_t *hashcat_ctx, const u8 *line_buf, const u32 line_len);
+
+#endif // HC_WRITER_H
@@ -17,6 +17,7 @@
 #include "stdout.h"
 #include "filehandling.h"
 #include "wordlist.h"
+#include "combinator.h"
 #include "shared.h"
 #include "hashes.h"
 #include "emu_inc_hash_md5.h"
@@ -25,6 +26,9 @@
 #include "backend.h"
 #include "terminal.h"
 #include "hwmon.h"
+#ifdef WITH_BRAIN
+#include "brain.h"
+#endif
 
 #if defined (__linux__)
 static const char *const  dri_card0_path = "/dev/dri/card0";
@@ -3691,6 +3695,109 @@ int run_copy (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const
   return 0;
 }
 
+// fills combs_buf with the next innerloop_left candidates of the combinator list, either from the cache or from combs_fp
+
+static u32 combs_fill (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, HCFILE *combs_fp, u64 *combs_pos, u64 *combs_rej, const u32 innerloop_left, const u32 salt_pos, const u64 pws_cnt, const bool iconv_enabled, iconv_t iconv_ctx, char *iconv_tmp, const bool combs_pad)
+{
+  combinator_ctx_t *combinator_ctx = hashcat_ctx->combinator_ctx;
+  hashconfig_t     *hashconfig     = hashcat_ctx->hashconfig;
+  status_ctx_t     *status_ctx     = hashcat_ctx->status_ctx;
+
+  const bool pad = (combs_pad == true) && (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT);
+
+  u32 i = 0;
+
+  if (combinator_ctx->cache_enabled == true)
+  {
+    if (innerloop_left == 0) return 0;
+
+    const u64 pos   = *combs_pos;
+    const u64 avail = combinator_ctx->cache_cnt - pos;
+
+    for (i = 0; (i < innerloop_left) && (i < avail); i++)
+    {
+      const u64 off = combinator_ctx->cache_off_buf[pos + i];
+
+      const u32 line_len = (u32) (combinator_ctx->cache_off_buf[pos + i + 1] - off);
+
+      u8 *ptr = (u8 *) device_param->combs_buf[i].i;
+
+      memcpy (ptr, combinator_ctx->cache_buf + off, line_len);
+
+      memset (ptr + line_len, 0, PW_MAX - line_len);
+
+      if (pad == true)
+      {
+        if (hashconfig->opts_type & OPTS_TYPE_PT_ADD80) ptr[line_len] = 0x80;
+        if (hashconfig->opts_type & OPTS_TYPE_PT_ADD06) ptr[line_len] = 0x06;
+        if (hashconfig->opts_type & OPTS_TYPE_PT_ADD01) ptr[line_len] = 0x01;
+      }
+
+      device_param->combs_buf[i].pw_len = line_len;
+    }
+
+    *combs_pos = pos + i;
+
+    // reading the file stops right after the last candidate of a full window, otherwise it runs into EOF
+
+    if (combinator_ctx->cache_rej_buf != NULL)
+    {
+      const u64 rej = (avail >= innerloop_left) ? combinator_ctx->cache_rej_buf[pos + i - 1] : combinator_ctx->cache_rej_buf[combinator_ctx->cache_cnt];
+
+      status_ctx->words_progress_rejected[salt_pos] += (rej - *combs_rej) * pws_cnt;
+
+      *combs_rej = rej;
+    }
+
+    return i;
+  }
+
+  char *line_buf = device_param->scratch_buf;
+
+  char rule_buf_out[RP_PASSWORD_SIZE];
+
+  while (i < innerloop_left)
+  {
+    if (hc_feof (combs_fp)) break;
+
+    size_t line_len = fgetl (combs_fp, line_buf, HCBUFSIZ_LARGE);
+
+    char *line_buf_new = NULL;
+
+    const int rc = combinator_line (hashcat_ctx, line_buf, line_len, iconv_enabled, iconv_ctx, iconv_tmp, rule_buf_out, &line_buf_new);
+
+    if (rc == -2) status_ctx->words_progress_rejected[salt_pos] += pws_cnt;
+
+    if (rc < 0) continue;
+
+    line_len = (size_t) rc;
+
+    u8 *ptr = (u8 *) device_param->combs_buf[i].i;
+
+    memcpy (ptr, line_buf_new, line_len);
+
+    memset (ptr + line_len, 0, PW_MAX - line_len);
+
+    if (hashconfig->opts_type & OPTS_TYPE_PT_UPPER)
+    {
+      uppercase (ptr, line_len);
+    }
+
+    if (pad == true)
+    {
+      if (hashconfig->opts_type & OPTS_TYPE_PT_ADD80) ptr[line_len] = 0x80;
+      if (hashconfig->opts_type & OPTS_TYPE_PT_ADD06) ptr[line_len] = 0x06;
+      if (hashconfig->opts_type & OPTS_TYPE_PT_ADD01) ptr[line_len] = 0x01;
+    }
+
+    device_param->combs_buf[i].pw_len = (u32) line_len;
+
+    i++;
+  }
+
+  return i;
+}
+
 int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 pws_pos, const u64 pws_cnt)
 {
   combinator_ctx_t      *combinator_ctx     = hashcat_ctx->combinator_ctx;
@@ -3793,10 +3900,15 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
     {
       if ((user_options->attack_mode == ATTACK_MODE_COMBI) || (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (user_options->attack_mode == ATTACK_MODE_HYBRID2)))
       {
-        hc_rewind (combs_fp);
+        if (combinator_ctx->cache_enabled == false) hc_rewind (combs_fp);
       }
     }
 
+    // position in the combinator list and the rejections accounted so far, see combs_fill ()
+
+    u64 combs_pos = 0;
+    u64 combs_rej = 0;
+
     // iteration type
 
     u32 innerloop_step = 0;
@@ -3907,102 +4019,7 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
           {
             if (user_options->attack_mode == ATTACK_MODE_COMBI)
             {
-              char *line_buf = device_param->scratch_buf;
-
-              u32 i = 0;
-
-              while (i < innerloop_left)
-              {
-                if (hc_feof (combs_fp)) break;
-
-                size_t line_len = fgetl (combs_fp, line_buf, HCBUFSIZ_LARGE);
-
-                line_len = convert_from_hex (hashcat_ctx, line_buf, line_len);
-
-                if (line_len > PW_MAX) continue;
-
-                char *line_buf_new = line_buf;
-
-                char rule_buf_out[RP_PASSWORD_SIZE];
-
-                if (run_rule_engine (user_options_extra->rule_len_r, user_options->rule_buf_r))
-                {
-                  if (line_len >= RP_PASSWORD_SIZE) continue;
-
-                  memset (rule_buf_out, 0, sizeof (rule_buf_out));
-
-                  const int rule_len_out = _old_apply_rule (user_options->rule_buf_r, user_options_extra->rule_len_r, line_buf, (u32) line_len, rule_buf_out);
-
-                  if (rule_len_out < 0)
-                  {
-                    if (user_options->attack_mode == ATTACK_MODE_ASSOCIATION)
-                    {
-                      for (u32 association_salt_pos = 0; association_salt_pos < pws_cnt; association_salt_pos++)
-                      {
-                        status_ctx->words_progress_rejected[association_salt_pos] += 1;
-                      }
-                    }
-                    else
-                    {
-                      status_ctx->words_progress_rejected[salt_pos] += pws_cnt;
-                    }
-
-                    continue;
-                  }
-
-                  line_len = rule_len_out;
-
-                  line_buf_new = rule_buf_out;
-                }
-
-                // do the on-the-fly encoding
-
-                if (iconv_enabled == true)
-                {
-                  char  *iconv_ptr = iconv_tmp;
-                  size_t iconv_sz  = HCBUFSIZ_TINY;
-
-                  if (iconv (iconv_ctx, &line_buf_new, &line_len, &iconv_ptr, &iconv_sz) == (size_t) -1) continue;
-
-                  line_buf_new = iconv_tmp;
-                  line_len     = HCBUFSIZ_TINY - iconv_sz;
-                }
-
-                line_len = MIN (line_len, PW_MAX);
-
-                u8 *ptr = (u8 *) device_param->combs_buf[i].i;
-
-                memcpy (ptr, line_buf_new, line_len);
-
-                memset (ptr + line_len, 0, PW_MAX - line_len);
-
-                if (hashconfig->opts_type & OPTS_TYPE_PT_UPPER)
-                {
-                  uppercase (ptr, line_len);
-                }
-
-                if (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT)
-                {
-                  if (hashconfig->opts_type & OPTS_TYPE_PT_ADD80)
-                  {
-                    ptr[line_len] = 0x80;
-                  }
-
-                  if (hashconfig->opts_type & OPTS_TYPE_PT_ADD06)
-                  {
-                    ptr[line_len] = 0x06;
-                  }
-
-                  if (hashconfig->opts_type & OPTS_TYPE_PT_ADD01)
-                  {
-                    ptr[line_len] = 0x01;
-                  }
-                }
-
-                device_param->combs_buf[i].pw_len = (u32) line_len;
-
-                i++;
-              }
+              const u32 i = combs_fill (hashcat_ctx, device_param, combs_fp, &combs_pos, &combs_rej, innerloop_left, salt_pos, pws_cnt, iconv_enabled, iconv_ctx, iconv_tmp, true);
 
               for (u32 j = i; j < innerloop_left; j++)
               {
@@ -4098,104 +4115,7 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
           {
             if ((user_options->attack_mode == ATTACK_MODE_COMBI) || (user_options->attack_mode == ATTACK_MODE_HYBRID2))
             {
-              char *line_buf = device_param->scratch_buf;
-
-              u32 i = 0;
-
-              while (i < innerloop_left)
-              {
-                if (hc_feof (combs_fp)) break;
-
-                size_t line_len = fgetl (combs_fp, line_buf, HCBUFSIZ_LARGE);
-
-                line_len = convert_from_hex (hashcat_ctx, line_buf, line_len);
-
-                if (line_len > PW_MAX) continue;
-
-                char *line_buf_new = line_buf;
-
-                char rule_buf_out[RP_PASSWORD_SIZE];
-
-                if (run_rule_engine (user_options_extra->rule_len_r, user_options->rule_buf_r))
-                {
-                  if (line_len >= RP_PASSWORD_SIZE) continue;
-
-                  memset (rule_buf_out, 0, sizeof (rule_buf_out));
-
-                  const int rule_len_out = _old_apply_rule (user_options->rule_buf_r, user_options_extra->rule_len_r, line_buf, (u32) line_len, rule_buf_out);
-
-                  if (rule_len_out < 0)
-                  {
-                    if (user_options->attack_mode == ATTACK_MODE_ASSOCIATION)
-                    {
-                      for (u32 association_salt_pos = 0; association_salt_pos < pws_cnt; association_salt_pos++)
-                      {
-                        status_ctx->words_progress_rejected[association_salt_pos] += 1;
-                      }
-                    }
-                    else
-                    {
-                      status_ctx->words_progress_rejected[salt_pos] += pws_cnt;
-                    }
-
-                    continue;
-                  }
-
-                  line_len = rule_len_out;
-
-                  line_buf_new = rule_buf_out;
-                }
-
-                // do the on-the-fly encoding
-
-                if (iconv_enabled == true)
-                {
-                  char  *iconv_ptr = iconv_tmp;
-                  size_t iconv_sz  = HCBUFSIZ_TINY;
-
-                  if (iconv (iconv_ctx, &line_buf_new, &line_len, &iconv_ptr, &iconv_sz) == (size_t) -1) continue;
-
-                  line_buf_new = iconv_tmp;
-                  line_len     = HCBUFSIZ_TINY - iconv_sz;
-                }
-
-                line_len = MIN (line_len, PW_MAX);
-
-                u8 *ptr = (u8 *) device_param->combs_buf[i].i;
-
-                memcpy (ptr, line_buf_new, line_len);
-
-                memset (ptr + line_len, 0, PW_MAX - line_len);
-
-                if (hashconfig->opts_type & OPTS_TYPE_PT_UPPER)
-                {
-                  uppercase (ptr, line_len);
-                }
-
-                /*
-                if (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT)
-                {
-                  if (hashconfig->opts_type & OPTS_TYPE_PT_ADD80)
-                  {
-                    ptr[line_len] = 0x80;
-                  }
-
-                  if (hashconfig->opts_type & OPTS_TYPE_PT_ADD06)
-                  {
-                    ptr[line_len] = 0x06;
-                  }
-
-                  if (hashconfig->opts_type & OPTS_TYPE_PT_ADD01)
-                  {
-                    ptr[line_len] = 0x01;
-                  }
-                }
-                */
-
-                device_param->combs_buf[i].pw_len = (u32) line_len;
-
-                i++;
-              }
+              const u32 i = combs_fill (hashcat_ctx, device_param, combs_fp, &combs_pos, &combs_rej, innerloop_left, salt_pos, pws_cnt, iconv_enabled, iconv_ctx, iconv_tmp, false);
 
               for (u32 j = i; j < innerloop_left; j++)
               {
@@ -15592,6 +15512,16 @@ int backend_session_begin (hashcat_ctx_t *hashcat_ctx)
       continue;
     }
 
+    // the wordlist based attacks fill a second set of pws_comp[] and pws_idx[] while the device runs the first one, see dispatch.c
+
+    bool pws_double = true;
+
+    if (user_options->slow_candidates == true)                 pws_double = false;
+    if (user_options_extra->wordlist_mode == WL_MODE_STDIN)     pws_double = false;
+    if (user_options->attack_mode == ATTACK_MODE_BF)            pws_double = false;
+
+    if (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (user_options->attack_mode == ATTACK_MODE_HYBRID2)) pws_double = false;
+
     // Opposite direction check: find out if we would request too much memory on memory blocks which are based on kernel_accel
 
     u64 size_pws      = 4;
@@ -15753,10 +15683,13 @@ int backend_session_begin (hashcat_ctx_t *hashcat_ctx)
       const u64 size_total_host
         = size_pws_comp
         + size_pws_idx
+        + ((pws_double == true) ? (size_pws_comp + size_pws_idx) : 0)
         + size_hooks
         #ifdef WITH_BRAIN
         + size_brain_link_in
         + size_brain_link_out
+        + ((user_options->brain_client == true) ? (size_brain_link_in + size_brain_link_out + size_pws_pre) : 0)
+        + ((user_options->brain_client == true) ? (size_brain_link_in * sizeof (brain_link_hash_t) + size_brain_link_out) : 0)
         #endif
         + size_pws_pre
         + size_pws_base;
@@ -15901,6 +15834,12 @@ int backend_session_begin (hashcat_ctx_t *hashcat_ctx)
 
     device_param->pws_idx = pws_idx;
 
+    if (pws_double == true)
+    {
+      device_param->pws_batches[1].pws_comp = (u32 *)      hcmalloc (size_pws_comp);
+      device_param->pws_batches[1].pws_idx  = (pw_idx_t *) hcmalloc (size_pws_idx);
+    }
+
     pw_t *combs_buf = (pw_t *) hccalloc (KERNEL_COMBS, sizeof (pw_t));
 
     device_param->combs_buf = combs_buf;
@@ -15921,6 +15860,33 @@ int backend_session_begin (hashcat_ctx_t *hashcat_ctx)
     u32 *brain_link_out_buf = (u32 *) hcmalloc (size_brain_link_out);
 
     device_param->brain_link_out_buf = brain_link_out_buf;
+
+    // a pipelined brain client generates a batch while the previous one is still waiting for its lookup
+
+    if (user_options->brain_client == true)
+    {
+      brain_link_batch_t *brain_link_batch = &device_param->brain_link_batches[1];
+
+      brain_link_batch->pws_pre_buf = (pw_pre_t *) hcmalloc (size_pws_pre);
+      brain_link_batch->in_buf      = (u8 *)       hcmalloc (size_brain_link_in);
+      brain_link_batch->out_buf     = (u32 *)      hcmalloc (size_brain_link_out);
+    }
+
+    // a lookup sorts and packs its hashes before they go to the server
+
+    if ((user_options->brain_client == true) && (user_options->brain_client_features & BRAIN_CLIENT_FEATURE_HASHES))
+    {
+      device_param->brain_link_sort_buf = (brain_link_hash_t *) hccalloc (size_brain_link_in, sizeof (brain_link_hash_t));
+      device_param->brain_link_wire_buf = (u8 *)                hcmalloc (size_brain_link_out + BRAIN_PACK_HEADER_SIZE);
+
+      if (user_options->brain_client_features & BRAIN_CLIENT_FEATURE_FILTER)
+      {
+        device_param->brain_link_filter_buf = (u64 *) hcmalloc ((1ULL << BRAIN_CLIENT_FILTER_BITS) / 8);
+
+        device_param->brain_link_batches[0].commit_buf = (u64 *) hcmalloc (size_brain_link_out);
+        device_param->brain_link_batches[1].commit_buf = (u64 *) hcmalloc (size_brain_link_out);
+      }
+    }
     #endif
 
     pw_pre_t *pws_pre_buf = (pw_pre_t *) hcmalloc (size_pws_pre);
@@ -16230,6 +16196,8 @@ void backend_session_destroy (hashcat_ctx_t *hashcat_ctx)
     hcfree_aligned (device_param->h_tmps);
     hcfree (device_param->pws_comp);
     hcfree (device_param->pws_idx);
+    hcfree (device_param->pws_batches[1].pws_comp);
+    hcfree (device_param->pws_batches[1].pws_idx);
     hcfree (device_param->pws_pre_buf);
     hcfree (device_param->pws_base_buf);
     hcfree (device_param->combs_buf);
@@ -16238,6 +16206,14 @@ void backend_session_destroy (hashcat_ctx_t *hashcat_ctx)
     #ifdef WITH_BRAIN
     hcfree (device_param->brain_link_in_buf);
     hcfree (device_param->brain_link_out_buf);
+    hcfree (device_param->brain_link_batches[1].pws_pre_buf);
+    hcfree (device_param->brain_link_batches[1].in_buf);
+    hcfree (device_param->brain_link_batches[1].out_buf);
+    hcfree (device_param->brain_link_sort_buf);
+    hcfree (device_param->brain_link_wire_buf);
+    hcfree (device_param->brain_link_filter_buf);
+    hcfree (device_param->brain_link_batches[0].commit_buf);
+    hcfree (device_param->brain_link_batches[1].commit_buf);
     #endif
 
     if (device_param->is_cuda == true)
@@ -16802,9 +16778,19 @@ void backend_session_destroy (hashcat_ctx_t *hashcat_ctx)
     device_param->combs_buf           = NULL;
     device_param->hooks_buf           = NULL;
     device_param->scratch_buf         = NULL;
+
+    memset (device_param->pws_batches, 0, sizeof (device_param->pws_batches));
+
     #ifdef WITH_BRAIN
     device_param->brain_link_in_buf   = NULL;
     device_param->brain_link_out_buf  = NULL;
+
+    memset (device_param->brain_link_batches, 0, sizeof (device_param->brain_link_batches));
+
+    device_param->brain_link_sort_buf   = NULL;
+    device_param->brain_link_wire_buf   = NULL;
+    device_param->brain_link_filter_buf = NULL;
+    device_param->brain_link_filter_cnt = 0;
     #endif
   }
 }
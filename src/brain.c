@@ -1062,6 +1062,8 @@ bool brain_client_connect (hc_device_param_t *device_param, const status_ctx_t *
     return false;
   }
 
+  device_param->brain_link_version = brain_link_version_ok;
+
   u32 challenge = 0;
 
   if (brain_recv (brain_link_client_fd, &challenge, sizeof (challenge), 0, NULL, NULL) == false)
@@ -1140,6 +1142,12 @@ bool brain_client_connect (hc_device_param_t *device_param, const status_ctx_t *
     return false;
   }
 
+  device_param->brain_link_epoch++;
+
+  // the server may have lost what we committed before, a new start is cheaper than a candidate nobody tries
+
+  brain_client_filter_reset (device_param);
+
   return true;
 }
 
@@ -1170,474 +1178,1955 @@ bool brain_client_reserve (hc_device_param_t *device_param, const status_ctx_t *
   return true;
 }
 
-bool brain_client_commit (hc_device_param_t *device_param, const status_ctx_t *status_ctx)
+bool brain_client_operation (hc_device_param_t *device_param, const status_ctx_t *status_ctx, u8 operation)
 {
-  if (device_param->pws_cnt == 0) return true;
-
   const int brain_link_client_fd = device_param->brain_link_client_fd;
 
   if (brain_link_client_fd == -1) return false;
 
-  u8 operation = BRAIN_OPERATION_COMMIT;
-
   if (brain_send (brain_link_client_fd, &operation, sizeof (operation), SEND_FLAGS, device_param, status_ctx) == false) return false;
 
   return true;
 }
 
-bool brain_client_lookup (hc_device_param_t *device_param, const status_ctx_t *status_ctx)
+bool brain_client_commit (hc_device_param_t *device_param, const status_ctx_t *status_ctx)
 {
-  if (device_param->pws_pre_cnt == 0) return true;
-
-  const int brain_link_client_fd = device_param->brain_link_client_fd;
-
-  if (brain_link_client_fd == -1) return false;
-
-  char *recvbuf = (char *) device_param->brain_link_in_buf;
-  char *sendbuf = (char *) device_param->brain_link_out_buf;
-
-  int in_size  = 0;
-  int out_size = device_param->pws_pre_cnt * BRAIN_HASH_SIZE;
-
-  u8 operation = BRAIN_OPERATION_HASH_LOOKUP;
+  if (device_param->pws_cnt == 0) return true;
 
-  if (brain_send (brain_link_client_fd, &operation, sizeof (operation), SEND_FLAGS, device_param, status_ctx) == false) return false;
-  if (brain_send (brain_link_client_fd, &out_size,   sizeof (out_size), SEND_FLAGS, device_param, status_ctx) == false) return false;
-  if (brain_send (brain_link_client_fd, sendbuf,              out_size, SEND_FLAGS, device_param, status_ctx) == false) return false;
+  if (brain_client_operation (device_param, status_ctx, BRAIN_OPERATION_COMMIT) == false) return false;
 
-  if (brain_recv (brain_link_client_fd, &in_size,     sizeof (in_size),          0, device_param, status_ctx) == false) return false;
+  // the batch of the last lookup is recorded on the server now, and only now it may go into the filter
 
-  if (in_size > (int) device_param->size_brain_link_in) return false;
+  if (device_param->brain_link_filter_buf != NULL)
+  {
+    for (u64 idx = 0; idx < device_param->pws_pre_cnt; idx++)
+    {
+      if (device_param->brain_link_in_buf[idx] == 1) continue;
 
-  if (brain_recv (brain_link_client_fd, recvbuf,      (size_t) in_size,          0, device_param, status_ctx) == false) return false;
+      brain_client_filter_add (device_param, (const u64 *) device_param->brain_link_out_buf + idx, 1);
+    }
+  }
 
   return true;
 }
 
-void brain_client_generate_hash (u64 *hash, const char *line_buf, const size_t line_len)
+bool brain_client_lookup (hc_device_param_t *device_param, const status_ctx_t *status_ctx)
 {
-  const u64 seed = 0;
-
-  hash[0] = XXH64 (line_buf, line_len, seed);
+  return brain_client_lookup_hashes (device_param, status_ctx, device_param->brain_link_out_buf, device_param->brain_link_in_buf, device_param->pws_pre_cnt);
 }
 
-void brain_server_db_hash_init (brain_server_db_hash_t *brain_server_db_hash, const u32 brain_session)
+/**
+ * Packed lookups
+ *
+ * XXH64 hashes are uniformly distributed, so the gaps between the n sorted hashes of a batch are about 2^64 / n.
+ * With a server that knows BRAIN_OPERATION_HASH_LOOKUP_PACKED, the client sends these gaps Rice coded with
+ * k = 63 - log2 (n), that is about 65 - log2 (n) bits per hash instead of 64, and the server answers with one
+ * bit per hash instead of one byte, in the order of the sorted hashes.
+ * A packed batch is the number of hashes (u32) and k (u8), followed by the bits, lowest bit first.
+ * Batches which would not get smaller, for whatever reason, are sent as before.
+ *
+ * With BRAIN_CLIENT_FEATURE_FILTER, a bloom filter of the hashes this client already committed rejects them
+ * before they go over the wire at all. Hashes go into it only once their commit was sent, a batch lost with
+ * a failed lookup or a dropped connection is looked up again in full. A false positive costs a candidate
+ * nobody tried, so the filter is cleared once it holds BRAIN_CLIENT_FILTER_ENTRIES hashes and on every connect.
+ */
+
+static bool brain_bits_put (brain_bits_t *bits, const u64 val, const int cnt)
 {
-  brain_server_db_hash->brain_session = brain_session;
+  // cnt <= 32, acc never holds more than 7 bits in between
 
-  brain_server_db_hash->hb           = 0;
-  brain_server_db_hash->long_cnt     = 0;
-  brain_server_db_hash->long_buf     = NULL;
-  brain_server_db_hash->long_alloc   = 0;
-  brain_server_db_hash->write_hashes = false;
+  bits->acc |= (val & ((1ULL << cnt) - 1)) << bits->acc_bits;
 
-  hc_thread_mutex_init (brain_server_db_hash->mux_hr);
-  hc_thread_mutex_init (brain_server_db_hash->mux_hg);
-}
+  bits->acc_bits += cnt;
 
-bool brain_server_db_hash_realloc (brain_server_db_hash_t *brain_server_db_hash, const i64 new_long_cnt)
-{
-  if ((brain_server_db_hash->long_cnt + new_long_cnt) > brain_server_db_hash->long_alloc)
+  while (bits->acc_bits >= 8)
   {
-    const i64 realloc_size_total = (i64) mydivc64 ((const u64) new_long_cnt, (const u64) BRAIN_SERVER_REALLOC_HASH_SIZE) * BRAIN_SERVER_REALLOC_HASH_SIZE;
+    if (bits->len == bits->size) return false;
 
-    brain_server_hash_long_t *long_buf = (brain_server_hash_long_t *) hcrealloc (brain_server_db_hash->long_buf, brain_server_db_hash->long_alloc * sizeof (brain_server_hash_long_t), realloc_size_total * sizeof (brain_server_hash_long_t));
+    bits->buf[bits->len++] = (u8) bits->acc;
 
-    if (long_buf == NULL) return false;
+    bits->acc >>= 8;
 
-    brain_server_db_hash->long_buf    = long_buf;
-    brain_server_db_hash->long_alloc += realloc_size_total;
+    bits->acc_bits -= 8;
   }
 
   return true;
 }
 
-void brain_server_db_hash_free (brain_server_db_hash_t *brain_server_db_hash)
+static bool brain_bits_flush (brain_bits_t *bits)
 {
-  hc_thread_mutex_delete (brain_server_db_hash->mux_hg);
-  hc_thread_mutex_delete (brain_server_db_hash->mux_hr);
-
-  hcfree (brain_server_db_hash->long_buf);
+  if (bits->acc_bits == 0) return true;
 
-  brain_server_db_hash->hb            = 0;
-  brain_server_db_hash->long_cnt      = 0;
-  brain_server_db_hash->long_buf      = NULL;
-  brain_server_db_hash->long_alloc    = 0;
-  brain_server_db_hash->write_hashes  = false;
-  brain_server_db_hash->brain_session = 0;
-}
+  if (bits->len == bits->size) return false;
 
-void brain_server_db_attack_init (brain_server_db_attack_t *brain_server_db_attack, const u32 brain_attack)
-{
-  brain_server_db_attack->brain_attack = brain_attack;
+  bits->buf[bits->len++] = (u8) bits->acc;
 
-  brain_server_db_attack->ab            = 0;
-  brain_server_db_attack->short_cnt     = 0;
-  brain_server_db_attack->short_buf     = NULL;
-  brain_server_db_attack->short_alloc   = 0;
-  brain_server_db_attack->long_cnt      = 0;
-  brain_server_db_attack->long_buf      = NULL;
-  brain_server_db_attack->long_alloc    = 0;
-  brain_server_db_attack->write_attacks = false;
+  bits->acc      = 0;
+  bits->acc_bits = 0;
 
-  hc_thread_mutex_init (brain_server_db_attack->mux_ar);
-  hc_thread_mutex_init (brain_server_db_attack->mux_ag);
+  return true;
 }
 
-bool brain_server_db_attack_realloc (brain_server_db_attack_t *brain_server_db_attack, const i64 new_long_cnt, const i64 new_short_cnt)
+static bool brain_bits_get (brain_bits_t *bits, u64 *val, const int cnt)
 {
-  if ((brain_server_db_attack->long_cnt + new_long_cnt) > brain_server_db_attack->long_alloc)
-  {
-    const i64 realloc_size_total = (i64) mydivc64 ((const u64) new_long_cnt, (const u64) BRAIN_SERVER_REALLOC_ATTACK_SIZE) * BRAIN_SERVER_REALLOC_ATTACK_SIZE;
+  // cnt <= 32
 
-    brain_server_attack_long_t *long_buf = (brain_server_attack_long_t *) hcrealloc (brain_server_db_attack->long_buf, brain_server_db_attack->long_alloc * sizeof (brain_server_attack_long_t), realloc_size_total * sizeof (brain_server_attack_long_t));
+  while (bits->acc_bits < cnt)
+  {
+    if (bits->len == bits->size) return false;
 
-    if (long_buf == NULL) return false;
+    bits->acc |= (u64) bits->buf[bits->len++] << bits->acc_bits;
 
-    brain_server_db_attack->long_buf    = long_buf;
-    brain_server_db_attack->long_alloc += realloc_size_total;
+    bits->acc_bits += 8;
   }
 
-  if ((brain_server_db_attack->short_cnt + new_short_cnt) > brain_server_db_attack->short_alloc)
-  {
-    const i64 realloc_size_total = (i64) mydivc64 ((const u64) new_short_cnt, (const u64) BRAIN_SERVER_REALLOC_ATTACK_SIZE) * BRAIN_SERVER_REALLOC_ATTACK_SIZE;
-
-    brain_server_attack_short_t *short_buf = (brain_server_attack_short_t *) hcrealloc (brain_server_db_attack->short_buf, brain_server_db_attack->short_alloc * sizeof (brain_server_attack_short_t), realloc_size_total * sizeof (brain_server_attack_short_t));
+  *val = bits->acc & ((1ULL << cnt) - 1);
 
-    if (short_buf == NULL) return false;
+  bits->acc >>= cnt;
 
-    brain_server_db_attack->short_buf    = short_buf;
-    brain_server_db_attack->short_alloc += realloc_size_total;
-  }
+  bits->acc_bits -= cnt;
 
   return true;
 }
 
-void brain_server_db_attack_free (brain_server_db_attack_t *brain_server_db_attack)
+static u8 brain_pack_rice_k (const u32 cnt)
 {
-  hc_thread_mutex_delete (brain_server_db_attack->mux_ag);
-  hc_thread_mutex_delete (brain_server_db_attack->mux_ar);
+  u8 k = 63;
 
-  hcfree (brain_server_db_attack->long_buf);
-  hcfree (brain_server_db_attack->short_buf);
+  for (u32 n = cnt; n > 1; n >>= 1) k--;
 
-  brain_server_db_attack->ab            = 0;
-  brain_server_db_attack->long_cnt      = 0;
-  brain_server_db_attack->long_buf      = NULL;
-  brain_server_db_attack->long_alloc    = 0;
-  brain_server_db_attack->short_cnt     = 0;
-  brain_server_db_attack->short_buf     = NULL;
-  brain_server_db_attack->short_alloc   = 0;
-  brain_server_db_attack->brain_attack  = 0;
-  brain_server_db_attack->write_attacks = false;
+  return k;
 }
 
-u64 brain_server_highest_attack (const brain_server_db_attack_t *buf)
+size_t brain_pack_hashes (u8 *buf, const size_t buf_size, const brain_link_hash_t *hashes, const u32 cnt)
 {
-  const brain_server_attack_long_t  *long_buf  = buf->long_buf;
-  const brain_server_attack_short_t *short_buf = buf->short_buf;
+  if (cnt == 0) return 0;
 
-  const u64 long_cnt  = buf->long_cnt;
-  const u64 short_cnt = buf->short_cnt;
+  if (buf_size < (size_t) BRAIN_PACK_HEADER_SIZE) return 0;
 
-  u64 highest_long  = brain_server_highest_attack_long  (long_buf,  long_cnt,  0);
-  u64 highest_short = brain_server_highest_attack_short (short_buf, short_cnt, 0);
+  const u8 k = brain_pack_rice_k (cnt);
 
-  u64 highest = MAX (highest_long, highest_short);
+  memcpy (buf, &cnt, sizeof (cnt));
 
-  highest_long  = brain_server_highest_attack_long  (long_buf,  long_cnt,  highest);
-  highest_short = brain_server_highest_attack_short (short_buf, short_cnt, highest);
+  buf[sizeof (cnt)] = k;
 
-  highest = MAX (highest_long, highest_short);
+  brain_bits_t bits;
 
-  return highest;
-}
+  memset (&bits, 0, sizeof (bits));
 
-u64 brain_server_highest_attack_long (const brain_server_attack_long_t *buf, const i64 cnt, const u64 start)
-{
-  u64 highest = start;
+  bits.buf  = buf;
+  bits.size = buf_size;
+  bits.len  = BRAIN_PACK_HEADER_SIZE;
 
-  for (i64 idx = 0; idx < cnt; idx++)
-  {
-    const u64 offset = buf[idx].offset;
-    const u64 length = buf[idx].length;
+  u64 prev = 0;
 
-    if (offset > highest) break;
+  for (u32 idx = 0; idx < cnt; idx++)
+  {
+    const u64 hash = hashes[idx].hash;
 
-    const u64 next = offset + length;
+    const u64 gap = hash - prev;
 
-    highest = MAX (highest, next);
-  }
+    prev = hash;
 
-  return highest;
-}
+    // quotient in unary, remainder in k bits
 
-u64 brain_server_highest_attack_short (const brain_server_attack_short_t *buf, const i64 cnt, const u64 start)
-{
-  u64 highest = start;
+    u64 q = gap >> k;
 
-  for (i64 idx = 0; idx < cnt; idx++)
-  {
-    const u64 offset = buf[idx].offset;
-    const u64 length = buf[idx].length;
+    for (; q >= 32; q -= 32)
+    {
+      if (brain_bits_put (&bits, 0xffffffff, 32) == false) return 0;
+    }
 
-    if (offset > highest) break;
+    if (brain_bits_put (&bits, (1ULL << q) - 1, (int) q + 1) == false) return 0;
 
-    const u64 next = offset + length;
+    if (brain_bits_put (&bits, gap, MIN (k, 32)) == false) return 0;
 
-    highest = MAX (highest, next);
+    if (k > 32)
+    {
+      if (brain_bits_put (&bits, gap >> 32, k - 32) == false) return 0;
+    }
   }
 
-  return highest;
+  if (brain_bits_flush (&bits) == false) return 0;
+
+  return bits.len;
 }
 
-u64 brain_server_find_attack_long (const brain_server_attack_long_t *buf, const i64 cnt, const u64 offset, const u64 length)
+u32 brain_unpack_hashes (brain_server_hash_unique_t *hashes, const u32 hashes_max, const u8 *buf, const size_t buf_size)
 {
-  const u64 end = offset + length;
+  if (buf_size < (size_t) BRAIN_PACK_HEADER_SIZE) return 0;
 
-  u64 overlap = 0;
+  u32 cnt = 0;
 
-  for (i64 idx = 0; idx < cnt; idx++)
-  {
-    const u64 element_length = buf[idx].length;
+  memcpy (&cnt, buf, sizeof (cnt));
 
-    if (element_length == 0) continue;
+  const u8 k = buf[sizeof (cnt)];
 
-    const u64 element_start = buf[idx].offset;
-    const u64 element_end   = element_start + element_length;
+  if (cnt == 0)          return 0;
+  if (cnt > hashes_max)  return 0;
+  if (k < 32 || k > 63)  return 0;
 
-    const u64 start = offset + overlap;
+  brain_bits_t bits;
 
-    if (element_start > start) break; // we can't ever do it since this list is sorted
+  memset (&bits, 0, sizeof (bits));
 
-    if (element_end > start)
+  bits.buf  = (u8 *) buf;
+  bits.size = buf_size;
+  bits.len  = BRAIN_PACK_HEADER_SIZE;
+
+  u64 prev = 0;
+
+  for (u32 idx = 0; idx < cnt; idx++)
+  {
+    u64 q = 0;
+
+    while (true)
     {
-      const u64 limited_end = MIN (end, element_end);
+      u64 bit = 0;
 
-      overlap += limited_end - start;
+      if (brain_bits_get (&bits, &bit, 1) == false) return 0;
 
-      if (overlap == length) break;
+      if (bit == 0) break;
+
+      q++;
     }
-  }
 
-  return overlap;
-}
+    // a gap has to fit into 64 bits and must not wrap around
 
-u64 brain_server_find_attack_short (const brain_server_attack_short_t *buf, const i64 cnt, const u64 offset, const u64 length)
-{
-  const u64 end = offset + length;
+    if (q >= (1ULL << (64 - k))) return 0;
 
-  u64 overlap = 0;
+    u64 lo = 0;
+    u64 hi = 0;
 
-  for (i64 idx = 0; idx < cnt; idx++)
-  {
-    const u64 element_length = buf[idx].length;
+    if (brain_bits_get (&bits, &lo, 32) == false) return 0;
 
-    if (element_length == 0) continue;
+    if (brain_bits_get (&bits, &hi, k - 32) == false) return 0;
 
-    const u64 element_start = buf[idx].offset;
-    const u64 element_end   = element_start + element_length;
+    const u64 gap = (q << k) | (hi << 32) | lo;
 
-    const u64 start = offset + overlap;
+    const u64 hash = prev + gap;
 
-    if (element_start > start) break; // we can't ever do it since this list is sorted
+    if (hash < prev) return 0;
 
-    if (element_end > start)
-    {
-      const u64 limited_end = MIN (end, element_end);
+    prev = hash;
 
-      overlap += limited_end - start;
+    hashes[idx].hash[0] = (u32) (hash >>  0);
+    hashes[idx].hash[1] = (u32) (hash >> 32);
 
-      if (overlap == length) break;
-    }
+    hashes[idx].hash_idx = idx;
   }
 
-  return overlap;
+  return cnt;
 }
 
-int brain_server_sort_db_hash (const void *v1, const void *v2)
+int brain_client_sort_hash (const void *v1, const void *v2)
 {
-  const brain_server_db_hash_t *d1 = (const brain_server_db_hash_t *) v1;
-  const brain_server_db_hash_t *d2 = (const brain_server_db_hash_t *) v2;
+  const brain_link_hash_t *d1 = (const brain_link_hash_t *) v1;
+  const brain_link_hash_t *d2 = (const brain_link_hash_t *) v2;
 
-  if (d1->brain_session > d2->brain_session) return  1;
-  if (d1->brain_session < d2->brain_session) return -1;
+  if (d1->hash > d2->hash) return  1;
+  if (d1->hash < d2->hash) return -1;
 
   return 0;
 }
 
-int brain_server_sort_db_attack (const void *v1, const void *v2)
+bool brain_client_filter (hc_device_param_t *device_param, const u64 hash)
 {
-  const brain_server_db_attack_t *d1 = (const brain_server_db_attack_t *) v1;
-  const brain_server_db_attack_t *d2 = (const brain_server_db_attack_t *) v2;
+  const u64 *filter_buf = device_param->brain_link_filter_buf;
 
-  if (d1->brain_attack > d2->brain_attack) return  1;
-  if (d1->brain_attack < d2->brain_attack) return -1;
+  const u64 mask = (1ULL << BRAIN_CLIENT_FILTER_BITS) - 1;
 
-  return 0;
-}
+  // double hashing, both halves of a XXH64 hash are as good as any other
 
-int brain_server_sort_hash (const void *v1, const void *v2)
-{
-  const u32 *d1 = (const u32 *) v1;
-  const u32 *d2 = (const u32 *) v2;
+  const u64 h1 = (hash >>  0) & 0xffffffff;
+  const u64 h2 = (hash >> 32) | 1;
 
-  if (d1[1] > d2[1]) return  1;
-  if (d1[1] < d2[1]) return -1;
-  if (d1[0] > d2[0]) return  1;
-  if (d1[0] < d2[0]) return -1;
+  for (int probe = 0; probe < BRAIN_CLIENT_FILTER_PROBES; probe++)
+  {
+    const u64 bit = (h1 + (probe * h2)) & mask;
 
-  return 0;
+    if ((filter_buf[bit / 64] & (1ULL << (bit % 64))) == 0) return false;
+  }
+
+  return true;
 }
 
-int brain_server_sort_attack_long (const void *v1, const void *v2)
+void brain_client_filter_add (hc_device_param_t *device_param, const u64 *hashes, const u64 cnt)
 {
-  const brain_server_attack_long_t *d1 = (const brain_server_attack_long_t *) v1;
-  const brain_server_attack_long_t *d2 = (const brain_server_attack_long_t *) v2;
+  u64 *filter_buf = device_param->brain_link_filter_buf;
 
-  if (d1->offset > d2->offset) return  1;
-  if (d1->offset < d2->offset) return -1;
+  if (filter_buf == NULL) return;
 
-  return 0;
-}
+  const u64 mask = (1ULL << BRAIN_CLIENT_FILTER_BITS) - 1;
 
-int brain_server_sort_attack_short (const void *v1, const void *v2)
-{
-  const brain_server_attack_short_t *d1 = (const brain_server_attack_short_t *) v1;
-  const brain_server_attack_short_t *d2 = (const brain_server_attack_short_t *) v2;
+  for (u64 idx = 0; idx < cnt; idx++)
+  {
+    if (device_param->brain_link_filter_cnt == (u64) BRAIN_CLIENT_FILTER_ENTRIES) brain_client_filter_reset (device_param);
 
-  if (d1->offset > d2->offset) return  1;
-  if (d1->offset < d2->offset) return -1;
+    const u64 h1 = (hashes[idx] >>  0) & 0xffffffff;
+    const u64 h2 = (hashes[idx] >> 32) | 1;
 
-  return 0;
-}
+    for (int probe = 0; probe < BRAIN_CLIENT_FILTER_PROBES; probe++)
+    {
+      const u64 bit = (h1 + (probe * h2)) & mask;
 
-int brain_server_sort_hash_long (const void *v1, const void *v2)
-{
-  const brain_server_hash_long_t *d1 = (const brain_server_hash_long_t *) v1;
-  const brain_server_hash_long_t *d2 = (const brain_server_hash_long_t *) v2;
+      filter_buf[bit / 64] |= 1ULL << (bit % 64);
+    }
 
-  return brain_server_sort_hash (d1->hash, d2->hash);
+    device_param->brain_link_filter_cnt++;
+  }
 }
 
-int brain_server_sort_hash_short (const void *v1, const void *v2)
+void brain_client_filter_reset (hc_device_param_t *device_param)
 {
-  const brain_server_hash_short_t *d1 = (const brain_server_hash_short_t *) v1;
-  const brain_server_hash_short_t *d2 = (const brain_server_hash_short_t *) v2;
+  if (device_param->brain_link_filter_buf == NULL) return;
 
-  return brain_server_sort_hash (d1->hash, d2->hash);
-}
+  if (device_param->brain_link_filter_cnt == 0) return;
 
-int brain_server_sort_hash_unique (const void *v1, const void *v2)
-{
-  const brain_server_hash_unique_t *d1 = (const brain_server_hash_unique_t *) v1;
-  const brain_server_hash_unique_t *d2 = (const brain_server_hash_unique_t *) v2;
+  memset (device_param->brain_link_filter_buf, 0, (1ULL << BRAIN_CLIENT_FILTER_BITS) / 8);
 
-  return brain_server_sort_hash (d1->hash, d2->hash);
+  device_param->brain_link_filter_cnt = 0;
 }
 
-bool brain_server_read_hash_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
+// the hashes of a batch which were sent to the server and not rejected by it, these are what a commit records
+
+u64 brain_client_filter_collect (u64 *commit_buf, const u32 *out_buf, const u8 *in_buf, const u64 cnt)
 {
-  brain_server_dbs->hash_cnt = 0;
+  const u64 *hashes = (const u64 *) out_buf;
 
-  /* temporary disabled due to https://github.com/hashcat/hashcat/issues/2379
-  if (chdir (path) == -1)
+  u64 commit_cnt = 0;
+
+  for (u64 idx = 0; idx < cnt; idx++)
   {
-    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
+    if (in_buf[idx] == 1) continue;
 
-    return false;
+    commit_buf[commit_cnt] = hashes[idx];
+
+    commit_cnt++;
   }
-  */
 
-  DIR *dirp = opendir (path);
+  return commit_cnt;
+}
 
-  if (dirp == NULL)
-  {
-    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
+bool brain_client_lookup_hashes (hc_device_param_t *device_param, const status_ctx_t *status_ctx, u32 *out_buf, u8 *in_buf, const u64 cnt)
+{
+  if (cnt == 0) return true;
 
-    return false;
-  }
+  const int brain_link_client_fd = device_param->brain_link_client_fd;
 
-  struct dirent *entry;
+  if (brain_link_client_fd == -1) return false;
 
-  while ((entry = readdir (dirp)) != NULL)
-  {
-    char *file = entry->d_name;
+  const u64 *hashes = (const u64 *) out_buf;
 
-    const size_t len = strlen (file);
+  brain_link_hash_t *sort_buf = device_param->brain_link_sort_buf;
 
-    if (len != 19) continue;
+  u8 *wire_buf = device_param->brain_link_wire_buf;
 
-    if (file[ 0] != 'b') continue;
-    if (file[ 1] != 'r') continue;
-    if (file[ 2] != 'a') continue;
+  // hashes this client already committed never leave it again
+
+  u64 send_cnt = 0;
+
+  for (u64 idx = 0; idx < cnt; idx++)
+  {
+    if ((device_param->brain_link_filter_buf != NULL) && (brain_client_filter (device_param, hashes[idx]) == true))
+    {
+      in_buf[idx] = 1;
+
+      continue;
+    }
+
+    in_buf[idx] = 0;
+
+    sort_buf[send_cnt].hash = hashes[idx];
+    sort_buf[send_cnt].idx  = idx;
+
+    send_cnt++;
+  }
+
+  if (send_cnt == 0) return true;
+
+  size_t packed_size = 0;
+
+  if (device_param->brain_link_version >= (u32) BRAIN_LINK_VERSION_PACKED)
+  {
+    qsort (sort_buf, send_cnt, sizeof (brain_link_hash_t), brain_client_sort_hash);
+
+    packed_size = brain_pack_hashes (wire_buf, send_cnt * BRAIN_HASH_SIZE, sort_buf, (u32) send_cnt);
+  }
+
+  const bool packed = (packed_size > 0);
+
+  u8 operation = BRAIN_OPERATION_HASH_LOOKUP;
+
+  int out_size = send_cnt * BRAIN_HASH_SIZE;
+
+  if (packed == true)
+  {
+    operation = BRAIN_OPERATION_HASH_LOOKUP_PACKED;
+
+    out_size = (int) packed_size;
+  }
+  else
+  {
+    u64 *wire_hashes = (u64 *) wire_buf;
+
+    for (u64 send_idx = 0; send_idx < send_cnt; send_idx++)
+    {
+      wire_hashes[send_idx] = sort_buf[send_idx].hash;
+    }
+  }
+
+  int in_size = 0;
+
+  if (brain_send (brain_link_client_fd, &operation, sizeof (operation), SEND_FLAGS, device_param, status_ctx) == false) return false;
+  if (brain_send (brain_link_client_fd, &out_size,   sizeof (out_size), SEND_FLAGS, device_param, status_ctx) == false) return false;
+  if (brain_send (brain_link_client_fd, wire_buf,             out_size, SEND_FLAGS, device_param, status_ctx) == false) return false;
+
+  if (brain_recv (brain_link_client_fd, &in_size,     sizeof (in_size),          0, device_param, status_ctx) == false) return false;
+
+  const int reply_size = (packed == true) ? (int) ((send_cnt + 7) / 8) : (int) send_cnt;
+
+  if (in_size != reply_size) return false;
+
+  if (brain_recv (brain_link_client_fd, wire_buf,     (size_t) in_size,          0, device_param, status_ctx) == false) return false;
+
+  for (u64 send_idx = 0; send_idx < send_cnt; send_idx++)
+  {
+    const u8 dupe = (packed == true) ? ((wire_buf[send_idx / 8] >> (send_idx % 8)) & 1) : wire_buf[send_idx];
+
+    in_buf[sort_buf[send_idx].idx] = dupe;
+  }
+
+  return true;
+}
+
+void brain_client_generate_hash (u64 *hash, const char *line_buf, const size_t line_len)
+{
+  const u64 seed = 0;
+
+  hash[0] = XXH64 (line_buf, line_len, seed);
+}
+
+/**
+ * Pipelined client
+ *
+ * With a server that knows BRAIN_OPERATION_SEAL, the socket of a device is owned by a link thread.
+ * The device thread posts jobs to it and only waits for the answer once it actually needs it, so a lookup
+ * or a reservation travels to the server while the device is busy with the previous batch, and commits and
+ * seals are sent without the device thread ever waiting for them.
+ * Jobs are done strictly in the order they were posted, each post returns a ticket to wait for.
+ * If a job fails, the link thread disconnects and all jobs left fail, too. The device thread notices the
+ * closed socket as before and reconnects, after it waited for the queue to drain.
+ */
+
+HC_API_CALL void *brain_client_thread (void *p)
+{
+  hc_device_param_t *device_param = (hc_device_param_t *) p;
+
+  const status_ctx_t *status_ctx = device_param->brain_link_status_ctx;
+
+  while (true)
+  {
+    hc_thread_mutex_lock (device_param->brain_link_mux);
+
+    while ((device_param->brain_link_jobs_done == device_param->brain_link_jobs_posted) && (device_param->brain_link_shutdown == false))
+    {
+      hc_thread_cond_wait (device_param->brain_link_cond, device_param->brain_link_mux);
+    }
+
+    const u64 jobs_posted = device_param->brain_link_jobs_posted;
+    const u64 jobs_done   = device_param->brain_link_jobs_done;
+
+    hc_thread_mutex_unlock (device_param->brain_link_mux);
+
+    // with shutdown set, whatever was queued is done first
+
+    if (jobs_done == jobs_posted) break;
+
+    brain_link_job_t *job = &device_param->brain_link_jobs[jobs_done % BRAIN_CLIENT_JOBS];
+
+    bool ok = false;
+
+    if (device_param->brain_link_client_fd != -1)
+    {
+      if (job->operation == BRAIN_OPERATION_HASH_LOOKUP)
+      {
+        ok = brain_client_lookup_hashes (device_param, status_ctx, job->out_buf, job->in_buf, job->cnt);
+      }
+      else if (job->operation == BRAIN_OPERATION_ATTACK_RESERVE)
+      {
+        ok = brain_client_reserve (device_param, status_ctx, job->words_off, job->work, job->overlap);
+      }
+      else
+      {
+        ok = brain_client_operation (device_param, status_ctx, (u8) job->operation);
+
+        if ((ok == true) && (job->operation == BRAIN_OPERATION_COMMIT)) brain_client_filter_add (device_param, (const u64 *) job->out_buf, job->cnt);
+      }
+
+      if (ok == false) brain_client_disconnect (device_param);
+    }
+
+    if (job->ok) *job->ok = ok;
+
+    hc_thread_mutex_lock (device_param->brain_link_mux);
+
+    device_param->brain_link_jobs_done++;
+
+    hc_thread_cond_wake (device_param->brain_link_cond);
+
+    hc_thread_mutex_unlock (device_param->brain_link_mux);
+  }
+
+  return NULL;
+}
+
+void brain_client_start (hc_device_param_t *device_param, status_ctx_t *status_ctx)
+{
+  device_param->brain_link_jobs        = (brain_link_job_t *) hccalloc (BRAIN_CLIENT_JOBS, sizeof (brain_link_job_t));
+  device_param->brain_link_jobs_posted = 0;
+  device_param->brain_link_jobs_done   = 0;
+  device_param->brain_link_shutdown    = false;
+  device_param->brain_link_status_ctx  = status_ctx;
+
+  hc_thread_mutex_init (device_param->brain_link_mux);
+  hc_thread_cond_init  (device_param->brain_link_cond);
+
+  hc_thread_create (device_param->brain_link_thread, brain_client_thread, device_param);
+
+  device_param->brain_link_pipeline = true;
+}
+
+void brain_client_stop (hc_device_param_t *device_param)
+{
+  if (device_param->brain_link_pipeline == false) return;
+
+  // whatever is still queued is sent, or fails right away if we're aborting
+
+  hc_thread_mutex_lock (device_param->brain_link_mux);
+
+  device_param->brain_link_shutdown = true;
+
+  hc_thread_cond_wake (device_param->brain_link_cond);
+
+  hc_thread_mutex_unlock (device_param->brain_link_mux);
+
+  hc_thread_wait (1, &device_param->brain_link_thread);
+
+  hc_thread_cond_delete  (device_param->brain_link_cond);
+  hc_thread_mutex_delete (device_param->brain_link_mux);
+
+  hcfree (device_param->brain_link_jobs);
+
+  device_param->brain_link_jobs     = NULL;
+  device_param->brain_link_pipeline = false;
+}
+
+u64 brain_client_post (hc_device_param_t *device_param, const brain_link_job_t *job)
+{
+  hc_thread_mutex_lock (device_param->brain_link_mux);
+
+  while ((device_param->brain_link_jobs_posted - device_param->brain_link_jobs_done) == (u64) BRAIN_CLIENT_JOBS)
+  {
+    hc_thread_cond_wait (device_param->brain_link_cond, device_param->brain_link_mux);
+  }
+
+  device_param->brain_link_jobs[device_param->brain_link_jobs_posted % BRAIN_CLIENT_JOBS] = *job;
+
+  const u64 ticket = ++device_param->brain_link_jobs_posted;
+
+  hc_thread_cond_wake (device_param->brain_link_cond);
+
+  hc_thread_mutex_unlock (device_param->brain_link_mux);
+
+  return ticket;
+}
+
+void brain_client_wait (hc_device_param_t *device_param, const u64 ticket)
+{
+  hc_thread_mutex_lock (device_param->brain_link_mux);
+
+  while (device_param->brain_link_jobs_done < ticket)
+  {
+    hc_thread_cond_wait (device_param->brain_link_cond, device_param->brain_link_mux);
+  }
+
+  hc_thread_mutex_unlock (device_param->brain_link_mux);
+}
+
+void brain_client_sync (hc_device_param_t *device_param)
+{
+  hc_thread_mutex_lock (device_param->brain_link_mux);
+
+  const u64 ticket = device_param->brain_link_jobs_posted;
+
+  hc_thread_mutex_unlock (device_param->brain_link_mux);
+
+  brain_client_wait (device_param, ticket);
+}
+
+/**
+ * Hash memory
+ *
+ * The long-term memory of a session is split into BRAIN_SERVER_HASH_SHARDS shards by the highest bits of the hash.
+ * Those are also the highest bits of the sort order, so each shard holds a contiguous part of the sorted array
+ * and the shards in order are exactly the sorted array we store in the dump.
+ * Each shard has its own lock: a lookup only waits for a commit to the same shard, and a commit only has to merge
+ * into the shards it actually adds to, so its cost is bounded by the shard size and not by the session size.
+ */
+
+u32 brain_server_hash_shard (const u32 *hash)
+{
+  return hash[1] >> (32 - BRAIN_SERVER_HASH_SHARDS_BITS);
+}
+
+void brain_server_db_hash_init (brain_server_db_hash_t *brain_server_db_hash, const u32 brain_session)
+{
+  brain_server_db_hash->brain_session = brain_session;
+
+  brain_server_db_hash->shards = (brain_server_db_hash_shard_t *) hccalloc (BRAIN_SERVER_HASH_SHARDS, sizeof (brain_server_db_hash_shard_t));
+
+  for (int shard_idx = 0; shard_idx < BRAIN_SERVER_HASH_SHARDS; shard_idx++)
+  {
+    brain_server_db_hash_shard_t *brain_server_db_hash_shard = &brain_server_db_hash->shards[shard_idx];
+
+    hc_thread_mutex_init (brain_server_db_hash_shard->mux_hr);
+    hc_thread_mutex_init (brain_server_db_hash_shard->mux_hg);
+  }
+
+  brain_server_db_hash->long_cnt         = 0;
+  brain_server_db_hash->map_buf          = NULL;
+  brain_server_db_hash->map_len          = 0;
+  brain_server_db_hash->journal_cnt      = 0;
+  brain_server_db_hash->journal_buf      = NULL;
+  brain_server_db_hash->journal_alloc    = 0;
+  brain_server_db_hash->journal_file_cnt = 0;
+  brain_server_db_hash->journal_compact  = false;
+  brain_server_db_hash->write_hashes     = false;
+
+  hc_thread_mutex_init (brain_server_db_hash->mux_hj);
+}
+
+bool brain_server_db_hash_shard_realloc (brain_server_db_hash_shard_t *brain_server_db_hash_shard, const i64 new_long_cnt)
+{
+  if ((brain_server_db_hash_shard->long_mapped == false) && ((brain_server_db_hash_shard->long_cnt + new_long_cnt) <= brain_server_db_hash_shard->long_alloc)) return true;
+
+  // grow in steps of at least 1/8, otherwise large shards get copied on every commit
+
+  const i64 realloc_step = MAX (brain_server_db_hash_shard->long_alloc / 8, BRAIN_SERVER_REALLOC_HASH_SIZE / BRAIN_SERVER_HASH_SHARDS);
+
+  const i64 realloc_size_total = (i64) mydivc64 ((const u64) new_long_cnt, (const u64) realloc_step) * realloc_step;
+
+  if (brain_server_db_hash_shard->long_mapped == true)
+  {
+    // the mapping is read-only, the first change moves the shard to the heap
+
+    brain_server_hash_long_t *long_buf = (brain_server_hash_long_t *) hcmalloc ((brain_server_db_hash_shard->long_alloc + realloc_size_total) * sizeof (brain_server_hash_long_t));
+
+    if (long_buf == NULL) return false;
+
+    memcpy (long_buf, brain_server_db_hash_shard->long_buf, brain_server_db_hash_shard->long_cnt * sizeof (brain_server_hash_long_t));
+
+    brain_server_db_hash_shard->long_buf     = long_buf;
+    brain_server_db_hash_shard->long_alloc  += realloc_size_total;
+    brain_server_db_hash_shard->long_mapped  = false;
+
+    return true;
+  }
+
+  brain_server_hash_long_t *long_buf = (brain_server_hash_long_t *) hcrealloc (brain_server_db_hash_shard->long_buf, brain_server_db_hash_shard->long_alloc * sizeof (brain_server_hash_long_t), realloc_size_total * sizeof (brain_server_hash_long_t));
+
+  if (long_buf == NULL) return false;
+
+  brain_server_db_hash_shard->long_buf    = long_buf;
+  brain_server_db_hash_shard->long_alloc += realloc_size_total;
+
+  return true;
+}
+
+void brain_server_db_hash_free (brain_server_db_hash_t *brain_server_db_hash)
+{
+  for (int shard_idx = 0; shard_idx < BRAIN_SERVER_HASH_SHARDS; shard_idx++)
+  {
+    brain_server_db_hash_shard_t *brain_server_db_hash_shard = &brain_server_db_hash->shards[shard_idx];
+
+    hc_thread_mutex_delete (brain_server_db_hash_shard->mux_hg);
+    hc_thread_mutex_delete (brain_server_db_hash_shard->mux_hr);
+
+    if (brain_server_db_hash_shard->long_mapped == false) hcfree (brain_server_db_hash_shard->long_buf);
+  }
+
+  hcfree (brain_server_db_hash->shards);
+
+  #if defined (_POSIX)
+  if (brain_server_db_hash->map_buf) munmap (brain_server_db_hash->map_buf, brain_server_db_hash->map_len);
+  #endif
+
+  hcfree (brain_server_db_hash->journal_buf);
+
+  hc_thread_mutex_delete (brain_server_db_hash->mux_hj);
+
+  brain_server_db_hash->shards           = NULL;
+  brain_server_db_hash->long_cnt         = 0;
+  brain_server_db_hash->map_buf          = NULL;
+  brain_server_db_hash->map_len          = 0;
+  brain_server_db_hash->journal_cnt      = 0;
+  brain_server_db_hash->journal_buf      = NULL;
+  brain_server_db_hash->journal_alloc    = 0;
+  brain_server_db_hash->journal_file_cnt = 0;
+  brain_server_db_hash->journal_compact  = false;
+  brain_server_db_hash->write_hashes     = false;
+  brain_server_db_hash->brain_session    = 0;
+}
+
+// lookups and dumps only read a shard, any number of them can do that at the same time, but not while a commit writes to it
+
+void brain_server_db_hash_shard_lock_read (brain_server_db_hash_shard_t *brain_server_db_hash_shard)
+{
+  hc_thread_mutex_lock (brain_server_db_hash_shard->mux_hr);
+
+  brain_server_db_hash_shard->hb++;
+
+  if (brain_server_db_hash_shard->hb == 1)
+  {
+    hc_thread_mutex_lock (brain_server_db_hash_shard->mux_hg);
+  }
+
+  hc_thread_mutex_unlock (brain_server_db_hash_shard->mux_hr);
+}
+
+void brain_server_db_hash_shard_unlock_read (brain_server_db_hash_shard_t *brain_server_db_hash_shard)
+{
+  hc_thread_mutex_lock (brain_server_db_hash_shard->mux_hr);
+
+  brain_server_db_hash_shard->hb--;
+
+  if (brain_server_db_hash_shard->hb == 0)
+  {
+    hc_thread_mutex_unlock (brain_server_db_hash_shard->mux_hg);
+  }
+
+  hc_thread_mutex_unlock (brain_server_db_hash_shard->mux_hr);
+}
+
+/**
+ * Merges sorted and unique hashes into a shard.
+ * The merge runs backwards from the end of the grown buffer so it needs no second buffer.
+ * The hashes which were actually new are copied to added_buf, if given.
+ * Returns the number of new hashes or -1 if we ran out of memory.
+ */
+
+i64 brain_server_db_hash_shard_merge (brain_server_db_hash_shard_t *brain_server_db_hash_shard, const brain_server_hash_long_t *new_buf, const i64 new_cnt, brain_server_hash_long_t *added_buf)
+{
+  if (new_cnt == 0) return 0;
+
+  if (brain_server_db_hash_shard_realloc (brain_server_db_hash_shard, new_cnt) == false) return -1;
+
+  if (brain_server_db_hash_shard->long_cnt == 0)
+  {
+    memcpy (brain_server_db_hash_shard->long_buf, new_buf, new_cnt * sizeof (brain_server_hash_long_t));
+
+    if (added_buf) memcpy (added_buf, new_buf, new_cnt * sizeof (brain_server_hash_long_t));
+
+    brain_server_db_hash_shard->long_cnt = new_cnt;
+
+    return new_cnt;
+  }
+
+  const i64 cnt_total = brain_server_db_hash_shard->long_cnt + new_cnt;
+
+  i64 long_left  = brain_server_db_hash_shard->long_cnt - 1;
+  i64 short_left = new_cnt - 1;
+  i64 long_dupes = 0;
+
+  i64 added_cnt = 0;
+
+  for (i64 idx = cnt_total - 1; idx >= long_dupes; idx--)
+  {
+    const brain_server_hash_long_t *long_entry  = &brain_server_db_hash_shard->long_buf[long_left];
+    const brain_server_hash_long_t *short_entry = &new_buf[short_left];
+
+    int rc = 0;
+
+    if ((long_left >= 0) && (short_left >= 0))
+    {
+      rc = brain_server_sort_hash (long_entry->hash, short_entry->hash);
+    }
+    else if (long_left >= 0)
+    {
+      // without dupes the rest of the long entries is in place already
+
+      if (long_dupes == 0) break;
+
+      rc = 1;
+    }
+    else if (short_left >= 0)
+    {
+      rc = -1;
+    }
+    else
+    {
+      brain_logging (stderr, 0, "unexpected remaining buffers in compare: %" PRIi64 " - %" PRIi64 "\n", long_left, short_left);
+    }
+
+    brain_server_hash_long_t *next = &brain_server_db_hash_shard->long_buf[idx];
+
+    if (rc == -1)
+    {
+      next->hash[0] = short_entry->hash[0];
+      next->hash[1] = short_entry->hash[1];
+
+      if (added_buf)
+      {
+        added_buf[added_cnt].hash[0] = short_entry->hash[0];
+        added_buf[added_cnt].hash[1] = short_entry->hash[1];
+      }
+
+      added_cnt++;
+
+      short_left--;
+    }
+    else if (rc == 1)
+    {
+      next->hash[0] = long_entry->hash[0];
+      next->hash[1] = long_entry->hash[1];
+
+      long_left--;
+    }
+    else
+    {
+      next->hash[0] = long_entry->hash[0];
+      next->hash[1] = long_entry->hash[1];
+
+      short_left--;
+      long_left--;
+
+      long_dupes++;
+    }
+  }
+
+  if (short_left != -1)
+  {
+    brain_logging (stderr, 0, "unexpected remaining buffers in commit: %" PRIi64 " - %" PRIi64 "\n", long_left, short_left);
+  }
+
+  brain_server_db_hash_shard->long_cnt = cnt_total - long_dupes;
+
+  if (long_dupes)
+  {
+    memmove (brain_server_db_hash_shard->long_buf, brain_server_db_hash_shard->long_buf + long_dupes, brain_server_db_hash_shard->long_cnt * sizeof (brain_server_hash_long_t));
+  }
+
+  return added_cnt;
+}
+
+/**
+ * Merges sorted and unique hashes into the long-term memory, one shard at a time.
+ * Returns the number of new hashes, those are also copied to added_buf if given.
+ */
+
+i64 brain_server_db_hash_merge (brain_server_db_hash_t *brain_server_db_hash, const brain_server_hash_long_t *new_buf, const i64 new_cnt, brain_server_hash_long_t *added_buf)
+{
+  i64 added_cnt = 0;
+
+  for (i64 seg_beg = 0, seg_end = 0; seg_beg < new_cnt; seg_beg = seg_end)
+  {
+    const u32 shard_idx = brain_server_hash_shard (new_buf[seg_beg].hash);
+
+    for (seg_end = seg_beg + 1; seg_end < new_cnt; seg_end++)
+    {
+      if (brain_server_hash_shard (new_buf[seg_end].hash) != shard_idx) break;
+    }
+
+    brain_server_db_hash_shard_t *brain_server_db_hash_shard = &brain_server_db_hash->shards[shard_idx];
+
+    hc_thread_mutex_lock (brain_server_db_hash_shard->mux_hg);
+
+    const i64 rc = brain_server_db_hash_shard_merge (brain_server_db_hash_shard, new_buf + seg_beg, seg_end - seg_beg, (added_buf) ? added_buf + added_cnt : NULL);
+
+    hc_thread_mutex_unlock (brain_server_db_hash_shard->mux_hg);
+
+    if (rc == -1)
+    {
+      brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
+
+      continue;
+    }
+
+    added_cnt += rc;
+  }
+
+  return added_cnt;
+}
+
+static void brain_server_db_hash_journal_drop (brain_server_db_hash_t *brain_server_db_hash)
+{
+  // the next dump is a full rewrite, there is no need to keep collecting
+
+  brain_server_db_hash->journal_compact = true;
+
+  hcfree (brain_server_db_hash->journal_buf);
+
+  brain_server_db_hash->journal_buf   = NULL;
+  brain_server_db_hash->journal_alloc = 0;
+  brain_server_db_hash->journal_cnt   = 0;
+}
+
+/**
+ * Accounts for the hashes a commit added.
+ * With journal set they are also kept for the journal,
+ * unless the journal has grown so large that the next dump is a full rewrite anyway.
+ */
+
+void brain_server_db_hash_journal (brain_server_db_hash_t *brain_server_db_hash, const brain_server_hash_long_t *added_buf, const i64 added_cnt, const bool journal)
+{
+  if (added_cnt == 0) return;
+
+  hc_thread_mutex_lock (brain_server_db_hash->mux_hj);
+
+  brain_server_db_hash->long_cnt += added_cnt;
+
+  brain_server_db_hash->write_hashes = true;
+
+  if ((journal == true) && (brain_server_db_hash->journal_compact == false))
+  {
+    const i64 journal_total = brain_server_db_hash->journal_file_cnt + brain_server_db_hash->journal_cnt + added_cnt;
+
+    if ((journal_total * BRAIN_SERVER_JOURNAL_RATIO) >= brain_server_db_hash->long_cnt)
+    {
+      brain_server_db_hash_journal_drop (brain_server_db_hash);
+    }
+    else
+    {
+      if ((brain_server_db_hash->journal_cnt + added_cnt) > brain_server_db_hash->journal_alloc)
+      {
+        const i64 realloc_size_total = (i64) mydivc64 ((const u64) added_cnt, (const u64) BRAIN_SERVER_REALLOC_HASH_SIZE) * BRAIN_SERVER_REALLOC_HASH_SIZE;
+
+        brain_server_hash_long_t *journal_buf = (brain_server_hash_long_t *) hcrealloc (brain_server_db_hash->journal_buf, brain_server_db_hash->journal_alloc * sizeof (brain_server_hash_long_t), realloc_size_total * sizeof (brain_server_hash_long_t));
+
+        if (journal_buf == NULL)
+        {
+          brain_server_db_hash_journal_drop (brain_server_db_hash);
+        }
+        else
+        {
+          brain_server_db_hash->journal_buf    = journal_buf;
+          brain_server_db_hash->journal_alloc += realloc_size_total;
+        }
+      }
+
+      if (brain_server_db_hash->journal_compact == false)
+      {
+        memcpy (brain_server_db_hash->journal_buf + brain_server_db_hash->journal_cnt, added_buf, added_cnt * sizeof (brain_server_hash_long_t));
+
+        brain_server_db_hash->journal_cnt += added_cnt;
+      }
+    }
+  }
+
+  hc_thread_mutex_unlock (brain_server_db_hash->mux_hj);
+}
+
+void brain_server_db_attack_init (brain_server_db_attack_t *brain_server_db_attack, const u32 brain_attack)
+{
+  brain_server_db_attack->brain_attack = brain_attack;
+
+  brain_server_db_attack->ab            = 0;
+  brain_server_db_attack->short_cnt     = 0;
+  brain_server_db_attack->short_buf     = NULL;
+  brain_server_db_attack->short_alloc   = 0;
+  brain_server_db_attack->long_cnt      = 0;
+  brain_server_db_attack->long_buf      = NULL;
+  brain_server_db_attack->long_alloc    = 0;
+  brain_server_db_attack->write_attacks = false;
+
+  brain_server_db_attack->journal_cnt      = 0;
+  brain_server_db_attack->journal_buf      = NULL;
+  brain_server_db_attack->journal_alloc    = 0;
+  brain_server_db_attack->journal_file_cnt = 0;
+  brain_server_db_attack->journal_compact  = false;
+
+  hc_thread_mutex_init (brain_server_db_attack->mux_ar);
+  hc_thread_mutex_init (brain_server_db_attack->mux_ag);
+}
+
+bool brain_server_db_attack_realloc (brain_server_db_attack_t *brain_server_db_attack, const i64 new_long_cnt, const i64 new_short_cnt)
+{
+  if ((brain_server_db_attack->long_cnt + new_long_cnt) > brain_server_db_attack->long_alloc)
+  {
+    const i64 realloc_size_total = (i64) mydivc64 ((const u64) new_long_cnt, (const u64) BRAIN_SERVER_REALLOC_ATTACK_SIZE) * BRAIN_SERVER_REALLOC_ATTACK_SIZE;
+
+    brain_server_attack_long_t *long_buf = (brain_server_attack_long_t *) hcrealloc (brain_server_db_attack->long_buf, brain_server_db_attack->long_alloc * sizeof (brain_server_attack_long_t), realloc_size_total * sizeof (brain_server_attack_long_t));
+
+    if (long_buf == NULL) return false;
+
+    brain_server_db_attack->long_buf    = long_buf;
+    brain_server_db_attack->long_alloc += realloc_size_total;
+  }
+
+  if ((brain_server_db_attack->short_cnt + new_short_cnt) > brain_server_db_attack->short_alloc)
+  {
+    const i64 realloc_size_total = (i64) mydivc64 ((const u64) new_short_cnt, (const u64) BRAIN_SERVER_REALLOC_ATTACK_SIZE) * BRAIN_SERVER_REALLOC_ATTACK_SIZE;
+
+    brain_server_attack_short_t *short_buf = (brain_server_attack_short_t *) hcrealloc (brain_server_db_attack->short_buf, brain_server_db_attack->short_alloc * sizeof (brain_server_attack_short_t), realloc_size_total * sizeof (brain_server_attack_short_t));
+
+    if (short_buf == NULL) return false;
+
+    brain_server_db_attack->short_buf    = short_buf;
+    brain_server_db_attack->short_alloc += realloc_size_total;
+  }
+
+  return true;
+}
+
+void brain_server_db_attack_free (brain_server_db_attack_t *brain_server_db_attack)
+{
+  hc_thread_mutex_delete (brain_server_db_attack->mux_ag);
+  hc_thread_mutex_delete (brain_server_db_attack->mux_ar);
+
+  hcfree (brain_server_db_attack->long_buf);
+  hcfree (brain_server_db_attack->short_buf);
+  hcfree (brain_server_db_attack->journal_buf);
+
+  brain_server_db_attack->journal_cnt      = 0;
+  brain_server_db_attack->journal_buf      = NULL;
+  brain_server_db_attack->journal_alloc    = 0;
+  brain_server_db_attack->journal_file_cnt = 0;
+  brain_server_db_attack->journal_compact  = false;
+
+  brain_server_db_attack->ab            = 0;
+  brain_server_db_attack->long_cnt      = 0;
+  brain_server_db_attack->long_buf      = NULL;
+  brain_server_db_attack->long_alloc    = 0;
+  brain_server_db_attack->short_cnt     = 0;
+  brain_server_db_attack->short_buf     = NULL;
+  brain_server_db_attack->short_alloc   = 0;
+  brain_server_db_attack->brain_attack  = 0;
+  brain_server_db_attack->write_attacks = false;
+}
+
+void brain_server_db_attack_journal (brain_server_db_attack_t *brain_server_db_attack, const brain_server_attack_long_t *entry)
+{
+  if (brain_server_db_attack->journal_compact == true) return;
+
+  const i64 journal_total = brain_server_db_attack->journal_file_cnt + brain_server_db_attack->journal_cnt + 1;
+
+  if ((journal_total * BRAIN_SERVER_JOURNAL_RATIO) >= brain_server_db_attack->long_cnt)
+  {
+    brain_server_db_attack->journal_compact = true;
+  }
+  else if (brain_server_db_attack->journal_cnt == brain_server_db_attack->journal_alloc)
+  {
+    brain_server_attack_long_t *journal_buf = (brain_server_attack_long_t *) hcrealloc (brain_server_db_attack->journal_buf, brain_server_db_attack->journal_alloc * sizeof (brain_server_attack_long_t), BRAIN_SERVER_REALLOC_ATTACK_SIZE * sizeof (brain_server_attack_long_t));
+
+    if (journal_buf == NULL)
+    {
+      brain_server_db_attack->journal_compact = true;
+    }
+    else
+    {
+      brain_server_db_attack->journal_buf    = journal_buf;
+      brain_server_db_attack->journal_alloc += BRAIN_SERVER_REALLOC_ATTACK_SIZE;
+    }
+  }
+
+  if (brain_server_db_attack->journal_compact == true)
+  {
+    hcfree (brain_server_db_attack->journal_buf);
+
+    brain_server_db_attack->journal_buf   = NULL;
+    brain_server_db_attack->journal_alloc = 0;
+    brain_server_db_attack->journal_cnt   = 0;
+
+    return;
+  }
+
+  brain_server_db_attack->journal_buf[brain_server_db_attack->journal_cnt] = *entry;
+
+  brain_server_db_attack->journal_cnt++;
+}
+
+/**
+ * Attack memory
+ *
+ * The long-term memory holds the finished ranges of an attack. They are kept sorted, disjoint and coalesced:
+ * a commit which touches or overlaps existing ranges is merged with them, so a single range usually covers
+ * everything from 0 up to the current position and the array only grows with the number of gaps.
+ * Any point is covered by at most one range, which is found with a binary search.
+ * The short-term memory holds the ranges the clients have reserved but not yet finished. Those are sorted by offset,
+ * can overlap (two clients can hold reservations which intersect) and are removed again on commit or disconnect,
+ * so there are never more of them than there are outstanding reservations.
+ */
+
+static i64 brain_server_attack_long_idx (const brain_server_attack_long_t *buf, const i64 cnt, const u64 offset)
+{
+  // index of the first range which ends after offset
+
+  i64 l = 0;
+  i64 r = cnt;
+
+  while (l < r)
+  {
+    const i64 m = l + ((r - l) / 2);
+
+    if ((buf[m].offset + buf[m].length) <= offset)
+    {
+      l = m + 1;
+    }
+    else
+    {
+      r = m;
+    }
+  }
+
+  return l;
+}
+
+u64 brain_server_highest_attack (const brain_server_db_attack_t *buf)
+{
+  const brain_server_attack_long_t  *long_buf  = buf->long_buf;
+  const brain_server_attack_short_t *short_buf = buf->short_buf;
+
+  const u64 long_cnt  = buf->long_cnt;
+  const u64 short_cnt = buf->short_cnt;
+
+  // finished and reserved ranges can take turns, so we repeat until neither of them gets us any further
+
+  u64 highest = 0;
+
+  while (true)
+  {
+    u64 next = highest;
+
+    next = brain_server_highest_attack_long  (long_buf,  long_cnt,  next);
+    next = brain_server_highest_attack_short (short_buf, short_cnt, next);
+
+    if (next == highest) break;
+
+    highest = next;
+  }
+
+  return highest;
+}
+
+u64 brain_server_highest_attack_long (const brain_server_attack_long_t *buf, const i64 cnt, const u64 start)
+{
+  const i64 idx = brain_server_attack_long_idx (buf, cnt, start);
+
+  if (idx == cnt) return start;
+
+  if (buf[idx].offset > start) return start;
+
+  return buf[idx].offset + buf[idx].length;
+}
+
+u64 brain_server_highest_attack_short (const brain_server_attack_short_t *buf, const i64 cnt, const u64 start)
+{
+  u64 highest = start;
+
+  for (i64 idx = 0; idx < cnt; idx++)
+  {
+    const u64 offset = buf[idx].offset;
+    const u64 length = buf[idx].length;
+
+    if (offset > highest) break;
+
+    const u64 next = offset + length;
+
+    highest = MAX (highest, next);
+  }
+
+  return highest;
+}
+
+u64 brain_server_find_attack_long (const brain_server_attack_long_t *buf, const i64 cnt, const u64 offset, const u64 length)
+{
+  if (length == 0) return 0;
+
+  const i64 idx = brain_server_attack_long_idx (buf, cnt, offset);
+
+  if (idx == cnt) return 0;
+
+  const u64 element_start = buf[idx].offset;
+  const u64 element_end   = element_start + buf[idx].length;
+
+  if (element_start > offset) return 0;
+
+  // coalesced, the next range can't continue where this one ends
+
+  return MIN (offset + length, element_end) - offset;
+}
+
+u64 brain_server_find_attack (const brain_server_db_attack_t *buf, const u64 offset, const u64 length)
+{
+  // same as with the highest position, a range can be covered partly by reservations and partly by finished ranges
+
+  u64 overlap = 0;
+
+  while (overlap < length)
+  {
+    u64 found = 0;
+
+    found += brain_server_find_attack_short (buf->short_buf, buf->short_cnt, offset + overlap,         length - overlap);
+    found += brain_server_find_attack_long  (buf->long_buf,  buf->long_cnt,  offset + overlap + found, length - overlap - found);
+
+    if (found == 0) break;
+
+    overlap += found;
+  }
+
+  return overlap;
+}
+
+u64 brain_server_find_attack_short (const brain_server_attack_short_t *buf, const i64 cnt, const u64 offset, const u64 length)
+{
+  const u64 end = offset + length;
+
+  u64 overlap = 0;
+
+  for (i64 idx = 0; idx < cnt; idx++)
+  {
+    const u64 element_length = buf[idx].length;
+
+    if (element_length == 0) continue;
+
+    const u64 element_start = buf[idx].offset;
+    const u64 element_end   = element_start + element_length;
+
+    const u64 start = offset + overlap;
+
+    if (element_start > start) break; // we can't ever do it since this list is sorted
+
+    if (element_end > start)
+    {
+      const u64 limited_end = MIN (end, element_end);
+
+      overlap += limited_end - start;
+
+      if (overlap == length) break;
+    }
+  }
+
+  return overlap;
+}
+
+bool brain_server_db_attack_reserve (brain_server_db_attack_t *brain_server_db_attack, const u64 offset, const u64 length, const int client_idx, const u32 batch)
+{
+  if (brain_server_db_attack_realloc (brain_server_db_attack, 0, 1) == false) return false;
+
+  brain_server_attack_short_t *short_buf = brain_server_db_attack->short_buf;
+
+  const i64 short_cnt = brain_server_db_attack->short_cnt;
+
+  // insert behind all reservations with a lower or equal offset, this keeps the array sorted
+
+  i64 l = 0;
+  i64 r = short_cnt;
+
+  while (l < r)
+  {
+    const i64 m = l + ((r - l) / 2);
+
+    if (short_buf[m].offset <= offset)
+    {
+      l = m + 1;
+    }
+    else
+    {
+      r = m;
+    }
+  }
+
+  memmove (short_buf + l + 1, short_buf + l, (short_cnt - l) * sizeof (brain_server_attack_short_t));
+
+  short_buf[l].offset     = offset;
+  short_buf[l].length     = length;
+  short_buf[l].client_idx = client_idx;
+  short_buf[l].batch      = batch;
+
+  brain_server_db_attack->short_cnt++;
+
+  return true;
+}
+
+bool brain_server_db_attack_insert (brain_server_db_attack_t *brain_server_db_attack, const u64 offset, const u64 length)
+{
+  if (length == 0) return true;
+
+  if (brain_server_db_attack_realloc (brain_server_db_attack, 1, 0) == false) return false;
+
+  brain_server_attack_long_t *long_buf = brain_server_db_attack->long_buf;
+
+  const i64 long_cnt = brain_server_db_attack->long_cnt;
+
+  u64 start = offset;
+  u64 end   = offset + length;
+
+  // all ranges from lo to hi touch or overlap the new one and are replaced by a single range
+
+  i64 lo = (offset == 0) ? 0 : brain_server_attack_long_idx (long_buf, long_cnt, offset - 1);
+  i64 hi = lo;
+
+  while ((hi < long_cnt) && (long_buf[hi].offset <= end))
+  {
+    start = MIN (start, long_buf[hi].offset);
+    end   = MAX (end,   long_buf[hi].offset + long_buf[hi].length);
+
+    hi++;
+  }
+
+  if (hi == lo)
+  {
+    memmove (long_buf + lo + 1, long_buf + lo, (long_cnt - lo) * sizeof (brain_server_attack_long_t));
+
+    brain_server_db_attack->long_cnt++;
+  }
+  else if ((hi - lo) > 1)
+  {
+    memmove (long_buf + lo + 1, long_buf + hi, (long_cnt - hi) * sizeof (brain_server_attack_long_t));
+
+    brain_server_db_attack->long_cnt -= hi - lo - 1;
+  }
+
+  long_buf[lo].offset = start;
+  long_buf[lo].length = end - start;
+
+  return true;
+}
+
+void brain_server_db_attack_coalesce (brain_server_db_attack_t *brain_server_db_attack)
+{
+  brain_server_attack_long_t *long_buf = brain_server_db_attack->long_buf;
+
+  const i64 long_cnt = brain_server_db_attack->long_cnt;
+
+  if (long_cnt == 0) return;
+
+  qsort (long_buf, long_cnt, sizeof (brain_server_attack_long_t), brain_server_sort_attack_long);
+
+  i64 cnt = 0;
+
+  for (i64 idx = 0; idx < long_cnt; idx++)
+  {
+    if (long_buf[idx].length == 0) continue;
+
+    if (cnt > 0)
+    {
+      brain_server_attack_long_t *prev = &long_buf[cnt - 1];
+
+      const u64 prev_end = prev->offset + prev->length;
+
+      if (long_buf[idx].offset <= prev_end)
+      {
+        prev->length = MAX (prev_end, long_buf[idx].offset + long_buf[idx].length) - prev->offset;
+
+        continue;
+      }
+    }
+
+    long_buf[cnt] = long_buf[idx];
+
+    cnt++;
+  }
+
+  brain_server_db_attack->long_cnt = cnt;
+}
+
+// a pipelining client has reservations of more than one batch, only those of the committed batch are done
+
+i64 brain_server_db_attack_commit (brain_server_db_attack_t *brain_server_db_attack, const int client_idx, const u32 batch, const bool journal)
+{
+  brain_server_attack_short_t *short_buf = brain_server_db_attack->short_buf;
+
+  i64 new_attacks = 0;
+
+  i64 short_cnt = 0;
+
+  for (i64 idx = 0; idx < brain_server_db_attack->short_cnt; idx++)
+  {
+    if ((short_buf[idx].client_idx != client_idx) || (short_buf[idx].batch != batch))
+    {
+      short_buf[short_cnt] = short_buf[idx];
+
+      short_cnt++;
+
+      continue;
+    }
+
+    if (brain_server_db_attack_insert (brain_server_db_attack, short_buf[idx].offset, short_buf[idx].length) == true)
+    {
+      if (journal == true)
+      {
+        brain_server_attack_long_t entry;
+
+        entry.offset = short_buf[idx].offset;
+        entry.length = short_buf[idx].length;
+
+        brain_server_db_attack_journal (brain_server_db_attack, &entry);
+      }
+    }
+    else
+    {
+      brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
+    }
+
+    new_attacks++;
+  }
+
+  brain_server_db_attack->short_cnt = short_cnt;
+
+  return new_attacks;
+}
+
+void brain_server_db_attack_release (brain_server_db_attack_t *brain_server_db_attack, const int client_idx)
+{
+  brain_server_attack_short_t *short_buf = brain_server_db_attack->short_buf;
+
+  i64 short_cnt = 0;
+
+  for (i64 idx = 0; idx < brain_server_db_attack->short_cnt; idx++)
+  {
+    if (short_buf[idx].client_idx == client_idx) continue;
+
+    short_buf[short_cnt] = short_buf[idx];
+
+    short_cnt++;
+  }
+
+  brain_server_db_attack->short_cnt = short_cnt;
+}
+
+int brain_server_sort_db_hash (const void *v1, const void *v2)
+{
+  const brain_server_db_hash_t *d1 = (const brain_server_db_hash_t *) v1;
+  const brain_server_db_hash_t *d2 = (const brain_server_db_hash_t *) v2;
+
+  if (d1->brain_session > d2->brain_session) return  1;
+  if (d1->brain_session < d2->brain_session) return -1;
+
+  return 0;
+}
+
+int brain_server_sort_db_attack (const void *v1, const void *v2)
+{
+  const brain_server_db_attack_t *d1 = (const brain_server_db_attack_t *) v1;
+  const brain_server_db_attack_t *d2 = (const brain_server_db_attack_t *) v2;
+
+  if (d1->brain_attack > d2->brain_attack) return  1;
+  if (d1->brain_attack < d2->brain_attack) return -1;
+
+  return 0;
+}
+
+int brain_server_sort_hash (const void *v1, const void *v2)
+{
+  const u32 *d1 = (const u32 *) v1;
+  const u32 *d2 = (const u32 *) v2;
+
+  if (d1[1] > d2[1]) return  1;
+  if (d1[1] < d2[1]) return -1;
+  if (d1[0] > d2[0]) return  1;
+  if (d1[0] < d2[0]) return -1;
+
+  return 0;
+}
+
+int brain_server_sort_attack_long (const void *v1, const void *v2)
+{
+  const brain_server_attack_long_t *d1 = (const brain_server_attack_long_t *) v1;
+  const brain_server_attack_long_t *d2 = (const brain_server_attack_long_t *) v2;
+
+  if (d1->offset > d2->offset) return  1;
+  if (d1->offset < d2->offset) return -1;
+
+  return 0;
+}
+
+int brain_server_sort_attack_short (const void *v1, const void *v2)
+{
+  const brain_server_attack_short_t *d1 = (const brain_server_attack_short_t *) v1;
+  const brain_server_attack_short_t *d2 = (const brain_server_attack_short_t *) v2;
+
+  if (d1->offset > d2->offset) return  1;
+  if (d1->offset < d2->offset) return -1;
+
+  return 0;
+}
+
+int brain_server_sort_hash_long (const void *v1, const void *v2)
+{
+  const brain_server_hash_long_t *d1 = (const brain_server_hash_long_t *) v1;
+  const brain_server_hash_long_t *d2 = (const brain_server_hash_long_t *) v2;
+
+  return brain_server_sort_hash (d1->hash, d2->hash);
+}
+
+int brain_server_sort_hash_short (const void *v1, const void *v2)
+{
+  const brain_server_hash_short_t *d1 = (const brain_server_hash_short_t *) v1;
+  const brain_server_hash_short_t *d2 = (const brain_server_hash_short_t *) v2;
+
+  return brain_server_sort_hash (d1->hash, d2->hash);
+}
+
+int brain_server_sort_hash_unique (const void *v1, const void *v2)
+{
+  const brain_server_hash_unique_t *d1 = (const brain_server_hash_unique_t *) v1;
+  const brain_server_hash_unique_t *d2 = (const brain_server_hash_unique_t *) v2;
+
+  return brain_server_sort_hash (d1->hash, d2->hash);
+}
+
+/**
+ * Persistence
+ *
+ * The long-term memory of a session or an attack is stored in a dump (.ldmp/.admp) and a journal (.ljrn/.ajrn).
+ * A commit keeps the entries it actually added and the cyclic dump only appends those to the journal.
+ * Once the journal holds 1/BRAIN_SERVER_JOURNAL_RATIO of all entries, the dump is rewritten instead and the journal removed.
+ * A new dump is written to a temporary file first, so a crash leaves either the old or the new dump next to the journal.
+ * On startup the journal is replayed on top of the dump. Replaying is idempotent, entries which are in both are merged.
+ * Hash dumps are sorted already and are mapped read-only, lookups then only page in what the binary search touches.
+ * Each shard points to its slice of the mapping until the first commit to that shard moves it to the heap.
+ */
+
+void brain_server_journal_file (char *journal_file, const size_t journal_size, const char *dump_file)
+{
+  // brain.XXXXXXXX.ldmp -> brain.XXXXXXXX.ljrn, brain.XXXXXXXX.admp -> brain.XXXXXXXX.ajrn
+
+  snprintf (journal_file, journal_size, "%s", dump_file);
+
+  const size_t len = strlen (journal_file);
+
+  if (len < 3) return;
+
+  memcpy (journal_file + len - 3, "jrn", 3);
+}
+
+bool brain_server_read_hash_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
+{
+  brain_server_dbs->hash_cnt = 0;
+
+  /* temporary disabled due to https://github.com/hashcat/hashcat/issues/2379
+  if (chdir (path) == -1)
+  {
+    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
+
+    return false;
+  }
+  */
+
+  DIR *dirp = opendir (path);
+
+  if (dirp == NULL)
+  {
+    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
+
+    return false;
+  }
+
+  struct dirent *entry;
+
+  while ((entry = readdir (dirp)) != NULL)
+  {
+    char *file = entry->d_name;
+
+    const size_t len = strlen (file);
+
+    if (len != 19) continue;
+
+    if (file[ 0] != 'b') continue;
+    if (file[ 1] != 'r') continue;
+    if (file[ 2] != 'a') continue;
     if (file[ 3] != 'i') continue;
     if (file[ 4] != 'n') continue;
     if (file[ 5] != '.') continue;
 
-    if (file[14] != '.') continue;
-    if (file[15] != 'l') continue;
-    if (file[16] != 'd') continue;
-    if (file[17] != 'm') continue;
-    if (file[18] != 'p') continue;
+    if (file[14] != '.') continue;
+    if (file[15] != 'l') continue;
+
+    // a session can have a dump, a journal or both
+
+    const bool is_dump    = (file[16] == 'd') && (file[17] == 'm') && (file[18] == 'p');
+    const bool is_journal = (file[16] == 'j') && (file[17] == 'r') && (file[18] == 'n');
+
+    if ((is_dump == false) && (is_journal == false)) continue;
+
+    const u32 brain_session = byte_swap_32 (hex_to_u32 ((const u8 *) file + 6));
+
+    bool known = false;
+
+    for (int idx = 0; idx < brain_server_dbs->hash_cnt; idx++)
+    {
+      if (brain_server_dbs->hash_buf[idx].brain_session == brain_session) known = true;
+    }
+
+    if (known == true) continue;
+
+    char dump_file[100];
+
+    memset (dump_file, 0, sizeof (dump_file));
+
+    snprintf (dump_file, sizeof (dump_file), "%s/brain.%08x.ldmp", path, brain_session);
+
+    brain_server_db_hash_t *brain_server_db_hash = &brain_server_dbs->hash_buf[brain_server_dbs->hash_cnt];
+
+    brain_server_db_hash_init (brain_server_db_hash, brain_session);
+
+    if (brain_server_read_hash_dump (brain_server_db_hash, dump_file) == false) continue;
+
+    brain_server_dbs->hash_cnt++;
+  }
+
+  closedir (dirp);
+
+  return true;
+}
+
+bool brain_server_write_hash_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
+{
+  for (i64 idx = 0; idx < brain_server_dbs->hash_cnt; idx++)
+  {
+    brain_server_db_hash_t *brain_server_db_hash = &brain_server_dbs->hash_buf[idx];
+
+    char file[100];
+
+    memset (file, 0, sizeof (file));
+
+    snprintf (file, sizeof (file), "%s/brain.%08x.ldmp", path, brain_server_db_hash->brain_session);
+
+    hc_thread_mutex_lock (brain_server_db_hash->mux_hj);
+
+    if (brain_server_db_hash->write_hashes == false)
+    {
+      hc_thread_mutex_unlock (brain_server_db_hash->mux_hj);
+
+      continue;
+    }
+
+    if ((brain_server_dbs->journal == false) || (brain_server_db_hash->journal_compact == true))
+    {
+      // everything committed so far is in the shards, whatever is committed from now on goes to the next journal
+
+      brain_server_db_hash->journal_cnt     = 0;
+      brain_server_db_hash->journal_compact = false;
+      brain_server_db_hash->write_hashes    = false;
+
+      hc_thread_mutex_unlock (brain_server_db_hash->mux_hj);
+
+      if (brain_server_write_hash_dump (brain_server_db_hash, file) == false)
+      {
+        hc_thread_mutex_lock (brain_server_db_hash->mux_hj);
+
+        brain_server_db_hash_journal_drop (brain_server_db_hash);
+
+        brain_server_db_hash->write_hashes = true;
+
+        hc_thread_mutex_unlock (brain_server_db_hash->mux_hj);
+      }
+    }
+    else
+    {
+      char journal_file[100];
+
+      brain_server_journal_file (journal_file, sizeof (journal_file), file);
+
+      brain_server_write_hash_journal (brain_server_db_hash, journal_file);
+
+      hc_thread_mutex_unlock (brain_server_db_hash->mux_hj);
+    }
+  }
+
+  return true;
+}
+
+bool brain_server_read_hash_dump (brain_server_db_hash_t *brain_server_db_hash, const char *file)
+{
+  hc_timer_t timer_dump;
+
+  hc_timer_set (&timer_dump);
+
+  // read from file, a session which was never compacted has no dump but a journal
+
+  struct stat sb;
+
+  memset (&sb, 0, sizeof (struct stat));
+
+  if (stat (file, &sb) == -1)
+  {
+    if (errno != ENOENT)
+    {
+      brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
+
+      return false;
+    }
+
+    memset (&sb, 0, sizeof (struct stat));
+  }
+
+  const i64 temp_cnt = (u64) sb.st_size / sizeof (brain_server_hash_long_t);
+
+  if (temp_cnt > 0)
+  {
+    #if defined (_POSIX)
+    const int fd = open (file, O_RDONLY);
+
+    if (fd != -1)
+    {
+      const size_t map_len = (size_t) temp_cnt * sizeof (brain_server_hash_long_t);
+
+      void *map_buf = mmap (NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      close (fd);
+
+      if (map_buf != MAP_FAILED)
+      {
+        madvise (map_buf, map_len, MADV_RANDOM);
+
+        brain_server_db_hash->map_buf = map_buf;
+        brain_server_db_hash->map_len = map_len;
+      }
+    }
+    #endif
+
+    if (brain_server_db_hash->map_buf)
+    {
+      // the dump is sorted, each shard is a slice of it and a binary search finds where the next one starts
+
+      brain_server_hash_long_t *long_buf = (brain_server_hash_long_t *) brain_server_db_hash->map_buf;
+
+      i64 shard_beg = 0;
+
+      for (int shard_idx = 0; shard_idx < BRAIN_SERVER_HASH_SHARDS; shard_idx++)
+      {
+        i64 l = shard_beg;
+        i64 r = temp_cnt;
+
+        while (l < r)
+        {
+          const i64 m = l + ((r - l) / 2);
+
+          if ((int) brain_server_hash_shard (long_buf[m].hash) <= shard_idx)
+          {
+            l = m + 1;
+          }
+          else
+          {
+            r = m;
+          }
+        }
+
+        const i64 shard_end = l;
+
+        if (shard_end > shard_beg)
+        {
+          brain_server_db_hash_shard_t *brain_server_db_hash_shard = &brain_server_db_hash->shards[shard_idx];
+
+          brain_server_db_hash_shard->long_buf    = long_buf + shard_beg;
+          brain_server_db_hash_shard->long_alloc  = shard_end - shard_beg;
+          brain_server_db_hash_shard->long_cnt    = shard_end - shard_beg;
+          brain_server_db_hash_shard->long_mapped = true;
+        }
+
+        shard_beg = shard_end;
+      }
+    }
+    else
+    {
+      HCFILE fp;
+
+      if (hc_fopen (&fp, file, "rb") == false)
+      {
+        brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
+
+        return false;
+      }
+
+      const i64 chunk_cnt = BRAIN_SERVER_REALLOC_HASH_SIZE;
+
+      brain_server_hash_long_t *chunk_buf = (brain_server_hash_long_t *) hccalloc (chunk_cnt, sizeof (brain_server_hash_long_t));
+
+      if (chunk_buf == NULL)
+      {
+        brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
+
+        hc_fclose (&fp);
+
+        return false;
+      }
+
+      for (i64 done_cnt = 0; done_cnt < temp_cnt; )
+      {
+        const i64 read_cnt = MIN (chunk_cnt, temp_cnt - done_cnt);
+
+        const size_t nread = hc_fread (chunk_buf, sizeof (brain_server_hash_long_t), read_cnt, &fp);
+
+        if (nread != (size_t) read_cnt)
+        {
+          brain_logging (stderr, 0, "%s: only %" PRIu64 " bytes read\n", file, (u64) (done_cnt + nread) * sizeof (brain_server_hash_long_t));
+
+          hcfree (chunk_buf);
+
+          hc_fclose (&fp);
+
+          return false;
+        }
+
+        // sorted, so the merge only appends
+
+        brain_server_db_hash_merge (brain_server_db_hash, chunk_buf, read_cnt, NULL);
+
+        done_cnt += read_cnt;
+      }
+
+      hcfree (chunk_buf);
+
+      hc_fclose (&fp);
+    }
+  }
+
+  brain_server_db_hash->long_cnt = temp_cnt;
+
+  // replay the journal on top
+
+  char journal_file[100];
+
+  brain_server_journal_file (journal_file, sizeof (journal_file), file);
+
+  if (brain_server_read_hash_journal (brain_server_db_hash, journal_file) == false) return false;
+
+  brain_server_db_hash->write_hashes = false;
+
+  const double ms = hc_timer_get (timer_dump);
+
+  const u64 bytes = (u64) sb.st_size + (u64) brain_server_db_hash->journal_file_cnt * sizeof (brain_server_hash_long_t);
+
+  brain_logging (stdout, 0, "Read %" PRIu64 " bytes from session 0x%08x in %.2f ms\n", bytes, brain_server_db_hash->brain_session, ms);
+
+  return true;
+}
+
+bool brain_server_write_hash_dump (brain_server_db_hash_t *brain_server_db_hash, const char *file)
+{
+  hc_timer_t timer_dump;
+
+  hc_timer_set (&timer_dump);
+
+  // write to a temporary file, the old dump stays valid until the new one is complete
 
-    const u32 brain_session = byte_swap_32 (hex_to_u32 ((const u8 *) file + 6));
+  char tmp_file[110];
 
-    brain_server_db_hash_t *brain_server_db_hash = &brain_server_dbs->hash_buf[brain_server_dbs->hash_cnt];
+  memset (tmp_file, 0, sizeof (tmp_file));
 
-    brain_server_db_hash_init (brain_server_db_hash, brain_session);
+  snprintf (tmp_file, sizeof (tmp_file), "%s.tmp", file);
 
-    if (brain_server_read_hash_dump (brain_server_db_hash, file) == false) continue;
+  HCFILE fp;
 
-    brain_server_dbs->hash_cnt++;
+  if (hc_fopen (&fp, tmp_file, "wb") == false)
+  {
+    brain_logging (stderr, 0, "%s: %s\n", tmp_file, strerror (errno));
+
+    return false;
   }
 
-  closedir (dirp);
+  // one shard at a time, commits to the other shards go on meanwhile
 
-  return true;
-}
+  for (int shard_idx = 0; shard_idx < BRAIN_SERVER_HASH_SHARDS; shard_idx++)
+  {
+    brain_server_db_hash_shard_t *brain_server_db_hash_shard = &brain_server_db_hash->shards[shard_idx];
 
-bool brain_server_write_hash_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
-{
-  for (i64 idx = 0; idx < brain_server_dbs->hash_cnt; idx++)
+    brain_server_db_hash_shard_lock_read (brain_server_db_hash_shard);
+
+    const size_t nwrite = hc_fwrite (brain_server_db_hash_shard->long_buf, sizeof (brain_server_hash_long_t), brain_server_db_hash_shard->long_cnt, &fp);
+
+    const bool ok = (nwrite == (size_t) brain_server_db_hash_shard->long_cnt);
+
+    brain_server_db_hash_shard_unlock_read (brain_server_db_hash_shard);
+
+    if (ok == false)
+    {
+      brain_logging (stderr, 0, "%s: %s\n", tmp_file, strerror (errno));
+
+      hc_fclose (&fp);
+
+      unlink (tmp_file);
+
+      return false;
+    }
+  }
+
+  hc_fclose (&fp);
+
+  if (rename (tmp_file, file) != 0)
   {
-    brain_server_db_hash_t *brain_server_db_hash = &brain_server_dbs->hash_buf[idx];
+    // rename () does not replace an existing file on windows
 
-    hc_thread_mutex_lock (brain_server_db_hash->mux_hg);
+    unlink (file);
 
-    char file[100];
+    if (rename (tmp_file, file) != 0)
+    {
+      brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
-    memset (file, 0, sizeof (file));
+      unlink (tmp_file);
 
-    snprintf (file, sizeof (file), "%s/brain.%08x.ldmp", path, brain_server_db_hash->brain_session);
+      return false;
+    }
+  }
+
+  // everything in the journal is part of the dump now
+
+  char journal_file[100];
+
+  brain_server_journal_file (journal_file, sizeof (journal_file), file);
+
+  unlink (journal_file);
+
+  hc_thread_mutex_lock (brain_server_db_hash->mux_hj);
+
+  brain_server_db_hash->journal_file_cnt = 0;
+
+  hc_thread_mutex_unlock (brain_server_db_hash->mux_hj);
+
+  // stats
+
+  const double ms = hc_timer_get (timer_dump);
+
+  struct stat sb;
+
+  memset (&sb, 0, sizeof (struct stat));
 
-    brain_server_write_hash_dump (brain_server_db_hash, file);
+  if (stat (file, &sb) == -1)
+  {
+    brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
-    hc_thread_mutex_unlock (brain_server_db_hash->mux_hg);
+    return false;
   }
 
+  brain_logging (stdout, 0, "Wrote %" PRIu64 " bytes from session 0x%08x in %.2f ms\n", (u64) sb.st_size, brain_server_db_hash->brain_session, ms);
+
   return true;
 }
 
-bool brain_server_read_hash_dump (brain_server_db_hash_t *brain_server_db_hash, const char *file)
+bool brain_server_read_hash_journal (brain_server_db_hash_t *brain_server_db_hash, const char *file)
 {
-  hc_timer_t timer_dump;
-
-  hc_timer_set (&timer_dump);
-
-  // read from file
-
   struct stat sb;
 
   memset (&sb, 0, sizeof (struct stat));
 
   if (stat (file, &sb) == -1)
   {
+    if (errno == ENOENT) return true;
+
     brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
     return false;
   }
 
+  // a partial entry at the end is from an interrupted append
+
+  const i64 temp_cnt = (u64) sb.st_size / sizeof (brain_server_hash_long_t);
+
+  if (temp_cnt == 0) return true;
+
   HCFILE fp;
 
   if (hc_fopen (&fp, file, "rb") == false)
@@ -1647,9 +3136,9 @@ bool brain_server_read_hash_dump (brain_server_db_hash_t *brain_server_db_hash,
     return false;
   }
 
-  i64 temp_cnt = (u64) sb.st_size / sizeof (brain_server_hash_long_t);
+  brain_server_hash_long_t *temp_buf = (brain_server_hash_long_t *) hccalloc (temp_cnt, sizeof (brain_server_hash_long_t));
 
-  if (brain_server_db_hash_realloc (brain_server_db_hash, temp_cnt) == false)
+  if (temp_buf == NULL)
   {
     brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
 
@@ -1658,66 +3147,211 @@ bool brain_server_read_hash_dump (brain_server_db_hash_t *brain_server_db_hash,
     return false;
   }
 
-  const size_t nread = hc_fread (brain_server_db_hash->long_buf, sizeof (brain_server_hash_long_t), temp_cnt, &fp);
+  const size_t nread = hc_fread (temp_buf, sizeof (brain_server_hash_long_t), temp_cnt, &fp);
+
+  hc_fclose (&fp);
 
   if (nread != (size_t) temp_cnt)
   {
     brain_logging (stderr, 0, "%s: only %" PRIu64 " bytes read\n", file, (u64) nread * sizeof (brain_server_hash_long_t));
 
-    hc_fclose (&fp);
+    hcfree (temp_buf);
 
     return false;
   }
 
-  brain_server_db_hash->long_cnt     = temp_cnt;
-  brain_server_db_hash->write_hashes = false;
+  // each append is one commit cycle, so the journal as a whole is neither sorted nor unique
 
-  hc_fclose (&fp);
+  qsort (temp_buf, temp_cnt, sizeof (brain_server_hash_long_t), brain_server_sort_hash_long);
 
-  const double ms = hc_timer_get (timer_dump);
+  i64 unique_cnt = 1;
+
+  for (i64 idx = 1; idx < temp_cnt; idx++)
+  {
+    if (brain_server_sort_hash_long (&temp_buf[unique_cnt - 1], &temp_buf[idx]) == 0) continue;
+
+    temp_buf[unique_cnt] = temp_buf[idx];
+
+    unique_cnt++;
+  }
+
+  brain_server_db_hash->long_cnt += brain_server_db_hash_merge (brain_server_db_hash, temp_buf, unique_cnt, NULL);
+
+  hcfree (temp_buf);
 
-  brain_logging (stdout, 0, "Read %" PRIu64 " bytes from session 0x%08x in %.2f ms\n", (u64) sb.st_size, brain_server_db_hash->brain_session, ms);
+  brain_server_db_hash->journal_file_cnt = temp_cnt;
 
   return true;
 }
 
-bool brain_server_write_hash_dump (brain_server_db_hash_t *brain_server_db_hash, const char *file)
+bool brain_server_write_hash_journal (brain_server_db_hash_t *brain_server_db_hash, const char *file)
 {
   if (brain_server_db_hash->write_hashes == false) return true;
 
+  if (brain_server_db_hash->journal_cnt == 0)
+  {
+    brain_server_db_hash->write_hashes = false;
+
+    return true;
+  }
+
   hc_timer_t timer_dump;
 
   hc_timer_set (&timer_dump);
 
-  // write to file
-
   HCFILE fp;
 
-  if (hc_fopen (&fp, file, "wb") == false)
+  if (hc_fopen (&fp, file, "ab") == false)
   {
     brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
     return false;
   }
 
-  const size_t nwrite = hc_fwrite (brain_server_db_hash->long_buf, sizeof (brain_server_hash_long_t), brain_server_db_hash->long_cnt, &fp);
+  const size_t nwrite = hc_fwrite (brain_server_db_hash->journal_buf, sizeof (brain_server_hash_long_t), brain_server_db_hash->journal_cnt, &fp);
+
+  hc_fclose (&fp);
 
-  if (nwrite != (size_t) brain_server_db_hash->long_cnt)
+  if (nwrite != (size_t) brain_server_db_hash->journal_cnt)
   {
     brain_logging (stderr, 0, "%s: only %" PRIu64 " bytes written\n", file, (u64) nwrite * sizeof (brain_server_hash_long_t));
 
-    hc_fclose (&fp);
+    return false;
+  }
+
+  const u64 bytes = (u64) brain_server_db_hash->journal_cnt * sizeof (brain_server_hash_long_t);
+
+  brain_server_db_hash->journal_file_cnt += brain_server_db_hash->journal_cnt;
+  brain_server_db_hash->journal_cnt       = 0;
+  brain_server_db_hash->write_hashes      = false;
+
+  const double ms = hc_timer_get (timer_dump);
+
+  brain_logging (stdout, 0, "Appended %" PRIu64 " bytes from session 0x%08x in %.2f ms\n", bytes, brain_server_db_hash->brain_session, ms);
+
+  return true;
+}
+
+bool brain_server_read_attack_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
+{
+  brain_server_dbs->attack_cnt = 0;
+
+  /* temporary disabled due to https://github.com/hashcat/hashcat/issues/2379
+  if (chdir (path) == -1)
+  {
+    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
 
     return false;
   }
+  */
 
-  hc_fclose (&fp);
+  DIR *dirp = opendir (path);
 
-  brain_server_db_hash->write_hashes = false;
+  if (dirp == NULL)
+  {
+    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
 
-  // stats
+    return false;
+  }
 
-  const double ms = hc_timer_get (timer_dump);
+  struct dirent *entry = NULL;
+
+  while ((entry = readdir (dirp)) != NULL)
+  {
+    char *file = entry->d_name;
+
+    const size_t len = strlen (file);
+
+    if (len != 19) continue;
+
+    if (file[ 0] != 'b') continue;
+    if (file[ 1] != 'r') continue;
+    if (file[ 2] != 'a') continue;
+    if (file[ 3] != 'i') continue;
+    if (file[ 4] != 'n') continue;
+    if (file[ 5] != '.') continue;
+
+    if (file[14] != '.') continue;
+    if (file[15] != 'a') continue;
+
+    // an attack can have a dump, a journal or both
+
+    const bool is_dump    = (file[16] == 'd') && (file[17] == 'm') && (file[18] == 'p');
+    const bool is_journal = (file[16] == 'j') && (file[17] == 'r') && (file[18] == 'n');
+
+    if ((is_dump == false) && (is_journal == false)) continue;
+
+    const u32 brain_attack = byte_swap_32 (hex_to_u32 ((const u8 *) file + 6));
+
+    bool known = false;
+
+    for (int idx = 0; idx < brain_server_dbs->attack_cnt; idx++)
+    {
+      if (brain_server_dbs->attack_buf[idx].brain_attack == brain_attack) known = true;
+    }
+
+    if (known == true) continue;
+
+    char dump_file[100];
+
+    memset (dump_file, 0, sizeof (dump_file));
+
+    snprintf (dump_file, sizeof (dump_file), "%s/brain.%08x.admp", path, brain_attack);
+
+    brain_server_db_attack_t *brain_server_db_attack = &brain_server_dbs->attack_buf[brain_server_dbs->attack_cnt];
+
+    brain_server_db_attack_init (brain_server_db_attack, brain_attack);
+
+    if (brain_server_read_attack_dump (brain_server_db_attack, dump_file) == false) continue;
+
+    brain_server_dbs->attack_cnt++;
+  }
+
+  closedir (dirp);
+
+  return true;
+}
+
+bool brain_server_write_attack_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
+{
+  for (i64 idx = 0; idx < brain_server_dbs->attack_cnt; idx++)
+  {
+    brain_server_db_attack_t *brain_server_db_attack = &brain_server_dbs->attack_buf[idx];
+
+    hc_thread_mutex_lock (brain_server_db_attack->mux_ag);
+
+    char file[100];
+
+    memset (file, 0, sizeof (file));
+
+    snprintf (file, sizeof (file), "%s/brain.%08x.admp", path, brain_server_db_attack->brain_attack);
+
+    if ((brain_server_dbs->journal == false) || (brain_server_db_attack->journal_compact == true))
+    {
+      brain_server_write_attack_dump (brain_server_db_attack, file);
+    }
+    else
+    {
+      char journal_file[100];
+
+      brain_server_journal_file (journal_file, sizeof (journal_file), file);
+
+      brain_server_write_attack_journal (brain_server_db_attack, journal_file);
+    }
+
+    hc_thread_mutex_unlock (brain_server_db_attack->mux_ag);
+  }
+
+  return true;
+}
+
+bool brain_server_read_attack_dump (brain_server_db_attack_t *brain_server_db_attack, const char *file)
+{
+  hc_timer_t timer_dump;
+
+  hc_timer_set (&timer_dump);
+
+  // read from file, an attack which was never compacted has no dump but a journal
 
   struct stat sb;
 
@@ -1725,118 +3359,189 @@ bool brain_server_write_hash_dump (brain_server_db_hash_t *brain_server_db_hash,
 
   if (stat (file, &sb) == -1)
   {
-    brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
+    if (errno != ENOENT)
+    {
+      brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
-    return false;
+      return false;
+    }
+
+    memset (&sb, 0, sizeof (struct stat));
   }
 
-  brain_logging (stdout, 0, "Wrote %" PRIu64 " bytes from session 0x%08x in %.2f ms\n", (u64) sb.st_size, brain_server_db_hash->brain_session, ms);
+  i64 temp_cnt = (u64) sb.st_size / sizeof (brain_server_attack_long_t);
+
+  if (temp_cnt > 0)
+  {
+    HCFILE fp;
+
+    if (hc_fopen (&fp, file, "rb") == false)
+    {
+      brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
+
+      return false;
+    }
+
+    if (brain_server_db_attack_realloc (brain_server_db_attack, temp_cnt, 0) == false)
+    {
+      brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
+
+      hc_fclose (&fp);
+
+      return false;
+    }
+
+    const size_t nread = hc_fread (brain_server_db_attack->long_buf, sizeof (brain_server_attack_long_t), temp_cnt, &fp);
+
+    if (nread != (size_t) temp_cnt)
+    {
+      brain_logging (stderr, 0, "%s: only %" PRIu64 " bytes read\n", file, (u64) nread * sizeof (brain_server_attack_long_t));
+
+      hc_fclose (&fp);
+
+      return false;
+    }
+
+    hc_fclose (&fp);
+  }
+
+  brain_server_db_attack->long_cnt = temp_cnt;
+
+  // replay the journal on top
+
+  char journal_file[100];
+
+  brain_server_journal_file (journal_file, sizeof (journal_file), file);
+
+  if (brain_server_read_attack_journal (brain_server_db_attack, journal_file) == false) return false;
+
+  // dumps of older versions are not coalesced and the journal is in commit order
+
+  brain_server_db_attack_coalesce (brain_server_db_attack);
+
+  brain_server_db_attack->write_attacks = false;
+
+  const double ms = hc_timer_get (timer_dump);
+
+  const u64 bytes = (u64) sb.st_size + (u64) brain_server_db_attack->journal_file_cnt * sizeof (brain_server_attack_long_t);
+
+  brain_logging (stdout, 0, "Read %" PRIu64 " bytes from attack 0x%08x in %.2f ms\n", bytes, brain_server_db_attack->brain_attack, ms);
 
   return true;
 }
 
-bool brain_server_read_attack_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
+bool brain_server_write_attack_dump (brain_server_db_attack_t *brain_server_db_attack, const char *file)
 {
-  brain_server_dbs->attack_cnt = 0;
+  if (brain_server_db_attack->write_attacks == false) return true;
 
-  /* temporary disabled due to https://github.com/hashcat/hashcat/issues/2379
-  if (chdir (path) == -1)
-  {
-    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
+  hc_timer_t timer_dump;
+
+  hc_timer_set (&timer_dump);
+
+  // write to a temporary file, the old dump stays valid until the new one is complete
 
-    return false;
-  }
-  */
+  char tmp_file[110];
 
-  DIR *dirp = opendir (path);
+  memset (tmp_file, 0, sizeof (tmp_file));
 
-  if (dirp == NULL)
+  snprintf (tmp_file, sizeof (tmp_file), "%s.tmp", file);
+
+  HCFILE fp;
+
+  if (hc_fopen (&fp, tmp_file, "wb") == false)
   {
-    brain_logging (stderr, 0, "%s: %s\n", path, strerror (errno));
+    brain_logging (stderr, 0, "%s: %s\n", tmp_file, strerror (errno));
 
     return false;
   }
 
-  struct dirent *entry = NULL;
+  // storing should not include reserved attacks only finished
 
-  while ((entry = readdir (dirp)) != NULL)
+  const size_t nwrite = hc_fwrite (brain_server_db_attack->long_buf, sizeof (brain_server_attack_long_t), brain_server_db_attack->long_cnt, &fp);
+
+  if (nwrite != (size_t) brain_server_db_attack->long_cnt)
   {
-    char *file = entry->d_name;
+    brain_logging (stderr, 0, "%s: only %" PRIu64 " bytes written\n", tmp_file, (u64) nwrite * sizeof (brain_server_attack_long_t));
 
-    const size_t len = strlen (file);
+    hc_fclose (&fp);
 
-    if (len != 19) continue;
+    unlink (tmp_file);
 
-    if (file[ 0] != 'b') continue;
-    if (file[ 1] != 'r') continue;
-    if (file[ 2] != 'a') continue;
-    if (file[ 3] != 'i') continue;
-    if (file[ 4] != 'n') continue;
-    if (file[ 5] != '.') continue;
+    return false;
+  }
 
-    if (file[14] != '.') continue;
-    if (file[15] != 'a') continue;
-    if (file[16] != 'd') continue;
-    if (file[17] != 'm') continue;
-    if (file[18] != 'p') continue;
+  hc_fclose (&fp);
 
-    const u32 brain_attack = byte_swap_32 (hex_to_u32 ((const u8 *) file + 6));
+  if (rename (tmp_file, file) != 0)
+  {
+    // rename () does not replace an existing file on windows
 
-    brain_server_db_attack_t *brain_server_db_attack = &brain_server_dbs->attack_buf[brain_server_dbs->attack_cnt];
+    unlink (file);
 
-    brain_server_db_attack_init (brain_server_db_attack, brain_attack);
+    if (rename (tmp_file, file) != 0)
+    {
+      brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
-    if (brain_server_read_attack_dump (brain_server_db_attack, file) == false) continue;
+      unlink (tmp_file);
 
-    brain_server_dbs->attack_cnt++;
+      return false;
+    }
   }
 
-  closedir (dirp);
+  // everything in the journal is part of the dump now
 
-  return true;
-}
+  char journal_file[100];
 
-bool brain_server_write_attack_dumps (brain_server_dbs_t *brain_server_dbs, const char *path)
-{
-  for (i64 idx = 0; idx < brain_server_dbs->attack_cnt; idx++)
-  {
-    brain_server_db_attack_t *brain_server_db_attack = &brain_server_dbs->attack_buf[idx];
+  brain_server_journal_file (journal_file, sizeof (journal_file), file);
 
-    hc_thread_mutex_lock (brain_server_db_attack->mux_ag);
+  unlink (journal_file);
 
-    char file[100];
+  brain_server_db_attack->journal_cnt      = 0;
+  brain_server_db_attack->journal_file_cnt = 0;
+  brain_server_db_attack->journal_compact  = false;
+  brain_server_db_attack->write_attacks    = false;
 
-    memset (file, 0, sizeof (file));
+  // stats
 
-    snprintf (file, sizeof (file), "%s/brain.%08x.admp", path, brain_server_db_attack->brain_attack);
+  const double ms = hc_timer_get (timer_dump);
+
+  struct stat sb;
 
-    brain_server_write_attack_dump (brain_server_db_attack, file);
+  memset (&sb, 0, sizeof (struct stat));
 
-    hc_thread_mutex_unlock (brain_server_db_attack->mux_ag);
+  if (stat (file, &sb) == -1)
+  {
+    brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
+
+    return false;
   }
 
+  brain_logging (stdout, 0, "Wrote %" PRIu64 " bytes from attack 0x%08x in %.2f ms\n", (u64) sb.st_size, brain_server_db_attack->brain_attack, ms);
+
   return true;
 }
 
-bool brain_server_read_attack_dump (brain_server_db_attack_t *brain_server_db_attack, const char *file)
+bool brain_server_read_attack_journal (brain_server_db_attack_t *brain_server_db_attack, const char *file)
 {
-  hc_timer_t timer_dump;
-
-  hc_timer_set (&timer_dump);
-
-  // read from file
-
   struct stat sb;
 
   memset (&sb, 0, sizeof (struct stat));
 
   if (stat (file, &sb) == -1)
   {
+    if (errno == ENOENT) return true;
+
     brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
     return false;
   }
 
+  // a partial entry at the end is from an interrupted append
+
+  const i64 temp_cnt = (u64) sb.st_size / sizeof (brain_server_attack_long_t);
+
+  if (temp_cnt == 0) return true;
+
   HCFILE fp;
 
   if (hc_fopen (&fp, file, "rb") == false)
@@ -1846,8 +3551,6 @@ bool brain_server_read_attack_dump (brain_server_db_attack_t *brain_server_db_at
     return false;
   }
 
-  i64 temp_cnt = (u64) sb.st_size / sizeof (brain_server_attack_long_t);
-
   if (brain_server_db_attack_realloc (brain_server_db_attack, temp_cnt, 0) == false)
   {
     brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
@@ -1857,81 +3560,69 @@ bool brain_server_read_attack_dump (brain_server_db_attack_t *brain_server_db_at
     return false;
   }
 
-  const size_t nread = hc_fread (brain_server_db_attack->long_buf, sizeof (brain_server_attack_long_t), temp_cnt, &fp);
+  const size_t nread = hc_fread (brain_server_db_attack->long_buf + brain_server_db_attack->long_cnt, sizeof (brain_server_attack_long_t), temp_cnt, &fp);
+
+  hc_fclose (&fp);
 
   if (nread != (size_t) temp_cnt)
   {
     brain_logging (stderr, 0, "%s: only %" PRIu64 " bytes read\n", file, (u64) nread * sizeof (brain_server_attack_long_t));
 
-    hc_fclose (&fp);
-
     return false;
   }
 
-  brain_server_db_attack->long_cnt      = temp_cnt;
-  brain_server_db_attack->write_attacks = false;
-
-  hc_fclose (&fp);
-
-  const double ms = hc_timer_get (timer_dump);
+  // ranges which made it into the dump before the journal was removed show up twice, that's fine for the coalesce
 
-  brain_logging (stdout, 0, "Read %" PRIu64 " bytes from attack 0x%08x in %.2f ms\n", (u64) sb.st_size, brain_server_db_attack->brain_attack, ms);
+  brain_server_db_attack->long_cnt        += temp_cnt;
+  brain_server_db_attack->journal_file_cnt = temp_cnt;
 
   return true;
 }
 
-bool brain_server_write_attack_dump (brain_server_db_attack_t *brain_server_db_attack, const char *file)
+bool brain_server_write_attack_journal (brain_server_db_attack_t *brain_server_db_attack, const char *file)
 {
   if (brain_server_db_attack->write_attacks == false) return true;
 
+  if (brain_server_db_attack->journal_cnt == 0)
+  {
+    brain_server_db_attack->write_attacks = false;
+
+    return true;
+  }
+
   hc_timer_t timer_dump;
 
   hc_timer_set (&timer_dump);
 
-  // write to file
-
   HCFILE fp;
 
-  if (hc_fopen (&fp, file, "wb") == false)
+  if (hc_fopen (&fp, file, "ab") == false)
   {
     brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
 
     return false;
   }
 
-  // storing should not include reserved attacks only finished
+  const size_t nwrite = hc_fwrite (brain_server_db_attack->journal_buf, sizeof (brain_server_attack_long_t), brain_server_db_attack->journal_cnt, &fp);
 
-  const size_t nwrite = hc_fwrite (brain_server_db_attack->long_buf, sizeof (brain_server_attack_long_t), brain_server_db_attack->long_cnt, &fp);
+  hc_fclose (&fp);
 
-  if (nwrite != (size_t) brain_server_db_attack->long_cnt)
+  if (nwrite != (size_t) brain_server_db_attack->journal_cnt)
   {
     brain_logging (stderr, 0, "%s: only %" PRIu64 " bytes written\n", file, (u64) nwrite * sizeof (brain_server_attack_long_t));
 
-    hc_fclose (&fp);
-
     return false;
   }
 
-  hc_fclose (&fp);
-
-  brain_server_db_attack->write_attacks = false;
+  const u64 bytes = (u64) brain_server_db_attack->journal_cnt * sizeof (brain_server_attack_long_t);
 
-  // stats
+  brain_server_db_attack->journal_file_cnt += brain_server_db_attack->journal_cnt;
+  brain_server_db_attack->journal_cnt       = 0;
+  brain_server_db_attack->write_attacks     = false;
 
   const double ms = hc_timer_get (timer_dump);
 
-  struct stat sb;
-
-  memset (&sb, 0, sizeof (struct stat));
-
-  if (stat (file, &sb) == -1)
-  {
-    brain_logging (stderr, 0, "%s: %s\n", file, strerror (errno));
-
-    return false;
-  }
-
-  brain_logging (stdout, 0, "Wrote %" PRIu64 " bytes from attack 0x%08x in %.2f ms\n", (u64) sb.st_size, brain_server_db_attack->brain_attack, ms);
+  brain_logging (stdout, 0, "Appended %" PRIu64 " bytes from attack 0x%08x in %.2f ms\n", bytes, brain_server_db_attack->brain_attack, ms);
 
   return true;
 }
@@ -2079,7 +3770,9 @@ HC_API_CALL void *brain_server_handle_client (void *p)
     return NULL;
   }
 
-  u32 brain_link_version_ok = (brain_link_version >= (u32) BRAIN_LINK_VERSION_MIN) ? 1 : 0;
+  // older clients only check for non-zero, newer ones learn what we support
+
+  u32 brain_link_version_ok = (brain_link_version >= (u32) BRAIN_LINK_VERSION_MIN) ? BRAIN_LINK_VERSION_CUR : 0;
 
   if (brain_send (client_fd, &brain_link_version_ok, sizeof (brain_link_version_ok), 0, NULL, NULL) == false)
   {
@@ -2347,7 +4040,7 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
   const size_t send_size = passwords_max * sizeof (char);
 
-  u8 *send_buf = (u8  *) hcmalloc (send_size); // we can reduce this to 1/8 if we use bits instead of bytes
+  u8 *send_buf = (u8  *) hcmalloc (send_size); // packed lookups are answered with bits, from the same buffer
 
   if (send_buf == NULL)
   {
@@ -2375,9 +4068,36 @@ HC_API_CALL void *brain_server_handle_client (void *p)
     return NULL;
   }
 
+  // hashes a commit actually added, for the journal
+
+  brain_server_hash_long_t *added_buf = (brain_server_hash_long_t *) hccalloc (passwords_max, sizeof (brain_server_hash_long_t));
+
+  if (added_buf == NULL)
+  {
+    brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
+
+    brain_server_dbs->client_slots[client_idx] = 0;
+
+    close (client_fd);
+
+    return NULL;
+  }
+
   // short global alloc
+  // a pipelining client seals a batch before it commits the previous one, so there is one slot for the batch
+  // it currently looks up and one for each sealed batch waiting for its commit, the slots are used as a ring.
+  // the sealed ones are only allocated once the client actually seals a batch
+
+  const int short_slots = 1 + BRAIN_LINK_PIPELINE_DEPTH;
+
+  brain_server_db_short_t *brain_server_db_shorts = (brain_server_db_short_t *) hccalloc (short_slots, sizeof (brain_server_db_short_t));
+
+  int short_head   = 0; // oldest sealed batch
+  int short_sealed = 0;
+
+  u32 batch_open = 0; // attack reservations are tagged with the batch they belong to
 
-  brain_server_db_short_t *brain_server_db_short = (brain_server_db_short_t *) hcmalloc (sizeof (brain_server_db_short_t));
+  brain_server_db_short_t *brain_server_db_short = &brain_server_db_shorts[0];
 
   brain_server_db_short->short_cnt = 0;
   brain_server_db_short->short_buf = (brain_server_hash_short_t *) hccalloc (passwords_max, sizeof (brain_server_hash_short_t));
@@ -2414,6 +4134,7 @@ HC_API_CALL void *brain_server_handle_client (void *p)
     // U = update
     // R = request
     // C = commit
+    // S = seal
 
     /**
      * L = lookup
@@ -2489,22 +4210,13 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
       hc_thread_mutex_lock (brain_server_db_attack->mux_ag);
 
-      u64 overlap = 0;
-
-      overlap += brain_server_find_attack_short (brain_server_db_attack->short_buf, brain_server_db_attack->short_cnt, offset, length);
-      overlap += brain_server_find_attack_long  (brain_server_db_attack->long_buf,  brain_server_db_attack->long_cnt,  offset + overlap, length - overlap);
+      u64 overlap = brain_server_find_attack (brain_server_db_attack, offset, length);
 
       if (overlap < length)
       {
-        if (brain_server_db_attack_realloc (brain_server_db_attack, 0, 1) == true)
+        if (brain_server_db_attack_reserve (brain_server_db_attack, offset + overlap, length - overlap, client_idx, batch_open) == false)
         {
-          brain_server_db_attack->short_buf[brain_server_db_attack->short_cnt].offset     = offset + overlap;
-          brain_server_db_attack->short_buf[brain_server_db_attack->short_cnt].length     = length - overlap;
-          brain_server_db_attack->short_buf[brain_server_db_attack->short_cnt].client_idx = client_idx;
-
-          brain_server_db_attack->short_cnt++;
-
-          qsort (brain_server_db_attack->short_buf, brain_server_db_attack->short_cnt, sizeof (brain_server_attack_short_t), brain_server_sort_attack_short);
+          brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
         }
       }
 
@@ -2516,44 +4228,64 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
       brain_logging (stdout, client_idx, "R | %8.2f ms | Offset: %" PRIu64 ", Length: %" PRIu64 ", Overlap: %" PRIu64 "\n", ms, offset, length, overlap);
     }
-    else if (operation == BRAIN_OPERATION_COMMIT)
+    else if (operation == BRAIN_OPERATION_SEAL)
     {
-      // time the lookups for debugging
-
-      hc_timer_t timer_commit;
+      // the lookups and reservations so far form a batch, the following ones belong to the next batch
 
-      hc_timer_set (&timer_commit);
+      if (short_sealed == BRAIN_LINK_PIPELINE_DEPTH)
+      {
+        brain_logging (stderr, client_idx, "Too many sealed batches\n");
 
-      hc_thread_mutex_lock (brain_server_db_attack->mux_ag);
+        break;
+      }
 
-      i64 new_attacks = 0;
+      brain_server_db_short_t *brain_server_db_short_next = &brain_server_db_shorts[(short_head + short_sealed + 1) % short_slots];
 
-      for (i64 idx = 0; idx < brain_server_db_attack->short_cnt; idx++)
+      if (brain_server_db_short_next->short_buf == NULL)
       {
-        if (brain_server_db_attack->short_buf[idx].client_idx == client_idx)
+        brain_server_db_short_next->short_buf = (brain_server_hash_short_t *) hccalloc (passwords_max, sizeof (brain_server_hash_short_t));
+
+        if (brain_server_db_short_next->short_buf == NULL)
         {
-          if (brain_server_db_attack_realloc (brain_server_db_attack, 1, 0) == true)
-          {
-            brain_server_db_attack->long_buf[brain_server_db_attack->long_cnt].offset = brain_server_db_attack->short_buf[idx].offset;
-            brain_server_db_attack->long_buf[brain_server_db_attack->long_cnt].length = brain_server_db_attack->short_buf[idx].length;
+          brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
 
-            brain_server_db_attack->long_cnt++;
+          break;
+        }
+      }
 
-            qsort (brain_server_db_attack->long_buf, brain_server_db_attack->long_cnt, sizeof (brain_server_attack_long_t), brain_server_sort_attack_long);
-          }
-          else
-          {
-            brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
-          }
+      brain_server_db_short_next->short_cnt = 0;
 
-          brain_server_db_attack->short_buf[idx].offset     = 0;
-          brain_server_db_attack->short_buf[idx].length     = 0;
-          brain_server_db_attack->short_buf[idx].client_idx = 0;
+      brain_server_db_short = brain_server_db_short_next;
 
-          new_attacks++;
-        }
+      short_sealed++;
+
+      batch_open++;
+    }
+    else if (operation == BRAIN_OPERATION_COMMIT)
+    {
+      // a pipelining client commits its oldest sealed batch, all others the only batch they have
+
+      brain_server_db_short_t *brain_server_db_commit = brain_server_db_short;
+
+      u32 batch_commit = batch_open;
+
+      if (short_sealed > 0)
+      {
+        brain_server_db_commit = &brain_server_db_shorts[short_head];
+
+        batch_commit = batch_open - short_sealed;
       }
 
+      // time the lookups for debugging
+
+      hc_timer_t timer_commit;
+
+      hc_timer_set (&timer_commit);
+
+      hc_thread_mutex_lock (brain_server_db_attack->mux_ag);
+
+      const i64 new_attacks = brain_server_db_attack_commit (brain_server_db_attack, client_idx, batch_commit, brain_server_dbs->journal);
+
       brain_server_db_attack->write_attacks = true;
 
       hc_thread_mutex_unlock (brain_server_db_attack->mux_ag);
@@ -2569,122 +4301,37 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
       hc_timer_set (&timer_commit);
 
-      hc_thread_mutex_lock (brain_server_db_hash->mux_hg);
-
-      // long-term memory merge
+      // long-term memory merge, the shards lock themselves
 
-      if (brain_server_db_short->short_cnt)
+      if (brain_server_db_commit->short_cnt)
       {
-        if (brain_server_db_hash_realloc (brain_server_db_hash, brain_server_db_short->short_cnt) == true)
-        {
-          if (brain_server_db_hash->long_cnt == 0)
-          {
-            for (i64 idx = 0; idx < brain_server_db_short->short_cnt; idx++)
-            {
-              brain_server_db_hash->long_buf[idx].hash[0] = brain_server_db_short->short_buf[idx].hash[0];
-              brain_server_db_hash->long_buf[idx].hash[1] = brain_server_db_short->short_buf[idx].hash[1];
-            }
-
-            brain_server_db_hash->long_cnt = brain_server_db_short->short_cnt;
-          }
-          else
-          {
-            const i64 cnt_total = brain_server_db_hash->long_cnt + brain_server_db_short->short_cnt;
-
-            i64 long_left  = brain_server_db_hash->long_cnt - 1;
-            i64 short_left = brain_server_db_short->short_cnt - 1;
-            i64 long_dupes = 0;
-
-            for (i64 idx = cnt_total - 1; idx >= long_dupes; idx--)
-            {
-              const brain_server_hash_long_t  *long_entry  = &brain_server_db_hash->long_buf[long_left];
-              const brain_server_hash_short_t *short_entry = &brain_server_db_short->short_buf[short_left];
-
-              int rc = 0;
-
-              if ((long_left >= 0) && (short_left >= 0))
-              {
-                rc = brain_server_sort_hash (long_entry->hash, short_entry->hash);
-              }
-              else if (long_left >= 0)
-              {
-                rc = 1;
-              }
-              else if (short_left >= 0)
-              {
-                rc = -1;
-              }
-              else
-              {
-                brain_logging (stderr, client_idx, "unexpected remaining buffers in compare: %" PRIi64 " - %" PRIi64 "\n", long_left, short_left);
-              }
-
-              brain_server_hash_long_t *next = &brain_server_db_hash->long_buf[idx];
-
-              if (rc == -1)
-              {
-                next->hash[0] = short_entry->hash[0];
-                next->hash[1] = short_entry->hash[1];
-
-                short_left--;
-              }
-              else if (rc == 1)
-              {
-                next->hash[0] = long_entry->hash[0];
-                next->hash[1] = long_entry->hash[1];
-
-                long_left--;
-              }
-              else
-              {
-                next->hash[0] = long_entry->hash[0];
-                next->hash[1] = long_entry->hash[1];
-
-                short_left--;
-                long_left--;
-
-                long_dupes++;
-              }
-            }
+        // short and long entries share the same layout
 
-            if ((long_left != -1) || (short_left != -1))
-            {
-              brain_logging (stderr, client_idx, "unexpected remaining buffers in commit: %" PRIi64 " - %" PRIi64 "\n", long_left, short_left);
-            }
+        const i64 added_cnt = brain_server_db_hash_merge (brain_server_db_hash, (const brain_server_hash_long_t *) brain_server_db_commit->short_buf, brain_server_db_commit->short_cnt, added_buf);
 
-            brain_server_db_hash->long_cnt = cnt_total - long_dupes;
+        brain_server_db_hash_journal (brain_server_db_hash, added_buf, added_cnt, brain_server_dbs->journal);
+      }
 
-            if (long_dupes)
-            {
-              for (i64 idx = 0; idx < brain_server_db_hash->long_cnt; idx++)
-              {
-                brain_server_db_hash->long_buf[idx].hash[0] = brain_server_db_hash->long_buf[long_dupes + idx].hash[0];
-                brain_server_db_hash->long_buf[idx].hash[1] = brain_server_db_hash->long_buf[long_dupes + idx].hash[1];
-              }
-            }
-          }
-        }
-        else
-        {
-          brain_logging (stderr, 0, "%s\n", MSG_ENOMEM);
-        }
+      if (brain_server_db_commit->short_cnt)
+      {
+        const double ms_hashes = hc_timer_get (timer_commit);
 
-        brain_server_db_hash->write_hashes = true;
+        brain_logging (stdout, client_idx, "C | %8.2f ms | Hashes: %" PRIi64 "\n", ms_hashes, brain_server_db_commit->short_cnt);
       }
 
-      hc_thread_mutex_unlock (brain_server_db_hash->mux_hg);
+      brain_server_db_commit->short_cnt = 0;
 
-      if (brain_server_db_short->short_cnt)
+      if (short_sealed > 0)
       {
-        const double ms_hashes = hc_timer_get (timer_commit);
+        short_head = (short_head + 1) % short_slots;
 
-        brain_logging (stdout, client_idx, "C | %8.2f ms | Hashes: %" PRIi64 "\n", ms_hashes, brain_server_db_short->short_cnt);
+        short_sealed--;
       }
-
-      brain_server_db_short->short_cnt = 0;
     }
-    else if (operation == BRAIN_OPERATION_HASH_LOOKUP)
+    else if ((operation == BRAIN_OPERATION_HASH_LOOKUP) || (operation == BRAIN_OPERATION_HASH_LOOKUP_PACKED))
     {
+      const bool packed = (operation == BRAIN_OPERATION_HASH_LOOKUP_PACKED);
+
       int in_size = 0;
 
       if (brain_recv (client_fd, &in_size, sizeof (in_size), 0, NULL, NULL) == false) break;
@@ -2700,11 +4347,13 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
       if (brain_recv (client_fd, recv_buf, (size_t) in_size, 0, NULL, NULL) == false) break;
 
-      const int hashes_cnt = in_size / BRAIN_HASH_SIZE;
+      // packed hashes are decoded straight into temp_buf, see brain_pack_hashes ()
+
+      const int hashes_cnt = (packed == true) ? (int) brain_unpack_hashes (temp_buf, (u32) passwords_max, (const u8 *) recv_buf, (size_t) in_size) : in_size / BRAIN_HASH_SIZE;
 
       if (hashes_cnt == 0)
       {
-        brain_logging (stderr, client_idx, "Zero passwords\n");
+        brain_logging (stderr, client_idx, (packed == true) ? "Invalid packed passwords\n" : "Zero passwords\n");
 
         break;
       }
@@ -2726,10 +4375,13 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
       for (int hash_idx = 0, recv_idx = 0; hash_idx < hashes_cnt; hash_idx += 1, recv_idx += 2)
       {
-        temp_buf[hash_idx].hash[0] = recv_buf[recv_idx + 0];
-        temp_buf[hash_idx].hash[1] = recv_buf[recv_idx + 1];
+        if (packed == false)
+        {
+          temp_buf[hash_idx].hash[0] = recv_buf[recv_idx + 0];
+          temp_buf[hash_idx].hash[1] = recv_buf[recv_idx + 1];
 
-        temp_buf[hash_idx].hash_idx = hash_idx;
+          temp_buf[hash_idx].hash_idx = hash_idx;
+        }
 
         send_buf[hash_idx] = 0;
       }
@@ -2765,71 +4417,68 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
       temp_cnt++;
 
-      // check if they are in long term memory
-
-      hc_thread_mutex_lock (brain_server_db_hash->mux_hr);
-
-      brain_server_db_hash->hb++;
-
-      if (brain_server_db_hash->hb == 1)
-      {
-        hc_thread_mutex_lock (brain_server_db_hash->mux_hg);
-      }
-
-      hc_thread_mutex_unlock (brain_server_db_hash->mux_hr);
+      // check if they are in long term memory, temp_buf is sorted so we only need to lock each shard once
 
       if (temp_cnt > 0)
       {
         i64 temp_idx_new = 0;
 
-        for (i64 temp_idx = 0; temp_idx < temp_cnt; temp_idx++)
+        for (i64 temp_idx = 0; temp_idx < temp_cnt; )
         {
-          brain_server_hash_unique_t *cur = &temp_buf[temp_idx];
+          const u32 shard_idx = brain_server_hash_shard (temp_buf[temp_idx].hash);
 
-          const i64 r = brain_server_find_hash_long (cur->hash, brain_server_db_hash->long_buf, brain_server_db_hash->long_cnt);
+          brain_server_db_hash_shard_t *brain_server_db_hash_shard = &brain_server_db_hash->shards[shard_idx];
 
-          if (r != -1)
-          {
-            send_buf[cur->hash_idx] = 1;
-          }
-          else
+          brain_server_db_hash_shard_lock_read (brain_server_db_hash_shard);
+
+          for (; temp_idx < temp_cnt; temp_idx++)
           {
-            brain_server_hash_unique_t *save = temp_buf + temp_idx_new;
+            brain_server_hash_unique_t *cur = &temp_buf[temp_idx];
 
-            temp_idx_new++;
+            if (brain_server_hash_shard (cur->hash) != shard_idx) break;
 
-            save->hash[0] = cur->hash[0];
-            save->hash[1] = cur->hash[1];
+            const i64 r = brain_server_find_hash_long (cur->hash, brain_server_db_hash_shard->long_buf, brain_server_db_hash_shard->long_cnt);
 
-            save->hash_idx = cur->hash_idx; // we need this in a later stage
+            if (r != -1)
+            {
+              send_buf[cur->hash_idx] = 1;
+            }
+            else
+            {
+              brain_server_hash_unique_t *save = temp_buf + temp_idx_new;
+
+              temp_idx_new++;
+
+              save->hash[0] = cur->hash[0];
+              save->hash[1] = cur->hash[1];
+
+              save->hash_idx = cur->hash_idx; // we need this in a later stage
+            }
           }
+
+          brain_server_db_hash_shard_unlock_read (brain_server_db_hash_shard);
         }
 
         temp_cnt = temp_idx_new;
       }
 
-      hc_thread_mutex_lock (brain_server_db_hash->mux_hr);
+      // check if they are in short term memory, that's the open batch and all sealed ones not yet committed
 
-      brain_server_db_hash->hb--;
-
-      if (brain_server_db_hash->hb == 0)
+      for (int short_idx = 0; short_idx <= short_sealed; short_idx++)
       {
-        hc_thread_mutex_unlock (brain_server_db_hash->mux_hg);
-      }
+        if (temp_cnt == 0) break;
 
-      hc_thread_mutex_unlock (brain_server_db_hash->mux_hr);
+        const brain_server_db_short_t *brain_server_db_short_chk = &brain_server_db_shorts[(short_head + short_idx) % short_slots];
 
-      // check if they are in short term memory
+        if (brain_server_db_short_chk->short_cnt == 0) continue;
 
-      if (temp_cnt > 0)
-      {
         i64 temp_idx_new = 0;
 
         for (i64 temp_idx = 0; temp_idx < temp_cnt; temp_idx++)
         {
           brain_server_hash_unique_t *cur = &temp_buf[temp_idx];
 
-          const i64 r = brain_server_find_hash_short (cur->hash, brain_server_db_short->short_buf, brain_server_db_short->short_cnt);
+          const i64 r = brain_server_find_hash_short (cur->hash, brain_server_db_short_chk->short_buf, brain_server_db_short_chk->short_cnt);
 
           if (r != -1)
           {
@@ -2945,10 +4594,31 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
       brain_logging (stdout, client_idx, "L | %8.2f ms | Long: %" PRIi64 ", Inc: %d, New: %d\n", ms, brain_server_db_hash->long_cnt, hashes_cnt, local_lookup_new);
 
-      // send
+      // send, packed lookups get one bit per password. bit i never lands behind byte i, so this works in place
 
       int out_size = hashes_cnt;
 
+      if (packed == true)
+      {
+        out_size = (hashes_cnt + 7) / 8;
+
+        for (int out_idx = 0; out_idx < out_size; out_idx++)
+        {
+          u8 v = 0;
+
+          for (int bit = 0; bit < 8; bit++)
+          {
+            const int hashes_idx = (out_idx * 8) + bit;
+
+            if (hashes_idx == hashes_cnt) break;
+
+            v |= (send_buf[hashes_idx] & 1) << bit;
+          }
+
+          send_buf[out_idx] = v;
+        }
+      }
+
       if (brain_send (client_fd, &out_size, sizeof (out_size), SEND_FLAGS, NULL, NULL) == false) break;
       if (brain_send (client_fd, send_buf,           out_size, SEND_FLAGS, NULL, NULL) == false) break;
     }
@@ -2962,27 +4632,24 @@ HC_API_CALL void *brain_server_handle_client (void *p)
 
   hc_thread_mutex_lock (brain_server_db_attack->mux_ag);
 
-  for (i64 idx = 0; idx < brain_server_db_attack->short_cnt; idx++)
-  {
-    if (brain_server_db_attack->short_buf[idx].client_idx == client_idx)
-    {
-      brain_server_db_attack->short_buf[idx].offset     = 0;
-      brain_server_db_attack->short_buf[idx].length     = 0;
-      brain_server_db_attack->short_buf[idx].client_idx = 0;
-    }
-  }
+  brain_server_db_attack_release (brain_server_db_attack, client_idx);
 
   hc_thread_mutex_unlock (brain_server_db_attack->mux_ag);
 
   // short free
 
-  hcfree (brain_server_db_short->short_buf);
-  hcfree (brain_server_db_short);
+  for (int short_idx = 0; short_idx < short_slots; short_idx++)
+  {
+    hcfree (brain_server_db_shorts[short_idx].short_buf);
+  }
+
+  hcfree (brain_server_db_shorts);
 
   // free local memory
 
   hcfree (send_buf);
   hcfree (temp_buf);
+  hcfree (added_buf);
   hcfree (recv_buf);
 
   brain_logging (stdout, client_idx, "Disconnected\n");
@@ -3141,6 +4808,10 @@ int brain_server (const char *listen_host, const int listen_port, const char *br
 
   hc_thread_mutex_init (brain_server_dbs->mux_dbs);
 
+  // without a cyclic dump everything is written once at the end, a journal would only cost memory
+
+  brain_server_dbs->journal = (brain_server_timer > 0);
+
   brain_server_dbs->hash_buf = (brain_server_db_hash_t *) hccalloc (BRAIN_SERVER_SESSIONS_MAX, sizeof (brain_server_db_hash_t));
   brain_server_dbs->hash_cnt = 0;
 
@@ -6,7 +6,12 @@
 #include "common.h"
 #include "types.h"
 #include "event.h"
+#include "memory.h"
 #include "shared.h"
+#include "convert.h"
+#include "filehandling.h"
+#include "rp.h"
+#include "rp_cpu.h"
 #include "wordlist.h"
 #include "combinator.h"
 
@@ -256,6 +261,11 @@ int combinator_ctx_init (hashcat_ctx_t *hashcat_ctx)
 
           user_options_extra->rule_len_l = user_options_extra->rule_len_r;
           user_options_extra->rule_len_r = tmpi;
+
+          rp_cpu_rule_t tmpr = user_options_extra->rule_cpu_l;
+
+          user_options_extra->rule_cpu_l = user_options_extra->rule_cpu_r;
+          user_options_extra->rule_cpu_r = tmpr;
         }
       }
       else if (user_options->attack_mode == ATTACK_MODE_HYBRID1)
@@ -429,3 +439,241 @@ void combinator_ctx_destroy (hashcat_ctx_t *hashcat_ctx)
 
   memset (combinator_ctx, 0, sizeof (combinator_ctx_t));
 }
+
+// hex decoding, -k and on-the-fly encoding of one line of the list run_cracker () combines with
+// returns the length of the finished candidate in *out_buf, -1 if the line is skipped and -2 if -k rejected it
+
+int combinator_line (hashcat_ctx_t *hashcat_ctx, char *line_buf, size_t line_len, const bool iconv_enabled, iconv_t iconv_ctx, char *iconv_tmp, char *rule_buf_out, char **out_buf)
+{
+  const user_options_t       *user_options       = hashcat_ctx->user_options;
+  const user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+
+  line_len = convert_from_hex (hashcat_ctx, line_buf, line_len);
+
+  if (line_len > PW_MAX) return -1;
+
+  char *line_buf_new = line_buf;
+
+  if (run_rule_engine (user_options_extra->rule_len_r, user_options->rule_buf_r))
+  {
+    if (line_len >= RP_PASSWORD_SIZE) return -1;
+
+    memset (rule_buf_out, 0, RP_PASSWORD_SIZE);
+
+    const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_r, line_buf, (u32) line_len, rule_buf_out);
+
+    if (rule_len_out < 0) return -2;
+
+    line_len = rule_len_out;
+
+    line_buf_new = rule_buf_out;
+  }
+
+  // do the on-the-fly encoding
+
+  if (iconv_enabled == true)
+  {
+    char  *iconv_ptr = iconv_tmp;
+    size_t iconv_sz  = HCBUFSIZ_TINY;
+
+    if (iconv (iconv_ctx, &line_buf_new, &line_len, &iconv_ptr, &iconv_sz) == (size_t) -1) return -1;
+
+    line_buf_new = iconv_tmp;
+    line_len     = HCBUFSIZ_TINY - iconv_sz;
+  }
+
+  line_len = MIN (line_len, PW_MAX);
+
+  *out_buf = line_buf_new;
+
+  return (int) line_len;
+}
+
+/**
+ * without the cache, run_cracker () rewinds the list and runs every line through fgetl () and combinator_line ()
+ * again for each window of each salt on each device. here it's done once, run_cracker () then copies slices.
+ * the rejections are kept per candidate so the progress accounting stays exactly the same.
+ */
+
+int combinator_cache_init (hashcat_ctx_t *hashcat_ctx)
+{
+  combinator_ctx_t     *combinator_ctx      = hashcat_ctx->combinator_ctx;
+  hashconfig_t         *hashconfig          = hashcat_ctx->hashconfig;
+  straight_ctx_t       *straight_ctx        = hashcat_ctx->straight_ctx;
+  user_options_t       *user_options        = hashcat_ctx->user_options;
+  user_options_extra_t *user_options_extra  = hashcat_ctx->user_options_extra;
+
+  combinator_ctx->cache_enabled = false;
+
+  if (combinator_ctx->enabled == false) return 0;
+
+  if (user_options->keyspace        == true) return 0;
+  if (user_options->slow_candidates == true) return 0;
+  if (user_options->stdout_flag     == true) return 0;
+
+  if (user_options_extra->wordlist_mode == WL_MODE_STDIN) return 0;
+
+  const char *dictfile = NULL;
+
+  if (user_options->attack_mode == ATTACK_MODE_COMBI)
+  {
+    dictfile = (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT) ? combinator_ctx->dict2 : combinator_ctx->dict1;
+  }
+  else if (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (user_options->attack_mode == ATTACK_MODE_HYBRID2))
+  {
+    dictfile = straight_ctx->dict;
+  }
+
+  if (dictfile == NULL) return 0;
+
+  HCFILE fp;
+
+  if (hc_fopen (&fp, dictfile, "rb") == false)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", dictfile, strerror (errno));
+
+    return -1;
+  }
+
+  // compressed files are checked against their compressed size, which is good enough for a memory limit
+
+  struct stat st;
+
+  if ((hc_fstat (&fp, &st) == -1) || (st.st_size > COMBINATOR_CACHE_MAX))
+  {
+    hc_fclose (&fp);
+
+    return 0;
+  }
+
+  bool iconv_enabled = false;
+
+  iconv_t iconv_ctx = NULL;
+
+  char iconv_tmp[HCBUFSIZ_TINY] = { 0 };
+
+  if (strcmp (user_options->encoding_from, user_options->encoding_to) != 0)
+  {
+    iconv_enabled = true;
+
+    iconv_ctx = iconv_open (user_options->encoding_to, user_options->encoding_from);
+
+    if (iconv_ctx == (iconv_t) -1)
+    {
+      hc_fclose (&fp);
+
+      return -1;
+    }
+  }
+
+  char *line_buf = (char *) hcmalloc (HCBUFSIZ_LARGE + 1);
+
+  char rule_buf_out[RP_PASSWORD_SIZE];
+
+  const bool rules = run_rule_engine (user_options_extra->rule_len_r, user_options->rule_buf_r);
+
+  u64 buf_size = 0;
+  u64 buf_len  = 0;
+  u64 cnt      = 0;
+  u64 avail    = 0;
+  u64 rej      = 0;
+
+  u8  *buf     = NULL;
+  u64 *off_buf = NULL;
+  u64 *rej_buf = NULL;
+
+  while (hc_feof (&fp) == false)
+  {
+    const size_t line_len = fgetl (&fp, line_buf, HCBUFSIZ_LARGE);
+
+    char *out_buf = NULL;
+
+    const int out_len = combinator_line (hashcat_ctx, line_buf, line_len, iconv_enabled, iconv_ctx, iconv_tmp, rule_buf_out, &out_buf);
+
+    if (out_len == -2) rej++;
+
+    if (out_len < 0) continue;
+
+    if ((buf_len + out_len) > buf_size)
+    {
+      const u64 add = MAX ((u64) st.st_size / 4, (u64) 1024 * 1024);
+
+      buf = (u8 *) hcrealloc (buf, buf_size, add);
+
+      buf_size += add;
+    }
+
+    // one spare element for the end marker
+
+    if ((cnt + 1) >= avail)
+    {
+      off_buf = (u64 *) hcrealloc (off_buf, avail * sizeof (u64), 0x10000 * sizeof (u64));
+
+      if (rules == true) rej_buf = (u64 *) hcrealloc (rej_buf, avail * sizeof (u64), 0x10000 * sizeof (u64));
+
+      avail += 0x10000;
+    }
+
+    memcpy (buf + buf_len, out_buf, out_len);
+
+    if (hashconfig->opts_type & OPTS_TYPE_PT_UPPER)
+    {
+      uppercase (buf + buf_len, out_len);
+    }
+
+    off_buf[cnt] = buf_len;
+
+    if (rules == true) rej_buf[cnt] = rej;
+
+    buf_len += out_len;
+
+    cnt++;
+  }
+
+  if (off_buf == NULL)
+  {
+    off_buf = (u64 *) hccalloc (1, sizeof (u64));
+
+    if (rules == true) rej_buf = (u64 *) hccalloc (1, sizeof (u64));
+  }
+
+  off_buf[cnt] = buf_len;
+
+  if (rules == true) rej_buf[cnt] = rej;
+
+  hcfree (line_buf);
+
+  if (iconv_enabled == true)
+  {
+    iconv_close (iconv_ctx);
+  }
+
+  hc_fclose (&fp);
+
+  combinator_ctx->cache_buf     = buf;
+  combinator_ctx->cache_off_buf = off_buf;
+  combinator_ctx->cache_rej_buf = rej_buf;
+  combinator_ctx->cache_cnt     = cnt;
+
+  combinator_ctx->cache_enabled = true;
+
+  return 0;
+}
+
+void combinator_cache_destroy (hashcat_ctx_t *hashcat_ctx)
+{
+  combinator_ctx_t *combinator_ctx = hashcat_ctx->combinator_ctx;
+
+  if (combinator_ctx->cache_enabled == false) return;
+
+  hcfree (combinator_ctx->cache_buf);
+  hcfree (combinator_ctx->cache_off_buf);
+  hcfree (combinator_ctx->cache_rej_buf);
+
+  combinator_ctx->cache_enabled = false;
+
+  combinator_ctx->cache_buf     = NULL;
+  combinator_ctx->cache_off_buf = NULL;
+  combinator_ctx->cache_rej_buf = NULL;
+  combinator_ctx->cache_cnt     = 0;
+}
@@ -15,6 +15,7 @@ int cpu_supports_xop ()      { return 0; }
 int cpu_supports_avx2 ()     { return 0; }
 int cpu_supports_avx512f ()  { return 0; }
 int cpu_supports_avx512vl () { return 0; }
+int cpu_supports_avx512bw () { return 0; }
 
 #else
 static inline void cpuid (u32 leaf, u32 subleaf, u32 *eax, u32 *ebx, u32 *ecx, u32 *edx)
@@ -130,6 +131,27 @@ int cpu_supports_avx512vl ()
 
   return (ebx & (1u << 31)) != 0;
 }
+
+int cpu_supports_avx512bw ()
+{
+  u32 eax, ebx, ecx, edx;
+
+  cpuid (1, 0, &eax, &ebx, &ecx, &edx);
+
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+  {
+    return 0;
+  }
+
+  if ((xgetbv(0) & 0xE6) != 0xE6)
+  {
+    return 0;
+  }
+
+  cpuid (7, 0, &eax, &ebx, &ecx, &edx);
+
+  return (ebx & bit_AVX512BW) != 0;
+}
 #endif
 
 int cpu_chipset_test ()
@@ -10,6 +10,8 @@
 #include "event.h"
 #include "locking.h"
 #include "shared.h"
+#include "folder.h"
+#include "filehandling.h"
 #include "dictstat.h"
 
 int sort_by_dictstat (const void *s1, const void *s2)
@@ -48,6 +50,153 @@ int sort_by_dictstat (const void *s1, const void *s2)
   return rc_memcmp;
 }
 
+static int sort_by_dictstat_key (const dictstat_t *d1, const dictstat_t *d2)
+{
+  const int rc_hash = memcmp (d1->hash_filename, d2->hash_filename, 16);
+
+  if (rc_hash != 0) return rc_hash;
+
+  const int rc_from = strcmp (d1->encoding_from, d2->encoding_from);
+
+  if (rc_from != 0) return rc_from;
+
+  return strcmp (d1->encoding_to, d2->encoding_to);
+}
+
+static int sort_by_dictstat_last_used (const void *s1, const void *s2)
+{
+  const dictstat_t *d1 = (const dictstat_t *) s1;
+  const dictstat_t *d2 = (const dictstat_t *) s2;
+
+  // most recently used first
+
+  if (d1->last_used > d2->last_used) return -1;
+  if (d1->last_used < d2->last_used) return  1;
+
+  return 0;
+}
+
+static u64 dictstat_key_hash (const dictstat_t *d)
+{
+  // hash_filename already is a sha1 of the path, only the encodings need mixing in (FNV-1a)
+
+  u64 h;
+
+  memcpy (&h, d->hash_filename, sizeof (u64));
+
+  for (const char *p = d->encoding_from; *p; p++) h = (h ^ (u8) *p) * 0x100000001b3;
+
+  h = (h ^ 0xff) * 0x100000001b3;
+
+  for (const char *p = d->encoding_to;   *p; p++) h = (h ^ (u8) *p) * 0x100000001b3;
+
+  return h;
+}
+
+static u64 *dictstat_slot (dictstat_ctx_t *dictstat_ctx, const dictstat_t *d)
+{
+  const u64 mask = dictstat_ctx->table_size - 1;
+
+  for (u64 pos = dictstat_key_hash (d) & mask; ; pos = (pos + 1) & mask)
+  {
+    u64 *slot = dictstat_ctx->table + pos;
+
+    if (*slot == 0) return slot;
+
+    if (sort_by_dictstat_key (dictstat_ctx->base + *slot - 1, d) == 0) return slot;
+  }
+
+  return NULL;
+}
+
+static void dictstat_rehash (dictstat_ctx_t *dictstat_ctx, const u64 table_size)
+{
+  hcfree (dictstat_ctx->table);
+
+  dictstat_ctx->table      = (u64 *) hccalloc (table_size, sizeof (u64));
+  dictstat_ctx->table_size = table_size;
+
+  for (u64 i = 0; i < dictstat_ctx->cnt; i++)
+  {
+    u64 *slot = dictstat_slot (dictstat_ctx, dictstat_ctx->base + i);
+
+    *slot = i + 1;
+  }
+}
+
+static void dictstat_evict (dictstat_ctx_t *dictstat_ctx)
+{
+  if (dictstat_ctx->cnt <= MAX_DICTSTAT) return;
+
+  qsort (dictstat_ctx->base, dictstat_ctx->cnt, sizeof (dictstat_t), sort_by_dictstat_last_used);
+
+  dictstat_ctx->cnt = DICTSTAT_EVICT_TO;
+
+  dictstat_rehash (dictstat_ctx, dictstat_ctx->table_size);
+
+  // the evicted entries are still in the file
+
+  dictstat_ctx->rewrite = true;
+}
+
+static dictstat_t *dictstat_put (dictstat_ctx_t *dictstat_ctx, const dictstat_t *d)
+{
+  // keep the load factor below 1/2
+
+  if (((dictstat_ctx->cnt + 1) * 2) > dictstat_ctx->table_size)
+  {
+    dictstat_rehash (dictstat_ctx, dictstat_ctx->table_size * 2);
+  }
+
+  u64 *slot = dictstat_slot (dictstat_ctx, d);
+
+  if (*slot)
+  {
+    // same file and encodings, either a touch or the file has changed since, the old entry is stale either way
+
+    dictstat_t *d_cache = dictstat_ctx->base + *slot - 1;
+
+    memcpy (d_cache, d, sizeof (dictstat_t));
+
+    return d_cache;
+  }
+
+  if (dictstat_ctx->cnt == dictstat_ctx->avail)
+  {
+    const u64 incr = MAX (dictstat_ctx->avail, INCR_DICTSTAT);
+
+    dictstat_ctx->base = (dictstat_t *) hcrealloc (dictstat_ctx->base, dictstat_ctx->avail * sizeof (dictstat_t), incr * sizeof (dictstat_t));
+
+    dictstat_ctx->avail += incr;
+  }
+
+  dictstat_t *d_cache = dictstat_ctx->base + dictstat_ctx->cnt;
+
+  memcpy (d_cache, d, sizeof (dictstat_t));
+
+  dictstat_ctx->cnt++;
+
+  *slot = dictstat_ctx->cnt;
+
+  return d_cache;
+}
+
+static void dictstat_queue_append (dictstat_ctx_t *dictstat_ctx, const dictstat_t *d)
+{
+  if (dictstat_ctx->append_cnt == dictstat_ctx->append_avail)
+  {
+    const u64 incr = MAX (dictstat_ctx->append_avail, INCR_DICTSTAT);
+
+    dictstat_ctx->append_buf = (dictstat_t *) hcrealloc (dictstat_ctx->append_buf, dictstat_ctx->append_avail * sizeof (dictstat_t), incr * sizeof (dictstat_t));
+
+    dictstat_ctx->append_avail += incr;
+  }
+
+  memcpy (dictstat_ctx->append_buf + dictstat_ctx->append_cnt, d, sizeof (dictstat_t));
+
+  dictstat_ctx->append_cnt++;
+}
+
 int dictstat_init (hashcat_ctx_t *hashcat_ctx)
 {
   dictstat_ctx_t  *dictstat_ctx  = hashcat_ctx->dictstat_ctx;
@@ -69,12 +218,23 @@ int dictstat_init (hashcat_ctx_t *hashcat_ctx)
 
   if (user_options->attack_mode == ATTACK_MODE_BF) return 0;
 
-  dictstat_ctx->enabled = true;
-  dictstat_ctx->base    = (dictstat_t *) hccalloc (MAX_DICTSTAT, sizeof (dictstat_t));
-  dictstat_ctx->cnt     = 0;
+  dictstat_ctx->enabled    = true;
+  dictstat_ctx->base       = NULL;
+  dictstat_ctx->cnt        = 0;
+  dictstat_ctx->avail      = 0;
+  dictstat_ctx->table      = (u64 *) hccalloc (INCR_DICTSTAT * 2, sizeof (u64));
+  dictstat_ctx->table_size = INCR_DICTSTAT * 2;
+  dictstat_ctx->disk_cnt   = 0;
+  dictstat_ctx->rewrite    = false;
 
   hc_asprintf (&dictstat_ctx->filename, "%s/%s", folder_config->profile_dir, DICTSTAT_FILENAME);
 
+  // word offset indexes are pure cache data, one file per wordlist
+
+  hc_asprintf (&dictstat_ctx->index_folder, "%s/%s", folder_config->cache_dir, DICTIDX_FOLDER);
+
+  hc_mkdir (dictstat_ctx->index_folder, 0700);
+
   return 0;
 }
 
@@ -85,7 +245,10 @@ void dictstat_destroy (hashcat_ctx_t *hashcat_ctx)
   if (dictstat_ctx->enabled == false) return;
 
   hcfree (dictstat_ctx->filename);
+  hcfree (dictstat_ctx->index_folder);
   hcfree (dictstat_ctx->base);
+  hcfree (dictstat_ctx->table);
+  hcfree (dictstat_ctx->append_buf);
 
   memset (dictstat_ctx, 0, sizeof (dictstat_ctx_t));
 }
@@ -103,6 +266,10 @@ void dictstat_read (hashcat_ctx_t *hashcat_ctx)
   if (user_options->rule_buf_l_chgd == true) return;
   if (user_options->rule_buf_r_chgd == true) return;
 
+  // unless we find a valid file below, dictstat_write () has to create it from scratch
+
+  dictstat_ctx->rewrite = true;
+
   HCFILE fp;
 
   if (hc_fopen (&fp, dictstat_ctx->filename, "rb") == false)
@@ -159,7 +326,7 @@ void dictstat_read (hashcat_ctx_t *hashcat_ctx)
     return;
   }
 
-  // parse data
+  // parse data, the file is a log: a later record for the same wordlist replaces an earlier one
 
   while (!hc_feof (&fp))
   {
@@ -169,17 +336,20 @@ void dictstat_read (hashcat_ctx_t *hashcat_ctx)
 
     if (nread == 0) continue;
 
-    lsearch (&d, dictstat_ctx->base, &dictstat_ctx->cnt, sizeof (dictstat_t), sort_by_dictstat);
-
-    if (dictstat_ctx->cnt == MAX_DICTSTAT)
-    {
-      event_log_error (hashcat_ctx, "There are too many entries in the %s database. You have to remove/rename it.", dictstat_ctx->filename);
+    dictstat_put (dictstat_ctx, &d);
 
-      break;
-    }
+    dictstat_ctx->disk_cnt++;
   }
 
   hc_fclose (&fp);
+
+  dictstat_ctx->rewrite = false;
+
+  dictstat_evict (dictstat_ctx);
+
+  // compact the file once most of it are superseded records
+
+  if (dictstat_ctx->disk_cnt > (dictstat_ctx->cnt * 2) + INCR_DICTSTAT) dictstat_ctx->rewrite = true;
 }
 
 int dictstat_write (hashcat_ctx_t *hashcat_ctx)
@@ -195,9 +365,13 @@ int dictstat_write (hashcat_ctx_t *hashcat_ctx)
   if (user_options->rule_buf_l_chgd == true) return 0;
   if (user_options->rule_buf_r_chgd == true) return 0;
 
+  // usually only the new and touched entries are appended, other instances may have appended theirs in the meantime
+
+  if ((dictstat_ctx->rewrite == false) && (dictstat_ctx->append_cnt == 0)) return 0;
+
   HCFILE fp;
 
-  if (hc_fopen (&fp, dictstat_ctx->filename, "wb") == false)
+  if (hc_fopen (&fp, dictstat_ctx->filename, (dictstat_ctx->rewrite == true) ? "wb" : "ab") == false)
   {
     event_log_error (hashcat_ctx, "%s: %s", dictstat_ctx->filename, strerror (errno));
 
@@ -213,20 +387,34 @@ int dictstat_write (hashcat_ctx_t *hashcat_ctx)
     return -1;
   }
 
-  // header
+  if (dictstat_ctx->rewrite == true)
+  {
+    // header
 
-  u64 v = DICTSTAT_VERSION;
-  u64 z = 0;
+    u64 v = DICTSTAT_VERSION;
+    u64 z = 0;
 
-  v = byte_swap_64 (v);
-  z = byte_swap_64 (z);
+    v = byte_swap_64 (v);
+    z = byte_swap_64 (z);
 
-  hc_fwrite (&v, sizeof (u64), 1, &fp);
-  hc_fwrite (&z, sizeof (u64), 1, &fp);
+    hc_fwrite (&v, sizeof (u64), 1, &fp);
+    hc_fwrite (&z, sizeof (u64), 1, &fp);
 
-  // data
+    // data
 
-  hc_fwrite (dictstat_ctx->base, sizeof (dictstat_t), dictstat_ctx->cnt, &fp);
+    hc_fwrite (dictstat_ctx->base, sizeof (dictstat_t), dictstat_ctx->cnt, &fp);
+
+    dictstat_ctx->disk_cnt = dictstat_ctx->cnt;
+  }
+  else
+  {
+    hc_fwrite (dictstat_ctx->append_buf, sizeof (dictstat_t), dictstat_ctx->append_cnt, &fp);
+
+    dictstat_ctx->disk_cnt += dictstat_ctx->append_cnt;
+  }
+
+  dictstat_ctx->rewrite    = false;
+  dictstat_ctx->append_cnt = 0;
 
   if (hc_unlockfile (&fp) == -1)
   {
@@ -251,9 +439,26 @@ u64 dictstat_find (hashcat_ctx_t *hashcat_ctx, dictstat_t *d)
 
   if (hashconfig->dictstat_disable == true) return 0;
 
-  dictstat_t *d_cache = (dictstat_t *) lfind (d, dictstat_ctx->base, &dictstat_ctx->cnt, sizeof (dictstat_t), sort_by_dictstat);
+  const u64 *slot = dictstat_slot (dictstat_ctx, d);
+
+  if (*slot == 0) return 0;
+
+  dictstat_t *d_cache = dictstat_ctx->base + *slot - 1;
+
+  // the file has changed since it was counted
 
-  if (d_cache == NULL) return 0;
+  if (sort_by_dictstat (d_cache, d) != 0) return 0;
+
+  // don't append a record on every single hit, a coarse timestamp is good enough for eviction
+
+  const u64 now = (u64) time (NULL);
+
+  if ((now - d_cache->last_used) > DICTSTAT_TOUCH_SECS)
+  {
+    d_cache->last_used = now;
+
+    dictstat_queue_append (dictstat_ctx, d_cache);
+  }
 
   return d_cache->cnt;
 }
@@ -267,12 +472,320 @@ void dictstat_append (hashcat_ctx_t *hashcat_ctx, dictstat_t *d)
 
   if (hashconfig->dictstat_disable == true) return;
 
-  if (dictstat_ctx->cnt == MAX_DICTSTAT)
+  d->last_used = (u64) time (NULL);
+
+  const dictstat_t *d_cache = dictstat_put (dictstat_ctx, d);
+
+  dictstat_queue_append (dictstat_ctx, d_cache);
+
+  dictstat_evict (dictstat_ctx);
+}
+
+bool dictstat_index_enabled (hashcat_ctx_t *hashcat_ctx)
+{
+  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  dictstat_ctx_t *dictstat_ctx = hashcat_ctx->dictstat_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  if (dictstat_ctx->enabled == false) return false;
+
+  if (hashconfig->dictstat_disable == true) return false;
+
+  // -j and -k change which words survive, the index would be specific to the rule
+
+  if (user_options->rule_buf_l_chgd == true) return false;
+  if (user_options->rule_buf_r_chgd == true) return false;
+
+  return true;
+}
+
+static char *dictstat_index_filename (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const char *ext)
+{
+  dictstat_ctx_t *dictstat_ctx = hashcat_ctx->dictstat_ctx;
+
+  char hash_hex[33];
+
+  for (int i = 0; i < 16; i++)
   {
-    event_log_error (hashcat_ctx, "There are too many entries in the %s database. You have to remove/rename it.", dictstat_ctx->filename);
+    snprintf (hash_hex + (i * 2), 3, "%02x", d->hash_filename[i]);
+  }
 
-    return;
+  char *filename = NULL;
+
+  hc_asprintf (&filename, "%s/%s.%s", dictstat_ctx->index_folder, hash_hex, ext);
+
+  return filename;
+}
+
+// index files are written to a file of their own and renamed into place once complete, so a second instance
+// reading the same index sees either the old or the new one, never a truncated or half written one
+
+static bool dictstat_index_create (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *filename, char **tmp_filename)
+{
+  hc_asprintf (tmp_filename, "%s.%d.tmp", filename, (int) getpid ());
+
+  if (hc_fopen_raw (fp, *tmp_filename, "wb") == false)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", *tmp_filename, strerror (errno));
+
+    hcfree (*tmp_filename);
+
+    return false;
   }
 
-  lsearch (d, dictstat_ctx->base, &dictstat_ctx->cnt, sizeof (dictstat_t), sort_by_dictstat);
+  return true;
+}
+
+static int dictstat_index_commit (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *filename, char *tmp_filename)
+{
+  hc_fflush (fp);
+
+  hc_fclose (fp);
+
+  #if defined (_WIN)
+  unlink (filename);
+  #endif
+
+  if (rename (tmp_filename, filename) == -1)
+  {
+    event_log_error (hashcat_ctx, "Rename file '%s' to '%s': %s", tmp_filename, filename, strerror (errno));
+
+    unlink (tmp_filename);
+
+    hcfree (tmp_filename);
+
+    return -1;
+  }
+
+  hcfree (tmp_filename);
+
+  return 0;
+}
+
+// opens an index file and checks its header, fp is positioned at the offsets if it returns true
+
+static bool dictstat_index_open (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const u32 flags, HCFILE *fp, u64 *cnt)
+{
+  char *filename = dictstat_index_filename (hashcat_ctx, d, "dictidx");
+
+  if (hc_fopen_raw (fp, filename, "rb") == false)
+  {
+    // no index built yet, not an error
+
+    hcfree (filename);
+
+    return false;
+  }
+
+  hcfree (filename);
+
+  u64 v = 0;
+  u32 f = 0;
+  u64 c = 0;
+
+  dictstat_t d_idx;
+
+  const size_t nread1 = hc_fread (&v,     sizeof (u64),        1, fp);
+  const size_t nread2 = hc_fread (&d_idx, sizeof (dictstat_t), 1, fp);
+  const size_t nread3 = hc_fread (&f,     sizeof (u32),        1, fp);
+  const size_t nread4 = hc_fread (&c,     sizeof (u64),        1, fp);
+
+  if ((nread1 != 1) || (nread2 != 1) || (nread3 != 1) || (nread4 != 1))
+  {
+    hc_fclose (fp);
+
+    return false;
+  }
+
+  // outdated index files are silently ignored and overwritten on the next count_words ()
+
+  if (byte_swap_64 (v) != DICTIDX_VERSION)    { hc_fclose (fp); return false; }
+  if (sort_by_dictstat (&d_idx, d) != 0)      { hc_fclose (fp); return false; }
+  if (f != flags)                             { hc_fclose (fp); return false; }
+  if (c == 0)                                 { hc_fclose (fp); return false; }
+
+  *cnt = c;
+
+  return true;
+}
+
+bool dictstat_index_exists (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const u32 flags)
+{
+  if (dictstat_index_enabled (hashcat_ctx) == false) return false;
+
+  HCFILE fp;
+
+  u64 c = 0;
+
+  if (dictstat_index_open (hashcat_ctx, d, flags, &fp, &c) == false) return false;
+
+  hc_fclose (&fp);
+
+  return true;
+}
+
+int dictstat_index_read (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const u32 flags, dictidx_t **idx_buf, u64 *idx_cnt)
+{
+  *idx_buf = NULL;
+  *idx_cnt = 0;
+
+  if (dictstat_index_enabled (hashcat_ctx) == false) return 0;
+
+  HCFILE fp;
+
+  u64 c = 0;
+
+  if (dictstat_index_open (hashcat_ctx, d, flags, &fp, &c) == false) return 0;
+
+  dictidx_t *buf = (dictidx_t *) hccalloc (c, sizeof (dictidx_t));
+
+  const size_t nread5 = hc_fread (buf, sizeof (dictidx_t), c, &fp);
+
+  hc_fclose (&fp);
+
+  if (nread5 != c)
+  {
+    hcfree (buf);
+
+    return 0;
+  }
+
+  *idx_buf = buf;
+  *idx_cnt = c;
+
+  return 0;
+}
+
+int dictstat_index_write (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const u32 flags, const dictidx_t *idx_buf, const u64 idx_cnt)
+{
+  if (dictstat_index_enabled (hashcat_ctx) == false) return 0;
+
+  if (idx_cnt == 0) return 0;
+
+  char *filename = dictstat_index_filename (hashcat_ctx, d, "dictidx");
+
+  HCFILE fp;
+
+  char *tmp_filename = NULL;
+
+  if (dictstat_index_create (hashcat_ctx, &fp, filename, &tmp_filename) == false)
+  {
+    hcfree (filename);
+
+    return -1;
+  }
+
+  const u64 v = byte_swap_64 (DICTIDX_VERSION);
+
+  hc_fwrite (&v,       sizeof (u64),        1, &fp);
+  hc_fwrite (d,        sizeof (dictstat_t), 1, &fp);
+  hc_fwrite (&flags,   sizeof (u32),        1, &fp);
+  hc_fwrite (&idx_cnt, sizeof (u64),        1, &fp);
+
+  hc_fwrite (idx_buf, sizeof (dictidx_t), idx_cnt, &fp);
+
+  const int rc = dictstat_index_commit (hashcat_ctx, &fp, filename, tmp_filename);
+
+  hcfree (filename);
+
+  return rc;
+}
+
+int dictstat_gzidx_read (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, gzidx_t *gzidx)
+{
+  dictstat_ctx_t *dictstat_ctx = hashcat_ctx->dictstat_ctx;
+
+  gzidx->points = NULL;
+  gzidx->cnt    = 0;
+
+  // the checkpoints only depend on the file, not on the rules, so dictstat_index_enabled () is too strict here
+
+  if (dictstat_ctx->enabled == false) return 0;
+
+  char *filename = dictstat_index_filename (hashcat_ctx, d, "gzidx");
+
+  HCFILE fp;
+
+  if (hc_fopen_raw (&fp, filename, "rb") == false)
+  {
+    hcfree (filename);
+
+    return 0;
+  }
+
+  hcfree (filename);
+
+  u64 v = 0;
+  u64 c = 0;
+
+  dictstat_t d_idx;
+
+  const size_t nread1 = hc_fread (&v,     sizeof (u64),        1, &fp);
+  const size_t nread2 = hc_fread (&d_idx, sizeof (dictstat_t), 1, &fp);
+  const size_t nread3 = hc_fread (&c,     sizeof (u64),        1, &fp);
+
+  if ((nread1 != 1) || (nread2 != 1) || (nread3 != 1))
+  {
+    hc_fclose (&fp);
+
+    return 0;
+  }
+
+  if (byte_swap_64 (v) != GZIDX_VERSION)      { hc_fclose (&fp); return 0; }
+  if (sort_by_dictstat (&d_idx, d) != 0)      { hc_fclose (&fp); return 0; }
+  if (c == 0)                                 { hc_fclose (&fp); return 0; }
+
+  gzidx_point_t *points = (gzidx_point_t *) hcmalloc (c * sizeof (gzidx_point_t));
+
+  const size_t nread4 = hc_fread (points, sizeof (gzidx_point_t), c, &fp);
+
+  hc_fclose (&fp);
+
+  if (nread4 != c)
+  {
+    hcfree (points);
+
+    return 0;
+  }
+
+  gzidx->points = points;
+  gzidx->cnt    = c;
+
+  return 0;
+}
+
+int dictstat_gzidx_write (hashcat_ctx_t *hashcat_ctx, const dictstat_t *d, const gzidx_t *gzidx)
+{
+  dictstat_ctx_t *dictstat_ctx = hashcat_ctx->dictstat_ctx;
+
+  if (dictstat_ctx->enabled == false) return 0;
+
+  if (gzidx->cnt == 0) return 0;
+
+  char *filename = dictstat_index_filename (hashcat_ctx, d, "gzidx");
+
+  HCFILE fp;
+
+  char *tmp_filename = NULL;
+
+  if (dictstat_index_create (hashcat_ctx, &fp, filename, &tmp_filename) == false)
+  {
+    hcfree (filename);
+
+    return -1;
+  }
+
+  const u64 v = byte_swap_64 (GZIDX_VERSION);
+
+  hc_fwrite (&v,          sizeof (u64),        1, &fp);
+  hc_fwrite (d,           sizeof (dictstat_t), 1, &fp);
+  hc_fwrite (&gzidx->cnt, sizeof (u64),        1, &fp);
+
+  hc_fwrite (gzidx->points, sizeof (gzidx_point_t), gzidx->cnt, &fp);
+
+  const int rc = dictstat_index_commit (hashcat_ctx, &fp, filename, tmp_filename);
+
+  hcfree (filename);
+
+  return rc;
 }
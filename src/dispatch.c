@@ -15,6 +15,8 @@
 #include "rp.h"
 #include "rp_cpu.h"
 #include "slow_candidates.h"
+#include "status.h"
+#include "restore.h"
 #include "dispatch.h"
 
 #ifdef WITH_BRAIN
@@ -81,15 +83,53 @@ static int set_kernel_power_final (hashcat_ctx_t *hashcat_ctx, const u64 kernel_
   return 0;
 }
 
-static u64 get_power (backend_ctx_t *backend_ctx, hc_device_param_t *device_param)
+/**
+ * once less than kernel_power_all words are left, every claim takes the device's share of what is left, so the
+ * claims shrink towards the end and a device coming back early simply takes another, smaller claim.
+ * the share follows the measured speed of the devices, the hardware power is only a guess for the case a device
+ * has not finished a single kernel run yet. with mixed devices, a split by hardware power left the last large
+ * claim to the slowest device often enough and everyone else waiting for it.
+ */
+
+static double get_device_factor (hashcat_ctx_t *hashcat_ctx, const hc_device_param_t *device_param)
+{
+  const backend_ctx_t *backend_ctx = hashcat_ctx->backend_ctx;
+
+  double speed_dev = 0;
+  double speed_all = 0;
+
+  for (int backend_devices_idx = 0; backend_devices_idx < backend_ctx->backend_devices_cnt; backend_devices_idx++)
+  {
+    const hc_device_param_t *device_param_cur = &backend_ctx->devices_param[backend_devices_idx];
+
+    if (device_param_cur->skipped == true) continue;
+    if (device_param_cur->skipped_warning == true) continue;
+
+    const double speed = status_get_hashes_msec_dev (hashcat_ctx, backend_devices_idx);
+
+    if (speed <= 0) return (double) device_param->hardware_power / backend_ctx->hardware_power_all;
+
+    if (device_param_cur == device_param) speed_dev = speed;
+
+    speed_all += speed;
+  }
+
+  if (speed_all <= 0) return (double) device_param->hardware_power / backend_ctx->hardware_power_all;
+
+  return speed_dev / speed_all;
+}
+
+static u64 get_power (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 words_left)
 {
+  const backend_ctx_t *backend_ctx = hashcat_ctx->backend_ctx;
+
   const u64 kernel_power_final = backend_ctx->kernel_power_final;
 
   if (kernel_power_final)
   {
-    const double device_factor = (double) device_param->hardware_power / backend_ctx->hardware_power_all;
+    const double device_factor = get_device_factor (hashcat_ctx, device_param);
 
-    const u64 words_left_device = (u64) CEIL (kernel_power_final * device_factor);
+    const u64 words_left_device = (u64) CEIL (words_left * device_factor);
 
     // work should be at least the hardware power available without any accelerator
 
@@ -105,7 +145,9 @@ static u64 get_power (backend_ctx_t *backend_ctx, hc_device_param_t *device_para
   return device_param->kernel_power;
 }
 
-static u64 get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 max)
+// claims the next range without touching device_param->words_off, which belongs to the batch the device is running
+
+static u64 get_work_off (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 max, u64 *words_off_claimed)
 {
   backend_ctx_t  *backend_ctx  = hashcat_ctx->backend_ctx;
   status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
@@ -113,14 +155,23 @@ static u64 get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
 
   hc_thread_mutex_lock (status_ctx->mux_dispatcher);
 
-  const u64 words_off  = status_ctx->words_off;
   const u64 words_base = (user_options->limit == 0) ? status_ctx->words_base : MIN (user_options->limit, status_ctx->words_base);
 
-  device_param->words_off = words_off;
+  // after a restore, ranges some device completed before are skipped and a claim ends where the next one starts
+
+  u64 words_off  = status_ctx->words_off;
+  u64 words_next = words_base;
+  u64 words_skip = 0;
+
+  restore_ranges_skip (hashcat_ctx, words_base, &words_off, &words_next, &words_skip);
+
+  status_ctx->words_off = words_off;
+
+  *words_off_claimed = words_off;
 
   const u64 kernel_power_all = backend_ctx->kernel_power_all;
 
-  const u64 words_left = words_base - words_off;
+  const u64 words_left = words_base - words_off - words_skip;
 
   if (words_left < kernel_power_all)
   {
@@ -130,12 +181,14 @@ static u64 get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
     }
   }
 
-  const u64 kernel_power = get_power (backend_ctx, device_param);
+  const u64 kernel_power = get_power (hashcat_ctx, device_param, words_left);
 
   u64 work = MIN (words_left, kernel_power);
 
   work = MIN (work, max);
 
+  work = MIN (work, words_next - words_off);
+
   status_ctx->words_off += work;
 
   hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
@@ -143,152 +196,604 @@ static u64 get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
   return work;
 }
 
-static int calc_stdin (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+static u64 get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 max)
+{
+  u64 words_off = 0;
+
+  const u64 work = get_work_off (hashcat_ctx, device_param, max, &words_off);
+
+  device_param->words_off = words_off;
+
+  return work;
+}
+
+/**
+ * the wordlist based attacks build their candidates on the host. done in turn with the kernel, the device sits idle
+ * while the host reads and the host sits idle while the device runs. with the second set of pws buffers from
+ * backend.c, a producer thread per device fills one set while the device thread copies and runs the other one.
+ * the producer claims and reads under mux_reader exactly as before, it just does it one batch ahead.
+ */
+
+static void pws_batch_fill (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, pws_batch_t *pws_batch)
 {
   user_options_t       *user_options       = hashcat_ctx->user_options;
   user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
   hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
   hashes_t             *hashes             = hashcat_ctx->hashes;
   straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
+  combinator_ctx_t     *combinator_ctx     = hashcat_ctx->combinator_ctx;
   status_ctx_t         *status_ctx         = hashcat_ctx->status_ctx;
+  wl_shared_t          *wl_shared          = hashcat_ctx->wl_shared;
+
+  hashcat_ctx_t *hashcat_ctx_tmp = wl_shared->hashcat_ctx_tmp;
 
   const u32 attack_mode = user_options->attack_mode;
   const u32 attack_kern = user_options_extra->attack_kern;
 
-  char *buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
+  u64 words_off = 0;
+  u64 words_fin = 0;
+  u64 words_extra = -1U;
+  u64 words_extra_total = 0;
+
+  memset (pws_batch->pws_comp, 0, device_param->size_pws_comp);
+  memset (pws_batch->pws_idx,  0, device_param->size_pws_idx);
 
-  bool iconv_enabled = false;
+  pws_batch->pws_cnt = 0;
 
-  iconv_t iconv_ctx = NULL;
+  // claiming a range and reading its words must be atomic, otherwise the shared reader position gets out of sync
 
-  char *iconv_tmp = NULL;
+  hc_thread_mutex_lock (wl_shared->mux_reader);
 
-  if (strcmp (user_options->encoding_from, user_options->encoding_to) != 0)
+  while (words_extra)
   {
-    iconv_enabled = true;
+    const u64 work = get_work_off (hashcat_ctx, device_param, words_extra, &words_off);
+
+    if (work == 0) break;
+
+    words_extra = 0;
+
+    if (words_fin == 0) pws_batch->words_start = words_off;
+
+    words_fin = words_off + work;
+
+    char *line_buf;
+    u32   line_len;
+
+    char rule_buf_out[RP_PASSWORD_SIZE];
 
-    iconv_ctx = iconv_open (user_options->encoding_to, user_options->encoding_from);
+    // only required once after --skip or --restore, all following claims start where the previous one ended
+    // the word-offset index (if any) gets us close to words_off without tokenizing everything in front of it
 
-    if (iconv_ctx == (iconv_t) -1)
+    if (wl_shared->words_cur < words_off) wl_shared->words_cur = wl_data_seek (hashcat_ctx_tmp, &wl_shared->fp, wl_shared->words_cur, words_off);
+
+    for ( ; wl_shared->words_cur < words_off; wl_shared->words_cur++) get_next_word (hashcat_ctx_tmp, &wl_shared->fp, &line_buf, &line_len);
+
+    for ( ; wl_shared->words_cur < words_fin; wl_shared->words_cur++)
     {
-      hcfree (buf);
+      get_next_word (hashcat_ctx_tmp, &wl_shared->fp, &line_buf, &line_len);
+
+      // post-process rule engine
+
+      int   rule_jk_len = (int)    user_options_extra->rule_len_l;
+      const char *rule_jk_buf = user_options->rule_buf_l;
+
+      const rp_cpu_rule_t *rule_jk_cpu = &user_options_extra->rule_cpu_l;
 
-      return -1;
+      if (attack_mode == ATTACK_MODE_HYBRID2)
+      {
+        rule_jk_len = (int)    user_options_extra->rule_len_r;
+        rule_jk_buf = user_options->rule_buf_r;
+
+        rule_jk_cpu = &user_options_extra->rule_cpu_r;
+      }
+
+      if (run_rule_engine (rule_jk_len, rule_jk_buf))
+      {
+        if (line_len >= RP_PASSWORD_SIZE) continue;
+
+        memset (rule_buf_out, 0, sizeof (rule_buf_out));
+
+        const int rule_len_out = rp_cpu_apply (rule_jk_cpu, line_buf, (int) line_len, rule_buf_out);
+
+        if (rule_len_out < 0) continue;
+
+        line_buf = rule_buf_out;
+        line_len = (u32) rule_len_out;
+      }
+
+      /*
+
+      if (attack_mode == ATTACK_MODE_ASSOCIATION)
+      {
+        // we can't reject password base on length in -a 9 because it will bring the schedule out of sync
+        // therefore we render it defective so the other candidates survive
+
+        line_len = MAX (line_len, hashconfig->pw_min);
+        line_len = MIN (line_len, hashconfig->pw_max);
+      }
+
+      This strategy turns out not to work very well. If there's a candidate shorter than pw_min, this leads to situation the \n is copied, too.
+
+      To reproduce:
+
+      $ cat hash
+      WPA*01*4d4fe7aac3a2cecab195321ceb99a7d0*fc690c158264*f4747f87f9f4*686173686361742d6573736964***
+      $ cat word
+      hashcat
+      $ ./hashcat -m 22000 -a 9 hash word
+      ...
+      Candidates.#1....: $HEX[686173686361740a21] -> $HEX[686173686361740a21]
+      ...
+      */
+
+      // This is a test fix for the above situation
+
+      if (attack_kern == ATTACK_KERN_STRAIGHT)
+      {
+        if (attack_mode == ATTACK_MODE_ASSOCIATION)
+        {
+          // do nothing, test fix for above scenario
+        }
+        else
+        {
+          if ((line_len < hashconfig->pw_min) || (line_len > hashconfig->pw_max))
+          {
+            words_extra++;
+
+            continue;
+          }
+        }
+      }
+      else if (attack_kern == ATTACK_KERN_COMBI)
+      {
+        // do not check if minimum restriction is satisfied (line_len >= hashconfig->pw_min) here
+        // since we still need to combine the plains
+
+        if (line_len > hashconfig->pw_max)
+        {
+          words_extra++;
+
+          continue;
+        }
+      }
+
+      pw_add_batch (device_param, pws_batch, (const u8 *) line_buf, (const int) line_len);
+
+      if (status_ctx->run_thread_level1 == false) break;
     }
 
-    iconv_tmp = (char *) hcmalloc (HCBUFSIZ_TINY);
+    words_extra_total += words_extra;
+
+    if (status_ctx->run_thread_level1 == false) break;
   }
 
-  while (status_ctx->run_thread_level1 == true)
+  hc_thread_mutex_unlock (wl_shared->mux_reader);
+
+  // run_cracker () gets the offset of the last claim, as always
+
+  pws_batch->words_off = words_off;
+  pws_batch->words_fin = words_fin;
+
+  if (status_ctx->run_thread_level1 == false) return;
+
+  if (words_extra_total > 0)
   {
-    hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+    hc_thread_mutex_lock (status_ctx->mux_counter);
 
-    if (feof (stdin) != 0)
+    for (u32 salt_pos = 0; salt_pos < hashes->salts_cnt; salt_pos++)
     {
-      hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+      if (attack_kern == ATTACK_KERN_STRAIGHT)
+      {
+        status_ctx->words_progress_rejected[salt_pos] += words_extra_total * straight_ctx->kernel_rules_cnt;
+      }
+      else if (attack_kern == ATTACK_KERN_COMBI)
+      {
+        status_ctx->words_progress_rejected[salt_pos] += words_extra_total * combinator_ctx->combs_cnt;
+      }
+    }
+
+    hc_thread_mutex_unlock (status_ctx->mux_counter);
+  }
+}
+
+static HC_API_CALL void *thread_pws_producer (void *p)
+{
+  thread_param_t *thread_param = (thread_param_t *) p;
+
+  hashcat_ctx_t *hashcat_ctx = thread_param->hashcat_ctx;
+  backend_ctx_t *backend_ctx = hashcat_ctx->backend_ctx;
+  status_ctx_t  *status_ctx  = hashcat_ctx->status_ctx;
+
+  hc_device_param_t *device_param = backend_ctx->devices_param + thread_param->tid;
 
-      break;
+  for (int pws_batch_idx = 0; ; pws_batch_idx ^= 1)
+  {
+    pws_batch_t *pws_batch = &device_param->pws_batches[pws_batch_idx];
+    pws_batch_t *pws_other = &device_param->pws_batches[pws_batch_idx ^ 1];
+
+    // wait for the device thread to hand the set back.
+    // close to the end, claiming ahead would only leave a second claim with a device that might be the slowest
+
+    hc_thread_mutex_lock (device_param->pws_batch_mux);
+
+    while (((pws_batch->ready == true) || ((backend_ctx->kernel_power_final > 0) && (pws_other->ready == true))) && (device_param->pws_batch_stop == false))
+    {
+      hc_thread_cond_wait (device_param->pws_batch_cond, device_param->pws_batch_mux);
     }
 
-    u64 words_extra_total = 0;
+    const bool stop = device_param->pws_batch_stop;
 
-    memset (device_param->pws_comp, 0, device_param->size_pws_comp);
-    memset (device_param->pws_idx,  0, device_param->size_pws_idx);
+    hc_thread_mutex_unlock (device_param->pws_batch_mux);
+
+    if (stop == true) break;
+
+    pws_batch_fill (hashcat_ctx, device_param, pws_batch);
+
+    hc_thread_mutex_lock (device_param->pws_batch_mux);
+
+    pws_batch->ready = true;
+
+    hc_thread_cond_wake (device_param->pws_batch_cond);
+
+    hc_thread_mutex_unlock (device_param->pws_batch_mux);
+
+    // the device thread stops at an empty or interrupted batch, so there is nothing left to prepare
+
+    if (pws_batch->words_fin == 0) break;
+
+    if (status_ctx->run_thread_level1 == false) break;
+  }
+
+  return NULL;
+}
+
+static void pws_batch_wait (hc_device_param_t *device_param, pws_batch_t *pws_batch)
+{
+  hc_thread_mutex_lock (device_param->pws_batch_mux);
+
+  while (pws_batch->ready == false)
+  {
+    hc_thread_cond_wait (device_param->pws_batch_cond, device_param->pws_batch_mux);
+  }
+
+  hc_thread_mutex_unlock (device_param->pws_batch_mux);
+}
+
+static void pws_batch_release (hc_device_param_t *device_param, pws_batch_t *pws_batch)
+{
+  hc_thread_mutex_lock (device_param->pws_batch_mux);
+
+  pws_batch->ready = false;
+
+  hc_thread_cond_wake (device_param->pws_batch_cond);
+
+  hc_thread_mutex_unlock (device_param->pws_batch_mux);
+}
+
+#ifdef WITH_BRAIN
+/**
+ * with a brain server that can seal batches, the slow candidates loops are pipelined:
+ * each round generates a batch and posts its lookup to the brain link thread, but the device runs the batch
+ * generated in the round before, whose lookup went over the wire while the device was busy with the one before that.
+ * the first chunk of the next batch is reserved ahead the same way and commits are posted without waiting.
+ * the server keeps the sealed batches apart, so a commit only ever takes the batch the device just finished.
+ * brain rejects are known only once a batch is complete, so they shrink the batch instead of being refilled.
+ */
+
+static void brain_pipeline_start (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+{
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  brain_link_batch_t *batch0 = &device_param->brain_link_batches[0];
+  brain_link_batch_t *batch1 = &device_param->brain_link_batches[1];
+
+  // the second set of buffers is allocated in backend_session_begin ()
+
+  batch0->pws_pre_buf = device_param->pws_pre_buf;
+  batch0->in_buf      = device_param->brain_link_in_buf;
+  batch0->out_buf     = device_param->brain_link_out_buf;
+
+  batch0->pending = false;
+  batch1->pending = false;
+
+  batch0->commit_ticket = 0;
+  batch1->commit_ticket = 0;
+
+  device_param->brain_link_batch_idx = 0;
+
+  device_param->brain_link_reserve.pending = false;
+
+  brain_client_start (device_param, status_ctx);
+}
+
+static void brain_pipeline_stop (hc_device_param_t *device_param)
+{
+  if (device_param->brain_link_pipeline == false) return;
+
+  brain_client_stop (device_param);
+
+  brain_link_batch_t *batch0 = &device_param->brain_link_batches[0];
+
+  device_param->pws_pre_buf        = batch0->pws_pre_buf;
+  device_param->brain_link_in_buf  = batch0->in_buf;
+  device_param->brain_link_out_buf = batch0->out_buf;
+}
+
+static void brain_pipeline_connect (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+{
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  if (device_param->brain_link_client_fd != -1) return;
+
+  // the link thread gives up on everything queued once the socket is closed, wait for that before we replace it
+
+  brain_client_sync (device_param);
+
+  const i64 passwords_max = device_param->hardware_power * device_param->kernel_accel;
+
+  u64 highest = 0;
+
+  if (brain_client_connect (device_param, status_ctx, user_options->brain_host, user_options->brain_port, user_options->brain_password, user_options->brain_session, user_options->brain_attack, passwords_max, &highest) == false)
+  {
+    brain_client_disconnect (device_param);
+
+    return;
+  }
+
+  // a server which can't keep our batches apart would commit batches we did not run yet
+
+  if (device_param->brain_link_version < (u32) BRAIN_LINK_VERSION_PIPELINE)
+  {
+    brain_client_disconnect (device_param);
+  }
+}
+
+// the first chunk of a batch comes from the reservation posted ahead in brain_pipeline_swap ()
+
+static u64 brain_pipeline_get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 max)
+{
+  brain_link_reserve_t *reserve = &device_param->brain_link_reserve;
+
+  if ((device_param->brain_link_pipeline == true) && (reserve->pending == true))
+  {
+    device_param->words_off = reserve->words_off;
+
+    return reserve->work;
+  }
+
+  return get_work (hashcat_ctx, device_param, max);
+}
+
+static u64 brain_pipeline_reserve (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 words_off, const u64 work)
+{
+  brain_link_reserve_t *reserve = &device_param->brain_link_reserve;
+
+  if (reserve->pending == true)
+  {
+    reserve->pending = false;
+
+    brain_client_wait (device_param, reserve->ticket);
+
+    if ((reserve->ok == true) && (reserve->epoch == device_param->brain_link_epoch)) return reserve->overlap;
+  }
+
+  brain_pipeline_connect (hashcat_ctx, device_param);
+
+  u64  overlap = 0;
+  bool ok      = false;
+
+  brain_link_job_t job;
+
+  memset (&job, 0, sizeof (job));
+
+  job.operation = BRAIN_OPERATION_ATTACK_RESERVE;
+  job.words_off = words_off;
+  job.work      = work;
+  job.overlap   = &overlap;
+  job.ok        = &ok;
+
+  brain_client_wait (device_param, brain_client_post (device_param, &job));
+
+  return overlap;
+}
+
+static bool brain_pipeline_swap (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u64 words_fin, const bool with_base, u64 *words_fin_run)
+{
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  brain_link_batch_t *batch_gen = &device_param->brain_link_batches[device_param->brain_link_batch_idx];
+  brain_link_batch_t *batch_run = &device_param->brain_link_batches[device_param->brain_link_batch_idx ^ 1];
+
+  // hand the batch generated in this round to the link thread
+
+  batch_gen->pws_pre_cnt = device_param->pws_pre_cnt;
+  batch_gen->words_fin   = words_fin;
+  batch_gen->ticket      = 0;
+  batch_gen->epoch       = device_param->brain_link_epoch;
+  batch_gen->ok          = true;
+  batch_gen->pending     = (words_fin > 0);
+
+  if (batch_gen->pending == true)
+  {
+    brain_link_job_t job;
+
+    if ((user_options->brain_client_features & BRAIN_CLIENT_FEATURE_HASHES) && (batch_gen->pws_pre_cnt > 0))
+    {
+      memset (&job, 0, sizeof (job));
+
+      job.operation = BRAIN_OPERATION_HASH_LOOKUP;
+      job.out_buf   = batch_gen->out_buf;
+      job.in_buf    = batch_gen->in_buf;
+      job.cnt       = batch_gen->pws_pre_cnt;
+      job.ok        = &batch_gen->ok;
+
+      batch_gen->ticket = brain_client_post (device_param, &job);
+    }
+
+    memset (&job, 0, sizeof (job));
+
+    job.operation = BRAIN_OPERATION_SEAL;
+
+    brain_client_post (device_param, &job);
+
+    if (user_options->brain_client_features & BRAIN_CLIENT_FEATURE_ATTACKS)
+    {
+      const u64 work = get_work (hashcat_ctx, device_param, -1);
+
+      if (work > 0)
+      {
+        brain_link_reserve_t *reserve = &device_param->brain_link_reserve;
+
+        reserve->words_off = device_param->words_off;
+        reserve->work      = work;
+        reserve->overlap   = 0;
+        reserve->epoch     = device_param->brain_link_epoch;
+        reserve->ok        = false;
+        reserve->pending   = true;
+
+        memset (&job, 0, sizeof (job));
+
+        job.operation = BRAIN_OPERATION_ATTACK_RESERVE;
+        job.words_off = reserve->words_off;
+        job.work      = reserve->work;
+        job.overlap   = &reserve->overlap;
+        job.ok        = &reserve->ok;
+
+        reserve->ticket = brain_client_post (device_param, &job);
+      }
+    }
+  }
+
+  // run the batch of the previous round, its buffers are filled again in the next round
+
+  device_param->brain_link_batch_idx ^= 1;
+
+  device_param->pws_pre_buf        = batch_run->pws_pre_buf;
+  device_param->brain_link_in_buf  = batch_run->in_buf;
+  device_param->brain_link_out_buf = batch_run->out_buf;
+
+  *words_fin_run = 0;
 
-    #define DISABLE_READ_TIMEOUT_AFTER 1000
+  if (batch_run->pending == true)
+  {
+    if (batch_run->ticket > 0) brain_client_wait (device_param, batch_run->ticket);
+
+    const bool looked_up = (batch_run->ticket > 0) && (batch_run->ok == true);
 
-    int selects_returned = 0;
+    u64 brain_rejects = 0;
 
-    while (device_param->pws_cnt < device_param->kernel_power)
+    for (u64 pws_pre_idx = 0; pws_pre_idx < batch_run->pws_pre_cnt; pws_pre_idx++)
     {
-      if (selects_returned < DISABLE_READ_TIMEOUT_AFTER)
+      if ((looked_up == true) && (batch_run->in_buf[pws_pre_idx] == 1))
       {
-        const int rc_select = select_read_timeout_console (1);
+        brain_rejects++;
 
-        if (rc_select == -1) break;
+        continue;
+      }
 
-        if (rc_select == 0)
-        {
-          if (status_ctx->run_thread_level1 == false) break;
+      pw_pre_t *pw_pre = batch_run->pws_pre_buf + pws_pre_idx;
 
-          status_ctx->stdin_read_timeout_cnt++;
+      if (with_base == true) pw_base_add (device_param, pw_pre);
 
-          continue;
-        }
+      pw_add (device_param, (const u8 *) pw_pre->pw_buf, (const int) pw_pre->pw_len);
+    }
 
-        status_ctx->stdin_read_timeout_cnt = 0;
+    if (brain_rejects > 0)
+    {
+      hc_thread_mutex_lock (status_ctx->mux_counter);
 
-        selects_returned++;
+      for (u32 salt_pos = 0; salt_pos < hashes->salts_cnt; salt_pos++)
+      {
+        status_ctx->words_progress_rejected[salt_pos] += brain_rejects;
       }
 
-      char *line_buf = fgets (buf, HCBUFSIZ_LARGE - 1, stdin);
+      hc_thread_mutex_unlock (status_ctx->mux_counter);
+    }
 
-      if (line_buf == NULL) break;
+    *words_fin_run = batch_run->words_fin;
+  }
 
-      size_t line_len = in_superchop (line_buf);
+  return batch_gen->pending;
+}
 
-      line_len = convert_from_hex (hashcat_ctx, line_buf, (u32) line_len);
+// every sealed batch is committed, even if all of it was rejected, the server expects them in order
 
-      // do the on-the-fly encoding
+static void brain_pipeline_commit (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+{
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
 
-      if (iconv_enabled == true)
-      {
-        char  *iconv_ptr = iconv_tmp;
-        size_t iconv_sz  = HCBUFSIZ_TINY;
+  brain_link_batch_t *batch_run = &device_param->brain_link_batches[device_param->brain_link_batch_idx];
 
-        if (iconv (iconv_ctx, &line_buf, &line_len, &iconv_ptr, &iconv_sz) == (size_t) -1) continue;
+  if (batch_run->pending == false) return;
 
-        line_buf = iconv_tmp;
-        line_len = HCBUFSIZ_TINY - iconv_sz;
-      }
+  batch_run->pending = false;
 
-      // post-process rule engine
+  if ((status_ctx->devices_status == STATUS_ABORTED)
+   || (status_ctx->devices_status == STATUS_ABORTED_RUNTIME)
+   || (status_ctx->devices_status == STATUS_QUIT)
+   || (status_ctx->devices_status == STATUS_BYPASS)
+   || (status_ctx->devices_status == STATUS_ERROR)) return;
 
-      char rule_buf_out[RP_PASSWORD_SIZE];
+  // it was sealed on a connection which is gone, and the server dropped it along with the connection
 
-      int   rule_jk_len = (int)    user_options_extra->rule_len_l;
-      const char *rule_jk_buf = user_options->rule_buf_l;
+  if (batch_run->epoch != device_param->brain_link_epoch) return;
 
-      if (attack_mode == ATTACK_MODE_HYBRID2)
-      {
-        rule_jk_len = (int)    user_options_extra->rule_len_r;
-        rule_jk_buf = user_options->rule_buf_r;
-      }
+  brain_link_job_t job;
 
-      if (run_rule_engine (rule_jk_len, rule_jk_buf))
-      {
-        if (line_len >= RP_PASSWORD_SIZE) continue;
+  memset (&job, 0, sizeof (job));
 
-        memset (rule_buf_out, 0, sizeof (rule_buf_out));
+  job.operation = BRAIN_OPERATION_COMMIT;
 
-        const int rule_len_out = _old_apply_rule (rule_jk_buf, rule_jk_len, line_buf, (int) line_len, rule_buf_out);
+  // the buffers of the batch are filled again in the next round, while the commit may still be queued
 
-        if (rule_len_out < 0) continue;
+  if ((batch_run->commit_buf != NULL) && (batch_run->ticket > 0) && (batch_run->ok == true))
+  {
+    if (batch_run->commit_ticket > 0) brain_client_wait (device_param, batch_run->commit_ticket);
 
-        line_buf = rule_buf_out;
-        line_len = (size_t) rule_len_out;
-      }
+    job.out_buf = (u32 *) batch_run->commit_buf;
+    job.cnt     = brain_client_filter_collect (batch_run->commit_buf, batch_run->out_buf, batch_run->in_buf, batch_run->pws_pre_cnt);
+  }
 
-      if (line_len > PW_MAX) continue;
+  batch_run->commit_ticket = brain_client_post (device_param, &job);
+}
+#endif
 
-      // hmm that's always the case, or?
+static void pw_pre_reset (hc_device_param_t *device_param, const bool batch_start)
+{
+  // a pipelined brain batch is looked up as a whole, so the refill rounds add to it
 
-      if (attack_kern == ATTACK_KERN_STRAIGHT)
-      {
-        if ((line_len < hashconfig->pw_min) || (line_len > hashconfig->pw_max))
-        {
-          words_extra_total++;
+  bool pipeline = false;
 
-          continue;
-        }
-      }
+  #ifdef WITH_BRAIN
+  pipeline = device_param->brain_link_pipeline;
+  #endif
 
-      pw_add (device_param, (const u8 *) line_buf, (const int) line_len);
+  if ((pipeline == true) && (batch_start == false)) return;
 
-      if (status_ctx->run_thread_level1 == false) break;
-    }
+  memset (device_param->pws_pre_buf, 0, device_param->size_pws_pre);
+
+  device_param->pws_pre_cnt = 0;
+}
+
+static int calc_stdin (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+{
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+
+  // stdin itself is read by the reader thread started in wl_shared_init (), see wordlist.c
+
+  while (status_ctx->run_thread_level1 == true)
+  {
+    u64 words_extra_total = 0;
+
+    memset (device_param->pws_comp, 0, device_param->size_pws_comp);
+    memset (device_param->pws_idx,  0, device_param->size_pws_idx);
 
-    hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+    wl_stdin_fill (hashcat_ctx, device_param, &words_extra_total);
 
     if (words_extra_total > 0)
     {
@@ -308,19 +813,9 @@ static int calc_stdin (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_par
 
     // flush
 
-    if (run_copy (hashcat_ctx, device_param, device_param->pws_cnt) == -1)
-    {
-      hcfree (buf);
-
-      return -1;
-    }
-
-    if (run_cracker (hashcat_ctx, device_param, -1, device_param->pws_cnt) == -1) // no pws_pos?
-    {
-      hcfree (buf);
+    if (run_copy (hashcat_ctx, device_param, device_param->pws_cnt) == -1) return -1;
 
-      return -1;
-    }
+    if (run_cracker (hashcat_ctx, device_param, -1, device_param->pws_cnt) == -1) return -1; // no pws_pos?
 
     device_param->pws_cnt = 0;
 
@@ -337,15 +832,6 @@ static int calc_stdin (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_par
   device_param->kernel_loops   = 0;
   device_param->kernel_threads = 0;
 
-  if (iconv_enabled == true)
-  {
-    iconv_close (iconv_ctx);
-
-    hcfree (iconv_tmp);
-  }
-
-  hcfree (buf);
-
   return 0;
 }
 
@@ -415,7 +901,6 @@ HC_API_CALL void *thread_calc_stdin (void *p)
 static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 {
   user_options_t       *user_options       = hashcat_ctx->user_options;
-  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
   hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
   hashes_t             *hashes             = hashcat_ctx->hashes;
   mask_ctx_t           *mask_ctx           = hashcat_ctx->mask_ctx;
@@ -425,7 +910,6 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
   status_ctx_t         *status_ctx         = hashcat_ctx->status_ctx;
 
   const u32 attack_mode = user_options->attack_mode;
-  const u32 attack_kern = user_options_extra->attack_kern;
 
   if (user_options->slow_candidates == true)
   {
@@ -462,6 +946,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
       }
+
+      if ((device_param->brain_link_client_fd != -1) && (device_param->brain_link_version >= (u32) BRAIN_LINK_VERSION_PIPELINE))
+      {
+        brain_pipeline_start (hashcat_ctx, device_param);
+      }
     }
     #endif
 
@@ -499,6 +988,8 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
         return -1;
       }
 
+      wl_data_index_load (hashcat_ctx_tmp, &extra_info_straight.fp, dictfile);
+
       u64 words_cur = 0;
 
       while (status_ctx->run_thread_level1 == true)
@@ -513,7 +1004,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         // this greatly reduces spam on hashcat console
 
-        const u64 pre_rejects_ignore = get_power (backend_ctx, device_param) / 2;
+        const u64 pre_rejects_ignore = get_power (hashcat_ctx, device_param, backend_ctx->kernel_power_final) / 2;
 
         while (pre_rejects > pre_rejects_ignore)
         {
@@ -523,13 +1014,15 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
           pre_rejects = 0;
 
-          memset (device_param->pws_pre_buf, 0, device_param->size_pws_pre);
-
-          device_param->pws_pre_cnt = 0;
+          pw_pre_reset (device_param, words_extra == (u64) -1);
 
           while (words_extra)
           {
+            #ifdef WITH_BRAIN
+            u64 work = brain_pipeline_get_work (hashcat_ctx, device_param, words_extra);
+            #else
             u64 work = get_work (hashcat_ctx, device_param, words_extra);
+            #endif
 
             if (work == 0) break;
 
@@ -538,7 +1031,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
             #ifdef WITH_BRAIN
             if (user_options->brain_client == true)
             {
-              if (device_param->brain_link_client_fd == -1)
+              if (device_param->brain_link_pipeline == true)
+              {
+                brain_pipeline_connect (hashcat_ctx, device_param);
+              }
+              else if (device_param->brain_link_client_fd == -1)
               {
                 const i64 passwords_max = device_param->hardware_power * device_param->kernel_accel;
 
@@ -552,7 +1049,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
               {
                 u64 overlap = 0;
 
-                if (brain_client_reserve (device_param, status_ctx, words_off, work, &overlap) == false)
+                if (device_param->brain_link_pipeline == true)
+                {
+                  overlap = brain_pipeline_reserve (hashcat_ctx, device_param, words_off, work);
+                }
+                else if (brain_client_reserve (device_param, status_ctx, words_off, work, &overlap) == false)
                 {
                   brain_client_disconnect (device_param);
                 }
@@ -613,7 +1114,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           }
 
           #ifdef WITH_BRAIN
-          if (user_options->brain_client == true)
+          if (device_param->brain_link_pipeline == true)
+          {
+            // looked up and added as a whole in brain_pipeline_swap ()
+          }
+          else if (user_options->brain_client == true)
           {
             if (user_options->brain_client_features & BRAIN_CLIENT_FEATURE_HASHES)
             {
@@ -688,6 +1193,15 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
         // flush
         //
 
+        #ifdef WITH_BRAIN
+        bool pipeline_pending = false;
+
+        if (device_param->brain_link_pipeline == true)
+        {
+          pipeline_pending = brain_pipeline_swap (hashcat_ctx, device_param, words_fin, true, &words_fin);
+        }
+        #endif
+
         const u64 pws_cnt = device_param->pws_cnt;
 
         if (pws_cnt)
@@ -713,7 +1227,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           }
 
           #ifdef WITH_BRAIN
-          if (user_options->brain_client == true)
+          if ((user_options->brain_client == true) && (device_param->brain_link_pipeline == false))
           {
             if ((status_ctx->devices_status != STATUS_ABORTED)
              && (status_ctx->devices_status != STATUS_ABORTED_RUNTIME)
@@ -733,6 +1247,13 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           device_param->pws_base_cnt = 0;
         }
 
+        #ifdef WITH_BRAIN
+        if (device_param->brain_link_pipeline == true)
+        {
+          brain_pipeline_commit (hashcat_ctx, device_param);
+        }
+        #endif
+
         if (device_param->speed_only_finish == true) break;
 
         if (status_ctx->run_thread_level2 == true)
@@ -744,7 +1265,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         if (status_ctx->run_thread_level1 == false) break;
 
+        #ifdef WITH_BRAIN
+        if ((words_fin == 0) && (pipeline_pending == false)) break;
+        #else
         if (words_fin == 0) break;
+        #endif
       }
 
       hc_fclose (&extra_info_straight.fp);
@@ -811,6 +1336,8 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
         return -1;
       }
 
+      wl_data_index_load (hashcat_ctx_tmp, &extra_info_combi.base_fp, base_file);
+
       u64 words_cur = 0;
 
       while (status_ctx->run_thread_level1 == true)
@@ -825,7 +1352,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         // this greatly reduces spam on hashcat console
 
-        const u64 pre_rejects_ignore = get_power (backend_ctx, device_param) / 2;
+        const u64 pre_rejects_ignore = get_power (hashcat_ctx, device_param, backend_ctx->kernel_power_final) / 2;
 
         while (pre_rejects > pre_rejects_ignore)
         {
@@ -835,13 +1362,15 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
           pre_rejects = 0;
 
-          memset (device_param->pws_pre_buf, 0, device_param->size_pws_pre);
-
-          device_param->pws_pre_cnt = 0;
+          pw_pre_reset (device_param, words_extra == (u64) -1);
 
           while (words_extra)
           {
+            #ifdef WITH_BRAIN
+            u64 work = brain_pipeline_get_work (hashcat_ctx, device_param, words_extra);
+            #else
             u64 work = get_work (hashcat_ctx, device_param, words_extra);
+            #endif
 
             if (work == 0) break;
 
@@ -852,7 +1381,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
             #ifdef WITH_BRAIN
             if (user_options->brain_client == true)
             {
-              if (device_param->brain_link_client_fd == -1)
+              if (device_param->brain_link_pipeline == true)
+              {
+                brain_pipeline_connect (hashcat_ctx, device_param);
+              }
+              else if (device_param->brain_link_client_fd == -1)
               {
                 const i64 passwords_max = device_param->hardware_power * device_param->kernel_accel;
 
@@ -866,7 +1399,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
               {
                 u64 overlap = 0;
 
-                if (brain_client_reserve (device_param, status_ctx, words_off, work, &overlap) == false)
+                if (device_param->brain_link_pipeline == true)
+                {
+                  overlap = brain_pipeline_reserve (hashcat_ctx, device_param, words_off, work);
+                }
+                else if (brain_client_reserve (device_param, status_ctx, words_off, work, &overlap) == false)
                 {
                   brain_client_disconnect (device_param);
                 }
@@ -925,7 +1462,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           }
 
           #ifdef WITH_BRAIN
-          if (user_options->brain_client == true)
+          if (device_param->brain_link_pipeline == true)
+          {
+            // looked up and added as a whole in brain_pipeline_swap ()
+          }
+          else if (user_options->brain_client == true)
           {
             if (user_options->brain_client_features & BRAIN_CLIENT_FEATURE_HASHES)
             {
@@ -1000,6 +1541,15 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
         // flush
         //
 
+        #ifdef WITH_BRAIN
+        bool pipeline_pending = false;
+
+        if (device_param->brain_link_pipeline == true)
+        {
+          pipeline_pending = brain_pipeline_swap (hashcat_ctx, device_param, words_fin, true, &words_fin);
+        }
+        #endif
+
         const u64 pws_cnt = device_param->pws_cnt;
 
         if (pws_cnt)
@@ -1027,7 +1577,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           }
 
           #ifdef WITH_BRAIN
-          if (user_options->brain_client == true)
+          if ((user_options->brain_client == true) && (device_param->brain_link_pipeline == false))
           {
             if ((status_ctx->devices_status != STATUS_ABORTED)
              && (status_ctx->devices_status != STATUS_ABORTED_RUNTIME)
@@ -1047,6 +1597,13 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           device_param->pws_base_cnt = 0;
         }
 
+        #ifdef WITH_BRAIN
+        if (device_param->brain_link_pipeline == true)
+        {
+          brain_pipeline_commit (hashcat_ctx, device_param);
+        }
+        #endif
+
         if (device_param->speed_only_finish == true) break;
 
         if (status_ctx->run_thread_level2 == true)
@@ -1058,7 +1615,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         if (status_ctx->run_thread_level1 == false) break;
 
+        #ifdef WITH_BRAIN
+        if ((words_fin == 0) && (pipeline_pending == false)) break;
+        #else
         if (words_fin == 0) break;
+        #endif
       }
 
       hc_fclose (&extra_info_combi.base_fp);
@@ -1090,7 +1651,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         // this greatly reduces spam on hashcat console
 
-        const u64 pre_rejects_ignore = get_power (backend_ctx, device_param) / 2;
+        const u64 pre_rejects_ignore = get_power (hashcat_ctx, device_param, backend_ctx->kernel_power_final) / 2;
 
         while (pre_rejects > pre_rejects_ignore)
         {
@@ -1100,13 +1661,15 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
           pre_rejects = 0;
 
-          memset (device_param->pws_pre_buf, 0, device_param->size_pws_pre);
-
-          device_param->pws_pre_cnt = 0;
+          pw_pre_reset (device_param, words_extra == (u64) -1);
 
           while (words_extra)
           {
+            #ifdef WITH_BRAIN
+            u64 work = brain_pipeline_get_work (hashcat_ctx, device_param, words_extra);
+            #else
             u64 work = get_work (hashcat_ctx, device_param, words_extra);
+            #endif
 
             if (work == 0) break;
 
@@ -1117,7 +1680,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
             #ifdef WITH_BRAIN
             if (user_options->brain_client == true)
             {
-              if (device_param->brain_link_client_fd == -1)
+              if (device_param->brain_link_pipeline == true)
+              {
+                brain_pipeline_connect (hashcat_ctx, device_param);
+              }
+              else if (device_param->brain_link_client_fd == -1)
               {
                 const i64 passwords_max = device_param->hardware_power * device_param->kernel_accel;
 
@@ -1131,7 +1698,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
               {
                 u64 overlap = 0;
 
-                if (brain_client_reserve (device_param, status_ctx, words_off, work, &overlap) == false)
+                if (device_param->brain_link_pipeline == true)
+                {
+                  overlap = brain_pipeline_reserve (hashcat_ctx, device_param, words_off, work);
+                }
+                else if (brain_client_reserve (device_param, status_ctx, words_off, work, &overlap) == false)
                 {
                   brain_client_disconnect (device_param);
                 }
@@ -1180,7 +1751,11 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           }
 
           #ifdef WITH_BRAIN
-          if (user_options->brain_client == true)
+          if (device_param->brain_link_pipeline == true)
+          {
+            // looked up and added as a whole in brain_pipeline_swap ()
+          }
+          else if (user_options->brain_client == true)
           {
             if (user_options->brain_client_features & BRAIN_CLIENT_FEATURE_HASHES)
             {
@@ -1249,6 +1824,15 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
         // flush
         //
 
+        #ifdef WITH_BRAIN
+        bool pipeline_pending = false;
+
+        if (device_param->brain_link_pipeline == true)
+        {
+          pipeline_pending = brain_pipeline_swap (hashcat_ctx, device_param, words_fin, false, &words_fin);
+        }
+        #endif
+
         const u64 pws_cnt = device_param->pws_cnt;
 
         if (pws_cnt)
@@ -1257,7 +1841,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           if (run_cracker (hashcat_ctx, device_param, -1, pws_cnt) == -1) return -1;
 
           #ifdef WITH_BRAIN
-          if (user_options->brain_client == true)
+          if ((user_options->brain_client == true) && (device_param->brain_link_pipeline == false))
           {
             if ((status_ctx->devices_status != STATUS_ABORTED)
              && (status_ctx->devices_status != STATUS_ABORTED_RUNTIME)
@@ -1276,6 +1860,13 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           device_param->pws_cnt = 0;
         }
 
+        #ifdef WITH_BRAIN
+        if (device_param->brain_link_pipeline == true)
+        {
+          brain_pipeline_commit (hashcat_ctx, device_param);
+        }
+        #endif
+
         if (device_param->speed_only_finish == true) break;
 
         if (status_ctx->run_thread_level2 == true)
@@ -1287,13 +1878,19 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         if (status_ctx->run_thread_level1 == false) break;
 
+        #ifdef WITH_BRAIN
+        if ((words_fin == 0) && (pipeline_pending == false)) break;
+        #else
         if (words_fin == 0) break;
+        #endif
       }
     }
 
     #ifdef WITH_BRAIN
     if (user_options->brain_client == true)
     {
+      brain_pipeline_stop (device_param);
+
       brain_client_disconnect (device_param);
     }
     #endif
@@ -1337,24 +1934,15 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           device_param->words_done = MAX (device_param->words_done, words_fin);
 
           status_ctx->words_cur = get_lowest_words_done (hashcat_ctx);
+
+          restore_ranges_add (hashcat_ctx, words_off, words_fin);
         }
       }
     }
     else
     {
-      char *dictfile = straight_ctx->dict;
-
       if (attack_mode == ATTACK_MODE_COMBI)
       {
-        if (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT)
-        {
-          dictfile = combinator_ctx->dict1;
-        }
-        else
-        {
-          dictfile = combinator_ctx->dict2;
-        }
-
         const u32 combs_mode = combinator_ctx->combs_mode;
 
         if (combs_mode == COMBINATOR_MODE_BASE_LEFT)
@@ -1381,210 +1969,79 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
         }
       }
 
-      HCFILE fp;
+      // the producer only runs with the second set of pws buffers, without it the batches are filled in turn
 
-      if (hc_fopen (&fp, dictfile, "rb") == false)
-      {
-        event_log_error (hashcat_ctx, "%s: %s", dictfile, strerror (errno));
+      const bool pws_double = (device_param->pws_batches[1].pws_comp != NULL);
 
-        return -1;
-      }
+      device_param->pws_batches[0].pws_comp = device_param->pws_comp;
+      device_param->pws_batches[0].pws_idx  = device_param->pws_idx;
 
-      hashcat_ctx_t *hashcat_ctx_tmp = (hashcat_ctx_t *) hcmalloc (sizeof (hashcat_ctx_t));
+      device_param->pws_batches[0].ready = false;
+      device_param->pws_batches[1].ready = false;
 
-      memcpy (hashcat_ctx_tmp, hashcat_ctx, sizeof (hashcat_ctx_t)); // yes we actually want to copy these pointers
+      device_param->pws_batch_stop = false;
 
-      hashcat_ctx_tmp->wl_data = (wl_data_t *) hcmalloc (sizeof (wl_data_t));
+      thread_param_t producer_param;
 
-      if (wl_data_init (hashcat_ctx_tmp) == -1)
-      {
-        if (attack_mode == ATTACK_MODE_COMBI) hc_fclose (&device_param->combs_fp);
+      producer_param.hashcat_ctx = hashcat_ctx;
+      producer_param.tid         = (u32) (device_param - backend_ctx->devices_param);
 
-        hc_fclose (&fp);
+      hc_thread_t producer_thread;
 
-        hcfree (hashcat_ctx_tmp->wl_data);
-        hcfree (hashcat_ctx_tmp);
+      if (pws_double == true)
+      {
+        hc_thread_mutex_init (device_param->pws_batch_mux);
+        hc_thread_cond_init  (device_param->pws_batch_cond);
 
-        return -1;
+        hc_thread_create (producer_thread, thread_pws_producer, &producer_param);
       }
 
-      u64 words_cur = 0;
+      int rc = 0;
+
+      int pws_batch_idx = 0;
 
       while (status_ctx->run_thread_level1 == true)
       {
-        u64 words_off = 0;
-        u64 words_fin = 0;
-        u64 words_extra = -1U;
-        u64 words_extra_total = 0;
-
-        memset (device_param->pws_comp, 0, device_param->size_pws_comp);
-        memset (device_param->pws_idx,  0, device_param->size_pws_idx);
+        pws_batch_t *pws_batch = &device_param->pws_batches[pws_batch_idx];
 
-        while (words_extra)
+        if (pws_double == true)
         {
-          const u64 work = get_work (hashcat_ctx, device_param, words_extra);
-
-          if (work == 0) break;
-
-          words_extra = 0;
-
-          words_off = device_param->words_off;
-          words_fin = words_off + work;
-
-          char *line_buf;
-          u32   line_len;
-
-          char rule_buf_out[RP_PASSWORD_SIZE];
-
-          for ( ; words_cur < words_off; words_cur++) get_next_word (hashcat_ctx_tmp, &fp, &line_buf, &line_len);
-
-          for ( ; words_cur < words_fin; words_cur++)
-          {
-            get_next_word (hashcat_ctx_tmp, &fp, &line_buf, &line_len);
-
-            // post-process rule engine
-
-            int   rule_jk_len = (int)    user_options_extra->rule_len_l;
-            const char *rule_jk_buf = user_options->rule_buf_l;
-
-            if (attack_mode == ATTACK_MODE_HYBRID2)
-            {
-              rule_jk_len = (int)    user_options_extra->rule_len_r;
-              rule_jk_buf = user_options->rule_buf_r;
-            }
-
-            if (run_rule_engine (rule_jk_len, rule_jk_buf))
-            {
-              if (line_len >= RP_PASSWORD_SIZE) continue;
-
-              memset (rule_buf_out, 0, sizeof (rule_buf_out));
-
-              const int rule_len_out = _old_apply_rule (rule_jk_buf, rule_jk_len, line_buf, (int) line_len, rule_buf_out);
-
-              if (rule_len_out < 0) continue;
-
-              line_buf = rule_buf_out;
-              line_len = (u32) rule_len_out;
-            }
-
-            /*
-
-            if (attack_mode == ATTACK_MODE_ASSOCIATION)
-            {
-              // we can't reject password base on length in -a 9 because it will bring the schedule out of sync
-              // therefore we render it defective so the other candidates survive
-
-              line_len = MAX (line_len, hashconfig->pw_min);
-              line_len = MIN (line_len, hashconfig->pw_max);
-            }
-
-            This strategy turns out not to work very well. If there's a candidate shorter than pw_min, this leads to situation the \n is copied, too.
-
-            To reproduce:
-
-            $ cat hash
-            WPA*01*4d4fe7aac3a2cecab195321ceb99a7d0*fc690c158264*f4747f87f9f4*686173686361742d6573736964***
-            $ cat word
-            hashcat
-            $ ./hashcat -m 22000 -a 9 hash word
-            ...
-            Candidates.#1....: $HEX[686173686361740a21] -> $HEX[686173686361740a21]
-            ...
-            */
-
-            // This is a test fix for the above situation
-
-            if (attack_kern == ATTACK_KERN_STRAIGHT)
-            {
-              if (attack_mode == ATTACK_MODE_ASSOCIATION)
-              {
-                // do nothing, test fix for above scenario
-              }
-              else
-              {
-                if ((line_len < hashconfig->pw_min) || (line_len > hashconfig->pw_max))
-                {
-                  words_extra++;
-
-                  continue;
-                }
-              }
-            }
-            else if (attack_kern == ATTACK_KERN_COMBI)
-            {
-              // do not check if minimum restriction is satisfied (line_len >= hashconfig->pw_min) here
-              // since we still need to combine the plains
-
-              if (line_len > hashconfig->pw_max)
-              {
-                words_extra++;
-
-                continue;
-              }
-            }
-
-            pw_add (device_param, (const u8 *) line_buf, (const int) line_len);
-
-            if (status_ctx->run_thread_level1 == false) break;
-          }
-
-          words_extra_total += words_extra;
-
-          if (status_ctx->run_thread_level1 == false) break;
+          pws_batch_wait (device_param, pws_batch);
         }
-
-        if (status_ctx->run_thread_level1 == false) break;
-
-        if (words_extra_total > 0)
+        else
         {
-          hc_thread_mutex_lock (status_ctx->mux_counter);
+          pws_batch_fill (hashcat_ctx, device_param, pws_batch);
+        }
 
-          for (u32 salt_pos = 0; salt_pos < hashes->salts_cnt; salt_pos++)
-          {
-            if (attack_kern == ATTACK_KERN_STRAIGHT)
-            {
-              status_ctx->words_progress_rejected[salt_pos] += words_extra_total * straight_ctx->kernel_rules_cnt;
-            }
-            else if (attack_kern == ATTACK_KERN_COMBI)
-            {
-              status_ctx->words_progress_rejected[salt_pos] += words_extra_total * combinator_ctx->combs_cnt;
-            }
-          }
+        if (status_ctx->run_thread_level1 == false) break;
 
-          hc_thread_mutex_unlock (status_ctx->mux_counter);
-        }
+        const u64 words_fin = pws_batch->words_fin;
 
         //
         // flush
         //
 
-        const u64 pws_cnt = device_param->pws_cnt;
+        const u64 pws_cnt = pws_batch->pws_cnt;
 
         if (pws_cnt)
         {
-          if (run_copy (hashcat_ctx, device_param, pws_cnt) == -1)
-          {
-            if (attack_mode == ATTACK_MODE_COMBI) hc_fclose (&device_param->combs_fp);
-
-            hc_fclose (&fp);
+          device_param->pws_comp  = pws_batch->pws_comp;
+          device_param->pws_idx   = pws_batch->pws_idx;
+          device_param->pws_cnt   = pws_cnt;
+          device_param->words_off = pws_batch->words_off;
 
-            hcfree (hashcat_ctx_tmp->wl_data);
-            hcfree (hashcat_ctx_tmp);
+          rc = run_copy (hashcat_ctx, device_param, pws_cnt);
 
-            return -1;
-          }
+          // run_copy () may have rebuilt the buffers
 
-          if (run_cracker (hashcat_ctx, device_param, device_param->words_off, pws_cnt) == -1)
-          {
-            if (attack_mode == ATTACK_MODE_COMBI) hc_fclose (&device_param->combs_fp);
+          pws_batch->pws_comp = device_param->pws_comp;
+          pws_batch->pws_idx  = device_param->pws_idx;
 
-            hc_fclose (&fp);
+          if (rc == -1) break;
 
-            hcfree (hashcat_ctx_tmp->wl_data);
-            hcfree (hashcat_ctx_tmp);
+          rc = run_cracker (hashcat_ctx, device_param, device_param->words_off, pws_cnt);
 
-            return -1;
-          }
+          if (rc == -1) break;
 
           device_param->pws_cnt = 0;
 
@@ -1624,21 +2081,45 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
           device_param->words_done = MAX (device_param->words_done, words_fin);
 
           status_ctx->words_cur = get_lowest_words_done (hashcat_ctx);
+
+          if (words_fin > 0) restore_ranges_add (hashcat_ctx, pws_batch->words_start, words_fin);
         }
 
         if (status_ctx->run_thread_level1 == false) break;
 
         if (words_fin == 0) break;
+
+        if (pws_double == true)
+        {
+          pws_batch_release (device_param, pws_batch);
+
+          pws_batch_idx ^= 1;
+        }
       }
 
-      if (attack_mode == ATTACK_MODE_COMBI) hc_fclose (&device_param->combs_fp);
+      if (pws_double == true)
+      {
+        hc_thread_mutex_lock (device_param->pws_batch_mux);
 
-      hc_fclose (&fp);
+        device_param->pws_batch_stop = true;
 
-      wl_data_destroy (hashcat_ctx_tmp);
+        hc_thread_cond_wake (device_param->pws_batch_cond);
 
-      hcfree (hashcat_ctx_tmp->wl_data);
-      hcfree (hashcat_ctx_tmp);
+        hc_thread_mutex_unlock (device_param->pws_batch_mux);
+
+        hc_thread_wait (1, &producer_thread);
+
+        hc_thread_cond_delete  (device_param->pws_batch_cond);
+        hc_thread_mutex_delete (device_param->pws_batch_mux);
+      }
+
+      device_param->pws_comp = device_param->pws_batches[0].pws_comp;
+      device_param->pws_idx  = device_param->pws_batches[0].pws_idx;
+      device_param->pws_cnt  = 0;
+
+      if (attack_mode == ATTACK_MODE_COMBI) hc_fclose (&device_param->combs_fp);
+
+      if (rc == -1) return -1;
     }
   }
 
@@ -1695,6 +2176,12 @@ HC_API_CALL void *thread_calc (void *p)
     status_ctx->devices_status = STATUS_ERROR;
   }
 
+  #ifdef WITH_BRAIN
+  // calc () returns early on errors, the brain link thread must not outlive it
+
+  brain_pipeline_stop (device_param);
+  #endif
+
   if (device_param->is_cuda == true)
   {
     if (hc_cuCtxPopCurrent (hashcat_ctx, &device_param->cuda_context) == -1) return NULL;
@@ -30,6 +30,16 @@ _Static_assert(sizeof (size_t) == sizeof (SizeT), "Check why sizeof(size_t) != s
 #define HCFILE_CHUNK_SIZE 4 * 1024 * 1024
 #endif
 
+// distance between two gzip checkpoints, doubled whenever GZIDX_MAX is reached
+
+#ifndef GZIDX_SPAN
+#define GZIDX_SPAN 4 * 1024 * 1024
+#endif
+
+#ifndef GZIDX_MAX
+#define GZIDX_MAX 512
+#endif
+
 static bool xz_initialized = false;
 
 static const ISzAlloc xz_alloc = { hc_lzma_alloc, hc_lzma_free };
@@ -48,6 +58,19 @@ struct xzfile
   UInt64             outSize;
   CXzUnpacker        state;
   CXzs               streams;
+  Int64              blocksEnd;   // random block mode: input offset where the blocks of the current stream end
+  Int64              nextStream;  // random block mode: input offset of the next stream, -1 if none
+};
+
+struct gzran
+{
+  z_stream           strm;
+  u8                *inBuf;
+  u8                *outBuf;
+  size_t             outLen;
+  size_t             outPos;
+  u64                outProcessed;
+  bool               outEof;
 };
 
 #if defined (__CYGWIN__)
@@ -62,6 +85,499 @@ int _wopen (const char *path, int oflag, ...)
 }
 #endif
 
+static int hc_fskip (HCFILE *fp, u64 len)
+{
+  u8 *buf = (u8 *) hcmalloc (HCFILE_BUFFER_SIZE);
+
+  while (len)
+  {
+    const size_t chunk = (len > HCFILE_BUFFER_SIZE) ? HCFILE_BUFFER_SIZE : (size_t) len;
+
+    if (hc_fread (buf, 1, chunk, fp) != chunk)
+    {
+      hcfree (buf);
+
+      return -1;
+    }
+
+    len -= chunk;
+  }
+
+  hcfree (buf);
+
+  return 0;
+}
+
+static bool xz_random_next (xzfile_t *xfp)
+{
+  // in random block mode the unpacker refuses to parse the stream index, so once the last block of the
+  // stream is through we either jump to the next stream and continue normally or we are done
+
+  if (xfp->blocksEnd == 0) return false;
+
+  if (xfp->inProcessed != xfp->blocksEnd) return false;
+
+  if (XzUnpacker_IsBlockFinished (&xfp->state) == 0) return false;
+
+  xfp->blocksEnd = 0;
+
+  xfp->inLen = 0;
+  xfp->inPos = 0;
+
+  Int64 offset = xfp->nextStream;
+
+  if (offset == -1)
+  {
+    xfp->inEof = true;
+
+    return true;
+  }
+
+  if (ISeekInStream_Seek (&xfp->inStream.vt, &offset, SZ_SEEK_SET) != SZ_OK)
+  {
+    xfp->inEof = true;
+
+    return true;
+  }
+
+  XzUnpacker_Init (&xfp->state);
+
+  xfp->inProcessed = xfp->nextStream;
+
+  return true;
+}
+
+static int xz_seek (HCFILE *fp, const u64 offset)
+{
+  xzfile_t *xfp = fp->xfp;
+
+  // hc_fopen () already loaded the index of every stream, Xzs_ReadBackward () stores them in reverse file order
+
+  const CXzs *streams = &xfp->streams;
+
+  UInt64 outPos = 0;
+
+  for (size_t i = streams->num; i > 0; i--)
+  {
+    const CXzStream *stream = streams->streams + i - 1;
+
+    Int64 blockPos  = (Int64) stream->startOffset + XZ_STREAM_HEADER_SIZE;
+    Int64 blocksEnd = blockPos;
+
+    for (size_t j = 0; j < stream->numBlocks; j++) blocksEnd += (Int64) ((stream->blocks[j].totalSize + 3) & ~((UInt64) 3));
+
+    for (size_t j = 0; j < stream->numBlocks; j++)
+    {
+      const CXzBlockSizes *block = stream->blocks + j;
+
+      if (offset < (outPos + block->unpackSize))
+      {
+        Int64 pos = blockPos;
+
+        if (ISeekInStream_Seek (&xfp->inStream.vt, &pos, SZ_SEEK_SET) != SZ_OK) return -1;
+
+        XzUnpacker_Init (&xfp->state);
+
+        xfp->state.streamFlags = stream->flags;
+
+        XzUnpacker_PrepareToRandomBlockDecoding (&xfp->state);
+
+        xfp->inEof        = false;
+        xfp->inLen        = 0;
+        xfp->inPos        = 0;
+        xfp->inProcessed  = blockPos;
+        xfp->outProcessed = (Int64) outPos;
+        xfp->blocksEnd    = blocksEnd;
+        xfp->nextStream   = (i > 1) ? (Int64) streams->streams[i - 2].startOffset : -1;
+
+        return hc_fskip (fp, offset - outPos);
+      }
+
+      blockPos += (Int64) ((block->totalSize + 3) & ~((UInt64) 3));
+
+      outPos += block->unpackSize;
+    }
+  }
+
+  if (offset != outPos) return -1;
+
+  // seek to the very end, the unpacker must not hand out what it still buffers
+
+  XzUnpacker_Init (&xfp->state);
+
+  xfp->inEof        = true;
+  xfp->inLen        = 0;
+  xfp->inPos        = 0;
+  xfp->outProcessed = (Int64) outPos;
+  xfp->blocksEnd    = 0;
+
+  return 0;
+}
+
+static void gzran_free (HCFILE *fp)
+{
+  gzran_t *gzran = fp->gzran;
+
+  if (gzran == NULL) return;
+
+  inflateEnd (&gzran->strm);
+
+  hcfree (gzran->inBuf);
+  hcfree (gzran->outBuf);
+  hcfree (gzran);
+
+  fp->gzran = NULL;
+}
+
+static int gzran_fill (HCFILE *fp)
+{
+  gzran_t *gzran = fp->gzran;
+
+  z_stream *strm = &gzran->strm;
+
+  gzran->outLen = 0;
+  gzran->outPos = 0;
+
+  strm->next_out  = gzran->outBuf;
+  strm->avail_out = HCFILE_BUFFER_SIZE;
+
+  while ((strm->avail_out == HCFILE_BUFFER_SIZE) && (gzran->outEof == false))
+  {
+    if (strm->avail_in == 0)
+    {
+      const ssize_t nread = read (fp->fd, gzran->inBuf, HCFILE_BUFFER_SIZE);
+
+      if (nread == -1) return -1;
+
+      // truncated file, keep what we have like gzread () does
+
+      if (nread == 0)
+      {
+        gzran->outEof = true;
+
+        break;
+      }
+
+      strm->next_in  = gzran->inBuf;
+      strm->avail_in = (uInt) nread;
+    }
+
+    const int ret = inflate (strm, Z_NO_FLUSH);
+
+    if (ret == Z_STREAM_END)
+    {
+      gzran->outEof = true;
+
+      break;
+    }
+
+    if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) return -1;
+  }
+
+  gzran->outLen = HCFILE_BUFFER_SIZE - strm->avail_out;
+
+  return 0;
+}
+
+static size_t gzran_read (HCFILE *fp, u8 *buf, const size_t len)
+{
+  gzran_t *gzran = fp->gzran;
+
+  size_t done = 0;
+
+  while (done < len)
+  {
+    if (gzran->outPos == gzran->outLen)
+    {
+      if (gzran->outEof == true) break;
+
+      if (gzran_fill (fp) == -1) return (size_t) -1;
+
+      continue;
+    }
+
+    const size_t avail = gzran->outLen - gzran->outPos;
+
+    const size_t chunk = ((len - done) < avail) ? (len - done) : avail;
+
+    memcpy (buf + done, gzran->outBuf + gzran->outPos, chunk);
+
+    gzran->outPos       += chunk;
+    gzran->outProcessed += chunk;
+
+    done += chunk;
+  }
+
+  return done;
+}
+
+static int gzran_seek (HCFILE *fp, const u64 offset)
+{
+  const gzidx_t *gzidx = fp->gzidx;
+
+  // find the last checkpoint at or before offset, the first one is always at offset 0
+
+  u64 lo = 0;
+  u64 hi = gzidx->cnt;
+
+  while (lo < hi)
+  {
+    const u64 mid = lo + ((hi - lo) / 2);
+
+    if (gzidx->points[mid].out <= offset)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  if (lo == 0) return -1;
+
+  const gzidx_point_t *point = gzidx->points + lo - 1;
+
+  const u64 cur = (u64) hc_ftell (fp);
+
+  // the current position is closer than any checkpoint, just read forward
+
+  if ((offset >= cur) && (point->out <= cur))
+  {
+    if (fp->gzran == NULL) return (gzseek (fp->gfp, (z_off_t) offset, SEEK_SET) == -1) ? -1 : 0;
+
+    return hc_fskip (fp, offset - cur);
+  }
+
+  if (fp->gzran == NULL)
+  {
+    gzran_t *gzran = (gzran_t *) hccalloc (1, sizeof (gzran_t));
+
+    if (inflateInit2 (&gzran->strm, -15) != Z_OK)
+    {
+      hcfree (gzran);
+
+      return -1;
+    }
+
+    gzran->inBuf  = (u8 *) hcmalloc (HCFILE_BUFFER_SIZE);
+    gzran->outBuf = (u8 *) hcmalloc (HCFILE_BUFFER_SIZE);
+
+    fp->gzran = gzran;
+  }
+  else
+  {
+    inflateReset (&fp->gzran->strm);
+  }
+
+  gzran_t *gzran = fp->gzran;
+
+  gzran->strm.avail_in = 0;
+
+  gzran->outLen       = 0;
+  gzran->outPos       = 0;
+  gzran->outProcessed = point->out;
+  gzran->outEof       = false;
+
+  // from here on the gzFile no longer knows where the fd is, only hc_rewind () hands it back
+
+  bool ok = (lseek (fp->fd, (off_t) (point->in - ((point->bits) ? 1 : 0)), SEEK_SET) != -1);
+
+  if ((ok == true) && (point->bits))
+  {
+    u8 c = 0;
+
+    ok = (read (fp->fd, &c, 1) == 1);
+
+    if (ok == true) ok = (inflatePrime (&gzran->strm, (int) point->bits, c >> (8 - point->bits)) == Z_OK);
+  }
+
+  if ((ok == true) && (point->out)) ok = (inflateSetDictionary (&gzran->strm, point->window, GZIDX_WINSIZE) == Z_OK);
+
+  if ((ok == true) && (hc_fskip (fp, offset - point->out) == 0)) return 0;
+
+  // get back to a sane state, the caller assumes the position did not change
+
+  gzran_free (fp);
+
+  gzseek (fp->gfp, (z_off_t) cur, SEEK_SET);
+
+  return -1;
+}
+
+static void gzidx_add (gzidx_t *gzidx, u64 *avail, const int bits, const u64 in, const u64 out, const unsigned left, const u8 *window)
+{
+  if (gzidx->cnt == *avail)
+  {
+    gzidx->points = (gzidx_point_t *) hcrealloc (gzidx->points, *avail * sizeof (gzidx_point_t), 16 * sizeof (gzidx_point_t));
+
+    *avail += 16;
+  }
+
+  gzidx_point_t *point = gzidx->points + gzidx->cnt;
+
+  point->in   = in;
+  point->out  = out;
+  point->bits = (u32) bits;
+
+  // the window is circular, left is the number of bytes between the write position and its end
+
+  if (left) memcpy (point->window, window + GZIDX_WINSIZE - left, left);
+
+  if (left < GZIDX_WINSIZE) memcpy (point->window + left, window, GZIDX_WINSIZE - left);
+
+  gzidx->cnt++;
+}
+
+int hc_gzidx_build (gzidx_t *gzidx, const char *path)
+{
+  gzidx->points = NULL;
+  gzidx->cnt    = 0;
+
+  HCFILE fp;
+
+  if (hc_fopen_raw (&fp, path, "rb") == false) return -1;
+
+  z_stream strm;
+
+  memset (&strm, 0, sizeof (strm));
+
+  // 47 = 15 + 32, the largest window with automatic gzip/zlib header detection
+
+  if (inflateInit2 (&strm, 47) != Z_OK)
+  {
+    hc_fclose (&fp);
+
+    return -1;
+  }
+
+  u8 *in_buf = (u8 *) hcmalloc (HCFILE_BUFFER_SIZE);
+  u8 *window = (u8 *) hcmalloc (GZIDX_WINSIZE);
+
+  u64 avail = 0;
+  u64 span  = GZIDX_SPAN;
+
+  u64 totin  = 0;
+  u64 totout = 0;
+  u64 last   = 0;
+
+  int ret = Z_OK;
+
+  strm.avail_out = 0;
+
+  do
+  {
+    const size_t nread = hc_fread (in_buf, 1, HCFILE_BUFFER_SIZE, &fp);
+
+    if ((nread == 0) || (nread == (size_t) -1))
+    {
+      ret = Z_DATA_ERROR;
+
+      break;
+    }
+
+    strm.next_in  = in_buf;
+    strm.avail_in = (uInt) nread;
+
+    do
+    {
+      if (strm.avail_out == 0)
+      {
+        strm.next_out  = window;
+        strm.avail_out = GZIDX_WINSIZE;
+      }
+
+      totin  += strm.avail_in;
+      totout += strm.avail_out;
+
+      // Z_BLOCK returns at every deflate block boundary, those are the only places where decoding can resume
+
+      ret = inflate (&strm, Z_BLOCK);
+
+      totin  -= strm.avail_in;
+      totout -= strm.avail_out;
+
+      if (ret == Z_NEED_DICT) ret = Z_DATA_ERROR;
+
+      if ((ret == Z_MEM_ERROR) || (ret == Z_DATA_ERROR) || (ret == Z_STREAM_END)) break;
+
+      const bool block_end  = (strm.data_type & 128) != 0;
+      const bool last_block = (strm.data_type &  64) != 0;
+
+      if ((block_end == true) && (last_block == false) && ((totout == 0) || ((totout - last) > span)))
+      {
+        gzidx_add (gzidx, &avail, strm.data_type & 7, totin, totout, strm.avail_out, window);
+
+        last = totout;
+
+        // keep the index small for huge files by dropping every other checkpoint
+
+        if (gzidx->cnt == GZIDX_MAX)
+        {
+          for (u64 i = 1; i < (GZIDX_MAX / 2); i++) memcpy (gzidx->points + i, gzidx->points + (i * 2), sizeof (gzidx_point_t));
+
+          gzidx->cnt = GZIDX_MAX / 2;
+
+          span *= 2;
+        }
+      }
+
+    } while (strm.avail_in != 0);
+
+  } while ((ret != Z_STREAM_END) && (ret != Z_MEM_ERROR) && (ret != Z_DATA_ERROR));
+
+  // concatenated gzip members are read by gzread () but the checkpoints only cover the first one
+
+  if (ret == Z_STREAM_END)
+  {
+    u8 tmp[1];
+
+    if ((strm.avail_in != 0) || (hc_fread (tmp, 1, sizeof (tmp), &fp) != 0)) ret = Z_DATA_ERROR;
+  }
+
+  inflateEnd (&strm);
+
+  hcfree (in_buf);
+  hcfree (window);
+
+  hc_fclose (&fp);
+
+  if ((ret != Z_STREAM_END) || (gzidx->cnt == 0))
+  {
+    hc_gzidx_free (gzidx);
+
+    return -1;
+  }
+
+  return 0;
+}
+
+void hc_gzidx_free (gzidx_t *gzidx)
+{
+  if (gzidx == NULL) return;
+
+  hcfree (gzidx->points);
+
+  gzidx->points = NULL;
+  gzidx->cnt    = 0;
+}
+
+bool hc_gzidx_attach (HCFILE *fp, gzidx_t *gzidx)
+{
+  if (fp->gfp == NULL) return false;
+
+  if (fp->gzidx != NULL)
+  {
+    hc_gzidx_free (fp->gzidx);
+
+    hcfree (fp->gzidx);
+  }
+
+  fp->gzidx = gzidx;
+
+  return true;
+}
+
 bool hc_fopen (HCFILE *fp, const char *path, const char *mode)
 {
   if (fp == NULL || path == NULL || mode == NULL) return false;
@@ -72,6 +588,8 @@ bool hc_fopen (HCFILE *fp, const char *path, const char *mode)
   fp->gfp      = NULL;
   fp->ufp      = NULL;
   fp->xfp      = NULL;
+  fp->gzidx    = NULL;
+  fp->gzran    = NULL;
   fp->bom_size = 0;
   fp->path     = NULL;
   fp->mode     = NULL;
@@ -301,6 +819,8 @@ bool hc_fopen_raw (HCFILE *fp, const char *path, const char *mode)
   fp->gfp      = NULL;
   fp->ufp      = NULL;
   fp->xfp      = NULL;
+  fp->gzidx    = NULL;
+  fp->gzran    = NULL;
   fp->bom_size = 0;
   fp->path     = NULL;
   fp->mode     = NULL;
@@ -409,7 +929,16 @@ size_t hc_fread (void *ptr, size_t size, size_t nmemb, HCFILE *fp)
   }
   else if (fp->gfp)
   {
-    n = gzfread (ptr, size, nmemb, fp->gfp);
+    if (fp->gzran)
+    {
+      const size_t bytes = gzran_read (fp, (u8 *) ptr, size * nmemb);
+
+      n = (bytes == (size_t) -1) ? bytes : bytes / size;
+    }
+    else
+    {
+      n = gzfread (ptr, size, nmemb, fp->gfp);
+    }
   }
   else if (fp->ufp)
   {
@@ -474,7 +1003,8 @@ size_t hc_fread (void *ptr, size_t size, size_t nmemb, HCFILE *fp)
       xfp->inPos += inLeft;
       xfp->inProcessed += inLeft;
       if (res != SZ_OK) return (size_t) -1;
-      if (inLeft == 0 && outLeft == 0)
+      const bool next = xz_random_next (xfp);
+      if (inLeft == 0 && outLeft == 0 && next == false)
       {
         /* partial read */
         n = (outPos / size);
@@ -554,7 +1084,18 @@ int hc_fseek (HCFILE *fp, off_t offset, int whence)
   }
   else if (fp->gfp)
   {
-    r = gzseek (fp->gfp, offset, whence);
+    if (whence == SEEK_CUR) offset += hc_ftell (fp);
+
+    if ((fp->gzidx) && (whence != SEEK_END) && (offset >= 0))
+    {
+      r = gzran_seek (fp, (u64) offset);
+    }
+    else
+    {
+      gzran_free (fp);
+
+      r = (gzseek (fp->gfp, offset, (whence == SEEK_CUR) ? SEEK_SET : whence) == -1) ? -1 : 0;
+    }
   }
   else if (fp->ufp)
   {
@@ -579,7 +1120,12 @@ int hc_fseek (HCFILE *fp, off_t offset, int whence)
   }
   else if (fp->xfp)
   {
-    /* TODO */
+    const xzfile_t *xfp = fp->xfp;
+
+    if (whence == SEEK_CUR) offset += (off_t) xfp->outProcessed;
+    if (whence == SEEK_END) offset += (off_t) xfp->outSize;
+
+    if (offset >= 0) r = xz_seek (fp, (u64) offset);
   }
 
   return r;
@@ -595,6 +1141,8 @@ void hc_rewind (HCFILE *fp)
   }
   else if (fp->gfp)
   {
+    gzran_free (fp);
+
     gzrewind (fp->gfp);
   }
   else if (fp->ufp)
@@ -611,6 +1159,7 @@ void hc_rewind (HCFILE *fp)
     xfp->inPos = 0;
     xfp->inProcessed  = 0;
     xfp->outProcessed = 0;
+    xfp->blocksEnd    = 0;
 
     /* reset */
     Int64 offset = 0;
@@ -678,7 +1227,7 @@ off_t hc_ftell (HCFILE *fp)
   }
   else if (fp->gfp)
   {
-    n = (off_t) gztell (fp->gfp);
+    n = (fp->gzran) ? (off_t) fp->gzran->outProcessed : (off_t) gztell (fp->gfp);
   }
   else if (fp->ufp)
   {
@@ -724,7 +1273,16 @@ int hc_fgetc (HCFILE *fp)
   }
   else if (fp->gfp)
   {
-    r = gzgetc (fp->gfp);
+    if (fp->gzran)
+    {
+      u8 c = 0;
+
+      if (gzran_read (fp, &c, 1) == 1) r = (int) c;
+    }
+    else
+    {
+      r = gzgetc (fp->gfp);
+    }
   }
   else if (fp->ufp)
   {
@@ -738,24 +1296,30 @@ int hc_fgetc (HCFILE *fp)
     SRes res = SZ_OK;
     xzfile_t *xfp = fp->xfp;
 
-    /* fill buffer if needed */
-    if (xfp->inLen == xfp->inPos && !xfp->inEof)
+    while (true)
     {
-      xfp->inPos = 0;
-      xfp->inLen = HCFILE_BUFFER_SIZE;
-      res = ISeekInStream_Read (&xfp->inStream.vt, xfp->inBuf, &xfp->inLen);
-      if (res != SZ_OK || xfp->inLen == 0) xfp->inEof = true;
-    }
+      /* fill buffer if needed */
+      if (xfp->inLen == xfp->inPos && !xfp->inEof)
+      {
+        xfp->inPos = 0;
+        xfp->inLen = HCFILE_BUFFER_SIZE;
+        res = ISeekInStream_Read (&xfp->inStream.vt, xfp->inBuf, &xfp->inLen);
+        if (res != SZ_OK || xfp->inLen == 0) xfp->inEof = true;
+      }
 
-    /* decode single byte */
-    ECoderStatus status;
-    SizeT inLeft = xfp->inLen - xfp->inPos;
-    SizeT outLeft = 1;
-    res = XzUnpacker_Code (&xfp->state, &out, &outLeft, xfp->inBuf + xfp->inPos, &inLeft, inLeft == 0, CODER_FINISH_ANY, &status);
-    if (inLeft == 0 && outLeft == 0) return r;
-    xfp->inPos += inLeft;
-    xfp->inProcessed += inLeft;
-    if (res != SZ_OK) return r;
+      /* decode single byte */
+      ECoderStatus status;
+      SizeT inLeft = xfp->inLen - xfp->inPos;
+      SizeT outLeft = 1;
+      res = XzUnpacker_Code (&xfp->state, &out, &outLeft, xfp->inBuf + xfp->inPos, &inLeft, inLeft == 0, CODER_FINISH_ANY, &status);
+      xfp->inPos += inLeft;
+      xfp->inProcessed += inLeft;
+      if (res != SZ_OK) return r;
+      const bool next = xz_random_next (xfp);
+      if (outLeft == 1) break;
+      /* block or stream headers only, try again */
+      if (inLeft == 0 && next == false) return r;
+    }
     xfp->outProcessed++;
     r = (int) out;
   }
@@ -775,7 +1339,27 @@ char *hc_fgets (char *buf, int len, HCFILE *fp)
   }
   else if (fp->gfp)
   {
-    r = gzgets (fp->gfp, buf, len);
+    if (fp->gzran)
+    {
+      int i = 0;
+
+      u8 c = 0;
+
+      while ((i < (len - 1)) && (gzran_read (fp, &c, 1) == 1))
+      {
+        buf[i++] = (char) c;
+
+        if (c == '\n') break;
+      }
+
+      buf[i] = 0;
+
+      if (i > 0) r = buf;
+    }
+    else
+    {
+      r = gzgets (fp->gfp, buf, len);
+    }
   }
   else if (fp->ufp)
   {
@@ -804,10 +1388,16 @@ char *hc_fgets (char *buf, int len, HCFILE *fp)
       SizeT inLeft = xfp->inLen - xfp->inPos;
       SizeT outLeft = 1;
       res = XzUnpacker_Code (&xfp->state, outBuf, &outLeft, xfp->inBuf + xfp->inPos, &inLeft, inLeft == 0, CODER_FINISH_ANY, &status);
-      if (inLeft == 0 && outLeft == 0) break;
       xfp->inPos += inLeft;
       xfp->inProcessed += inLeft;
       if (res != SZ_OK) break;
+      const bool next = xz_random_next (xfp);
+      if (outLeft == 0)
+      {
+        /* block or stream headers only, try again */
+        if (inLeft == 0 && next == false) break;
+        continue;
+      }
       xfp->outProcessed++;
       if (*outBuf++ == '\n')
       {
@@ -898,7 +1488,7 @@ int hc_feof (HCFILE *fp)
   }
   else if (fp->gfp)
   {
-    r = gzeof (fp->gfp);
+    r = (fp->gzran) ? (fp->gzran->outEof && fp->gzran->outPos == fp->gzran->outLen) : gzeof (fp->gfp);
   }
   else if (fp->ufp)
   {
@@ -953,6 +1543,8 @@ void hc_fclose (HCFILE *fp)
   }
   else if (fp->gfp)
   {
+    gzran_free (fp);
+
     gzclose (fp->gfp);
   }
   else if (fp->ufp)
@@ -981,10 +1573,30 @@ void hc_fclose (HCFILE *fp)
   fp->ufp = NULL;
   fp->xfp = NULL;
 
+  if (fp->gzidx)
+  {
+    hc_gzidx_free (fp->gzidx);
+
+    hcfree (fp->gzidx);
+
+    fp->gzidx = NULL;
+  }
+
   fp->path = NULL;
   fp->mode = NULL;
 }
 
+static inline int hc_fgetc_unlocked (HCFILE *fp)
+{
+  if (fp->pfp == NULL) return hc_fgetc (fp);
+
+  #if defined (_WIN)
+  return _fgetc_nolock (fp->pfp);
+  #else
+  return getc_unlocked (fp->pfp);
+  #endif
+}
+
 size_t fgetl (HCFILE *fp, char *line_buf, const size_t line_sz)
 {
   int c;
@@ -993,7 +1605,18 @@ size_t fgetl (HCFILE *fp, char *line_buf, const size_t line_sz)
 
   size_t line_truncated = 0;
 
-  while ((c = hc_fgetc (fp)) != EOF)
+  // once the process has started a thread, fgetc () locks the stream for every byte, lock it once per line instead
+
+  if (fp->pfp)
+  {
+    #if defined (_WIN)
+    _lock_file (fp->pfp);
+    #else
+    flockfile (fp->pfp);
+    #endif
+  }
+
+  while ((c = hc_fgetc_unlocked (fp)) != EOF)
   {
     if (c == '\n') break;
 
@@ -1009,6 +1632,15 @@ size_t fgetl (HCFILE *fp, char *line_buf, const size_t line_sz)
     }
   }
 
+  if (fp->pfp)
+  {
+    #if defined (_WIN)
+    _unlock_file (fp->pfp);
+    #else
+    funlockfile (fp->pfp);
+    #endif
+  }
+
   if (line_truncated > 0)
   {
     fprintf (stderr, "\nOversized line detected! Truncated %" PRIu64 " bytes\n", (u64) line_truncated);
@@ -48,6 +48,7 @@
 #include "tuningdb.h"
 #include "user_options.h"
 #include "wordlist.h"
+#include "writer.h"
 #include "hashcat.h"
 #include "usage.h"
 
@@ -100,6 +101,12 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
     user_options->skip = 0;
   }
+  else
+  {
+    // ranges from the restore file only belong to the loop it was written in
+
+    restore_ranges_reset (hashcat_ctx);
+  }
 
   if (user_options->skip > 0)
   {
@@ -149,6 +156,26 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
     return -1;
   }
 
+  // completed ranges above words_off, empty unless restored
+
+  u64 words_done = status_ctx->words_off;
+
+  for (u32 i = 0; i < restore_ctx->ranges_cnt; i++)
+  {
+    const restore_range_t *range = restore_ctx->ranges_buf + i;
+
+    if (range->fin > status_ctx->words_base)
+    {
+      event_log_error (hashcat_ctx, "Restore value is greater than keyspace.");
+
+      return -1;
+    }
+
+    if (range->fin <= status_ctx->words_off) continue;
+
+    words_done += range->fin - MAX (range->off, status_ctx->words_off);
+  }
+
   if (user_options->attack_mode == ATTACK_MODE_ASSOCIATION)
   {
     const u64 progress_restored = 1 * amplifier_cnt;
@@ -157,10 +184,20 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
     {
       status_ctx->words_progress_restored[i] = progress_restored;
     }
+
+    for (u32 i = 0; i < restore_ctx->ranges_cnt; i++)
+    {
+      const restore_range_t *range = restore_ctx->ranges_buf + i;
+
+      for (u64 j = MAX (range->off, status_ctx->words_off); j < range->fin; j++)
+      {
+        status_ctx->words_progress_restored[j] = progress_restored;
+      }
+    }
   }
   else
   {
-    const u64 progress_restored = status_ctx->words_off * amplifier_cnt;
+    const u64 progress_restored = words_done * amplifier_cnt;
 
     for (u32 i = 0; i < hashes->salts_cnt; i++)
     {
@@ -313,6 +350,26 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
   EVENT (EVENT_CRACKER_STARTING);
 
+  if (wl_shared_init (hashcat_ctx) == -1)
+  {
+    hcfree (c_threads);
+
+    hcfree (threads_param);
+
+    return -1;
+  }
+
+  if (combinator_cache_init (hashcat_ctx) == -1)
+  {
+    wl_shared_destroy (hashcat_ctx);
+
+    hcfree (c_threads);
+
+    hcfree (threads_param);
+
+    return -1;
+  }
+
   status_ctx->devices_status = STATUS_RUNNING;
 
   status_ctx->accessible = true;
@@ -336,6 +393,10 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
   hc_thread_wait (backend_ctx->backend_devices_cnt, c_threads);
 
+  combinator_cache_destroy (hashcat_ctx);
+
+  wl_shared_destroy (hashcat_ctx);
+
   hcfree (c_threads);
 
   hcfree (threads_param);
@@ -960,6 +1021,10 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
 
   if (potfile_write_open (hashcat_ctx) == -1) return -1;
 
+  // cracked hashes are written by a separate thread from here on, see writer.c
+
+  if (writer_start (hashcat_ctx) == -1) return -1;
+
   /**
    * status and monitor threads
    */
@@ -1038,6 +1103,10 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
 
   EVENT (EVENT_INNERLOOP1_FINISHED);
 
+  // write what is still queued, the cracker threads are done
+
+  writer_stop (hashcat_ctx);
+
   // finalize potfile
 
   potfile_write_close (hashcat_ctx);
@@ -1113,6 +1182,8 @@ int hashcat_init (hashcat_ctx_t *hashcat_ctx, void (*event) (const u32, struct h
   hashcat_ctx->user_options_extra = (user_options_extra_t *)  hcmalloc (sizeof (user_options_extra_t));
   hashcat_ctx->user_options       = (user_options_t *)        hcmalloc (sizeof (user_options_t));
   hashcat_ctx->wl_data            = (wl_data_t *)             hcmalloc (sizeof (wl_data_t));
+  hashcat_ctx->wl_shared          = (wl_shared_t *)           hcmalloc (sizeof (wl_shared_t));
+  hashcat_ctx->writer_ctx         = (writer_ctx_t *)          hcmalloc (sizeof (writer_ctx_t));
 
   return 0;
 }
@@ -1149,6 +1220,8 @@ void hashcat_destroy (hashcat_ctx_t *hashcat_ctx)
   hcfree (hashcat_ctx->user_options_extra);
   hcfree (hashcat_ctx->user_options);
   hcfree (hashcat_ctx->wl_data);
+  hcfree (hashcat_ctx->wl_shared);
+  hcfree (hashcat_ctx->writer_ctx);
 
   memset (hashcat_ctx, 0, sizeof (hashcat_ctx_t));
 }
@@ -17,6 +17,7 @@
 #include "backend.h"
 #include "outfile.h"
 #include "potfile.h"
+#include "writer.h"
 #include "rp.h"
 #include "shared.h"
 #include "thread.h"
@@ -318,6 +319,7 @@ int check_hash (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, pla
   const hashconfig_t    *hashconfig    = hashcat_ctx->hashconfig;
   const loopback_ctx_t  *loopback_ctx  = hashcat_ctx->loopback_ctx;
   const module_ctx_t    *module_ctx    = hashcat_ctx->module_ctx;
+  const outfile_ctx_t   *outfile_ctx   = hashcat_ctx->outfile_ctx;
 
   const u32 salt_pos    = plain->salt_pos;
   const u32 digest_pos  = plain->digest_pos;  // relative
@@ -461,8 +463,11 @@ int check_hash (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, pla
   // outfile, can be either to file or stdout
   // if an error occurs opening the file, send to stdout as fallback
   // the fp gets opened for each cracked hash so that the user can modify (move) the outfile while hashcat runs
+  // with the writer thread running, the line is only queued and the writer does the same for each batch
 
-  outfile_write_open (hashcat_ctx);
+  const bool outfile_async = outfile_ctx->is_async;
+
+  if (outfile_async == false) outfile_write_open (hashcat_ctx);
 
   u8 *tmp_buf = hashes->tmp_buf;
 
@@ -470,9 +475,20 @@ int check_hash (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, pla
 
   const int tmp_len = outfile_write (hashcat_ctx, (char *) out_buf, out_len, plain_ptr, plain_len, crackpos, NULL, 0, true, (char *) tmp_buf);
 
+  if (outfile_async == true)
+  {
+    const int eol_len = (int) strlen (EOL);
+
+    memcpy (tmp_buf + tmp_len, EOL, eol_len);
+
+    writer_outfile_append (hashcat_ctx, tmp_buf, (u32) (tmp_len + eol_len));
+
+    tmp_buf[tmp_len] = 0;
+  }
+
   EVENT_DATA (EVENT_CRACKER_HASH_CRACKED, tmp_buf, tmp_len);
 
-  outfile_write_close (hashcat_ctx);
+  if (outfile_async == false) outfile_write_close (hashcat_ctx);
 
   // potfile
   // we can have either used-defined hooks or reuse the same format as input format
@@ -887,622 +903,949 @@ int hashes_init_filename (hashcat_ctx_t *hashcat_ctx)
   return 0;
 }
 
-int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
+static void hashes_scan_range (hashes_range_t *hr)
 {
-  hashconfig_t          *hashconfig         = hashcat_ctx->hashconfig;
-  hashes_t              *hashes             = hashcat_ctx->hashes;
-  module_ctx_t          *module_ctx         = hashcat_ctx->module_ctx;
-  user_options_t        *user_options       = hashcat_ctx->user_options;
-  user_options_extra_t  *user_options_extra = hashcat_ctx->user_options_extra;
+  hashcat_ctx_t *hashcat_ctx = hr->hashcat_ctx;
+  hashconfig_t  *hashconfig  = hashcat_ctx->hashconfig;
 
-  /**
-   * load hashes, part I: find input mode, count hashes
-   */
+  // count the lines in front of the later ranges and an upper bound of the hashes each range can produce
+  // fgetl () skips a line if nothing but '\r' is left of it, so those don't get a slot
 
-  const char *hashfile      = hashes->hashfile;
-  const u32   hashlist_mode = hashes->hashlist_mode;
+  const u64 hashes_per_line = (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT) ? 2 : 1;
 
-  u32 hashlist_format = HLFMT_HASHCAT;
+  char *buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
 
-  u64 hashes_avail = 0;
+  bool line_open = false;
+  bool line_data = false;
 
-  if ((user_options->benchmark == false) && (user_options->stdout_flag == false) && (user_options->keyspace == false))
+  u64 left = hr->end - hr->beg;
+
+  while (left)
   {
-    if (hashlist_mode == HL_MODE_ARG)
-    {
-      hashes_avail = 1;
-    }
-    else if (hashlist_mode == HL_MODE_FILE_PLAIN)
+    const size_t nread = hc_fread (buf, 1, (size_t) MIN (left, HCBUFSIZ_LARGE), &hr->fp);
+
+    if ((nread == 0) || (nread == (size_t) -1)) break;
+
+    left -= nread;
+
+    for (size_t i = 0; i < nread; i++)
     {
-      HCFILE fp;
+      if (buf[i] == '\n')
+      {
+        hr->lines_cnt++;
 
-      if (hc_fopen (&fp, hashfile, "rb") == false)
+        if (line_data == true) hr->hashes_max += hashes_per_line;
+
+        line_open = false;
+        line_data = false;
+      }
+      else
       {
-        event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+        line_open = true;
 
-        return -1;
+        if (buf[i] != '\r') line_data = true;
       }
+    }
+  }
 
-      EVENT_DATA (EVENT_HASHLIST_COUNT_LINES_PRE, hashfile, strlen (hashfile));
+  if (line_open == true)
+  {
+    hr->lines_cnt++;
 
-      hashes_avail = count_lines (&fp);
+    if (line_data == true) hr->hashes_max += hashes_per_line;
+  }
 
-      EVENT_DATA (EVENT_HASHLIST_COUNT_LINES_POST, hashfile, strlen (hashfile));
+  hcfree (buf);
 
-      hc_rewind (&fp);
+  hc_fseek (&hr->fp, (off_t) hr->beg, SEEK_SET);
+}
 
-      if (hashes_avail == 0)
-      {
-        event_log_error (hashcat_ctx, "hashfile is empty or corrupt.");
+static HC_API_CALL void *thread_hashes_scan_range (void *p)
+{
+  hashes_scan_range ((hashes_range_t *) p);
 
-        hc_fclose (&fp);
+  return NULL;
+}
 
-        return -1;
-      }
+static void hashes_range_warning (hashes_range_t *hr, const char *fmt, ...)
+{
+  // event_log_warning () formats into a buffer shared by all threads, the ranges take turns
 
-      hashlist_format = hlfmt_detect (hashcat_ctx, &fp, 100); // 100 = max numbers to "scan". could be hashes_avail, too
+  char buf[HCBUFSIZ_SMALL];
 
-      hc_fclose (&fp);
+  va_list ap;
 
-      if ((user_options->remove == true) && (hashlist_format != HLFMT_HASHCAT))
-      {
-        event_log_error (hashcat_ctx, "Use of --remove is not supported in native hashfile-format mode.");
+  va_start (ap, fmt);
 
-        return -1;
-      }
-    }
-    else if (hashlist_mode == HL_MODE_FILE_BINARY)
-    {
-      struct stat st;
+  vsnprintf (buf, sizeof (buf), fmt, ap);
 
-      if (stat (hashes->hashfile, &st) == -1)
-      {
-        event_log_error (hashcat_ctx, "%s: %s", hashes->hashfile, strerror (errno));
+  va_end (ap);
 
-        return -1;
-      }
+  hc_thread_mutex_lock (*hr->mux_log);
 
-      if (module_ctx->module_hash_binary_count != MODULE_DEFAULT)
-      {
-        const int binary_count = module_ctx->module_hash_binary_count (hashes);
+  event_log_warning (hr->hashcat_ctx, "%s", buf);
 
-        if (binary_count > 0)
-        {
-          hashes_avail = binary_count;
-        }
-        else if (binary_count == 0)
-        {
-          event_log_error (hashcat_ctx, "No hashes loaded.");
+  hc_thread_mutex_unlock (*hr->mux_log);
+}
 
-          return -1;
-        }
-        else if (binary_count == PARSER_HAVE_ERRNO)
-        {
-          event_log_error (hashcat_ctx, "%s: %s", hashes->hashfile, strerror (errno));
+static void hashes_parse_range (hashes_range_t *hr)
+{
+  hashcat_ctx_t         *hashcat_ctx        = hr->hashcat_ctx;
+  hashconfig_t          *hashconfig         = hashcat_ctx->hashconfig;
+  hashes_t              *hashes             = hashcat_ctx->hashes;
+  module_ctx_t          *module_ctx         = hashcat_ctx->module_ctx;
+  user_options_t        *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t  *user_options_extra = hashcat_ctx->user_options_extra;
 
-          return -1;
-        }
-        else
-        {
-          event_log_error (hashcat_ctx, "%s: %s", hashes->hashfile, strerror (binary_count));
+  const u32 hashlist_format = hashes->hashlist_format;
 
-          return -1;
-        }
-      }
-      else
-      {
-        hashes_avail = 1;
-      }
-    }
-  }
-  else
-  {
-    hashes_avail = 1;
-  }
+  hash_t *hashes_buf = hashes->hashes_buf;
 
-  if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT) hashes_avail *= 2;
+  // each range writes to its own slice of hashes_buf, hashes_init_stage1 () closes the gaps afterwards
 
-  hashes->hashlist_format = hashlist_format;
+  const u64 hashes_end = hr->hashes_base + hr->hashes_avail;
 
-  /**
-   * load hashes, part II: allocate required memory, set pointers
-   */
+  u64 hashes_cnt = hr->hashes_base;
 
-  hash_t *hashes_buf     = (hash_t *) hccalloc (hashes_avail, sizeof (hash_t));
-  void   *digests_buf    =            hccalloc (hashes_avail, hashconfig->dgst_size);
-  salt_t *salts_buf      = NULL;
-  void   *esalts_buf     = NULL;
-  void   *hook_salts_buf = NULL;
+  u32 line_num = hr->line_num;
 
-  if ((user_options->dynamic_x == true) || (user_options->username == true) || (hashconfig->opts_type & OPTS_TYPE_HASH_COPY) || (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT))
+  char *line_buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
+
+  time_t prev = 0;
+  time_t now  = 0;
+
+  while (!hc_feof (&hr->fp))
   {
-    u64 hash_pos;
+    if ((hr->ranged == true) && ((line_num - hr->line_num) == hr->lines_cnt)) break;
+
+    line_num++;
+
+    const size_t line_len = fgetl (&hr->fp, line_buf, HCBUFSIZ_LARGE);
 
-    for (hash_pos = 0; hash_pos < hashes_avail; hash_pos++)
+    if (line_len == 0) continue;
+
+    if (hashes_end == hashes_cnt)
     {
-      hashinfo_t *hash_info = (hashinfo_t *) hcmalloc (sizeof (hashinfo_t));
+      hashes_range_warning (hr, "Hashfile '%s' on line %u: File changed during runtime. Skipping new data.", hashes->hashfile, line_num);
 
-      hashes_buf[hash_pos].hash_info = hash_info;
+      break;
+    }
 
-      if (user_options->dynamic_x == true)
-      {
-        hash_info->dynamicx = (dynamicx_t *) hcmalloc (sizeof (dynamicx_t));
-      }
+    char *hash_buf = NULL;
+    int   hash_len = 0;
 
-      if (user_options->username == true)
-      {
-        hash_info->user = (user_t *) hcmalloc (sizeof (user_t));
-      }
+    hlfmt_hash (hashcat_ctx, hashlist_format, line_buf, line_len, &hash_buf, &hash_len);
 
-      if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
+    bool hash_fmt_error = false;
+
+    if (hash_len < 1)     hash_fmt_error = true;
+    if (hash_buf == NULL) hash_fmt_error = true;
+
+    if (hash_fmt_error)
+    {
+      hashes_range_warning (hr, "Failed to parse hashes using the '%s' format.", strhlfmt (hashlist_format));
+
+      continue;
+    }
+
+    if (user_options->username == true)
+    {
+      char *user_buf = NULL;
+      int   user_len = 0;
+
+      hlfmt_user (hashcat_ctx, hashlist_format, line_buf, line_len, &user_buf, &user_len);
+
+      // special case:
+      // both hash_t need to have the username info if the pwdump format is used (i.e. we have 2 hashes for 3000, both with same user)
+
+      u32 hashes_per_user = 1;
+
+      if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
       {
-        if (user_options->benchmark == false)
+        // the following conditions should be true if (hashlist_format == HLFMT_PWDUMP)
+
+        if (hash_len == 32)
         {
-          hash_info->orighash = (char *) hcmalloc (256);
+          hashes_per_user = 2;
         }
       }
 
-      if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
+      for (u32 i = 0; i < hashes_per_user; i++)
       {
-        hash_info->split = (split_t *) hcmalloc (sizeof (split_t));
+        user_t *user_ptr = hashes_buf[hashes_cnt + i].hash_info->user;
+
+        if (user_buf != NULL)
+        {
+          user_ptr->user_name = hcarena_strdup (&hr->arena, user_buf);
+        }
+        else
+        {
+          user_ptr->user_name = hcarena_strdup (&hr->arena, "");
+        }
+
+        user_ptr->user_len = (u32) user_len;
       }
     }
-  }
-
-  if (hashconfig->is_salted == true)
-  {
-    salts_buf = (salt_t *) hccalloc (hashes_avail, sizeof (salt_t));
 
-    if (user_options->attack_mode == ATTACK_MODE_ASSOCIATION)
+    if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
     {
-      // this disables:
-      // - sorting by salt value
-      // - grouping by salt value
-      // - keep the salt in position relative to hashfile (not equal because of some hashes maybe failed to load)
+      hashinfo_t *hash_info_tmp = hashes_buf[hashes_cnt].hash_info;
 
-      u64 hash_pos;
+      hash_info_tmp->orighash = hcarena_strdup (&hr->arena, hash_buf);
+    }
 
-      for (hash_pos = 0; hash_pos < hashes_avail; hash_pos++)
-      {
-        salt_t *salt = &salts_buf[hash_pos];
+    if (hashconfig->is_salted == true)
+    {
+      const u32 orig_pos = hashes_buf[hashes_cnt].salt->orig_pos;
 
-        salt->orig_pos = hash_pos;
-      }
+      memset (hashes_buf[hashes_cnt].salt, 0, sizeof (salt_t));
+
+      hashes_buf[hashes_cnt].salt->orig_pos = orig_pos;
     }
 
     if (hashconfig->esalt_size > 0)
     {
-      esalts_buf = hccalloc (hashes_avail, hashconfig->esalt_size);
+      memset (hashes_buf[hashes_cnt].esalt, 0, hashconfig->esalt_size);
     }
 
     if (hashconfig->hook_salt_size > 0)
     {
-      hook_salts_buf = hccalloc (hashes_avail, hashconfig->hook_salt_size);
+      memset (hashes_buf[hashes_cnt].hook_salt, 0, hashconfig->hook_salt_size);
     }
-  }
-  else
-  {
-    salts_buf = (salt_t *) hccalloc (1, sizeof (salt_t));
-  }
-
-  for (u64 hash_pos = 0; hash_pos < hashes_avail; hash_pos++)
-  {
-    /**
-     * Initialize some values for later use
-     */
-
-    hashes_buf[hash_pos].orig_line_pos = hash_pos;
-
-    hashes_buf[hash_pos].digest = ((char *) digests_buf) + (hash_pos * hashconfig->dgst_size);
 
-    if (hashconfig->is_salted == true)
+    if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
     {
-      hashes_buf[hash_pos].salt = &salts_buf[hash_pos];
-
-      if (hashconfig->esalt_size > 0)
+      if (hash_len == 32)
       {
-        hashes_buf[hash_pos].esalt = ((char *) esalts_buf) + (hash_pos * hashconfig->esalt_size);
-      }
+        hash_t *hash;
 
-      if (hashconfig->hook_salt_size > 0)
-      {
-        hashes_buf[hash_pos].hook_salt = ((char *) hook_salts_buf) + (hash_pos * hashconfig->hook_salt_size);
-      }
-    }
-    else
-    {
-      hashes_buf[hash_pos].salt = &salts_buf[0];
-    }
-  }
+        hash = &hashes_buf[hashes_cnt];
 
-  hashes->hashes_buf     = hashes_buf;
-  hashes->digests_buf    = digests_buf;
-  hashes->salts_buf      = salts_buf;
-  hashes->esalts_buf     = esalts_buf;
-  hashes->hook_salts_buf = hook_salts_buf;
+        int parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf +  0, 16);
 
-  /**
-   * load hashes, part III: parse hashes
-   */
+        if (parser_status < PARSER_GLOBAL_ZERO)
+        {
+          char *tmp_line_buf;
 
-  u32 hashes_cnt = 0;
+          hc_asprintf (&tmp_line_buf, "%s", line_buf);
 
-  if (user_options->benchmark == true)
-  {
-    hashes->hashfile = "-";
+          compress_terminal_line_length (tmp_line_buf, 38, 32);
 
-    hashes_cnt = 1;
-  }
-  else if (user_options->hash_info == true)
-  {
-  }
-  else if (user_options->keyspace == true)
-  {
-  }
-  else if (user_options->stdout_flag == true)
-  {
-  }
-  else if (user_options->backend_info > 0)
-  {
-  }
-  else
-  {
-    if (hashlist_mode == HL_MODE_ARG)
-    {
-      char *input_buf = user_options_extra->hc_hash;
+          if (user_options->machine_readable == true)
+          {
+            hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+          }
+          else
+          {
+            hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+          }
 
-      size_t input_len = strlen (input_buf);
+          hcfree (tmp_line_buf);
 
-      char  *hash_buf = NULL;
-      int    hash_len = 0;
+          continue;
+        }
 
-      hlfmt_hash (hashcat_ctx, hashlist_format, input_buf, input_len, &hash_buf, &hash_len);
+        if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
+        {
+          int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
 
-      bool hash_fmt_error = false;
+          if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
+          {
+            char *tmp_line_buf;
 
-      if (hash_len < 1)     hash_fmt_error = true;
-      if (hash_buf == NULL) hash_fmt_error = true;
+            hc_asprintf (&tmp_line_buf, "%s", line_buf);
 
-      if (hash_fmt_error)
-      {
-        event_log_warning (hashcat_ctx, "Failed to parse hashes using the '%s' format.", strhlfmt (hashlist_format));
-      }
-      else
-      {
-        if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
-        {
-          hashinfo_t *hash_info_tmp = hashes_buf[hashes_cnt].hash_info;
+            compress_terminal_line_length (tmp_line_buf, 38, 32);
 
-          hash_info_tmp->orighash = hcstrdup (hash_buf);
-        }
+            if (user_options->machine_readable == true)
+            {
+              hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
+            }
+            else
+            {
+              hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
+            }
 
-        if (hashconfig->is_salted == true)
-        {
-          memset (hashes_buf[0].salt, 0, sizeof (salt_t));
-        }
+            hcfree (tmp_line_buf);
 
-        if (hashconfig->esalt_size > 0)
-        {
-          memset (hashes_buf[0].esalt, 0, hashconfig->esalt_size);
+            continue;
+          }
         }
 
-        if (hashconfig->hook_salt_size > 0)
-        {
-          memset (hashes_buf[0].hook_salt, 0, hashconfig->hook_salt_size);
-        }
+        hashes_buf[hashes_cnt].hash_info->split->split_group  = line_num;
+        hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_LEFT;
 
-        int parser_status = PARSER_OK;
+        hashes_cnt++;
 
-        if (user_options->username == true)
-        {
-          char *user_buf = NULL;
-          int   user_len = 0;
+        hash = &hashes_buf[hashes_cnt];
 
-          hlfmt_user (hashcat_ctx, hashlist_format, input_buf, input_len, &user_buf, &user_len);
+        parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf + 16, 16);
 
-          // special case:
-          // both hash_t need to have the username info if the pwdump format is used (i.e. we have 2 hashes for 3000, both with same user)
+        if (parser_status < PARSER_GLOBAL_ZERO)
+        {
+          char *tmp_line_buf;
 
-          u32 hashes_per_user = 1;
+          hc_asprintf (&tmp_line_buf, "%s", line_buf);
 
-          if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
-          {
-            // the following conditions should be true if (hashlist_format == HLFMT_PWDUMP)
+          compress_terminal_line_length (tmp_line_buf, 38, 32);
 
-            if (hash_len == 32)
-            {
-              hashes_per_user = 2;
-            }
+          if (user_options->machine_readable == true)
+          {
+            hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+          }
+          else
+          {
+            hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
           }
 
-          for (u32 i = 0; i < hashes_per_user; i++)
+          hcfree (tmp_line_buf);
+
+          continue;
+        }
+
+        if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
+        {
+          int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+
+          if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
           {
-            user_t **user = &hashes_buf[hashes_cnt + i].hash_info->user;
+            char *tmp_line_buf;
 
-            *user = (user_t *) hcmalloc (sizeof (user_t));
+            hc_asprintf (&tmp_line_buf, "%s", line_buf);
 
-            user_t *user_ptr = *user;
+            compress_terminal_line_length (tmp_line_buf, 38, 32);
 
-            if (user_buf != NULL)
+            if (user_options->machine_readable == true)
             {
-              user_ptr->user_name = hcstrdup (user_buf);
+              hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
             }
             else
             {
-              user_ptr->user_name = hcstrdup ("");
+              hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
             }
 
-            user_ptr->user_len = (u32) user_len;
+            hcfree (tmp_line_buf);
+
+            continue;
           }
         }
 
-        if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
-        {
-          if (hash_len == 32)
-          {
-            hash_t *hash;
+        hashes_buf[hashes_cnt].hash_info->split->split_group  = line_num;
+        hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_RIGHT;
 
-            hash = &hashes_buf[hashes_cnt];
+        hashes_cnt++;
+      }
+      else
+      {
+        hash_t *hash = &hashes_buf[hashes_cnt];
 
-            parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf +  0, 16);
+        int parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
 
-            if (parser_status == PARSER_OK)
-            {
-              if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
-              {
-                parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+        if (parser_status < PARSER_GLOBAL_ZERO)
+        {
+          char *tmp_line_buf;
 
-                if (parser_status == PARSER_OK)
-                {
-                  // nothing to do
-                }
-                else
-                {
-                  event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
-                }
-              }
+          hc_asprintf (&tmp_line_buf, "%s", line_buf);
 
-              hashes_buf[hashes_cnt].hash_info->split->split_group  = 0;
-              hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_LEFT;
+          compress_terminal_line_length (tmp_line_buf, 38, 32);
 
-              hashes_cnt++;
-            }
-            else
-            {
-              event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
-            }
+          if (user_options->machine_readable == true)
+          {
+            hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+          }
+          else
+          {
+            hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+          }
 
-            if (parser_status == PARSER_TOKEN_LENGTH)
-            {
-              hashes->parser_token_length_cnt++;
-            }
+          hcfree (tmp_line_buf);
 
-            hash = &hashes_buf[hashes_cnt];
+          continue;
+        }
 
-            parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf + 16, 16);
+        if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
+        {
+          int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
 
-            if (parser_status == PARSER_OK)
-            {
-              if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
-              {
-                parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+          if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
+          {
+            char *tmp_line_buf;
 
-                if (parser_status == PARSER_OK)
-                {
-                  // nothing to do
-                }
-                else
-                {
-                  event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
-                }
-              }
+            hc_asprintf (&tmp_line_buf, "%s", line_buf);
 
-              hashes_buf[hashes_cnt].hash_info->split->split_group  = 0;
-              hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_RIGHT;
+            compress_terminal_line_length (tmp_line_buf, 38, 32);
 
-              hashes_cnt++;
+            if (user_options->machine_readable == true)
+            {
+              hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
             }
             else
             {
-              event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
+              hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
             }
 
-            if (parser_status == PARSER_TOKEN_LENGTH)
-            {
-              hashes->parser_token_length_cnt++;
-            }
+            hcfree (tmp_line_buf);
+
+            continue;
           }
-          else
-          {
-            hash_t *hash = &hashes_buf[hashes_cnt];
+        }
 
-            parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
+        hashes_buf[hashes_cnt].hash_info->split->split_group  = line_num;
+        hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_NONE;
 
-            if (parser_status == PARSER_OK)
-            {
-              if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
-              {
-                parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+        hashes_cnt++;
+      }
+    }
+    else
+    {
+      hash_t *hash = &hashes_buf[hashes_cnt];
 
-                if (parser_status == PARSER_OK)
-                {
-                  // nothing to do
-                }
-                else
-                {
-                  event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
-                }
-              }
+      int parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
 
-              hashes_buf[hashes_cnt].hash_info->split->split_group  = 0;
-              hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_NONE;
+      if (parser_status < PARSER_GLOBAL_ZERO)
+      {
+        char *tmp_line_buf;
 
-              hashes_cnt++;
-            }
-            else
-            {
-              event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
-            }
+        hc_asprintf (&tmp_line_buf, "%s", line_buf);
 
-            if (parser_status == PARSER_TOKEN_LENGTH)
-            {
-              hashes->parser_token_length_cnt++;
-            }
-          }
+        compress_terminal_line_length (tmp_line_buf, 38, 32);
+
+        if (user_options->machine_readable == true)
+        {
+          hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
         }
         else
         {
-          hash_t *hash = &hashes_buf[hashes_cnt];
+          hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+        }
 
-          parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
+        hcfree (tmp_line_buf);
 
-          if (parser_status == PARSER_OK)
-          {
-            if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
-            {
-              parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+        if (parser_status == PARSER_TOKEN_LENGTH)
+        {
+          hr->parser_token_length_cnt++;
+        }
 
-              if (parser_status == PARSER_OK)
-              {
-                // nothing to do
-              }
-              else
-              {
-                event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
-              }
-            }
+        continue;
+      }
 
-            hashes_cnt++;
+      if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
+      {
+        int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+
+        if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
+        {
+          char *tmp_line_buf;
+
+          hc_asprintf (&tmp_line_buf, "%s", line_buf);
+
+          compress_terminal_line_length (tmp_line_buf, 38, 32);
+
+          if (user_options->machine_readable == true)
+          {
+            hashes_range_warning (hr, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
           }
           else
           {
-            event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
+            hashes_range_warning (hr, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
           }
 
-          if (parser_status == PARSER_TOKEN_LENGTH)
+          hcfree (tmp_line_buf);
+
+          if (parser_status_postprocess == PARSER_TOKEN_LENGTH)
           {
-            hashes->parser_token_length_cnt++;
+            hr->parser_token_length_cnt++;
           }
+
+          continue;
         }
       }
+
+      hashes_cnt++;
     }
-    else if (hashlist_mode == HL_MODE_FILE_PLAIN)
-    {
-      HCFILE fp;
 
-      if (hc_fopen (&fp, hashfile, "rb") == false)
-      {
-        event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+    hr->hashes_cnt = hashes_cnt - hr->hashes_base;
 
-        return -1;
-      }
+    // only the range parsed by the calling thread reports progress, for all of them
 
-      u32 line_num = 0;
+    if (hr->hr_all == NULL) continue;
 
-      char *line_buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
+    time (&now);
 
-      time_t prev = 0;
-      time_t now  = 0;
+    if ((now - prev) == 0) continue;
 
-      while (!hc_feof (&fp))
-      {
-        line_num++;
+    time (&prev);
 
-        const size_t line_len = fgetl (&fp, line_buf, HCBUFSIZ_LARGE);
+    hashlist_parse_t hashlist_parse;
 
-        if (line_len == 0) continue;
+    hashlist_parse.hashes_cnt   = 0;
+    hashlist_parse.hashes_avail = hr->hashes_total;
 
-        if (hashes_avail == hashes_cnt)
-        {
-          event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u: File changed during runtime. Skipping new data.", hashes->hashfile, line_num);
+    for (u32 i = 0; i < hr->hr_cnt; i++) hashlist_parse.hashes_cnt += hr->hr_all[i].hashes_cnt;
 
-          break;
-        }
+    hc_thread_mutex_lock (*hr->mux_log);
 
-        char *hash_buf = NULL;
-        int   hash_len = 0;
+    EVENT_DATA (EVENT_HASHLIST_PARSE_HASH, &hashlist_parse, sizeof (hashlist_parse_t));
 
-        hlfmt_hash (hashcat_ctx, hashlist_format, line_buf, line_len, &hash_buf, &hash_len);
+    hc_thread_mutex_unlock (*hr->mux_log);
+  }
 
-        bool hash_fmt_error = false;
+  hr->hashes_cnt = hashes_cnt - hr->hashes_base;
 
-        if (hash_len < 1)     hash_fmt_error = true;
-        if (hash_buf == NULL) hash_fmt_error = true;
+  hcfree (line_buf);
+}
 
-        if (hash_fmt_error)
-        {
-          event_log_warning (hashcat_ctx, "Failed to parse hashes using the '%s' format.", strhlfmt (hashlist_format));
+static HC_API_CALL void *thread_hashes_parse_range (void *p)
+{
+  hashes_parse_range ((hashes_range_t *) p);
 
-          continue;
-        }
+  return NULL;
+}
 
-        if (user_options->username == true)
-        {
-          char *user_buf = NULL;
-          int   user_len = 0;
+static u32 hashes_range_split (hashcat_ctx_t *hashcat_ctx, const char *hashfile, hashes_range_t *hr_all, const u32 hr_max)
+{
+  // the plain hashfile is cut into newline-aligned byte ranges, each one opened separately
 
-          hlfmt_user (hashcat_ctx, hashlist_format, line_buf, line_len, &user_buf, &user_len);
+  HCFILE *fp = &hr_all[0].fp;
 
-          // special case:
-          // both hash_t need to have the username info if the pwdump format is used (i.e. we have 2 hashes for 3000, both with same user)
+  struct stat st;
 
-          u32 hashes_per_user = 1;
+  if (hc_fstat (fp, &st) == -1) return 1;
 
-          if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
-          {
-            // the following conditions should be true if (hashlist_format == HLFMT_PWDUMP)
+  const u64 size = (u64) st.st_size;
 
-            if (hash_len == 32)
-            {
-              hashes_per_user = 2;
-            }
-          }
+  hr_all[0].beg = (u64) hc_ftell (fp);
+  hr_all[0].end = size;
 
-          for (u32 i = 0; i < hashes_per_user; i++)
-          {
-            user_t **user = &hashes_buf[hashes_cnt + i].hash_info->user;
+  u32 hr_cnt = 1;
 
-            *user = (user_t *) hcmalloc (sizeof (user_t));
+  for (u32 k = 1; k < hr_max; k++)
+  {
+    const u64 cut = (size / hr_max) * k;
 
-            user_t *user_ptr = *user;
+    if (cut <= hr_all[hr_cnt - 1].beg) continue;
 
-            if (user_buf != NULL)
-            {
-              user_ptr->user_name = hcstrdup (user_buf);
-            }
-            else
-            {
-              user_ptr->user_name = hcstrdup ("");
-            }
+    if (hc_fseek (fp, (off_t) cut - 1, SEEK_SET) == -1) break;
 
-            user_ptr->user_len = (u32) user_len;
-          }
+    int c;
+
+    while ((c = hc_fgetc (fp)) != EOF)
+    {
+      if (c == '\n') break;
+    }
+
+    if (c == EOF) break;
+
+    const off_t beg = hc_ftell (fp);
+
+    if ((u64) beg >= size) break;
+
+    if ((u64) beg <= hr_all[hr_cnt - 1].beg) continue;
+
+    hashes_range_t *hr = hr_all + hr_cnt;
+
+    if (hc_fopen (&hr->fp, hashfile, "rb") == false)
+    {
+      event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+
+      break;
+    }
+
+    if (hc_fseek (&hr->fp, beg, SEEK_SET) == -1)
+    {
+      hc_fclose (&hr->fp);
+
+      break;
+    }
+
+    hr->hashcat_ctx = hashcat_ctx;
+    hr->beg         = (u64) beg;
+    hr->end         = size;
+
+    hr_all[hr_cnt - 1].end = (u64) beg;
+
+    hr_cnt++;
+  }
+
+  hc_fseek (fp, (off_t) hr_all[0].beg, SEEK_SET);
+
+  return hr_cnt;
+}
+
+static void hashes_move (hashcat_ctx_t *hashcat_ctx, const u64 dst, const u64 src)
+{
+  hashconfig_t *hashconfig = hashcat_ctx->hashconfig;
+  hashes_t     *hashes     = hashcat_ctx->hashes;
+
+  // the hash_t at dst keeps pointing to its own digest and salt slots, only their content moves
+
+  hash_t *hash_dst = hashes->hashes_buf + dst;
+  hash_t *hash_src = hashes->hashes_buf + src;
+
+  memcpy (hash_dst->digest, hash_src->digest, hashconfig->dgst_size);
+
+  if (hashconfig->is_salted == true)
+  {
+    const u32 orig_pos = hash_dst->salt->orig_pos;
+
+    memcpy (hash_dst->salt, hash_src->salt, sizeof (salt_t));
+
+    hash_dst->salt->orig_pos = orig_pos;
+
+    if (hashconfig->esalt_size > 0)
+    {
+      memcpy (hash_dst->esalt, hash_src->esalt, hashconfig->esalt_size);
+    }
+
+    if (hashconfig->hook_salt_size > 0)
+    {
+      memcpy (hash_dst->hook_salt, hash_src->hook_salt, hashconfig->hook_salt_size);
+    }
+  }
+
+  hashinfo_t *hash_info = hash_dst->hash_info;
+
+  hash_dst->hash_info = hash_src->hash_info;
+  hash_src->hash_info = hash_info;
+}
+
+int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
+{
+  hashconfig_t          *hashconfig         = hashcat_ctx->hashconfig;
+  hashes_t              *hashes             = hashcat_ctx->hashes;
+  module_ctx_t          *module_ctx         = hashcat_ctx->module_ctx;
+  user_options_t        *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t  *user_options_extra = hashcat_ctx->user_options_extra;
+
+  /**
+   * load hashes, part I: find input mode, count hashes
+   */
+
+  const char *hashfile      = hashes->hashfile;
+  const u32   hashlist_mode = hashes->hashlist_mode;
+
+  u32 hashlist_format = HLFMT_HASHCAT;
+
+  u64 hashes_avail = 0;
+
+  if ((user_options->benchmark == false) && (user_options->stdout_flag == false) && (user_options->keyspace == false))
+  {
+    if (hashlist_mode == HL_MODE_ARG)
+    {
+      hashes_avail = 1;
+    }
+    else if (hashlist_mode == HL_MODE_FILE_PLAIN)
+    {
+      HCFILE fp;
+
+      if (hc_fopen (&fp, hashfile, "rb") == false)
+      {
+        event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+
+        return -1;
+      }
+
+      EVENT_DATA (EVENT_HASHLIST_COUNT_LINES_PRE, hashfile, strlen (hashfile));
+
+      hashes_avail = count_lines (&fp);
+
+      EVENT_DATA (EVENT_HASHLIST_COUNT_LINES_POST, hashfile, strlen (hashfile));
+
+      hc_rewind (&fp);
+
+      if (hashes_avail == 0)
+      {
+        event_log_error (hashcat_ctx, "hashfile is empty or corrupt.");
+
+        hc_fclose (&fp);
+
+        return -1;
+      }
+
+      hashlist_format = hlfmt_detect (hashcat_ctx, &fp, 100); // 100 = max numbers to "scan". could be hashes_avail, too
+
+      hc_fclose (&fp);
+
+      if ((user_options->remove == true) && (hashlist_format != HLFMT_HASHCAT))
+      {
+        event_log_error (hashcat_ctx, "Use of --remove is not supported in native hashfile-format mode.");
+
+        return -1;
+      }
+    }
+    else if (hashlist_mode == HL_MODE_FILE_BINARY)
+    {
+      struct stat st;
+
+      if (stat (hashes->hashfile, &st) == -1)
+      {
+        event_log_error (hashcat_ctx, "%s: %s", hashes->hashfile, strerror (errno));
+
+        return -1;
+      }
+
+      if (module_ctx->module_hash_binary_count != MODULE_DEFAULT)
+      {
+        const int binary_count = module_ctx->module_hash_binary_count (hashes);
+
+        if (binary_count > 0)
+        {
+          hashes_avail = binary_count;
         }
+        else if (binary_count == 0)
+        {
+          event_log_error (hashcat_ctx, "No hashes loaded.");
+
+          return -1;
+        }
+        else if (binary_count == PARSER_HAVE_ERRNO)
+        {
+          event_log_error (hashcat_ctx, "%s: %s", hashes->hashfile, strerror (errno));
+
+          return -1;
+        }
+        else
+        {
+          event_log_error (hashcat_ctx, "%s: %s", hashes->hashfile, strerror (binary_count));
+
+          return -1;
+        }
+      }
+      else
+      {
+        hashes_avail = 1;
+      }
+    }
+  }
+  else
+  {
+    hashes_avail = 1;
+  }
+
+  if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT) hashes_avail *= 2;
+
+  hashes->hashlist_format = hashlist_format;
 
+  /**
+   * load hashes, part II: allocate required memory, set pointers
+   */
+
+  hash_t *hashes_buf     = (hash_t *) hccalloc (hashes_avail, sizeof (hash_t));
+  void   *digests_buf    =            hccalloc (hashes_avail, hashconfig->dgst_size);
+  salt_t *salts_buf      = NULL;
+  void   *esalts_buf     = NULL;
+  void   *hook_salts_buf = NULL;
+
+  if ((user_options->dynamic_x == true) || (user_options->username == true) || (hashconfig->opts_type & OPTS_TYPE_HASH_COPY) || (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT))
+  {
+    // one array per type out of the arena instead of up to five heap allocations per hash.
+    // orighash is set to an exact-size copy of the hash line while parsing
+
+    hcarena_t *arena = &hashes->arena;
+
+    hashinfo_t *hash_info_buf = (hashinfo_t *) hcarena_alloc (arena, hashes_avail * sizeof (hashinfo_t));
+
+    dynamicx_t *dynamicx_buf = NULL;
+    user_t     *users_buf    = NULL;
+    split_t    *split_buf    = NULL;
+
+    if (user_options->dynamic_x == true)              dynamicx_buf = (dynamicx_t *) hcarena_alloc (arena, hashes_avail * sizeof (dynamicx_t));
+    if (user_options->username  == true)              users_buf    = (user_t *)     hcarena_alloc (arena, hashes_avail * sizeof (user_t));
+    if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT) split_buf    = (split_t *)    hcarena_alloc (arena, hashes_avail * sizeof (split_t));
+
+    for (u64 hash_pos = 0; hash_pos < hashes_avail; hash_pos++)
+    {
+      hashinfo_t *hash_info = &hash_info_buf[hash_pos];
+
+      hashes_buf[hash_pos].hash_info = hash_info;
+
+      if (dynamicx_buf) hash_info->dynamicx = &dynamicx_buf[hash_pos];
+      if (users_buf)    hash_info->user     = &users_buf[hash_pos];
+      if (split_buf)    hash_info->split    = &split_buf[hash_pos];
+    }
+  }
+
+  if (hashconfig->is_salted == true)
+  {
+    salts_buf = (salt_t *) hccalloc (hashes_avail, sizeof (salt_t));
+
+    if (user_options->attack_mode == ATTACK_MODE_ASSOCIATION)
+    {
+      // this disables:
+      // - sorting by salt value
+      // - grouping by salt value
+      // - keep the salt in position relative to hashfile (not equal because of some hashes maybe failed to load)
+
+      u64 hash_pos;
+
+      for (hash_pos = 0; hash_pos < hashes_avail; hash_pos++)
+      {
+        salt_t *salt = &salts_buf[hash_pos];
+
+        salt->orig_pos = hash_pos;
+      }
+    }
+
+    if (hashconfig->esalt_size > 0)
+    {
+      esalts_buf = hccalloc (hashes_avail, hashconfig->esalt_size);
+    }
+
+    if (hashconfig->hook_salt_size > 0)
+    {
+      hook_salts_buf = hccalloc (hashes_avail, hashconfig->hook_salt_size);
+    }
+  }
+  else
+  {
+    salts_buf = (salt_t *) hccalloc (1, sizeof (salt_t));
+  }
+
+  for (u64 hash_pos = 0; hash_pos < hashes_avail; hash_pos++)
+  {
+    /**
+     * Initialize some values for later use
+     */
+
+    hashes_buf[hash_pos].orig_line_pos = hash_pos;
+
+    hashes_buf[hash_pos].digest = ((char *) digests_buf) + (hash_pos * hashconfig->dgst_size);
+
+    if (hashconfig->is_salted == true)
+    {
+      hashes_buf[hash_pos].salt = &salts_buf[hash_pos];
+
+      if (hashconfig->esalt_size > 0)
+      {
+        hashes_buf[hash_pos].esalt = ((char *) esalts_buf) + (hash_pos * hashconfig->esalt_size);
+      }
+
+      if (hashconfig->hook_salt_size > 0)
+      {
+        hashes_buf[hash_pos].hook_salt = ((char *) hook_salts_buf) + (hash_pos * hashconfig->hook_salt_size);
+      }
+    }
+    else
+    {
+      hashes_buf[hash_pos].salt = &salts_buf[0];
+    }
+  }
+
+  hashes->hashes_buf     = hashes_buf;
+  hashes->digests_buf    = digests_buf;
+  hashes->salts_buf      = salts_buf;
+  hashes->esalts_buf     = esalts_buf;
+  hashes->hook_salts_buf = hook_salts_buf;
+
+  /**
+   * load hashes, part III: parse hashes
+   */
+
+  u32 hashes_cnt = 0;
+
+  if (user_options->benchmark == true)
+  {
+    hashes->hashfile = "-";
+
+    hashes_cnt = 1;
+  }
+  else if (user_options->hash_info == true)
+  {
+  }
+  else if (user_options->keyspace == true)
+  {
+  }
+  else if (user_options->stdout_flag == true)
+  {
+  }
+  else if (user_options->backend_info > 0)
+  {
+  }
+  else
+  {
+    if (hashlist_mode == HL_MODE_ARG)
+    {
+      char *input_buf = user_options_extra->hc_hash;
+
+      size_t input_len = strlen (input_buf);
+
+      char  *hash_buf = NULL;
+      int    hash_len = 0;
+
+      hlfmt_hash (hashcat_ctx, hashlist_format, input_buf, input_len, &hash_buf, &hash_len);
+
+      bool hash_fmt_error = false;
+
+      if (hash_len < 1)     hash_fmt_error = true;
+      if (hash_buf == NULL) hash_fmt_error = true;
+
+      if (hash_fmt_error)
+      {
+        event_log_warning (hashcat_ctx, "Failed to parse hashes using the '%s' format.", strhlfmt (hashlist_format));
+      }
+      else
+      {
         if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
         {
           hashinfo_t *hash_info_tmp = hashes_buf[hashes_cnt].hash_info;
 
-          hash_info_tmp->orighash = hcstrdup (hash_buf);
+          hash_info_tmp->orighash = hcarena_strdup (&hashes->arena, hash_buf);
         }
 
         if (hashconfig->is_salted == true)
         {
-          const u32 orig_pos = hashes_buf[hashes_cnt].salt->orig_pos;
-
-          memset (hashes_buf[hashes_cnt].salt, 0, sizeof (salt_t));
-
-          hashes_buf[hashes_cnt].salt->orig_pos = orig_pos;
+          memset (hashes_buf[0].salt, 0, sizeof (salt_t));
         }
 
         if (hashconfig->esalt_size > 0)
         {
-          memset (hashes_buf[hashes_cnt].esalt, 0, hashconfig->esalt_size);
+          memset (hashes_buf[0].esalt, 0, hashconfig->esalt_size);
         }
 
-        if (hashconfig->hook_salt_size > 0)
-        {
-          memset (hashes_buf[hashes_cnt].hook_salt, 0, hashconfig->hook_salt_size);
+        if (hashconfig->hook_salt_size > 0)
+        {
+          memset (hashes_buf[0].hook_salt, 0, hashconfig->hook_salt_size);
+        }
+
+        int parser_status = PARSER_OK;
+
+        if (user_options->username == true)
+        {
+          char *user_buf = NULL;
+          int   user_len = 0;
+
+          hlfmt_user (hashcat_ctx, hashlist_format, input_buf, input_len, &user_buf, &user_len);
+
+          // special case:
+          // both hash_t need to have the username info if the pwdump format is used (i.e. we have 2 hashes for 3000, both with same user)
+
+          u32 hashes_per_user = 1;
+
+          if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
+          {
+            // the following conditions should be true if (hashlist_format == HLFMT_PWDUMP)
+
+            if (hash_len == 32)
+            {
+              hashes_per_user = 2;
+            }
+          }
+
+          for (u32 i = 0; i < hashes_per_user; i++)
+          {
+            user_t *user_ptr = hashes_buf[hashes_cnt + i].hash_info->user;
+
+            if (user_buf != NULL)
+            {
+              user_ptr->user_name = hcarena_strdup (&hashes->arena, user_buf);
+            }
+            else
+            {
+              user_ptr->user_name = hcarena_strdup (&hashes->arena, "");
+            }
+
+            user_ptr->user_len = (u32) user_len;
+          }
         }
 
         if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
@@ -1513,273 +1856,264 @@ int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
 
             hash = &hashes_buf[hashes_cnt];
 
-            int parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf +  0, 16);
-
-            if (parser_status < PARSER_GLOBAL_ZERO)
-            {
-              char *tmp_line_buf;
-
-              hc_asprintf (&tmp_line_buf, "%s", line_buf);
-
-              compress_terminal_line_length (tmp_line_buf, 38, 32);
-
-              if (user_options->machine_readable == true)
-              {
-                event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
-              }
-              else
-              {
-                event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
-              }
-
-              hcfree (tmp_line_buf);
-
-              continue;
-            }
+            parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf +  0, 16);
 
-            if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
+            if (parser_status == PARSER_OK)
             {
-              int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
-
-              if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
+              if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
               {
-                char *tmp_line_buf;
-
-                hc_asprintf (&tmp_line_buf, "%s", line_buf);
-
-                compress_terminal_line_length (tmp_line_buf, 38, 32);
+                parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
 
-                if (user_options->machine_readable == true)
+                if (parser_status == PARSER_OK)
                 {
-                  event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
+                  // nothing to do
                 }
                 else
                 {
-                  event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
+                  event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
                 }
+              }
 
-                hcfree (tmp_line_buf);
+              hashes_buf[hashes_cnt].hash_info->split->split_group  = 0;
+              hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_LEFT;
 
-                continue;
-              }
+              hashes_cnt++;
+            }
+            else
+            {
+              event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
             }
 
-            hashes_buf[hashes_cnt].hash_info->split->split_group  = line_num;
-            hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_LEFT;
-
-            hashes_cnt++;
+            if (parser_status == PARSER_TOKEN_LENGTH)
+            {
+              hashes->parser_token_length_cnt++;
+            }
 
             hash = &hashes_buf[hashes_cnt];
 
             parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf + 16, 16);
 
-            if (parser_status < PARSER_GLOBAL_ZERO)
+            if (parser_status == PARSER_OK)
             {
-              char *tmp_line_buf;
-
-              hc_asprintf (&tmp_line_buf, "%s", line_buf);
-
-              compress_terminal_line_length (tmp_line_buf, 38, 32);
-
-              if (user_options->machine_readable == true)
-              {
-                event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
-              }
-              else
+              if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
               {
-                event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+                parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+
+                if (parser_status == PARSER_OK)
+                {
+                  // nothing to do
+                }
+                else
+                {
+                  event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
+                }
               }
 
-              hcfree (tmp_line_buf);
+              hashes_buf[hashes_cnt].hash_info->split->split_group  = 0;
+              hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_RIGHT;
 
-              continue;
+              hashes_cnt++;
             }
-
-            if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
+            else
             {
-              int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+              event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
+            }
 
-              if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
-              {
-                char *tmp_line_buf;
+            if (parser_status == PARSER_TOKEN_LENGTH)
+            {
+              hashes->parser_token_length_cnt++;
+            }
+          }
+          else
+          {
+            hash_t *hash = &hashes_buf[hashes_cnt];
 
-                hc_asprintf (&tmp_line_buf, "%s", line_buf);
+            parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
 
-                compress_terminal_line_length (tmp_line_buf, 38, 32);
+            if (parser_status == PARSER_OK)
+            {
+              if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
+              {
+                parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
 
-                if (user_options->machine_readable == true)
+                if (parser_status == PARSER_OK)
                 {
-                  event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
+                  // nothing to do
                 }
                 else
                 {
-                  event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
+                  event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
                 }
+              }
 
-                hcfree (tmp_line_buf);
+              hashes_buf[hashes_cnt].hash_info->split->split_group  = 0;
+              hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_NONE;
 
-                continue;
-              }
+              hashes_cnt++;
+            }
+            else
+            {
+              event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
             }
 
-            hashes_buf[hashes_cnt].hash_info->split->split_group  = line_num;
-            hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_RIGHT;
-
-            hashes_cnt++;
+            if (parser_status == PARSER_TOKEN_LENGTH)
+            {
+              hashes->parser_token_length_cnt++;
+            }
           }
-          else
-          {
-            hash_t *hash = &hashes_buf[hashes_cnt];
+        }
+        else
+        {
+          hash_t *hash = &hashes_buf[hashes_cnt];
 
-            int parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
+          parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
 
-            if (parser_status < PARSER_GLOBAL_ZERO)
+          if (parser_status == PARSER_OK)
+          {
+            if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
             {
-              char *tmp_line_buf;
-
-              hc_asprintf (&tmp_line_buf, "%s", line_buf);
-
-              compress_terminal_line_length (tmp_line_buf, 38, 32);
+              parser_status = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
 
-              if (user_options->machine_readable == true)
+              if (parser_status == PARSER_OK)
               {
-                event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+                // nothing to do
               }
               else
               {
-                event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
+                event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
               }
+            }
 
-              hcfree (tmp_line_buf);
+            hashes_cnt++;
+          }
+          else
+          {
+            event_log_warning (hashcat_ctx, "Hash '%s': %s", input_buf, strparser (parser_status));
+          }
 
-              continue;
-            }
+          if (parser_status == PARSER_TOKEN_LENGTH)
+          {
+            hashes->parser_token_length_cnt++;
+          }
+        }
+      }
+    }
+    else if (hashlist_mode == HL_MODE_FILE_PLAIN)
+    {
+      // big plain hashfiles are cut into newline-aligned ranges, which are counted and then parsed in parallel
+      // compressed files can't be entered in the middle, they are parsed in one go
+      // so are hashfiles of modules whose decoder did not opt in with OPTS_TYPE_HASH_DECODE_MT
 
-            if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
-            {
-              int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+      int procs_cnt = hc_get_processor_count ();
 
-              if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
-              {
-                char *tmp_line_buf;
+      if (procs_cnt < 1) procs_cnt = 1;
 
-                hc_asprintf (&tmp_line_buf, "%s", line_buf);
+      hashes_range_t *hr_all = (hashes_range_t *) hccalloc (procs_cnt, sizeof (hashes_range_t));
 
-                compress_terminal_line_length (tmp_line_buf, 38, 32);
+      hashes_range_t *hr0 = hr_all;
 
-                if (user_options->machine_readable == true)
-                {
-                  event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
-                }
-                else
-                {
-                  event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
-                }
+      if (hc_fopen (&hr0->fp, hashfile, "rb") == false)
+      {
+        event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
 
-                hcfree (tmp_line_buf);
+        hcfree (hr_all);
 
-                continue;
-              }
-            }
+        return -1;
+      }
 
-            hashes_buf[hashes_cnt].hash_info->split->split_group  = line_num;
-            hashes_buf[hashes_cnt].hash_info->split->split_origin = SPLIT_ORIGIN_NONE;
+      hr0->hashcat_ctx = hashcat_ctx;
+      hr0->ranged      = false;
 
-            hashes_cnt++;
-          }
-        }
-        else
-        {
-          hash_t *hash = &hashes_buf[hashes_cnt];
+      u32 hr_max = 1;
 
-          int parser_status = module_ctx->module_hash_decode (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, hash_buf, hash_len);
+      struct stat st;
 
-          if (parser_status < PARSER_GLOBAL_ZERO)
-          {
-            char *tmp_line_buf;
+      if ((hashconfig->opts_type & OPTS_TYPE_HASH_DECODE_MT) && (hr0->fp.pfp != NULL) && (hc_fstat (&hr0->fp, &st) == 0))
+      {
+        hr_max = (u32) MIN ((u64) procs_cnt, MAX ((u64) st.st_size / HASHES_RANGE_MIN, 1));
+      }
 
-            hc_asprintf (&tmp_line_buf, "%s", line_buf);
+      const u32 hr_cnt = (hr_max > 1) ? hashes_range_split (hashcat_ctx, hashfile, hr_all, hr_max) : 1;
 
-            compress_terminal_line_length (tmp_line_buf, 38, 32);
+      hc_thread_t *hr_threads = (hc_thread_t *) hccalloc (hr_cnt, sizeof (hc_thread_t));
 
-            if (user_options->machine_readable == true)
-            {
-              event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
-            }
-            else
-            {
-              event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status));
-            }
+      if (hr_cnt > 1)
+      {
+        for (u32 k = 0; k < hr_cnt; k++) hr_all[k].ranged = true;
 
-            hcfree (tmp_line_buf);
+        for (u32 k = 1; k < hr_cnt; k++) hc_thread_create (hr_threads[k], thread_hashes_scan_range, &hr_all[k]);
 
-            if (parser_status == PARSER_TOKEN_LENGTH)
-            {
-              hashes->parser_token_length_cnt++;
-            }
+        hashes_scan_range (hr0);
 
-            continue;
-          }
+        hc_thread_wait ((int) hr_cnt - 1, hr_threads + 1);
+      }
 
-          if (module_ctx->module_hash_decode_postprocess != MODULE_DEFAULT)
-          {
-            int parser_status_postprocess = module_ctx->module_hash_decode_postprocess (hashconfig, hash->digest, hash->salt, hash->esalt, hash->hook_salt, hash->hash_info, user_options, user_options_extra);
+      // every range gets a slice of hashes_buf large enough for all its lines, in file order
 
-            if (parser_status_postprocess < PARSER_GLOBAL_ZERO)
-            {
-              char *tmp_line_buf;
+      u32 line_num    = 0;
+      u64 hashes_base = 0;
 
-              hc_asprintf (&tmp_line_buf, "%s", line_buf);
+      for (u32 k = 0; k < hr_cnt; k++)
+      {
+        hashes_range_t *hr = hr_all + k;
 
-              compress_terminal_line_length (tmp_line_buf, 38, 32);
+        hr->line_num = line_num;
 
-              if (user_options->machine_readable == true)
-              {
-                event_log_warning (hashcat_ctx, "%s:%u:%s:%s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
-              }
-              else
-              {
-                event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, tmp_line_buf, strparser (parser_status_postprocess));
-              }
+        hr->hashes_base  = hashes_base;
+        hr->hashes_avail = (hr_cnt > 1) ? MIN (hr->hashes_max, hashes_avail - hashes_base) : hashes_avail;
 
-              hcfree (tmp_line_buf);
+        line_num    += hr->lines_cnt;
+        hashes_base += hr->hashes_avail;
+      }
 
-              if (parser_status_postprocess == PARSER_TOKEN_LENGTH)
-              {
-                hashes->parser_token_length_cnt++;
-              }
+      hc_thread_mutex_t mux_log;
 
-              continue;
-            }
-          }
+      hc_thread_mutex_init (mux_log);
 
-          hashes_cnt++;
-        }
+      for (u32 k = 0; k < hr_cnt; k++) hr_all[k].mux_log = &mux_log;
+
+      hr0->hr_all       = hr_all;
+      hr0->hr_cnt       = hr_cnt;
+      hr0->hashes_total = hashes_avail;
+
+      for (u32 k = 1; k < hr_cnt; k++) hc_thread_create (hr_threads[k], thread_hashes_parse_range, &hr_all[k]);
+
+      hashes_parse_range (hr0);
+
+      hc_thread_wait ((int) hr_cnt - 1, hr_threads + 1);
+
+      hcfree (hr_threads);
+
+      hc_thread_mutex_delete (mux_log);
 
-        time (&now);
+      // close the gaps between the slices, merging in file order gives the same result as a serial parse
 
-        if ((now - prev) == 0) continue;
+      for (u32 k = 0; k < hr_cnt; k++)
+      {
+        hashes_range_t *hr = hr_all + k;
+
+        for (u64 i = 0; i < hr->hashes_cnt; i++)
+        {
+          if ((hr->hashes_base + i) != (hashes_cnt + i)) hashes_move (hashcat_ctx, hashes_cnt + i, hr->hashes_base + i);
+        }
 
-        time (&prev);
+        hashes_cnt += (u32) hr->hashes_cnt;
 
-        hashlist_parse_t hashlist_parse;
+        hashes->parser_token_length_cnt += hr->parser_token_length_cnt;
 
-        hashlist_parse.hashes_cnt   = hashes_cnt;
-        hashlist_parse.hashes_avail = hashes_avail;
+        hcarena_merge (&hashes->arena, &hr->arena);
 
-        EVENT_DATA (EVENT_HASHLIST_PARSE_HASH, &hashlist_parse, sizeof (hashlist_parse_t));
+        hc_fclose (&hr->fp);
       }
 
+      hcfree (hr_all);
+
       hashlist_parse_t hashlist_parse;
 
       hashlist_parse.hashes_cnt   = hashes_cnt;
       hashlist_parse.hashes_avail = hashes_avail;
 
       EVENT_DATA (EVENT_HASHLIST_PARSE_HASH, &hashlist_parse, sizeof (hashlist_parse_t));
-
-      hcfree (line_buf);
-
-      hc_fclose (&fp);
     }
     else if (hashlist_mode == HL_MODE_FILE_BINARY)
     {
@@ -1791,7 +2125,7 @@ int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
       {
         hashinfo_t *hash_info_tmp = hashes_buf[hashes_cnt].hash_info;
 
-        hash_info_tmp->orighash = hcstrdup (input_buf);
+        hash_info_tmp->orighash = hcarena_strdup (&hashes->arena, input_buf);
       }
 
       if (hashconfig->is_salted == true)
@@ -1890,26 +2224,56 @@ int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
     // update split split_neighbor after sorting
     // see https://github.com/hashcat/hashcat/issues/1034 for good examples for testing
 
+    // split_group is the line number of the pair, so a table indexed by it finds the right half
+    // of each left half in one pass. it keeps the first right half of a group, like a linear search would
+
+    u32 split_group_max = 0;
+
+    for (u32 i = 0; i < hashes_cnt; i++)
+    {
+      split_t *split = hashes_buf[i].hash_info->split;
+
+      if (split->split_origin != SPLIT_ORIGIN_RIGHT) continue;
+
+      split_group_max = MAX (split_group_max, (u32) split->split_group);
+    }
+
+    u32 *split_right = (u32 *) hcmalloc (((u64) split_group_max + 1) * sizeof (u32));
+
+    memset (split_right, 0xff, ((u64) split_group_max + 1) * sizeof (u32));
+
+    for (u32 j = 0; j < hashes_cnt; j++)
+    {
+      split_t *split2 = hashes_buf[j].hash_info->split;
+
+      if (split2->split_origin != SPLIT_ORIGIN_RIGHT) continue;
+
+      const u32 split_group = (u32) split2->split_group;
+
+      if (split_right[split_group] == 0xffffffff) split_right[split_group] = j;
+    }
+
     for (u32 i = 0; i < hashes_cnt; i++)
     {
       split_t *split1 = hashes_buf[i].hash_info->split;
 
       if (split1->split_origin != SPLIT_ORIGIN_LEFT) continue;
 
-      for (u32 j = 0; j < hashes_cnt; j++)
-      {
-        split_t *split2 = hashes_buf[j].hash_info->split;
+      const u32 split_group = (u32) split1->split_group;
 
-        if (split2->split_origin != SPLIT_ORIGIN_RIGHT) continue;
+      if (split_group > split_group_max) continue;
 
-        if (split1->split_group != split2->split_group) continue;
+      const u32 j = split_right[split_group];
 
-        split1->split_neighbor = j;
-        split2->split_neighbor = i;
+      if (j == 0xffffffff) continue;
 
-        break;
-      }
+      split_t *split2 = hashes_buf[j].hash_info->split;
+
+      split1->split_neighbor = j;
+      split2->split_neighbor = i;
     }
+
+    hcfree (split_right);
   }
 
   if (hashes->parser_token_length_cnt > 0)
@@ -2671,9 +3035,7 @@ int hashes_init_zerohash (hashcat_ctx_t *hashcat_ctx)
 
 void hashes_destroy (hashcat_ctx_t *hashcat_ctx)
 {
-  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
-  hashes_t       *hashes       = hashcat_ctx->hashes;
-  user_options_t *user_options = hashcat_ctx->user_options;
+  hashes_t *hashes = hashcat_ctx->hashes;
 
   hcfree (hashes->digests_buf);
   hcfree (hashes->digests_shown);
@@ -2681,29 +3043,10 @@ void hashes_destroy (hashcat_ctx_t *hashcat_ctx)
   hcfree (hashes->salts_buf);
   hcfree (hashes->salts_shown);
 
-  if ((user_options->username == true) || (hashconfig->opts_type & OPTS_TYPE_HASH_COPY))
-  {
-    for (u32 hash_pos = 0; hash_pos < hashes->hashes_cnt; hash_pos++)
-    {
-      if (user_options->username == true)
-      {
-        hcfree (hashes->hash_info[hash_pos]->user);
-      }
-
-      if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
-      {
-        hcfree (hashes->hash_info[hash_pos]->orighash);
-      }
-
-      if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
-      {
-        hcfree (hashes->hash_info[hash_pos]->split);
-      }
-    }
-  }
-
   hcfree (hashes->hash_info);
 
+  hcarena_free (&hashes->arena);
+
   hcfree (hashes->esalts_buf);
   hcfree (hashes->hook_salts_buf);
 
@@ -346,6 +346,7 @@ static void main_cracker_hash_cracked (MAYBE_UNUSED hashcat_ctx_t *hashcat_ctx,
   user_options_extra_t  *user_options_extra = hashcat_ctx->user_options_extra;
 
   if (outfile_ctx->fp.pfp != NULL) return; // cracked hash was not written to an outfile
+  if (outfile_ctx->is_async == true) return; // cracked hash was queued for the outfile
 
   if ((user_options_extra->wordlist_mode == WL_MODE_FILE) || (user_options_extra->wordlist_mode == WL_MODE_MASK))
   {
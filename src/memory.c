@@ -67,6 +67,98 @@ void hcfree (void *ptr)
   free (ptr);
 }
 
+// the arena hands out zeroed memory like hcmalloc () but carves it out of large blocks,
+// which saves one heap allocation and the malloc header per object
+
+#define HCARENA_ALIGN(x) (((x) + 15) & ~((size_t) 15))
+
+void *hcarena_alloc (hcarena_t *arena, const size_t sz)
+{
+  const size_t hdr_sz = HCARENA_ALIGN (sizeof (hcarena_block_t));
+
+  const size_t req_sz = HCARENA_ALIGN (sz);
+
+  hcarena_block_t *head = arena->head;
+
+  if ((head != NULL) && ((head->size - head->used) >= req_sz))
+  {
+    void *p = (char *) head + hdr_sz + head->used;
+
+    head->used += req_sz;
+
+    return (p);
+  }
+
+  // big requests get a block of their own, so the current block can still be filled up
+
+  const bool own_block = (req_sz > (HCARENA_BLOCK_SIZE / 4));
+
+  const size_t block_sz = (own_block == true) ? req_sz : HCARENA_BLOCK_SIZE;
+
+  hcarena_block_t *block = (hcarena_block_t *) hcmalloc (hdr_sz + block_sz);
+
+  if (block == NULL) return (NULL);
+
+  block->size = block_sz;
+  block->used = req_sz;
+
+  if ((own_block == true) && (head != NULL))
+  {
+    block->next = head->next;
+    head->next  = block;
+  }
+  else
+  {
+    block->next = head;
+    arena->head = block;
+  }
+
+  return ((char *) block + hdr_sz);
+}
+
+char *hcarena_strdup (hcarena_t *arena, const char *s)
+{
+  const size_t len = strlen (s);
+
+  char *b = (char *) hcarena_alloc (arena, len + 1);
+
+  if (b == NULL) return (NULL);
+
+  memcpy (b, s, len);
+
+  return (b);
+}
+
+void hcarena_merge (hcarena_t *dst, hcarena_t *src)
+{
+  hcarena_block_t *tail = src->head;
+
+  if (tail == NULL) return;
+
+  while (tail->next != NULL) tail = tail->next;
+
+  tail->next = dst->head;
+
+  dst->head = src->head;
+  src->head = NULL;
+}
+
+void hcarena_free (hcarena_t *arena)
+{
+  hcarena_block_t *block = arena->head;
+
+  while (block != NULL)
+  {
+    hcarena_block_t *next = block->next;
+
+    hcfree (block);
+
+    block = next;
+  }
+
+  arena->head = NULL;
+}
+
 void *hcmalloc_aligned (const size_t sz, const int align)
 {
   uintptr_t align_mask = (uintptr_t) (align - 1);
@@ -497,6 +497,27 @@ u32 module_deep_comp_kernel (MAYBE_UNUSED const hashes_t *hashes, MAYBE_UNUSED c
   return 0;
 }
 
+u64 module_potfile_custom_bucket (MAYBE_UNUSED const hashconfig_t *hashconfig, MAYBE_UNUSED const hash_t *hash)
+{
+  const wpa_eapol_t *wpa_eapol = (const wpa_eapol_t *) hash->esalt;
+
+  // module_potfile_custom_check () rejects everything with a different essid, so the essid is the bucket.
+  // it compares with strcmp (), anything past a zero byte must not change the bucket
+
+  const u8 *essid = (const u8 *) wpa_eapol->essid;
+
+  u64 bucket = 0xcbf29ce484222325 ^ wpa_eapol->essid_len;
+
+  for (u32 i = 0; i < wpa_eapol->essid_len; i++)
+  {
+    if (essid[i] == 0) break;
+
+    bucket = (bucket ^ essid[i]) * 0x100000001b3;
+  }
+
+  return bucket;
+}
+
 bool module_potfile_custom_check (MAYBE_UNUSED const hashconfig_t *hashconfig, MAYBE_UNUSED const hash_t *db, MAYBE_UNUSED const hash_t *entry_hash, MAYBE_UNUSED const void *entry_tmps)
 {
   const wpa_eapol_t *wpa_eapol_entry = (const wpa_eapol_t *) entry_hash->esalt;
@@ -966,6 +987,7 @@ void module_init (module_ctx_t *module_ctx)
   module_ctx->module_opts_type                = module_opts_type;
   module_ctx->module_outfile_check_disable    = MODULE_DEFAULT;
   module_ctx->module_outfile_check_nocomp     = MODULE_DEFAULT;
+  module_ctx->module_potfile_custom_bucket    = module_potfile_custom_bucket;
   module_ctx->module_potfile_custom_check     = module_potfile_custom_check;
   module_ctx->module_potfile_disable          = MODULE_DEFAULT;
   module_ctx->module_potfile_keep_all_hashes  = MODULE_DEFAULT;
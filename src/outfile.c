@@ -568,6 +568,44 @@ void outfile_write_close (hashcat_ctx_t *hashcat_ctx)
   hc_fclose (&outfile_ctx->fp);
 }
 
+// used by the writer thread, opens the outfile just like outfile_write_open () but with its own handle,
+// because outfile_ctx->fp decides whether check_cracked () prints to stdout.
+// returns -1 with errno set if the outfile can't be written, the caller logs it and falls back to stdout then
+
+int outfile_write_batch (hashcat_ctx_t *hashcat_ctx, const u8 *buf, const size_t len)
+{
+  const outfile_ctx_t *outfile_ctx = hashcat_ctx->outfile_ctx;
+
+  if (len == 0) return 0;
+
+  HCFILE fp;
+
+  bool opened = hc_fopen (&fp, outfile_ctx->filename, "ab");
+
+  if ((opened == true) && (hc_lockfile (&fp) == -1))
+  {
+    const int lock_errno = errno;
+
+    hc_fclose (&fp);
+
+    errno = lock_errno;
+
+    opened = false;
+  }
+
+  if (opened == false) return -1;
+
+  hc_fwrite (buf, len, 1, &fp);
+
+  hc_fflush (&fp);
+
+  hc_unlockfile (&fp);
+
+  hc_fclose (&fp);
+
+  return 0;
+}
+
 int outfile_write (hashcat_ctx_t *hashcat_ctx, const char *out_buf, const int out_len, const unsigned char *plain_ptr, const u32 plain_len, const u64 crackpos, const unsigned char *username, const u32 user_len, const bool print_eol, char *tmp_buf)
 {
   const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
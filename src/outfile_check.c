@@ -79,17 +79,86 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
 
   u32 check_left = outfile_check_timer; // or 1 if we want to check it at startup
 
+  // with inotify, a change in the directory triggers a check right away instead of after up to
+  // outfile_check_timer seconds. the timer based check stays, inotify does not see everything
+  // (for instance writes from other hosts to a network filesystem)
+
+  bool event_pending = false;
+  bool rescan_forced = false;
+
+  #if defined (OUTCHECK_INOTIFY)
+  int inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+
+  if (inotify_fd != -1)
+  {
+    if (inotify_add_watch (inotify_fd, root_directory, IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) == -1)
+    {
+      close (inotify_fd);
+
+      inotify_fd = -1;
+    }
+  }
+  #endif
+
   while (status_ctx->shutdown_inner == false)
   {
+    bool timer_tick = true;
+
+    #if defined (OUTCHECK_INOTIFY)
+    if (inotify_fd != -1)
+    {
+      struct pollfd pfd;
+
+      pfd.fd      = inotify_fd;
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+
+      if (poll (&pfd, 1, 1000) > 0)
+      {
+        // only a full second without events counts for the timer
+
+        timer_tick = false;
+
+        char events_buf[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+
+        ssize_t events_len;
+
+        while ((events_len = read (inotify_fd, events_buf, sizeof (events_buf))) > 0)
+        {
+          for (char *ptr = events_buf; ptr < events_buf + events_len; )
+          {
+            const struct inotify_event *event = (const struct inotify_event *) ptr;
+
+            // the file list is refreshed by mtime of the directory, which has a resolution of one second
+
+            if (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) rescan_forced = true;
+
+            event_pending = true;
+
+            ptr += sizeof (struct inotify_event) + event->len;
+          }
+        }
+      }
+    }
+    else
+    {
+      sleep (1);
+    }
+    #else
     sleep (1);
+    #endif
 
     if (status_ctx->devices_status != STATUS_RUNNING) continue;
 
-    check_left--;
+    if (timer_tick == true) check_left--;
+
+    const bool timer_due = (check_left == 0);
 
-    if (check_left != 0) continue;
+    if ((timer_due == false) && (event_pending == false)) continue;
 
-    check_left = outfile_check_timer;
+    if (timer_due == true) check_left = outfile_check_timer;
+
+    event_pending = false;
 
     if (hc_path_exist (root_directory) == false) continue;
 
@@ -103,14 +172,20 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
     {
       event_log_error (hashcat_ctx, "%s: %s", root_directory, strerror (errno));
 
+      #if defined (OUTCHECK_INOTIFY)
+      if (inotify_fd != -1) close (inotify_fd);
+      #endif
+
       hcfree (out_files);
       hcfree (out_info);
 
       return -1;
     }
 
-    if (outfile_check_stat.st_mtime > folder_mtime)
+    if ((outfile_check_stat.st_mtime > folder_mtime) || (rescan_forced == true))
     {
+      rescan_forced = false;
+
       char **out_files_new = scan_directory (root_directory);
 
       int out_cnt_new = count_dictionaries (out_files_new);
@@ -125,7 +200,7 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
         {
           out_info_new[i].file_name = out_files_new[i];
 
-          // check if there are files that we have seen/checked before (and not changed)
+          // check if there are files that we have seen/checked before (and not replaced or truncated)
 
           for (int j = 0; j < out_cnt; j++)
           {
@@ -135,10 +210,12 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
 
             if (stat (out_info_new[i].file_name, &outfile_stat) != 0) continue;
 
-            if (outfile_stat.st_ctime != out_info[j].ctime) continue;
+            if (outfile_stat.st_ino  != out_info[j].inode) continue;
+            if (outfile_stat.st_size <  out_info[j].size)  continue;
 
-            out_info_new[i].ctime = out_info[j].ctime;
+            out_info_new[i].inode = out_info[j].inode;
             out_info_new[i].seek  = out_info[j].seek;
+            out_info_new[i].size  = out_info[j].size;
           }
         }
       }
@@ -170,14 +247,27 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
         continue;
       }
 
-      if (outfile_stat.st_ctime > out_info[j].ctime)
+      // appending to a file only moves its end, everything else means we have to start over.
+      // seek can't be compared to st_size, for a compressed file it is an offset into the decompressed data
+
+      if ((outfile_stat.st_ino != out_info[j].inode) || (outfile_stat.st_size < out_info[j].size))
       {
-        out_info[j].ctime = outfile_stat.st_ctime;
+        out_info[j].inode = outfile_stat.st_ino;
         out_info[j].seek  = 0;
+        out_info[j].size  = 0;
+      }
+
+      if (outfile_stat.st_size == out_info[j].size)
+      {
+        hc_fclose (&fp);
+
+        continue;
       }
 
       hc_fseek (&fp, out_info[j].seek, SEEK_SET);
 
+      off_t seek_next = -1;
+
       char *line_buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
 
       // large portion of the following code is the same as in potfile_remove_parse
@@ -185,8 +275,20 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
 
       while (!hc_feof (&fp))
       {
+        const off_t line_off = hc_ftell (&fp);
+
         size_t line_len = fgetl (&fp, line_buf, HCBUFSIZ_LARGE);
 
+        // a line without EOL at the end of the file could still be in the middle of being written.
+        // an inotify event can arrive at exactly this point, so leave it for later unless the timer is due
+
+        if (hc_feof (&fp) && (line_len > 0) && (timer_due == false))
+        {
+          seek_next = line_off;
+
+          break;
+        }
+
         if (line_len == 0) continue;
 
         // this fake separator is used to enable loading outfiles without password
@@ -292,7 +394,8 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
 
       hcfree (line_buf);
 
-      out_info[j].seek = hc_ftell (&fp);
+      out_info[j].seek = (seek_next == -1) ? hc_ftell (&fp) : seek_next;
+      out_info[j].size = (seek_next == -1) ? outfile_stat.st_size : -1;
 
       //hc_thread_mutex_unlock (status_ctx->mux_display);
 
@@ -302,6 +405,10 @@ static int outfile_remove (hashcat_ctx_t *hashcat_ctx)
     }
   }
 
+  #if defined (OUTCHECK_INOTIFY)
+  if (inotify_fd != -1) close (inotify_fd);
+  #endif
+
   hcfree (hash_buf.esalt);
   hcfree (hash_buf.hook_salt);
 
@@ -15,6 +15,7 @@
 #include "locking.h"
 #include "shared.h"
 #include "potfile.h"
+#include "writer.h"
 
 static const char MASKED_PLAIN[] = "[notfound]";
 
@@ -101,6 +102,919 @@ void pot_tree_destroy (pot_tree_entry_t *tree)
   }
 }
 
+// splits a potfile line into hash and password, returns the length of the hash part or -1
+
+static int potfile_line_split (const hashconfig_t *hashconfig, char *line_buf, const size_t line_len, char **line_pw_buf, size_t *line_pw_len)
+{
+  char *last_separator = strrchr (line_buf, hashconfig->separator);
+
+  if (last_separator == NULL) return -1; // ??
+
+  *line_pw_buf = last_separator + 1;
+  *line_pw_len = line_buf + line_len - *line_pw_buf;
+
+  const int line_hash_len = last_separator - line_buf;
+
+  line_buf[line_hash_len] = 0;
+
+  if (line_hash_len == 0) return -1;
+
+  return line_hash_len;
+}
+
+// the hashes are grouped by module_potfile_custom_bucket () so that a potfile line only needs to be checked against
+// the hashes in its own bucket instead of all of them. within a bucket the hashes stay in hashes_buf order
+
+static int sort_pot_bucket (const void *v1, const void *v2)
+{
+  const pot_bucket_t *b1 = (const pot_bucket_t *) v1;
+  const pot_bucket_t *b2 = (const pot_bucket_t *) v2;
+
+  if (b1->bucket < b2->bucket) return -1;
+  if (b1->bucket > b2->bucket) return  1;
+
+  if (b1->pos < b2->pos) return -1;
+  if (b1->pos > b2->pos) return  1;
+
+  return 0;
+}
+
+static void potfile_bucket_init (hashcat_ctx_t *hashcat_ctx)
+{
+  const hashconfig_t  *hashconfig  = hashcat_ctx->hashconfig;
+  const hashes_t      *hashes      = hashcat_ctx->hashes;
+  const module_ctx_t  *module_ctx  = hashcat_ctx->module_ctx;
+        potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  potfile_ctx->bucket_buf = NULL;
+  potfile_ctx->bucket_cnt = 0;
+
+  if (module_ctx->module_hash_decode_potfile   == MODULE_DEFAULT) return;
+  if (module_ctx->module_potfile_custom_check  == MODULE_DEFAULT) return;
+  if (module_ctx->module_potfile_custom_bucket == MODULE_DEFAULT) return;
+
+  const u32 hashes_cnt = hashes->hashes_cnt;
+
+  pot_bucket_t *bucket_buf = (pot_bucket_t *) hccalloc (hashes_cnt, sizeof (pot_bucket_t));
+
+  for (u32 hashes_pos = 0; hashes_pos < hashes_cnt; hashes_pos++)
+  {
+    bucket_buf[hashes_pos].bucket = module_ctx->module_potfile_custom_bucket (hashconfig, &hashes->hashes_buf[hashes_pos]);
+    bucket_buf[hashes_pos].pos    = hashes_pos;
+  }
+
+  qsort (bucket_buf, hashes_cnt, sizeof (pot_bucket_t), sort_pot_bucket);
+
+  potfile_ctx->bucket_buf = bucket_buf;
+  potfile_ctx->bucket_cnt = hashes_cnt;
+}
+
+static void potfile_bucket_destroy (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  hcfree (potfile_ctx->bucket_buf);
+
+  potfile_ctx->bucket_buf = NULL;
+  potfile_ctx->bucket_cnt = 0;
+}
+
+// returns the position of the first entry of the bucket or bucket_cnt if there is none
+
+static u32 potfile_bucket_first (const potfile_ctx_t *potfile_ctx, const u64 bucket)
+{
+  u32 lo = 0;
+  u32 hi = potfile_ctx->bucket_cnt;
+
+  while (lo < hi)
+  {
+    const u32 mid = lo + ((hi - lo) / 2);
+
+    if (potfile_ctx->bucket_buf[mid].bucket < bucket)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static void potfile_remove_parse_line (hashcat_ctx_t *hashcat_ctx, char *line_buf, const size_t line_len, hash_t *hash_buf, void *tmps, pot_tree_entry_t *all_hashes_tree)
+{
+  const hashconfig_t *hashconfig = hashcat_ctx->hashconfig;
+  const hashes_t     *hashes     = hashcat_ctx->hashes;
+  const module_ctx_t *module_ctx = hashcat_ctx->module_ctx;
+
+  hash_t *hashes_buf = hashes->hashes_buf;
+  u32     hashes_cnt = hashes->hashes_cnt;
+
+  char  *line_pw_buf = NULL;
+  size_t line_pw_len = 0;
+
+  char *line_hash_buf = line_buf;
+
+  const int line_hash_len = potfile_line_split (hashconfig, line_buf, line_len, &line_pw_buf, &line_pw_len);
+
+  if (line_hash_len == -1) return;
+
+  if (hash_buf->salt)
+  {
+    memset (hash_buf->salt, 0, sizeof (salt_t));
+  }
+
+  if (hash_buf->esalt)
+  {
+    memset (hash_buf->esalt, 0, hashconfig->esalt_size);
+  }
+
+  if (hash_buf->hook_salt)
+  {
+    memset (hash_buf->hook_salt, 0, hashconfig->hook_salt_size);
+  }
+
+  if (module_ctx->module_hash_decode_potfile != MODULE_DEFAULT)
+  {
+    if (module_ctx->module_potfile_custom_check != MODULE_DEFAULT)
+    {
+      const int parser_status = module_ctx->module_hash_decode_potfile (hashconfig, hash_buf->digest, hash_buf->salt, hash_buf->esalt, hash_buf->hook_salt, hash_buf->hash_info, line_hash_buf, line_hash_len, tmps);
+
+      if (parser_status != PARSER_OK) return;
+
+      const potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+      if (potfile_ctx->bucket_buf != NULL)
+      {
+        const u64 bucket = module_ctx->module_potfile_custom_bucket (hashconfig, hash_buf);
+
+        for (u32 bucket_pos = potfile_bucket_first (potfile_ctx, bucket); bucket_pos < potfile_ctx->bucket_cnt; bucket_pos++)
+        {
+          if (potfile_ctx->bucket_buf[bucket_pos].bucket != bucket) break;
+
+          const u32 hashes_pos = potfile_ctx->bucket_buf[bucket_pos].pos;
+
+          const bool cracked = module_ctx->module_potfile_custom_check (hashconfig, &hashes_buf[hashes_pos], hash_buf, tmps);
+
+          if (cracked == true)
+          {
+            potfile_update_hash (hashcat_ctx, &hashes_buf[hashes_pos], line_pw_buf, (u32) line_pw_len);
+          }
+        }
+
+        return;
+      }
+
+      for (u32 hashes_pos = 0; hashes_pos < hashes_cnt; hashes_pos++)
+      {
+        const bool cracked = module_ctx->module_potfile_custom_check (hashconfig, &hashes_buf[hashes_pos], hash_buf, tmps);
+
+        if (cracked == true)
+        {
+          potfile_update_hash (hashcat_ctx, &hashes_buf[hashes_pos], line_pw_buf, (u32) line_pw_len);
+        }
+      }
+
+      return;
+    }
+
+    // should be rejected?
+    //const int parser_status = module_ctx->module_hash_decode_potfile (hashconfig, hash_buf->digest, hash_buf->salt, hash_buf->esalt, hash_buf->hook_salt, hash_buf->hash_info, line_hash_buf, line_hash_len, NULL);
+    //if (parser_status != PARSER_OK) return;
+  }
+  else
+  {
+    const int parser_status = module_ctx->module_hash_decode (hashconfig, hash_buf->digest, hash_buf->salt, hash_buf->esalt, hash_buf->hook_salt, hash_buf->hash_info, line_hash_buf, line_hash_len);
+
+    if (parser_status != PARSER_OK) return;
+
+    if (hashconfig->potfile_keep_all_hashes == true)
+    {
+      potfile_update_hashes (hashcat_ctx, hash_buf, line_pw_buf, (u32) line_pw_len, all_hashes_tree);
+
+      return;
+    }
+
+    hash_t *found = (hash_t *) hc_bsearch_r (hash_buf, hashes_buf, hashes_cnt, sizeof (hash_t), sort_by_hash, (void *) hashconfig);
+
+    potfile_update_hash (hashcat_ctx, found, line_pw_buf, (u32) line_pw_len);
+  }
+}
+
+/**
+ * --potfile-index
+ *
+ * <potfile>.<hash-mode>.potidx maps a 64 bit key of the decoded hash to the potfile line it was decoded from.
+ * the key covers exactly what sort_by_hash () compares, so it is equal for hashes which would match in the
+ * hc_bsearch_r () above. keys can collide, every candidate line is therefore decoded and compared for real.
+ *
+ * the file is a header, a part sorted by key which covers the potfile up to hdr.pot_size and an unsorted tail
+ * to which potfile_write_append () adds one record per cracked hash. potfile lines not yet covered by any
+ * record (written by an instance without --potfile-index or for another hash-mode) are parsed on startup and
+ * added to the tail as well. the tail gets merged into the sorted part once it grows too large.
+ */
+
+static u64 potfile_index_key (const hashconfig_t *hashconfig, const hash_t *hash)
+{
+  const u32 *digest = (const u32 *) hash->digest;
+
+  u64 key = 0xcbf29ce484222325;
+
+  #define POTIDX_MIX(v) key = (key ^ (u64) (v)) * 0x100000001b3
+
+  POTIDX_MIX (digest[hashconfig->dgst_pos0]);
+  POTIDX_MIX (digest[hashconfig->dgst_pos1]);
+  POTIDX_MIX (digest[hashconfig->dgst_pos2]);
+  POTIDX_MIX (digest[hashconfig->dgst_pos3]);
+
+  if (hashconfig->is_salted == true)
+  {
+    const salt_t *salt = hash->salt;
+
+    POTIDX_MIX (salt->orig_pos);
+    POTIDX_MIX (salt->salt_len);
+    POTIDX_MIX (salt->salt_iter);
+
+    for (int n = 0; n < 64; n++) POTIDX_MIX (salt->salt_buf[n]);
+    for (int n = 0; n < 64; n++) POTIDX_MIX (salt->salt_buf_pc[n]);
+  }
+
+  #undef POTIDX_MIX
+
+  // final avalanche, the plain FNV-1a state is weak in the high bits
+
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccd;
+  key ^= key >> 33;
+
+  if (key == POTIDX_KEY_NONE) key = 1;
+
+  return key;
+}
+
+static u64 potfile_index_hash_key (hashcat_ctx_t *hashcat_ctx, const char *line_hash_buf, const int line_hash_len, hash_t *hash_buf)
+{
+  const hashconfig_t *hashconfig = hashcat_ctx->hashconfig;
+  const module_ctx_t *module_ctx = hashcat_ctx->module_ctx;
+
+  if (hash_buf->salt)      memset (hash_buf->salt,      0, sizeof (salt_t));
+  if (hash_buf->esalt)     memset (hash_buf->esalt,     0, hashconfig->esalt_size);
+  if (hash_buf->hook_salt) memset (hash_buf->hook_salt, 0, hashconfig->hook_salt_size);
+
+  const int parser_status = module_ctx->module_hash_decode (hashconfig, hash_buf->digest, hash_buf->salt, hash_buf->esalt, hash_buf->hook_salt, hash_buf->hash_info, line_hash_buf, line_hash_len);
+
+  if (parser_status != PARSER_OK) return POTIDX_KEY_NONE;
+
+  return potfile_index_key (hashconfig, hash_buf);
+}
+
+static int sort_by_potidx_key (const void *v1, const void *v2)
+{
+  const potidx_t *p1 = (const potidx_t *) v1;
+  const potidx_t *p2 = (const potidx_t *) v2;
+
+  if (p1->key > p2->key) return  1;
+  if (p1->key < p2->key) return -1;
+  if (p1->off > p2->off) return  1;
+  if (p1->off < p2->off) return -1;
+
+  return 0;
+}
+
+static int sort_by_potidx_off (const void *v1, const void *v2)
+{
+  const potidx_t *p1 = (const potidx_t *) v1;
+  const potidx_t *p2 = (const potidx_t *) v2;
+
+  if (p1->off > p2->off) return  1;
+  if (p1->off < p2->off) return -1;
+
+  return 0;
+}
+
+static int sort_by_u64 (const void *v1, const void *v2)
+{
+  const u64 u1 = *(const u64 *) v1;
+  const u64 u2 = *(const u64 *) v2;
+
+  if (u1 > u2) return  1;
+  if (u1 < u2) return -1;
+
+  return 0;
+}
+
+// like fgetl (), but also returns the number of bytes consumed and whether the line was terminated
+
+static size_t potfile_index_getl (HCFILE *fp, char *line_buf, const size_t line_sz, u64 *line_raw, bool *line_complete)
+{
+  int c;
+
+  size_t line_len = 0;
+
+  *line_raw      = 0;
+  *line_complete = false;
+
+  while ((c = hc_fgetc (fp)) != EOF)
+  {
+    *line_raw += 1;
+
+    if (c == '\n')
+    {
+      *line_complete = true;
+
+      break;
+    }
+
+    if (line_len < line_sz) line_buf[line_len++] = (char) c;
+  }
+
+  if (line_len == line_sz) line_len--;
+
+  while (line_len > 0 && line_buf[line_len - 1] == '\r') line_len--;
+
+  line_buf[line_len] = 0;
+
+  return line_len;
+}
+
+static void potfile_index_hit (u64 **hits_buf, u64 *hits_cnt, u64 *hits_avail, const u64 off)
+{
+  if (*hits_cnt == *hits_avail)
+  {
+    *hits_buf = (u64 *) hcrealloc (*hits_buf, *hits_avail * sizeof (u64), INCR_POT * sizeof (u64));
+
+    *hits_avail += INCR_POT;
+  }
+
+  (*hits_buf)[*hits_cnt] = off;
+
+  *hits_cnt += 1;
+}
+
+static void potfile_index_push (potidx_t **buf, u64 *cnt, u64 *avail, const potidx_t *rec)
+{
+  if (*cnt == *avail)
+  {
+    *buf = (potidx_t *) hcrealloc (*buf, *avail * sizeof (potidx_t), POTIDX_CHUNK * sizeof (potidx_t));
+
+    *avail += POTIDX_CHUNK;
+  }
+
+  (*buf)[*cnt] = *rec;
+
+  *cnt += 1;
+}
+
+static void potfile_index_pot_tail (HCFILE *fp, const u64 pos, u8 *pot_tail)
+{
+  memset (pot_tail, 0, POTIDX_TAIL_LEN);
+
+  const u64 len = MIN (pos, (u64) POTIDX_TAIL_LEN);
+
+  if (len == 0) return;
+
+  if (hc_fseek (fp, (off_t) (pos - len), SEEK_SET) == -1) return;
+
+  hc_fread (pot_tail, 1, len, fp);
+}
+
+// reads the header and the tail, leaves idx_fp open for reading the sorted part
+
+static bool potfile_index_load (hashcat_ctx_t *hashcat_ctx, HCFILE *idx_fp, const u64 pot_size, potidx_hdr_t *hdr, potidx_t **tail_buf, u64 *tail_cnt)
+{
+  const hashconfig_t  *hashconfig  = hashcat_ctx->hashconfig;
+        potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  *tail_buf = NULL;
+  *tail_cnt = 0;
+
+  if (hc_fopen_raw (idx_fp, potfile_ctx->idx_filename, "rb") == false) return false;
+
+  struct stat st;
+
+  if ((hc_fstat (idx_fp, &st) == -1) || (hc_fread (hdr, sizeof (potidx_hdr_t), 1, idx_fp) != 1))
+  {
+    hc_fclose (idx_fp);
+
+    return false;
+  }
+
+  bool valid = true;
+
+  if (hdr->version   != POTIDX_VERSION)                    valid = false;
+  if (hdr->hash_mode != (u32) hashconfig->hash_mode)       valid = false;
+  if (hdr->separator != (u32) (u8) hashconfig->separator)  valid = false;
+  if (hdr->pot_size  >  pot_size)                          valid = false;
+
+  const u64 sorted_end = sizeof (potidx_hdr_t) + (hdr->sorted_cnt * sizeof (potidx_t));
+
+  if ((u64) st.st_size < sorted_end) valid = false;
+
+  if (valid == true)
+  {
+    u8 pot_tail[POTIDX_TAIL_LEN];
+
+    potfile_index_pot_tail (&potfile_ctx->fp, hdr->pot_size, pot_tail);
+
+    if (memcmp (pot_tail, hdr->pot_tail, POTIDX_TAIL_LEN) != 0) valid = false;
+  }
+
+  if (valid == true)
+  {
+    // a partial record at the end is what's left of an interrupted append, it's ignored
+
+    const u64 cnt = ((u64) st.st_size - sorted_end) / sizeof (potidx_t);
+
+    potidx_t *buf = (potidx_t *) hccalloc (cnt + 1, sizeof (potidx_t));
+
+    if ((hc_fseek (idx_fp, (off_t) sorted_end, SEEK_SET) == -1) || (hc_fread (buf, sizeof (potidx_t), cnt, idx_fp) != cnt)) valid = false;
+
+    for (u64 i = 0; i < cnt; i++)
+    {
+      if ((buf[i].off >= buf[i].end) || (buf[i].end > pot_size)) valid = false;
+    }
+
+    if (valid == true)
+    {
+      *tail_buf = buf;
+      *tail_cnt = cnt;
+    }
+    else
+    {
+      hcfree (buf);
+    }
+  }
+
+  if (valid == false) hc_fclose (idx_fp);
+
+  return valid;
+}
+
+// decodes the potfile lines in [beg, end) into new records, returns where it stopped
+
+static u64 potfile_index_parse_range (hashcat_ctx_t *hashcat_ctx, const u64 beg, const u64 end, hash_t *hash_buf, char *line_buf, potidx_t **new_buf, u64 *new_cnt, u64 *new_avail)
+{
+  const hashconfig_t  *hashconfig  = hashcat_ctx->hashconfig;
+        potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  HCFILE *fp = &potfile_ctx->fp;
+
+  if (hc_fseek (fp, (off_t) beg, SEEK_SET) == -1) return beg;
+
+  u64 off = beg;
+
+  while (off < end)
+  {
+    u64  line_raw      = 0;
+    bool line_complete = false;
+
+    const size_t line_len = potfile_index_getl (fp, line_buf, HCBUFSIZ_LARGE, &line_raw, &line_complete);
+
+    // an unterminated last line could still be in the middle of being written
+
+    if (line_complete == false) break;
+
+    potidx_t rec;
+
+    rec.key = POTIDX_KEY_NONE;
+    rec.off = off;
+    rec.end = off + line_raw;
+
+    char  *line_pw_buf = NULL;
+    size_t line_pw_len = 0;
+
+    const int line_hash_len = (line_len > 0) ? potfile_line_split (hashconfig, line_buf, line_len, &line_pw_buf, &line_pw_len) : -1;
+
+    if (line_hash_len != -1) rec.key = potfile_index_hash_key (hashcat_ctx, line_buf, line_hash_len, hash_buf);
+
+    potfile_index_push (new_buf, new_cnt, new_avail, &rec);
+
+    off = rec.end;
+  }
+
+  return off;
+}
+
+// collects the line offsets of all records with a key which is also in keys_buf, both sorted by key
+
+static void potfile_index_join (const u64 *keys_buf, const u64 keys_cnt, u64 *keys_pos, const potidx_t *recs_buf, const u64 recs_cnt, u64 **hits_buf, u64 *hits_cnt, u64 *hits_avail)
+{
+  u64 pos = *keys_pos;
+
+  for (u64 i = 0; i < recs_cnt; i++)
+  {
+    const u64 key = recs_buf[i].key;
+
+    while ((pos < keys_cnt) && (keys_buf[pos] < key)) pos++;
+
+    if (pos == keys_cnt) break;
+
+    if (keys_buf[pos] != key) continue;
+
+    potfile_index_hit (hits_buf, hits_cnt, hits_avail, recs_buf[i].off);
+  }
+
+  *keys_pos = pos;
+}
+
+static bool potfile_index_read_rec (HCFILE *idx_fp, const u64 idx, potidx_t *rec)
+{
+  if (hc_fseek (idx_fp, (off_t) (sizeof (potidx_hdr_t) + (idx * sizeof (potidx_t))), SEEK_SET) == -1) return false;
+
+  return (hc_fread (rec, sizeof (potidx_t), 1, idx_fp) == 1);
+}
+
+// merges the sorted part of the current index with mem_buf (sorted by key) into a new index file
+
+static int potfile_index_compact (hashcat_ctx_t *hashcat_ctx, HCFILE *idx_fp, const u64 sorted_cnt, const potidx_t *mem_buf, const u64 mem_cnt, const u64 pot_size)
+{
+  const hashconfig_t  *hashconfig  = hashcat_ctx->hashconfig;
+        potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  char *tmp_filename = NULL;
+
+  hc_asprintf (&tmp_filename, "%s.tmp", potfile_ctx->idx_filename);
+
+  HCFILE tmp_fp;
+
+  if (hc_fopen_raw (&tmp_fp, tmp_filename, "wb") == false)
+  {
+    event_log_warning (hashcat_ctx, "%s: %s", tmp_filename, strerror (errno));
+
+    hcfree (tmp_filename);
+
+    return -1;
+  }
+
+  potidx_hdr_t hdr;
+
+  memset (&hdr, 0, sizeof (potidx_hdr_t));
+
+  hdr.version    = POTIDX_VERSION;
+  hdr.hash_mode  = hashconfig->hash_mode;
+  hdr.separator  = (u32) (u8) hashconfig->separator;
+  hdr.sorted_cnt = sorted_cnt + mem_cnt;
+  hdr.pot_size   = pot_size;
+
+  potfile_index_pot_tail (&potfile_ctx->fp, pot_size, hdr.pot_tail);
+
+  bool ok = (hc_fwrite (&hdr, sizeof (potidx_hdr_t), 1, &tmp_fp) == 1);
+
+  potidx_t *out_buf = (potidx_t *) hccalloc (POTIDX_CHUNK, sizeof (potidx_t));
+  potidx_t *in_buf  = (potidx_t *) hccalloc (POTIDX_CHUNK, sizeof (potidx_t));
+
+  u64 out_cnt = 0;
+
+  u64 in_pos = 0;
+  u64 in_cnt = 0;
+  u64 in_done = 0;
+
+  u64 mem_pos = 0;
+
+  if (sorted_cnt > 0)
+  {
+    if (hc_fseek (idx_fp, (off_t) sizeof (potidx_hdr_t), SEEK_SET) == -1) ok = false;
+  }
+
+  while (ok == true)
+  {
+    if ((in_pos == in_cnt) && (in_done < sorted_cnt))
+    {
+      in_cnt = MIN ((u64) POTIDX_CHUNK, sorted_cnt - in_done);
+
+      if (hc_fread (in_buf, sizeof (potidx_t), in_cnt, idx_fp) != in_cnt) { ok = false; break; }
+
+      in_pos   = 0;
+      in_done += in_cnt;
+    }
+
+    const bool in_avail  = (in_pos  < in_cnt);
+    const bool mem_avail = (mem_pos < mem_cnt);
+
+    if ((in_avail == false) && (mem_avail == false)) break;
+
+    if ((in_avail == true) && ((mem_avail == false) || (sort_by_potidx_key (&in_buf[in_pos], &mem_buf[mem_pos]) <= 0)))
+    {
+      out_buf[out_cnt++] = in_buf[in_pos++];
+    }
+    else
+    {
+      out_buf[out_cnt++] = mem_buf[mem_pos++];
+    }
+
+    if (out_cnt == POTIDX_CHUNK)
+    {
+      if (hc_fwrite (out_buf, sizeof (potidx_t), out_cnt, &tmp_fp) != out_cnt) ok = false;
+
+      out_cnt = 0;
+    }
+  }
+
+  if ((ok == true) && (out_cnt > 0))
+  {
+    if (hc_fwrite (out_buf, sizeof (potidx_t), out_cnt, &tmp_fp) != out_cnt) ok = false;
+  }
+
+  hcfree (out_buf);
+  hcfree (in_buf);
+
+  hc_fclose (&tmp_fp);
+
+  if (ok == true)
+  {
+    if (rename (tmp_filename, potfile_ctx->idx_filename) != 0)
+    {
+      // rename () does not replace an existing file on windows
+
+      unlink (potfile_ctx->idx_filename);
+
+      if (rename (tmp_filename, potfile_ctx->idx_filename) != 0) ok = false;
+    }
+  }
+
+  if (ok == false)
+  {
+    event_log_warning (hashcat_ctx, "%s: Failed to update potfile index.", potfile_ctx->idx_filename);
+
+    unlink (tmp_filename);
+  }
+
+  hcfree (tmp_filename);
+
+  return (ok == true) ? 0 : -1;
+}
+
+// no event_log_* () in here, potfile_write_batch () runs on the writer thread
+
+static int potfile_index_append (HCFILE *idx_fp, const potidx_t *recs_buf, const u64 recs_cnt)
+{
+  if (hc_lockfile (idx_fp) == -1) return -1;
+
+  const size_t nwrite = hc_fwrite (recs_buf, sizeof (potidx_t), recs_cnt, idx_fp);
+
+  hc_fflush (idx_fp);
+
+  if (hc_unlockfile (idx_fp)) return -1;
+
+  return (nwrite == recs_cnt) ? 0 : -1;
+}
+
+// returns -1 without touching any hash if the index can't be used, the caller then parses the potfile as text
+
+static int potfile_index_remove_parse (hashcat_ctx_t *hashcat_ctx, hash_t *hash_buf, void *tmps, char *line_buf, pot_tree_entry_t *all_hashes_tree)
+{
+  const hashconfig_t  *hashconfig  = hashcat_ctx->hashconfig;
+  const hashes_t      *hashes      = hashcat_ctx->hashes;
+        potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  HCFILE *fp = &potfile_ctx->fp;
+
+  // line offsets are only meaningful in an uncompressed potfile
+
+  if (fp->pfp == NULL) return -1;
+
+  struct stat st;
+
+  if (hc_fstat (fp, &st) == -1) return -1;
+
+  const u64 pot_size = (u64) st.st_size;
+
+  HCFILE idx_fp;
+
+  potidx_hdr_t hdr;
+
+  potidx_t *tail_buf = NULL;
+  u64       tail_cnt = 0;
+
+  const bool loaded = potfile_index_load (hashcat_ctx, &idx_fp, pot_size, &hdr, &tail_buf, &tail_cnt);
+
+  if (loaded == false)
+  {
+    // missing or stale: index everything from scratch
+
+    memset (&hdr, 0, sizeof (potidx_hdr_t));
+  }
+
+  // find the parts of the potfile which no record covers yet and decode them
+
+  potidx_t *new_buf   = NULL;
+  u64       new_cnt   = 0;
+  u64       new_avail = 0;
+
+  qsort (tail_buf, tail_cnt, sizeof (potidx_t), sort_by_potidx_off);
+
+  // hc_fopen () skips a BOM, so does the index
+
+  u64 covered = MAX (hdr.pot_size, (u64) fp->bom_size);
+
+  for (u64 i = 0; i < tail_cnt; i++)
+  {
+    if (tail_buf[i].off > covered)
+    {
+      potfile_index_parse_range (hashcat_ctx, covered, tail_buf[i].off, hash_buf, line_buf, &new_buf, &new_cnt, &new_avail);
+    }
+
+    covered = MAX (covered, tail_buf[i].end);
+  }
+
+  covered = potfile_index_parse_range (hashcat_ctx, covered, pot_size, hash_buf, line_buf, &new_buf, &new_cnt, &new_avail);
+
+  // merge-join the keys of the hashlist against all records
+
+  hash_t *hashes_buf = hashes->hashes_buf;
+  u32     hashes_cnt = hashes->hashes_cnt;
+
+  u64 *keys_buf = (u64 *) hccalloc ((u64) hashes_cnt + 1, sizeof (u64));
+
+  for (u32 hashes_pos = 0; hashes_pos < hashes_cnt; hashes_pos++)
+  {
+    keys_buf[hashes_pos] = potfile_index_key (hashconfig, &hashes_buf[hashes_pos]);
+  }
+
+  qsort (keys_buf, hashes_cnt, sizeof (u64), sort_by_u64);
+
+  // tail and new records are merged into one key-sorted list, it's either appended or compacted later
+
+  potidx_t *mem_buf = (potidx_t *) hccalloc (tail_cnt + new_cnt + 1, sizeof (potidx_t));
+  u64       mem_cnt = 0;
+
+  for (u64 i = 0; i < tail_cnt; i++) if (tail_buf[i].key != POTIDX_KEY_NONE) mem_buf[mem_cnt++] = tail_buf[i];
+  for (u64 i = 0; i < new_cnt;  i++) if (new_buf[i].key  != POTIDX_KEY_NONE) mem_buf[mem_cnt++] = new_buf[i];
+
+  qsort (mem_buf, mem_cnt, sizeof (potidx_t), sort_by_potidx_key);
+
+  u64 *hits_buf   = NULL;
+  u64  hits_cnt   = 0;
+  u64  hits_avail = 0;
+
+  u64 keys_pos = 0;
+
+  potfile_index_join (keys_buf, hashes_cnt, &keys_pos, mem_buf, mem_cnt, &hits_buf, &hits_cnt, &hits_avail);
+
+  if (hdr.sorted_cnt > 0)
+  {
+    if (((u64) hashes_cnt * 1024) < hdr.sorted_cnt)
+    {
+      // the hashlist is tiny compared to the index, binary searching each key touches far less of it
+
+      for (u32 i = 0; i < hashes_cnt; i++)
+      {
+        if ((i > 0) && (keys_buf[i] == keys_buf[i - 1])) continue;
+
+        u64 lo = 0;
+        u64 hi = hdr.sorted_cnt;
+
+        potidx_t rec;
+
+        while (lo < hi)
+        {
+          const u64 mid = lo + ((hi - lo) / 2);
+
+          if (potfile_index_read_rec (&idx_fp, mid, &rec) == false) break;
+
+          if (rec.key < keys_buf[i]) lo = mid + 1; else hi = mid;
+        }
+
+        for (u64 j = lo; j < hdr.sorted_cnt; j++)
+        {
+          if (potfile_index_read_rec (&idx_fp, j, &rec) == false) break;
+
+          if (rec.key != keys_buf[i]) break;
+
+          potfile_index_hit (&hits_buf, &hits_cnt, &hits_avail, rec.off);
+        }
+      }
+    }
+    else
+    {
+      potidx_t *recs_buf = (potidx_t *) hccalloc (POTIDX_CHUNK, sizeof (potidx_t));
+
+      keys_pos = 0;
+
+      if (hc_fseek (&idx_fp, (off_t) sizeof (potidx_hdr_t), SEEK_SET) == 0)
+      {
+        for (u64 done = 0; done < hdr.sorted_cnt; )
+        {
+          const u64 cnt = MIN ((u64) POTIDX_CHUNK, hdr.sorted_cnt - done);
+
+          if (hc_fread (recs_buf, sizeof (potidx_t), cnt, &idx_fp) != cnt) break;
+
+          potfile_index_join (keys_buf, hashes_cnt, &keys_pos, recs_buf, cnt, &hits_buf, &hits_cnt, &hits_avail);
+
+          if (keys_pos == hashes_cnt) break;
+
+          done += cnt;
+        }
+      }
+
+      hcfree (recs_buf);
+    }
+  }
+
+  hcfree (keys_buf);
+
+  // process the candidate lines in potfile order, just like a full parse would
+
+  qsort (hits_buf, hits_cnt, sizeof (u64), sort_by_u64);
+
+  for (u64 i = 0; i < hits_cnt; i++)
+  {
+    if ((i > 0) && (hits_buf[i] == hits_buf[i - 1])) continue;
+
+    if (hc_fseek (fp, (off_t) hits_buf[i], SEEK_SET) == -1) continue;
+
+    u64  line_raw      = 0;
+    bool line_complete = false;
+
+    const size_t line_len = potfile_index_getl (fp, line_buf, HCBUFSIZ_LARGE, &line_raw, &line_complete);
+
+    if (line_len == 0) continue;
+
+    potfile_remove_parse_line (hashcat_ctx, line_buf, line_len, hash_buf, tmps, all_hashes_tree);
+  }
+
+  hcfree (hits_buf);
+
+  // bring the index up to date for the next start
+
+  if ((loaded == false) || ((tail_cnt + new_cnt) > POTIDX_TAIL_MAX (hdr.sorted_cnt)))
+  {
+    potfile_index_compact (hashcat_ctx, &idx_fp, hdr.sorted_cnt, mem_buf, mem_cnt, covered);
+  }
+  else if (new_cnt > 0)
+  {
+    HCFILE app_fp;
+
+    if (hc_fopen_raw (&app_fp, potfile_ctx->idx_filename, "ab") == true)
+    {
+      if (potfile_index_append (&app_fp, new_buf, new_cnt) == -1)
+      {
+        event_log_warning (hashcat_ctx, "%s: Failed to update potfile index.", potfile_ctx->idx_filename);
+      }
+
+      hc_fclose (&app_fp);
+    }
+  }
+
+  if (loaded == true) hc_fclose (&idx_fp);
+
+  hcfree (mem_buf);
+  hcfree (new_buf);
+  hcfree (tail_buf);
+
+  return 0;
+}
+
+static void potfile_index_free (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  hcfree (potfile_ctx->idx_filename);
+  hcfree (potfile_ctx->idx_hash.digest);
+  hcfree (potfile_ctx->idx_hash.salt);
+  hcfree (potfile_ctx->idx_hash.esalt);
+  hcfree (potfile_ctx->idx_hash.hook_salt);
+
+  potfile_ctx->idx_enabled  = false;
+  potfile_ctx->idx_filename = NULL;
+
+  memset (&potfile_ctx->idx_hash, 0, sizeof (hash_t));
+}
+
+// the index depends on the hash-mode, so this runs from the outer loop and not from potfile_init ()
+
+static void potfile_index_init (hashcat_ctx_t *hashcat_ctx)
+{
+  const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  const module_ctx_t   *module_ctx   = hashcat_ctx->module_ctx;
+  const user_options_t *user_options = hashcat_ctx->user_options;
+        potfile_ctx_t  *potfile_ctx  = hashcat_ctx->potfile_ctx;
+
+  potfile_index_free (hashcat_ctx);
+
+  if (user_options->potfile_index == false) return;
+
+  // the index relies on module_hash_decode () to map a potfile line to the hash it cracked
+
+  if (module_ctx->module_hash_decode_potfile != MODULE_DEFAULT) return;
+
+  if (hashconfig->opts_type & OPTS_TYPE_PT_NEVERCRACK) return;
+
+  potfile_ctx->idx_enabled = true;
+
+  hc_asprintf (&potfile_ctx->idx_filename, "%s.%u.potidx", potfile_ctx->filename, hashconfig->hash_mode);
+
+  hash_t *idx_hash = &potfile_ctx->idx_hash;
+
+  idx_hash->digest = hcmalloc (hashconfig->dgst_size);
+
+  if (hashconfig->is_salted == true)  idx_hash->salt      = (salt_t *) hcmalloc (sizeof (salt_t));
+  if (hashconfig->esalt_size > 0)     idx_hash->esalt     = hcmalloc (hashconfig->esalt_size);
+  if (hashconfig->hook_salt_size > 0) idx_hash->hook_salt = hcmalloc (hashconfig->hook_salt_size);
+}
+
 int potfile_init (hashcat_ctx_t *hashcat_ctx)
 {
   const folder_config_t *folder_config = hashcat_ctx->folder_config;
@@ -181,6 +1095,8 @@ void potfile_destroy (hashcat_ctx_t *hashcat_ctx)
   hcfree (potfile_ctx->out_buf);
   hcfree (potfile_ctx->filename);
 
+  potfile_index_free (hashcat_ctx);
+
   memset (potfile_ctx, 0, sizeof (potfile_ctx_t));
 }
 
@@ -231,6 +1147,38 @@ int potfile_write_open (hashcat_ctx_t *hashcat_ctx)
     return -1;
   }
 
+  potfile_index_init (hashcat_ctx);
+
+  if (potfile_ctx->idx_enabled == true)
+  {
+    // an index created here covers nothing yet, whatever is in the potfile gets indexed on the next start
+
+    if (hc_path_exist (potfile_ctx->idx_filename) == false)
+    {
+      HCFILE idx_fp;
+
+      if (hc_fopen_raw (&idx_fp, potfile_ctx->idx_filename, "wb") == true)
+      {
+        potidx_hdr_t hdr;
+
+        memset (&hdr, 0, sizeof (potidx_hdr_t));
+
+        hdr.version   = POTIDX_VERSION;
+        hdr.hash_mode = hashconfig->hash_mode;
+        hdr.separator = (u32) (u8) hashconfig->separator;
+
+        hc_fwrite (&hdr, sizeof (potidx_hdr_t), 1, &idx_fp);
+
+        hc_fclose (&idx_fp);
+      }
+    }
+
+    if (hc_fopen_raw (&potfile_ctx->idx_fp, potfile_ctx->idx_filename, "ab") == false)
+    {
+      event_log_warning (hashcat_ctx, "%s: %s", potfile_ctx->idx_filename, strerror (errno));
+    }
+  }
+
   return 0;
 }
 
@@ -244,6 +1192,8 @@ void potfile_write_close (hashcat_ctx_t *hashcat_ctx)
   if (hashconfig->potfile_disable == true) return;
 
   hc_fclose (&potfile_ctx->fp);
+
+  if (potfile_ctx->idx_fp.pfp != NULL) hc_fclose (&potfile_ctx->idx_fp);
 }
 
 void potfile_write_append (hashcat_ctx_t *hashcat_ctx, const char *out_buf, const int out_len, u8 *plain_ptr, unsigned int plain_len)
@@ -296,18 +1246,98 @@ void potfile_write_append (hashcat_ctx_t *hashcat_ctx, const char *out_buf, cons
     }
   }
 
-  tmp_buf[tmp_len] = 0;
+  // the writer thread takes the line as it is, so it gets its EOL here already
+
+  const int eol_len = (int) strlen (EOL);
+
+  memcpy (tmp_buf + tmp_len, EOL, eol_len);
+
+  tmp_len += eol_len;
+
+  writer_line_t line;
+
+  line.line_len = (u32) tmp_len;
+  line.hash_len = (u32) out_len;
+
+  const writer_ctx_t *writer_ctx = hashcat_ctx->writer_ctx;
+
+  if (writer_ctx->potfile == true)
+  {
+    writer_potfile_append (hashcat_ctx, tmp_buf, &line);
+
+    return;
+  }
+
+  if (potfile_write_batch (hashcat_ctx, tmp_buf, (size_t) tmp_len, &line, 1) == -1)
+  {
+    event_log_error (hashcat_ctx, "%s: Failed to update potfile.", potfile_ctx->filename);
+  }
+}
+
+// writes complete lines, as prepared by potfile_write_append (), with a single lock and flush
+// it runs on the writer thread, so failures are returned to the caller instead of logged
+
+int potfile_write_batch (hashcat_ctx_t *hashcat_ctx, const u8 *buf, const size_t len, const writer_line_t *lines_buf, const u32 lines_cnt)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  if (lines_cnt == 0) return 0;
+
+  int rc = 0;
 
   hc_lockfile (&potfile_ctx->fp);
 
-  hc_fprintf (&potfile_ctx->fp, "%s" EOL, tmp_buf);
+  const bool idx_append = (potfile_ctx->idx_fp.pfp != NULL);
+
+  u64 line_off = 0;
+
+  if (idx_append == true)
+  {
+    hc_fseek (&potfile_ctx->fp, 0, SEEK_END);
+
+    line_off = (u64) hc_ftell (&potfile_ctx->fp);
+  }
+
+  hc_fwrite (buf, len, 1, &potfile_ctx->fp);
 
   hc_fflush (&potfile_ctx->fp);
 
-  if (hc_unlockfile (&potfile_ctx->fp))
+  if (idx_append == true)
   {
-    event_log_error (hashcat_ctx, "%s: Failed to unlock file.", potfile_ctx->filename);
+    // out_buf is only used by --show and --left otherwise, the decoder gets a zero terminated copy of the hash
+
+    char *hash_buf = (char *) potfile_ctx->out_buf;
+
+    potidx_t *recs_buf = (potidx_t *) hccalloc (lines_cnt, sizeof (potidx_t));
+
+    const u8 *line_buf = buf;
+
+    for (u32 lines_pos = 0; lines_pos < lines_cnt; lines_pos++)
+    {
+      const writer_line_t *line = &lines_buf[lines_pos];
+
+      memcpy (hash_buf, line_buf, line->hash_len);
+
+      hash_buf[line->hash_len] = 0;
+
+      potidx_t *rec = &recs_buf[lines_pos];
+
+      rec->key = potfile_index_hash_key (hashcat_ctx, hash_buf, (int) line->hash_len, &potfile_ctx->idx_hash);
+      rec->off = line_off;
+      rec->end = line_off + line->line_len;
+
+      line_off += line->line_len;
+      line_buf += line->line_len;
+    }
+
+    if (potfile_index_append (&potfile_ctx->idx_fp, recs_buf, lines_cnt) == -1) rc = -1;
+
+    hcfree (recs_buf);
   }
+
+  if (hc_unlockfile (&potfile_ctx->fp)) rc = -1;
+
+  return rc;
 }
 
 void potfile_update_hash (hashcat_ctx_t *hashcat_ctx, hash_t *found, char *line_pw_buf, int line_pw_len)
@@ -380,7 +1410,6 @@ int potfile_remove_parse (hashcat_ctx_t *hashcat_ctx)
 {
   const hashconfig_t  *hashconfig   = hashcat_ctx->hashconfig;
   const hashes_t      *hashes       = hashcat_ctx->hashes;
-  const module_ctx_t  *module_ctx   = hashcat_ctx->module_ctx;
         potfile_ctx_t *potfile_ctx  = hashcat_ctx->potfile_ctx;
 
   if (potfile_ctx->enabled == false) return 0;
@@ -393,6 +1422,8 @@ int potfile_remove_parse (hashcat_ctx_t *hashcat_ctx)
 
   if (hc_path_exist (potfile_ctx->filename) == false) return 0;
 
+  potfile_index_init (hashcat_ctx);
+
   hash_t *hashes_buf = hashes->hashes_buf;
   u32     hashes_cnt = hashes->hashes_cnt;
 
@@ -513,87 +1544,22 @@ int potfile_remove_parse (hashcat_ctx_t *hashcat_ctx)
 
   char *line_buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
 
-  while (!hc_feof (&potfile_ctx->fp))
-  {
-    size_t line_len = fgetl (&potfile_ctx->fp, line_buf, HCBUFSIZ_LARGE);
-
-    if (line_len == 0) continue;
-
-    char *last_separator = strrchr (line_buf, hashconfig->separator);
-
-    if (last_separator == NULL) continue; // ??
-
-    char *line_pw_buf = last_separator + 1;
-
-    size_t line_pw_len = line_buf + line_len - line_pw_buf;
-
-    char *line_hash_buf = line_buf;
-
-    int line_hash_len = last_separator - line_buf;
-
-    line_hash_buf[line_hash_len] = 0;
-
-    if (line_hash_len == 0) continue;
+  potfile_bucket_init (hashcat_ctx);
 
-    if (hash_buf.salt)
-    {
-      memset (hash_buf.salt, 0, sizeof (salt_t));
-    }
-
-    if (hash_buf.esalt)
-    {
-      memset (hash_buf.esalt, 0, hashconfig->esalt_size);
-    }
-
-    if (hash_buf.hook_salt)
-    {
-      memset (hash_buf.hook_salt, 0, hashconfig->hook_salt_size);
-    }
-
-    if (module_ctx->module_hash_decode_potfile != MODULE_DEFAULT)
-    {
-      if (module_ctx->module_potfile_custom_check != MODULE_DEFAULT)
-      {
-        const int parser_status = module_ctx->module_hash_decode_potfile (hashconfig, hash_buf.digest, hash_buf.salt, hash_buf.esalt, hash_buf.hook_salt, hash_buf.hash_info, line_hash_buf, line_hash_len, tmps);
-
-        if (parser_status != PARSER_OK) continue;
-
-        for (u32 hashes_pos = 0; hashes_pos < hashes_cnt; hashes_pos++)
-        {
-          const bool cracked = module_ctx->module_potfile_custom_check (hashconfig, &hashes_buf[hashes_pos], &hash_buf, tmps);
-
-          if (cracked == true)
-          {
-            potfile_update_hash (hashcat_ctx, &hashes_buf[hashes_pos], line_pw_buf, (u32) line_pw_len);
-          }
-        }
-
-        continue;
-      }
-
-      // should be rejected?
-      //const int parser_status = module_ctx->module_hash_decode_potfile (hashconfig, hash_buf.digest, hash_buf.salt, hash_buf.esalt, hash_buf.hook_salt, hash_buf.hash_info, line_hash_buf, line_hash_len, NULL);
-      //if (parser_status != PARSER_OK) continue;
-    }
-    else
+  if ((potfile_ctx->idx_enabled == false) || (potfile_index_remove_parse (hashcat_ctx, &hash_buf, tmps, line_buf, all_hashes_tree) == -1))
+  {
+    while (!hc_feof (&potfile_ctx->fp))
     {
-      const int parser_status = module_ctx->module_hash_decode (hashconfig, hash_buf.digest, hash_buf.salt, hash_buf.esalt, hash_buf.hook_salt, hash_buf.hash_info, line_hash_buf, line_hash_len);
-
-      if (parser_status != PARSER_OK) continue;
-
-      if (hashconfig->potfile_keep_all_hashes == true)
-      {
-        potfile_update_hashes (hashcat_ctx, &hash_buf, line_pw_buf, (u32) line_pw_len, all_hashes_tree);
-
-        continue;
-      }
+      size_t line_len = fgetl (&potfile_ctx->fp, line_buf, HCBUFSIZ_LARGE);
 
-      hash_t *found = (hash_t *) hc_bsearch_r (&hash_buf, hashes_buf, hashes_cnt, sizeof (hash_t), sort_by_hash, (void *) hashconfig);
+      if (line_len == 0) continue;
 
-      potfile_update_hash (hashcat_ctx, found, line_pw_buf, (u32) line_pw_len);
+      potfile_remove_parse_line (hashcat_ctx, line_buf, line_len, &hash_buf, tmps, all_hashes_tree);
     }
   }
 
+  potfile_bucket_destroy (hashcat_ctx);
+
   hcfree (line_buf);
 
   if (hashconfig->tmp_size > 0)
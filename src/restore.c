@@ -11,6 +11,8 @@
 #include "shared.h"
 #include "pidfile.h"
 #include "folder.h"
+#include "thread.h"
+#include "writer.h"
 #include "restore.h"
 
 static int init_restore (hashcat_ctx_t *hashcat_ctx)
@@ -111,6 +113,70 @@ static int read_restore (hashcat_ctx_t *hashcat_ctx)
 
   hcfree (buf);
 
+  // completed ranges above words_cur, older versions simply redo everything above it
+
+  if (rd->version >= RESTORE_VERSION_RANGES)
+  {
+    u32 ranges_cnt = 0;
+
+    if (hc_fread (&ranges_cnt, sizeof (ranges_cnt), 1, &fp) != 1)
+    {
+      event_log_error (hashcat_ctx, "Cannot read %s", eff_restore_file);
+
+      hc_fclose (&fp);
+
+      return -1;
+    }
+
+    if (ranges_cnt > RESTORE_RANGES_MAX)
+    {
+      event_log_error (hashcat_ctx, "Unusually high number of ranges within restore file %s", eff_restore_file);
+
+      hc_fclose (&fp);
+
+      return -1;
+    }
+
+    restore_range_t *ranges_buf = (restore_range_t *) hccalloc (ranges_cnt + 1, sizeof (restore_range_t));
+
+    if ((ranges_cnt > 0) && (hc_fread (ranges_buf, sizeof (restore_range_t), ranges_cnt, &fp) != ranges_cnt))
+    {
+      event_log_error (hashcat_ctx, "Cannot read %s", eff_restore_file);
+
+      hcfree (ranges_buf);
+
+      hc_fclose (&fp);
+
+      return -1;
+    }
+
+    // they have to be what write_restore () writes: sorted, apart and above words_cur
+
+    for (u32 i = 0; i < ranges_cnt; i++)
+    {
+      const restore_range_t *range = ranges_buf + i;
+
+      bool valid = (range->off < range->fin) && (range->fin > rd->words_cur);
+
+      if ((i > 0) && (range->off <= ranges_buf[i - 1].fin)) valid = false;
+
+      if (valid == false)
+      {
+        event_log_error (hashcat_ctx, "Invalid range within restore file %s", eff_restore_file);
+
+        hcfree (ranges_buf);
+
+        hc_fclose (&fp);
+
+        return -1;
+      }
+    }
+
+    restore_ctx->ranges_buf   = ranges_buf;
+    restore_ctx->ranges_cnt   = ranges_cnt;
+    restore_ctx->ranges_alloc = ranges_cnt + 1;
+  }
+
   hc_fclose (&fp);
 
   if (hc_path_exist (rd->cwd) == false)
@@ -181,17 +247,46 @@ static int write_restore (hashcat_ctx_t *hashcat_ctx)
 {
   const mask_ctx_t     *mask_ctx     = hashcat_ctx->mask_ctx;
   const restore_ctx_t  *restore_ctx  = hashcat_ctx->restore_ctx;
-  const status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+        status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
   const straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
 
   if (restore_ctx->enabled == false) return 0;
 
   restore_data_t *rd = restore_ctx->rd;
 
+  // rd may come from an older file, but what follows is written in the current format
+
+  rd->version = RESTORE_VERSION_CUR;
+
   rd->masks_pos = mask_ctx->masks_pos;
   rd->dicts_pos = straight_ctx->dicts_pos;
+
+  // the devices keep on adding ranges, take a copy which matches words_cur
+
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
   rd->words_cur = status_ctx->words_cur;
 
+  restore_range_t *ranges_buf = (restore_range_t *) hccalloc (restore_ctx->ranges_cnt + 1, sizeof (restore_range_t));
+
+  u32 ranges_cnt = 0;
+
+  for (u32 i = 0; i < restore_ctx->ranges_cnt; i++)
+  {
+    if (restore_ctx->ranges_buf[i].fin <= rd->words_cur) continue;
+
+    ranges_buf[ranges_cnt] = restore_ctx->ranges_buf[i];
+
+    ranges_cnt++;
+  }
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+
+  // cracks from the progress above may still be queued, they have to reach the potfile and outfile
+  // before the restore file lets a restored session skip them
+
+  writer_flush (hashcat_ctx);
+
   char *new_restore_file = restore_ctx->new_restore_file;
 
   HCFILE fp;
@@ -200,6 +295,8 @@ static int write_restore (hashcat_ctx_t *hashcat_ctx)
   {
     event_log_error (hashcat_ctx, "%s: %s", new_restore_file, strerror (errno));
 
+    hcfree (ranges_buf);
+
     return -1;
   }
 
@@ -207,6 +304,8 @@ static int write_restore (hashcat_ctx_t *hashcat_ctx)
   {
     event_log_error (hashcat_ctx, "setvbuf file '%s': %s", new_restore_file, strerror (errno));
 
+    hcfree (ranges_buf);
+
     hc_fclose (&fp);
 
     return -1;
@@ -221,6 +320,12 @@ static int write_restore (hashcat_ctx_t *hashcat_ctx)
     hc_fputc ('\n', &fp);
   }
 
+  hc_fwrite (&ranges_cnt, sizeof (ranges_cnt), 1, &fp);
+
+  if (ranges_cnt > 0) hc_fwrite (ranges_buf, sizeof (restore_range_t), ranges_cnt, &fp);
+
+  hcfree (ranges_buf);
+
   hc_fflush (&fp);
 
   hc_fsync (&fp);
@@ -245,13 +350,15 @@ int cycle_restore (hashcat_ctx_t *hashcat_ctx)
   const straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
 
   // no updates, no need to write
-  if ((restore_ctx->masks_pos_prev == mask_ctx->masks_pos)
-   && (restore_ctx->dicts_pos_prev == straight_ctx->dicts_pos)
-   && (restore_ctx->words_cur_prev == status_ctx->words_cur)) return 0;
+  if ((restore_ctx->masks_pos_prev  == mask_ctx->masks_pos)
+   && (restore_ctx->dicts_pos_prev  == straight_ctx->dicts_pos)
+   && (restore_ctx->words_cur_prev  == status_ctx->words_cur)
+   && (restore_ctx->ranges_ver_prev == restore_ctx->ranges_ver)) return 0;
 
-  restore_ctx->masks_pos_prev = mask_ctx->masks_pos;
-  restore_ctx->dicts_pos_prev = straight_ctx->dicts_pos;
-  restore_ctx->words_cur_prev = status_ctx->words_cur;
+  restore_ctx->masks_pos_prev  = mask_ctx->masks_pos;
+  restore_ctx->dicts_pos_prev  = straight_ctx->dicts_pos;
+  restore_ctx->words_cur_prev  = status_ctx->words_cur;
+  restore_ctx->ranges_ver_prev = restore_ctx->ranges_ver;
 
   const char *eff_restore_file = restore_ctx->eff_restore_file;
   const char *new_restore_file = restore_ctx->new_restore_file;
@@ -376,6 +483,152 @@ void restore_ctx_destroy (hashcat_ctx_t *hashcat_ctx)
   hcfree (restore_ctx->eff_restore_file);
   hcfree (restore_ctx->new_restore_file);
   hcfree (restore_ctx->rd);
+  hcfree (restore_ctx->ranges_buf);
 
   memset (restore_ctx, 0, sizeof (restore_ctx_t));
 }
+
+/**
+ * words_cur is the lowest position all devices are done with. everything a faster device finished above it
+ * used to be redone after a restore, which for slow hashes on a large rig can be hours of work per crash.
+ * so the devices also report each completed batch as a [off, fin) range. the ranges are kept sorted and
+ * coalesced and everything below words_cur is dropped, so there are hardly more than the batches in flight.
+ * cycle_restore () writes them behind the arguments and after a restore get_work () hands out only the gaps.
+ */
+
+void restore_ranges_add (hashcat_ctx_t *hashcat_ctx, const u64 off, const u64 fin)
+{
+  restore_ctx_t *restore_ctx = hashcat_ctx->restore_ctx;
+  status_ctx_t  *status_ctx  = hashcat_ctx->status_ctx;
+
+  if (restore_ctx->enabled == false) return;
+
+  if (off >= fin) return;
+
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
+  restore_range_t *ranges_buf = restore_ctx->ranges_buf;
+
+  u32 ranges_cnt = restore_ctx->ranges_cnt;
+
+  // all ranges from pos to end touch the new one and are merged into it
+
+  u32 pos = 0;
+
+  while ((pos < ranges_cnt) && (ranges_buf[pos].fin < off)) pos++;
+
+  u32 end = pos;
+
+  u64 new_off = off;
+  u64 new_fin = fin;
+
+  while ((end < ranges_cnt) && (ranges_buf[end].off <= fin))
+  {
+    new_off = MIN (new_off, ranges_buf[end].off);
+    new_fin = MAX (new_fin, ranges_buf[end].fin);
+
+    end++;
+  }
+
+  if (end == pos)
+  {
+    if (ranges_cnt == restore_ctx->ranges_alloc)
+    {
+      restore_ctx->ranges_buf = (restore_range_t *) hcrealloc (restore_ctx->ranges_buf, restore_ctx->ranges_alloc * sizeof (restore_range_t), 64 * sizeof (restore_range_t));
+
+      restore_ctx->ranges_alloc += 64;
+
+      ranges_buf = restore_ctx->ranges_buf;
+    }
+
+    memmove (ranges_buf + pos + 1, ranges_buf + pos, (ranges_cnt - pos) * sizeof (restore_range_t));
+
+    ranges_cnt++;
+  }
+  else if (end > (pos + 1))
+  {
+    memmove (ranges_buf + pos + 1, ranges_buf + end, (ranges_cnt - end) * sizeof (restore_range_t));
+
+    ranges_cnt -= end - pos - 1;
+  }
+
+  ranges_buf[pos].off = new_off;
+  ranges_buf[pos].fin = new_fin;
+
+  // words_cur covers these already
+
+  u32 drop = 0;
+
+  while ((drop < ranges_cnt) && (ranges_buf[drop].fin <= status_ctx->words_cur)) drop++;
+
+  if (drop > 0)
+  {
+    memmove (ranges_buf, ranges_buf + drop, (ranges_cnt - drop) * sizeof (restore_range_t));
+
+    ranges_cnt -= drop;
+  }
+
+  restore_ctx->ranges_cnt = ranges_cnt;
+
+  restore_ctx->ranges_ver++;
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+}
+
+// with mux_dispatcher held: moves words_off past a completed range, words_next is where the next one starts,
+// words_skip is how many words above words_off are done already
+
+void restore_ranges_skip (hashcat_ctx_t *hashcat_ctx, const u64 words_base, u64 *words_off, u64 *words_next, u64 *words_skip)
+{
+  const restore_ctx_t *restore_ctx = hashcat_ctx->restore_ctx;
+
+  *words_next = words_base;
+  *words_skip = 0;
+
+  if (restore_ctx->enabled == false) return;
+
+  bool next_set = false;
+
+  for (u32 i = 0; i < restore_ctx->ranges_cnt; i++)
+  {
+    const restore_range_t *range = restore_ctx->ranges_buf + i;
+
+    if (range->fin <= *words_off) continue;
+
+    if (range->off >= words_base) break;
+
+    if (range->off <= *words_off)
+    {
+      *words_off = MIN (range->fin, words_base);
+
+      continue;
+    }
+
+    if (next_set == false)
+    {
+      *words_next = range->off;
+
+      next_set = true;
+    }
+
+    *words_skip += MIN (range->fin, words_base) - range->off;
+  }
+}
+
+// the ranges belong to the dictionary and mask position they were written for
+
+void restore_ranges_reset (hashcat_ctx_t *hashcat_ctx)
+{
+  restore_ctx_t *restore_ctx = hashcat_ctx->restore_ctx;
+  status_ctx_t  *status_ctx  = hashcat_ctx->status_ctx;
+
+  if (restore_ctx->enabled == false) return;
+
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
+  restore_ctx->ranges_cnt = 0;
+
+  restore_ctx->ranges_ver++;
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+}
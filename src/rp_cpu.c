@@ -10,19 +10,6 @@
 #include "rp.h"
 #include "rp_cpu.h"
 
-#define NEXT_RULEPOS(rp)      if (++(rp) == rule_len) return (RULE_RC_SYNTAX_ERROR)
-#define NEXT_RPTOI(r,rp,up)   if (((up) = conv_pos ((r)[(rp)], pos_mem)) == -1) return (RULE_RC_SYNTAX_ERROR)
-
-static int conv_pos (const u8 c, const int pos_mem)
-{
-  if (c == RULE_LAST_REJECTED_SAVED_POS)
-  {
-    return pos_mem;
-  }
-
-  return conv_ctoi (c);
-}
-
 static void MANGLE_TOGGLE_AT (char *arr, const int pos)
 {
   if (class_alpha (arr[pos])) arr[pos] ^= 0x20;
@@ -510,29 +497,102 @@ static int mangle_title_sep (char arr[RP_PASSWORD_SIZE], int arr_len, char c)
   return (arr_len);
 }
 
-int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE], int in_len, char out[RP_PASSWORD_SIZE])
+// number of arguments following a rule command, -1 for an unknown command
+
+static int rp_cpu_argc (const u8 cmd)
 {
-  char mem[RP_PASSWORD_SIZE] = { 0 };
+  switch (cmd)
+  {
+    case ' ':
+    case RULE_OP_MANGLE_NOOP:
+    case RULE_OP_MANGLE_LREST:
+    case RULE_OP_MANGLE_UREST:
+    case RULE_OP_MANGLE_LREST_UFIRST:
+    case RULE_OP_MANGLE_UREST_LFIRST:
+    case RULE_OP_MANGLE_TREST:
+    case RULE_OP_MANGLE_REVERSE:
+    case RULE_OP_MANGLE_DUPEWORD:
+    case RULE_OP_MANGLE_REFLECT:
+    case RULE_OP_MANGLE_ROTATE_LEFT:
+    case RULE_OP_MANGLE_ROTATE_RIGHT:
+    case RULE_OP_MANGLE_DELETE_FIRST:
+    case RULE_OP_MANGLE_DELETE_LAST:
+    case RULE_OP_MANGLE_TOGGLECASE_REC:
+    case RULE_OP_MANGLE_DUPECHAR_ALL:
+    case RULE_OP_MANGLE_SWITCH_FIRST:
+    case RULE_OP_MANGLE_SWITCH_LAST:
+    case RULE_OP_MANGLE_TITLE:
+    case RULE_OP_MANGLE_APPEND_MEMORY:
+    case RULE_OP_MANGLE_PREPEND_MEMORY:
+    case RULE_OP_MEMORIZE_WORD:
+    case RULE_OP_REJECT_MEMORY:
+      return 0;
+
+    case RULE_OP_MANGLE_TOGGLE_AT:
+    case RULE_OP_MANGLE_DUPEWORD_TIMES:
+    case RULE_OP_MANGLE_APPEND:
+    case RULE_OP_MANGLE_PREPEND:
+    case RULE_OP_MANGLE_DELETE_AT:
+    case RULE_OP_MANGLE_TRUNCATE_AT:
+    case RULE_OP_MANGLE_PURGECHAR:
+    case RULE_OP_MANGLE_DUPECHAR_FIRST:
+    case RULE_OP_MANGLE_DUPECHAR_LAST:
+    case RULE_OP_MANGLE_DUPEBLOCK_FIRST:
+    case RULE_OP_MANGLE_DUPEBLOCK_LAST:
+    case RULE_OP_MANGLE_CHR_SHIFTL:
+    case RULE_OP_MANGLE_CHR_SHIFTR:
+    case RULE_OP_MANGLE_CHR_INCR:
+    case RULE_OP_MANGLE_CHR_DECR:
+    case RULE_OP_MANGLE_REPLACE_NP1:
+    case RULE_OP_MANGLE_REPLACE_NM1:
+    case RULE_OP_MANGLE_TITLE_SEP:
+    case RULE_OP_REJECT_LESS:
+    case RULE_OP_REJECT_GREATER:
+    case RULE_OP_REJECT_EQUAL:
+    case RULE_OP_REJECT_CONTAIN:
+    case RULE_OP_REJECT_NOT_CONTAIN:
+    case RULE_OP_REJECT_EQUAL_FIRST:
+    case RULE_OP_REJECT_EQUAL_LAST:
+      return 1;
+
+    case RULE_OP_MANGLE_TOGGLE_AT_SEP:
+    case RULE_OP_MANGLE_EXTRACT:
+    case RULE_OP_MANGLE_OMIT:
+    case RULE_OP_MANGLE_INSERT:
+    case RULE_OP_MANGLE_OVERSTRIKE:
+    case RULE_OP_MANGLE_REPLACE:
+    case RULE_OP_MANGLE_SWITCH_AT:
+    case RULE_OP_REJECT_EQUAL_AT:
+    case RULE_OP_REJECT_CONTAINS:
+      return 2;
+
+    case RULE_OP_MANGLE_EXTRACT_MEMORY:
+      return 3;
+  }
 
-  int pos_mem = -1;
+  return -1;
+}
 
-  if (in == NULL) return (RULE_RC_REJECT_ERROR);
+/**
+ * the rule string is decoded once: hex notation is resolved and every command is stored together with its
+ * arguments and their position values. errors are not raised here but recorded in the program (an unknown
+ * command, an argument list cut short by the end of the rule, a position which isn't one) so that
+ * rp_cpu_apply () returns RULE_RC_SYNTAX_ERROR at exactly the same point the string interpreter used to,
+ * after any rejection caused by an earlier command.
+ */
 
-  if (out == NULL) return (RULE_RC_REJECT_ERROR);
+int rp_cpu_compile (const char *rule, const int rule_len, rp_cpu_rule_t *rp_cpu_rule)
+{
+  memset (rp_cpu_rule, 0, sizeof (rp_cpu_rule_t));
 
-  if (in_len < 0 || in_len > RP_PASSWORD_SIZE) return (RULE_RC_REJECT_ERROR);
+  rp_cpu_rule->rule_len = rule_len;
 
-  if (rule_len < 1) return (RULE_RC_REJECT_ERROR);
+  if (rule_len < 1) return 0;
 
-  int out_len = in_len;
-  int mem_len = in_len;
-
-  memcpy (out, in, out_len);
+  // arguments are read up to rule_len, past the decoded length that's zero bytes
 
   char *rule_new = (char *) hcmalloc (rule_len);
 
-  #define HCFREE_AND_RETURN(x) { hcfree (rule_new); return (x); }
-
   int rule_len_new = 0;
 
   int rule_pos;
@@ -557,19 +617,86 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
     }
   }
 
+  rp_cpu_rule->ops_buf = (rp_cpu_op_t *) hccalloc (rule_len_new, sizeof (rp_cpu_op_t));
+
   for (rule_pos = 0; rule_pos < rule_len_new; rule_pos++)
   {
-    int upos, upos2;
-    int ulen;
+    const u8 cmd = (u8) rule_new[rule_pos];
+
+    // nothing to do for these at all
+
+    if ((cmd == ' ') || (cmd == RULE_OP_MANGLE_NOOP) || (cmd == RULE_OP_MANGLE_TOGGLECASE_REC)) continue;
+
+    rp_cpu_op_t *op = rp_cpu_rule->ops_buf + rp_cpu_rule->ops_cnt;
+
+    rp_cpu_rule->ops_cnt++;
+
+    op->cmd = cmd;
 
-    switch (rule_new[rule_pos])
+    const int argc = rp_cpu_argc (cmd);
+
+    // nothing after an unknown command is ever reached
+
+    if (argc == -1) break;
+
+    for (int arg_idx = 0; arg_idx < argc; arg_idx++)
     {
-      case ' ':
-        break;
+      if (++rule_pos == rule_len) break;
 
-      case RULE_OP_MANGLE_NOOP:
-        break;
+      op->arg[arg_idx] = (u8) rule_new[rule_pos];
+      op->pos[arg_idx] = conv_ctoi (op->arg[arg_idx]);
+
+      op->argc++;
+    }
+
+    if (op->argc < argc) break;
+  }
+
+  hcfree (rule_new);
 
+  return 0;
+}
+
+void rp_cpu_destroy (rp_cpu_rule_t *rp_cpu_rule)
+{
+  hcfree (rp_cpu_rule->ops_buf);
+
+  memset (rp_cpu_rule, 0, sizeof (rp_cpu_rule_t));
+}
+
+#define RP_ARG_CHR(i,c)   if ((i) >= op->argc) return (RULE_RC_SYNTAX_ERROR); (c) = (char) op->arg[(i)]
+#define RP_ARG_POS(i,up)  if ((i) >= op->argc) return (RULE_RC_SYNTAX_ERROR); if (((up) = (op->arg[(i)] == RULE_LAST_REJECTED_SAVED_POS) ? pos_mem : op->pos[(i)]) == -1) return (RULE_RC_SYNTAX_ERROR)
+
+int rp_cpu_apply (const rp_cpu_rule_t *rp_cpu_rule, char in[RP_PASSWORD_SIZE], int in_len, char out[RP_PASSWORD_SIZE])
+{
+  char mem[RP_PASSWORD_SIZE] = { 0 };
+
+  int pos_mem = -1;
+
+  if (in == NULL) return (RULE_RC_REJECT_ERROR);
+
+  if (out == NULL) return (RULE_RC_REJECT_ERROR);
+
+  if (in_len < 0 || in_len > RP_PASSWORD_SIZE) return (RULE_RC_REJECT_ERROR);
+
+  if (rp_cpu_rule->rule_len < 1) return (RULE_RC_REJECT_ERROR);
+
+  int out_len = in_len;
+  int mem_len = in_len;
+
+  memcpy (out, in, out_len);
+
+  for (int op_idx = 0; op_idx < rp_cpu_rule->ops_cnt; op_idx++)
+  {
+    const rp_cpu_op_t *op = rp_cpu_rule->ops_buf + op_idx;
+
+    int upos, upos2;
+    int ulen;
+
+    char uchr, uchr2;
+
+    switch (op->cmd)
+    {
       case RULE_OP_MANGLE_LREST:
         out_len = mangle_lrest (out, out_len);
         break;
@@ -593,16 +720,14 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_MANGLE_TOGGLE_AT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         if (upos < out_len) MANGLE_TOGGLE_AT (out, upos);
         break;
 
       case RULE_OP_MANGLE_TOGGLE_AT_SEP:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_toggle_at_sep (out, out_len, rule_new[rule_pos], upos);
+        RP_ARG_POS (0, upos);
+        RP_ARG_CHR (1, uchr);
+        out_len = mangle_toggle_at_sep (out, out_len, uchr, upos);
         break;
 
       case RULE_OP_MANGLE_REVERSE:
@@ -614,8 +739,7 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_MANGLE_DUPEWORD_TIMES:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
+        RP_ARG_POS (0, ulen);
         out_len = mangle_double_times (out, out_len, ulen);
         break;
 
@@ -632,13 +756,13 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_MANGLE_APPEND:
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_append (out, out_len, rule_new[rule_pos]);
+        RP_ARG_CHR (0, uchr);
+        out_len = mangle_append (out, out_len, uchr);
         break;
 
       case RULE_OP_MANGLE_PREPEND:
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_prepend (out, out_len, rule_new[rule_pos]);
+        RP_ARG_CHR (0, uchr);
+        out_len = mangle_prepend (out, out_len, uchr);
         break;
 
       case RULE_OP_MANGLE_DELETE_FIRST:
@@ -650,71 +774,57 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_MANGLE_DELETE_AT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         out_len = mangle_delete_at (out, out_len, upos);
         break;
 
       case RULE_OP_MANGLE_EXTRACT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
+        RP_ARG_POS (0, upos);
+        RP_ARG_POS (1, ulen);
         out_len = mangle_extract (out, out_len, upos, ulen);
         break;
 
       case RULE_OP_MANGLE_OMIT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
+        RP_ARG_POS (0, upos);
+        RP_ARG_POS (1, ulen);
         out_len = mangle_omit (out, out_len, upos, ulen);
         break;
 
       case RULE_OP_MANGLE_INSERT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_insert (out, out_len, upos, rule_new[rule_pos]);
+        RP_ARG_POS (0, upos);
+        RP_ARG_CHR (1, uchr);
+        out_len = mangle_insert (out, out_len, upos, uchr);
         break;
 
       case RULE_OP_MANGLE_OVERSTRIKE:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_overstrike (out, out_len, upos, rule_new[rule_pos]);
+        RP_ARG_POS (0, upos);
+        RP_ARG_CHR (1, uchr);
+        out_len = mangle_overstrike (out, out_len, upos, uchr);
         break;
 
       case RULE_OP_MANGLE_TRUNCATE_AT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         out_len = mangle_truncate_at (out, out_len, upos);
         break;
 
       case RULE_OP_MANGLE_REPLACE:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_replace (out, out_len, rule_new[rule_pos - 1], rule_new[rule_pos]);
+        RP_ARG_CHR (0, uchr);
+        RP_ARG_CHR (1, uchr2);
+        out_len = mangle_replace (out, out_len, uchr, uchr2);
         break;
 
       case RULE_OP_MANGLE_PURGECHAR:
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_purgechar (out, out_len, rule_new[rule_pos]);
-        break;
-
-      case RULE_OP_MANGLE_TOGGLECASE_REC:
-        /* todo */
+        RP_ARG_CHR (0, uchr);
+        out_len = mangle_purgechar (out, out_len, uchr);
         break;
 
       case RULE_OP_MANGLE_DUPECHAR_FIRST:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
+        RP_ARG_POS (0, ulen);
         out_len = mangle_dupechar_at (out, out_len, 0, ulen);
         break;
 
       case RULE_OP_MANGLE_DUPECHAR_LAST:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
+        RP_ARG_POS (0, ulen);
         out_len = mangle_dupechar_at (out, out_len, out_len - 1, ulen);
         break;
 
@@ -723,14 +833,12 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_MANGLE_DUPEBLOCK_FIRST:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
+        RP_ARG_POS (0, ulen);
         out_len = mangle_dupeblock_prepend (out, out_len, ulen);
         break;
 
       case RULE_OP_MANGLE_DUPEBLOCK_LAST:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
+        RP_ARG_POS (0, ulen);
         out_len = mangle_dupeblock_append (out, out_len, ulen);
         break;
 
@@ -743,52 +851,44 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_MANGLE_SWITCH_AT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos2);
+        RP_ARG_POS (0, upos);
+        RP_ARG_POS (1, upos2);
         out_len = mangle_switch_at_check (out, out_len, upos, upos2);
         break;
 
       case RULE_OP_MANGLE_CHR_SHIFTL:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         mangle_chr_shiftl (out, out_len, upos);
         break;
 
       case RULE_OP_MANGLE_CHR_SHIFTR:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         mangle_chr_shiftr (out, out_len, upos);
         break;
 
       case RULE_OP_MANGLE_CHR_INCR:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         mangle_chr_incr (out, out_len, upos);
         break;
 
       case RULE_OP_MANGLE_CHR_DECR:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         mangle_chr_decr (out, out_len, upos);
         break;
 
       case RULE_OP_MANGLE_REPLACE_NP1:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         if ((upos >= 0) && ((upos + 1) < out_len)) mangle_overstrike (out, out_len, upos, out[upos + 1]);
         break;
 
       case RULE_OP_MANGLE_REPLACE_NM1:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
+        RP_ARG_POS (0, upos);
         if ((upos >= 1) && ((upos + 0) < out_len)) mangle_overstrike (out, out_len, upos, out[upos - 1]);
         break;
 
       case RULE_OP_MANGLE_TITLE_SEP:
-        NEXT_RULEPOS (rule_pos);
-        out_len = mangle_title_sep (out, out_len, rule_new[rule_pos]);
+        RP_ARG_CHR (0, uchr);
+        out_len = mangle_title_sep (out, out_len, uchr);
         break;
 
       case RULE_OP_MANGLE_TITLE:
@@ -796,26 +896,23 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_MANGLE_EXTRACT_MEMORY:
-        if (mem_len < 1) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, ulen);
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos2);
-        if ((out_len = mangle_insert_multi (out, out_len, upos2, mem, mem_len, upos, ulen)) < 1) HCFREE_AND_RETURN (out_len);
+        if (mem_len < 1) return (RULE_RC_REJECT_ERROR);
+        RP_ARG_POS (0, upos);
+        RP_ARG_POS (1, ulen);
+        RP_ARG_POS (2, upos2);
+        if ((out_len = mangle_insert_multi (out, out_len, upos2, mem, mem_len, upos, ulen)) < 1) return (out_len);
         break;
 
       case RULE_OP_MANGLE_APPEND_MEMORY:
-        if (mem_len < 1) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
-        if ((out_len + mem_len) >= RP_PASSWORD_SIZE) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        if (mem_len < 1) return (RULE_RC_REJECT_ERROR);
+        if ((out_len + mem_len) >= RP_PASSWORD_SIZE) return (RULE_RC_REJECT_ERROR);
         memcpy (out + out_len, mem, mem_len);
         out_len += mem_len;
         break;
 
       case RULE_OP_MANGLE_PREPEND_MEMORY:
-        if (mem_len < 1) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
-        if ((mem_len + out_len) >= RP_PASSWORD_SIZE) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        if (mem_len < 1) return (RULE_RC_REJECT_ERROR);
+        if ((mem_len + out_len) >= RP_PASSWORD_SIZE) return (RULE_RC_REJECT_ERROR);
         memcpy (mem + mem_len, out, out_len);
         out_len += mem_len;
         memcpy (out, mem, out_len);
@@ -827,93 +924,104 @@ int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE],
         break;
 
       case RULE_OP_REJECT_LESS:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        if (out_len > upos) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        RP_ARG_POS (0, upos);
+        if (out_len > upos) return (RULE_RC_REJECT_ERROR);
         break;
 
       case RULE_OP_REJECT_GREATER:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        if (out_len < upos) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        RP_ARG_POS (0, upos);
+        if (out_len < upos) return (RULE_RC_REJECT_ERROR);
         break;
 
       case RULE_OP_REJECT_EQUAL:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        if (out_len != upos) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        RP_ARG_POS (0, upos);
+        if (out_len != upos) return (RULE_RC_REJECT_ERROR);
         break;
 
       case RULE_OP_REJECT_CONTAIN:
-        NEXT_RULEPOS (rule_pos);
-        if (strchr (out, rule_new[rule_pos]) != NULL) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        RP_ARG_CHR (0, uchr);
+        if (strchr (out, uchr) != NULL) return (RULE_RC_REJECT_ERROR);
         break;
 
       case RULE_OP_REJECT_NOT_CONTAIN:
-        NEXT_RULEPOS (rule_pos);
+        RP_ARG_CHR (0, uchr);
         {
-          const char *match = strchr (out, rule_new[rule_pos]);
+          const char *match = strchr (out, uchr);
           if (match != NULL)
           {
             pos_mem = (int)(match - out);
           }
           else
           {
-            HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+            return (RULE_RC_REJECT_ERROR);
           }
         }
         break;
 
       case RULE_OP_REJECT_EQUAL_FIRST:
-        NEXT_RULEPOS (rule_pos);
-        if (out[0] != rule_new[rule_pos]) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        RP_ARG_CHR (0, uchr);
+        if (out[0] != uchr) return (RULE_RC_REJECT_ERROR);
         break;
 
       case RULE_OP_REJECT_EQUAL_LAST:
-        NEXT_RULEPOS (rule_pos);
-        if (out[out_len - 1] != rule_new[rule_pos]) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        RP_ARG_CHR (0, uchr);
+        if (out[out_len - 1] != uchr) return (RULE_RC_REJECT_ERROR);
         break;
 
       case RULE_OP_REJECT_EQUAL_AT:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        if ((upos + 1) > out_len) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
-        NEXT_RULEPOS (rule_pos);
-        if (out[upos] != rule_new[rule_pos]) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        RP_ARG_POS (0, upos);
+        if ((upos + 1) > out_len) return (RULE_RC_REJECT_ERROR);
+        RP_ARG_CHR (1, uchr);
+        if (out[upos] != uchr) return (RULE_RC_REJECT_ERROR);
         break;
 
       case RULE_OP_REJECT_CONTAINS:
-        NEXT_RULEPOS (rule_pos);
-        NEXT_RPTOI (rule_new, rule_pos, upos);
-        if ((upos + 1) > out_len) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
-        NEXT_RULEPOS (rule_pos);
-        int c; int cnt;
-        for (c = 0, cnt = 0; c < out_len && cnt < upos; c++)
+        RP_ARG_POS (0, upos);
+        if ((upos + 1) > out_len) return (RULE_RC_REJECT_ERROR);
+        RP_ARG_CHR (1, uchr);
         {
-          if (out[c] == rule_new[rule_pos])
+          int c; int cnt;
+          for (c = 0, cnt = 0; c < out_len && cnt < upos; c++)
           {
-            cnt++;
-            pos_mem = c;
+            if (out[c] == uchr)
+            {
+              cnt++;
+              pos_mem = c;
+            }
           }
-        }
 
-        if (cnt < upos) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+          if (cnt < upos) return (RULE_RC_REJECT_ERROR);
+        }
         break;
 
       case RULE_OP_REJECT_MEMORY:
-        if ((out_len == mem_len) && (memcmp (out, mem, out_len) == 0)) HCFREE_AND_RETURN (RULE_RC_REJECT_ERROR);
+        if ((out_len == mem_len) && (memcmp (out, mem, out_len) == 0)) return (RULE_RC_REJECT_ERROR);
         break;
 
       default:
-        HCFREE_AND_RETURN (RULE_RC_SYNTAX_ERROR);
+        return (RULE_RC_SYNTAX_ERROR);
     }
   }
 
   memset (out + out_len, 0, RP_PASSWORD_SIZE - out_len);
 
-  HCFREE_AND_RETURN (out_len);
+  return (out_len);
+}
+
+#undef RP_ARG_CHR
+#undef RP_ARG_POS
+
+int _old_apply_rule (const char *rule, int rule_len, char in[RP_PASSWORD_SIZE], int in_len, char out[RP_PASSWORD_SIZE])
+{
+  rp_cpu_rule_t rp_cpu_rule;
+
+  rp_cpu_compile (rule, rule_len, &rp_cpu_rule);
+
+  const int rc = rp_cpu_apply (&rp_cpu_rule, in, in_len, out);
+
+  rp_cpu_destroy (&rp_cpu_rule);
 
-  #undef HCFREE_AND_RETURN
+  return rc;
 }
 
 int run_rule_engine (const int rule_len, const char *rule_buf)
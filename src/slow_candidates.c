@@ -28,7 +28,21 @@ void slow_candidates_seek (hashcat_ctx_t *hashcat_ctx, void *extra_info, const u
   {
     extra_info_straight_t *extra_info_straight = (extra_info_straight_t *) extra_info;
 
-    for (u64 i = cur; i < end; i++)
+    // jump close to the last base word we need using the word-offset index, if there is one
+
+    const u64 words_have = CEILDIV (cur, straight_ctx->kernel_rules_cnt);
+    const u64 words_need = CEILDIV (end, straight_ctx->kernel_rules_cnt);
+
+    u64 i = cur;
+
+    if (words_need > (words_have + 1))
+    {
+      const u64 words_jump = wl_data_seek (hashcat_ctx, &extra_info_straight->fp, words_have, words_need - 1);
+
+      if (words_jump > words_have) i = words_jump * straight_ctx->kernel_rules_cnt;
+    }
+
+    for ( ; i < end; i++)
     {
       if ((i % straight_ctx->kernel_rules_cnt) == 0)
       {
@@ -51,7 +65,7 @@ void slow_candidates_seek (hashcat_ctx_t *hashcat_ctx, void *extra_info, const u
 
             memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-            const int rule_len_out = _old_apply_rule (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, line_buf, (int) line_len, rule_buf_out);
+            const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_l, line_buf, (int) line_len, rule_buf_out);
 
             if (rule_len_out < 0) continue;
 
@@ -79,7 +93,21 @@ void slow_candidates_seek (hashcat_ctx_t *hashcat_ctx, void *extra_info, const u
     HCFILE *base_fp = &extra_info_combi->base_fp;
     HCFILE *combs_fp = &extra_info_combi->combs_fp;
 
-    for (u64 i = cur; i < end; i++)
+    // jump close to the last base word we need using the word-offset index, if there is one
+
+    const u64 words_have = CEILDIV (cur, combinator_ctx->combs_cnt);
+    const u64 words_need = CEILDIV (end, combinator_ctx->combs_cnt);
+
+    u64 i = cur;
+
+    if (words_need > (words_have + 1))
+    {
+      const u64 words_jump = wl_data_seek (hashcat_ctx, base_fp, words_have, words_need - 1);
+
+      if (words_jump > words_have) i = words_jump * combinator_ctx->combs_cnt;
+    }
+
+    for ( ; i < end; i++)
     {
       if ((i % combinator_ctx->combs_cnt) == 0)
       {
@@ -100,7 +128,7 @@ void slow_candidates_seek (hashcat_ctx_t *hashcat_ctx, void *extra_info, const u
 
             memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-            const int rule_len_out = _old_apply_rule (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, line_buf, (int) line_len, rule_buf_out);
+            const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_l, line_buf, (int) line_len, rule_buf_out);
 
             if (rule_len_out < 0) continue;
 
@@ -137,7 +165,7 @@ void slow_candidates_seek (hashcat_ctx_t *hashcat_ctx, void *extra_info, const u
 
           memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-          const int rule_len_out = _old_apply_rule (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, line_buf, (int) line_len, rule_buf_out);
+          const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_l, line_buf, (int) line_len, rule_buf_out);
 
           if (rule_len_out < 0) continue;
         }
@@ -192,7 +220,7 @@ void slow_candidates_next (hashcat_ctx_t *hashcat_ctx, void *extra_info)
 
           memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-          const int rule_len_out = _old_apply_rule (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, line_buf, (int) line_len, rule_buf_out);
+          const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_l, line_buf, (int) line_len, rule_buf_out);
 
           if (rule_len_out < 0) continue;
 
@@ -264,7 +292,7 @@ void slow_candidates_next (hashcat_ctx_t *hashcat_ctx, void *extra_info)
 
           memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-          const int rule_len_out = _old_apply_rule (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, line_buf, (int) line_len, rule_buf_out);
+          const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_l, line_buf, (int) line_len, rule_buf_out);
 
           if (rule_len_out < 0) continue;
 
@@ -305,7 +333,7 @@ void slow_candidates_next (hashcat_ctx_t *hashcat_ctx, void *extra_info)
 
         memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-        const int rule_len_out = _old_apply_rule (user_options->rule_buf_r, (int) user_options_extra->rule_len_r, line_buf, (int) line_len, rule_buf_out);
+        const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_r, line_buf, (int) line_len, rule_buf_out);
 
         if (rule_len_out < 0) continue;
       }
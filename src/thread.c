@@ -114,6 +114,32 @@ void hc_signal (void (callback) (int))
 #endif
 */
 
+void hc_thread_cond_timedwait (hc_thread_cond_t *cond, hc_thread_mutex_t *mux, const u32 msec)
+{
+  #if defined (_WIN)
+
+  SleepConditionVariableCS (cond, mux, msec);
+
+  #else
+
+  struct timespec ts;
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+
+  ts.tv_sec  += msec / 1000;
+  ts.tv_nsec += (long) (msec % 1000) * 1000000;
+
+  if (ts.tv_nsec >= 1000000000)
+  {
+    ts.tv_sec  += 1;
+    ts.tv_nsec -= 1000000000;
+  }
+
+  pthread_cond_timedwait (cond, mux, &ts);
+
+  #endif
+}
+
 int mycracked (hashcat_ctx_t *hashcat_ctx)
 {
   status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
@@ -71,6 +71,9 @@ static const char *const USAGE_BIG_PRE_HASHMODES[] =
   "     --remove-timer             | Num  | Update input hash file each X seconds                | --remove-timer=30",
   "     --potfile-disable          |      | Do not write potfile                                 |",
   "     --potfile-path             | File | Specific path to potfile                             | --potfile-path=my.pot",
+  "     --potfile-index            |      | Keep a sidecar index to skip parsing the potfile     |",
+  "     --cracked-flush-timer      | Num  | Flush cracks to potfile/outfile every X ms, 0 = sync | --cracked-flush-timer=1000",
+  "     --cracked-flush-lines      | Num  | Flush cracks to potfile/outfile every X lines        | --cracked-flush-lines=100",
   "     --encoding-from            | Code | Force internal wordlist encoding from X              | --encoding-from=iso-8859-15",
   "     --encoding-to              | Code | Force internal wordlist encoding to X                | --encoding-to=utf-32le",
   "     --debug-mode               | Num  | Defines the debug mode (hybrid only by using rules)  | --debug-mode=4",
@@ -187,6 +190,7 @@ static const char *const USAGE_BIG_POST_HASHMODES[] =
   "  1 | Send hashed passwords",
   "  2 | Send attack positions",
   "  3 | Send hashed passwords and attack positions",
+  "  4 | Filter passwords already sent locally (add to 1 or 3, may rarely skip a new one)",
   "",
   #endif
   "- [ Outfile Formats ] -",
@@ -15,6 +15,8 @@
 #include "backend.h"
 #include "user_options.h"
 #include "outfile.h"
+#include "rp.h"
+#include "rp_cpu.h"
 
 #ifdef WITH_BRAIN
 #include "brain.h"
@@ -55,6 +57,8 @@ static const struct option long_options[] =
   {"bridge-parameter3",         required_argument, NULL, IDX_BRIDGE_PARAMETER3},
   {"bridge-parameter4",         required_argument, NULL, IDX_BRIDGE_PARAMETER4},
   {"cpu-affinity",              required_argument, NULL, IDX_CPU_AFFINITY},
+  {"cracked-flush-lines",       required_argument, NULL, IDX_CRACKED_FLUSH_LINES},
+  {"cracked-flush-timer",       required_argument, NULL, IDX_CRACKED_FLUSH_TIMER},
   {"custom-charset1",           required_argument, NULL, IDX_CUSTOM_CHARSET_1},
   {"custom-charset2",           required_argument, NULL, IDX_CUSTOM_CHARSET_2},
   {"custom-charset3",           required_argument, NULL, IDX_CUSTOM_CHARSET_3},
@@ -115,6 +119,7 @@ static const struct option long_options[] =
   {"outfile-json",              no_argument,       NULL, IDX_OUTFILE_JSON},
   {"outfile",                   required_argument, NULL, IDX_OUTFILE},
   {"potfile-disable",           no_argument,       NULL, IDX_POTFILE_DISABLE},
+  {"potfile-index",             no_argument,       NULL, IDX_POTFILE_INDEX},
   {"potfile-path",              required_argument, NULL, IDX_POTFILE_PATH},
   {"progress-only",             no_argument,       NULL, IDX_PROGRESS_ONLY},
   {"quiet",                     no_argument,       NULL, IDX_QUIET},
@@ -215,6 +220,8 @@ int user_options_init (hashcat_ctx_t *hashcat_ctx)
   user_options->bridge_parameter3         = NULL;
   user_options->bridge_parameter4         = NULL;
   user_options->cpu_affinity              = NULL;
+  user_options->cracked_flush_lines       = CRACKED_FLUSH_LINES;
+  user_options->cracked_flush_timer       = CRACKED_FLUSH_TIMER;
   user_options->custom_charset_1          = NULL;
   user_options->custom_charset_2          = NULL;
   user_options->custom_charset_3          = NULL;
@@ -268,6 +275,7 @@ int user_options_init (hashcat_ctx_t *hashcat_ctx)
   user_options->outfile_json              = OUTFILE_JSON;
   user_options->outfile                   = NULL;
   user_options->potfile                   = POTFILE;
+  user_options->potfile_index             = POTFILE_INDEX;
   user_options->potfile_path              = NULL;
   user_options->progress_only             = PROGRESS_ONLY;
   user_options->quiet                     = QUIET;
@@ -350,6 +358,8 @@ int user_options_getopt (hashcat_ctx_t *hashcat_ctx, int argc, char **argv)
       case IDX_SKIP:
       case IDX_LIMIT:
       case IDX_STATUS_TIMER:
+      case IDX_CRACKED_FLUSH_LINES:
+      case IDX_CRACKED_FLUSH_TIMER:
       case IDX_HASH_MODE:
       case IDX_RUNTIME:
       case IDX_METAL_COMPILER_RUNTIME:
@@ -428,6 +438,7 @@ int user_options_getopt (hashcat_ctx_t *hashcat_ctx, int argc, char **argv)
       case IDX_REMOVE_TIMER:              user_options->remove_timer              = hc_strtoul (optarg, NULL, 10);
                                           user_options->remove_timer_chgd         = true;                            break;
       case IDX_POTFILE_DISABLE:           user_options->potfile                   = false;                           break;
+      case IDX_POTFILE_INDEX:             user_options->potfile_index             = true;                            break;
       case IDX_POTFILE_PATH:              user_options->potfile_path              = optarg;                          break;
       case IDX_DEBUG_MODE:                user_options->debug_mode                = hc_strtoul (optarg, NULL, 10);   break;
       case IDX_DEBUG_FILE:                user_options->debug_file                = optarg;                          break;
@@ -502,6 +513,8 @@ int user_options_getopt (hashcat_ctx_t *hashcat_ctx, int argc, char **argv)
       case IDX_BRIDGE_PARAMETER3:         user_options->bridge_parameter3         = optarg;                          break;
       case IDX_BRIDGE_PARAMETER4:         user_options->bridge_parameter4         = optarg;                          break;
       case IDX_CPU_AFFINITY:              user_options->cpu_affinity              = optarg;                          break;
+      case IDX_CRACKED_FLUSH_LINES:       user_options->cracked_flush_lines       = hc_strtoul (optarg, NULL, 10);   break;
+      case IDX_CRACKED_FLUSH_TIMER:       user_options->cracked_flush_timer       = hc_strtoul (optarg, NULL, 10);   break;
       case IDX_BACKEND_IGNORE_CUDA:       user_options->backend_ignore_cuda       = true;                            break;
       case IDX_BACKEND_IGNORE_HIP:        user_options->backend_ignore_hip        = true;                            break;
       #if defined (__APPLE__)
@@ -620,13 +633,20 @@ int user_options_sanity (hashcat_ctx_t *hashcat_ctx)
     return -1;
   }
 
-  if ((user_options->brain_client_features < 1) || (user_options->brain_client_features > 3))
+  if ((user_options->brain_client_features < 1) || (user_options->brain_client_features > 7))
   {
     event_log_error (hashcat_ctx, "Invalid --brain-client-feature argument.");
 
     return -1;
   }
 
+  if ((user_options->brain_client_features & BRAIN_CLIENT_FEATURE_FILTER) && ((user_options->brain_client_features & BRAIN_CLIENT_FEATURE_HASHES) == 0))
+  {
+    event_log_error (hashcat_ctx, "Brain client feature 4 requires feature 1 (hashed passwords).");
+
+    return -1;
+  }
+
   if (user_options->brain_port > 65535)
   {
     event_log_error (hashcat_ctx, "Invalid brain port specified (greater than 65535).");
@@ -2371,6 +2391,9 @@ void user_options_extra_init (hashcat_ctx_t *hashcat_ctx)
   user_options_extra->rule_len_l = (int) strlen (user_options->rule_buf_l);
   user_options_extra->rule_len_r = (int) strlen (user_options->rule_buf_r);
 
+  rp_cpu_compile (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, &user_options_extra->rule_cpu_l);
+  rp_cpu_compile (user_options->rule_buf_r, (int) user_options_extra->rule_len_r, &user_options_extra->rule_cpu_r);
+
   // hc_hash and hc_work*
 
   user_options_extra->hc_hash  = NULL;
@@ -2428,6 +2451,9 @@ void user_options_extra_destroy (hashcat_ctx_t *hashcat_ctx)
 {
   user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
 
+  rp_cpu_destroy (&user_options_extra->rule_cpu_l);
+  rp_cpu_destroy (&user_options_extra->rule_cpu_r);
+
   memset (user_options_extra, 0, sizeof (user_options_extra_t));
 }
 
@@ -3341,6 +3367,8 @@ void user_options_logger (hashcat_ctx_t *hashcat_ctx)
   logfile_top_uint   (user_options->benchmark_min);
   logfile_top_uint   (user_options->bitmap_max);
   logfile_top_uint   (user_options->bitmap_min);
+  logfile_top_uint   (user_options->cracked_flush_lines);
+  logfile_top_uint   (user_options->cracked_flush_timer);
   logfile_top_uint   (user_options->debug_mode);
   logfile_top_uint   (user_options->dynamic_x);
   logfile_top_uint   (user_options->hash_info);
@@ -3380,6 +3408,7 @@ void user_options_logger (hashcat_ctx_t *hashcat_ctx)
   logfile_top_uint   (user_options->outfile_json);
   logfile_top_uint   (user_options->wordlist_autohex);
   logfile_top_uint   (user_options->potfile);
+  logfile_top_uint   (user_options->potfile_index);
   logfile_top_uint   (user_options->progress_only);
   logfile_top_uint   (user_options->quiet);
   logfile_top_uint   (user_options->remove);
@@ -12,10 +12,21 @@
 #include "rp.h"
 #include "rp_cpu.h"
 #include "shared.h"
+#include "thread.h"
+#include "filehandling.h"
 #include "wordlist.h"
 #include "bitops.h"
+#include "cpu_features.h"
 #include "emu_inc_hash_sha1.h"
 
+#if defined (__x86_64__) || defined (_M_X64)
+#include <immintrin.h>
+#define WL_SIMD_X86
+#elif defined (__aarch64__) || defined (__arm64__)
+#include "sse2neon.h"
+#define WL_SIMD_NEON
+#endif
+
 size_t convert_from_hex (hashcat_ctx_t *hashcat_ctx, char *line_buf, const size_t line_len)
 {
   const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
@@ -50,12 +61,189 @@ size_t convert_from_hex (hashcat_ctx_t *hashcat_ctx, char *line_buf, const size_
   return (line_len);
 }
 
+#if defined (_POSIX)
+static void wl_data_unmap (wl_data_t *wl_data)
+{
+  if (wl_data->mmap_buf == NULL) return;
+
+  munmap (wl_data->mmap_buf, wl_data->mmap_len);
+
+  wl_data->mmap_buf      = NULL;
+  wl_data->mmap_len      = 0;
+  wl_data->mmap_dev      = 0;
+  wl_data->mmap_ino      = 0;
+  wl_data->mmap_mtime    = 0;
+  wl_data->mmap_released = 0;
+}
+
+static bool load_segment_mmap (hashcat_ctx_t *hashcat_ctx, HCFILE *fp)
+{
+  wl_data_t *wl_data = hashcat_ctx->wl_data;
+
+  if (wl_data->mmap_enabled == false) return false;
+
+  // compressed files have to go through the decoder
+
+  if (fp->pfp == NULL) return false;
+
+  struct stat st;
+
+  if (fstat (fp->fd, &st) == -1) return false;
+
+  if (S_ISREG (st.st_mode) == 0) return false;
+
+  if (st.st_size == 0) return false;
+
+  /**
+   * wordlists must not change while hashcat runs. touching a mapped page beyond the end of a truncated file raises
+   * SIGBUS, where the read path simply saw EOF, and anything appended is not part of the mapping. so every segment
+   * checks the file again and once it has changed, the read path takes over from the current position, which then
+   * sees the new size. a file truncated while its current segment is being tokenized still can't be caught.
+   */
+
+  const bool same_file = (wl_data->mmap_buf != NULL) && (wl_data->mmap_dev == (u64) st.st_dev) && (wl_data->mmap_ino == (u64) st.st_ino);
+
+  if ((same_file == true) && ((wl_data->mmap_len != (u64) st.st_size) || (wl_data->mmap_mtime != (u64) st.st_mtime)))
+  {
+    wl_data_unmap (wl_data);
+
+    wl_data->mmap_enabled = false;
+
+    return false;
+  }
+
+  // the same wl_data can be used for different files, for instance by count_words ()
+
+  if (same_file == false)
+  {
+    wl_data_unmap (wl_data);
+
+    // private mapping, because the tokenizers and the hex decoder work in-place
+
+    char *mmap_buf = (char *) mmap (NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fp->fd, 0);
+
+    if (mmap_buf == MAP_FAILED)
+    {
+      wl_data->mmap_enabled = false;
+
+      return false;
+    }
+
+    madvise (mmap_buf, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+    wl_data->mmap_buf = mmap_buf;
+    wl_data->mmap_len = (u64) st.st_size;
+    wl_data->mmap_dev = (u64) st.st_dev;
+    wl_data->mmap_ino = (u64) st.st_ino;
+
+    wl_data->mmap_mtime = (u64) st.st_mtime;
+  }
+
+  char *mmap_buf = wl_data->mmap_buf;
+
+  const u64 mmap_len = wl_data->mmap_len;
+
+  // the stream position is the source of truth, this takes care of the BOM and of any seek done by the caller
+
+  const off_t ftell_pos = hc_ftell (fp);
+
+  const u64 seg_beg = (ftell_pos < 0) ? mmap_len : MIN ((u64) ftell_pos, mmap_len);
+
+  u64 seg_end = seg_beg + (wl_data->incr - 1000);
+
+  if (seg_end >= mmap_len)
+  {
+    seg_end = mmap_len;
+  }
+  else
+  {
+    // finish the last line of the segment with memchr instead of a hc_fgetc () loop
+
+    const char *nl = (const char *) memchr (mmap_buf + seg_end - 1, '\n', mmap_len - (seg_end - 1));
+
+    seg_end = (nl == NULL) ? mmap_len : (u64) (nl - mmap_buf) + 1;
+  }
+
+  const u64 seg_len = seg_end - seg_beg;
+
+  // pages which have been fully consumed are no longer needed, this also drops private copies made by in-place writes
+
+  const u64 page_size = (u64) sysconf (_SC_PAGESIZE);
+
+  const u64 release_end = seg_beg & ~(page_size - 1);
+
+  if (release_end > wl_data->mmap_released)
+  {
+    madvise (mmap_buf + wl_data->mmap_released, release_end - wl_data->mmap_released, MADV_DONTNEED);
+
+    wl_data->mmap_released = release_end;
+  }
+  else if (release_end < wl_data->mmap_released)
+  {
+    // caller did seek backwards
+
+    wl_data->mmap_released = release_end;
+  }
+
+  if (seg_end < mmap_len)
+  {
+    const u64 ahead_beg = seg_end & ~(page_size - 1);
+    const u64 ahead_len = MIN (wl_data->incr, mmap_len - ahead_beg);
+
+    madvise (mmap_buf + ahead_beg, ahead_len, MADV_WILLNEED);
+  }
+
+  wl_data->pos = 0;
+
+  if ((seg_len > 0) && (seg_end == mmap_len) && (mmap_buf[mmap_len - 1] != '\n'))
+  {
+    // the last line of the file has no newline, the tokenizers require one so this tail goes through the heap buffer
+
+    if ((seg_len + 1) >= wl_data->avail)
+    {
+      const u64 avail_new = seg_len + 2;
+
+      wl_data->buf_heap = (char *) hcrealloc (wl_data->buf_heap, wl_data->avail, avail_new - wl_data->avail);
+
+      wl_data->avail = avail_new;
+    }
+
+    memcpy (wl_data->buf_heap, mmap_buf + seg_beg, seg_len);
+
+    wl_data->buf_heap[seg_len + 0] = '\n';
+    wl_data->buf_heap[seg_len + 1] = 0;
+
+    wl_data->buf = wl_data->buf_heap;
+    wl_data->cnt = seg_len + 1;
+  }
+  else
+  {
+    wl_data->buf = mmap_buf + seg_beg;
+    wl_data->cnt = seg_len;
+  }
+
+  // keep the stream in sync so that hc_feof () and hc_ftell () behave like on the read path
+
+  hc_fseek (fp, (off_t) seg_end, SEEK_SET);
+
+  if (seg_end == mmap_len) hc_fgetc (fp);
+
+  return true;
+}
+#endif
+
 int load_segment (hashcat_ctx_t *hashcat_ctx, HCFILE *fp)
 {
   wl_data_t *wl_data = hashcat_ctx->wl_data;
 
+  #if defined (_POSIX)
+  if (load_segment_mmap (hashcat_ctx, fp) == true) return 0;
+  #endif
+
   // NOTE: use (never changing) ->incr here instead of ->avail otherwise the buffer gets bigger and bigger
 
+  wl_data->buf = wl_data->buf_heap;
+
   wl_data->pos = 0;
 
   wl_data->cnt = hc_fread (wl_data->buf, 1, wl_data->incr - 1000, fp);
@@ -70,7 +258,9 @@ int load_segment (hashcat_ctx_t *hashcat_ctx, HCFILE *fp)
   {
     if (wl_data->cnt == wl_data->avail)
     {
-      wl_data->buf = (char *) hcrealloc (wl_data->buf, wl_data->avail, wl_data->incr);
+      wl_data->buf_heap = (char *) hcrealloc (wl_data->buf_heap, wl_data->avail, wl_data->incr);
+
+      wl_data->buf = wl_data->buf_heap;
 
       wl_data->avail += wl_data->incr;
     }
@@ -98,34 +288,264 @@ int load_segment (hashcat_ctx_t *hashcat_ctx, HCFILE *fp)
   return 0;
 }
 
-void get_next_word_lm_gen (char *buf, u64 sz, u64 *len, u64 *off, u64 cutlen)
+/**
+ * line splitting
+ *
+ * wl_scan_* return the position of the next '\n' in buf (or sz if there is none) and optionally upper-case everything
+ * in front of it. whole vectors are only loaded while they fit into sz, a mapped wordlist may end at a page boundary.
+ * upper-casing has to stop at the '\n' like the scalar loop does, the LM parsers look at the following line before it
+ * gets upper-cased, "$hex[" is not "$HEX[" and "7a" is not "7A" to them.
+ * the SSE2 version is used by NEON through sse2neon, the wider ones are picked at runtime in wl_data_init ()
+ */
+
+static inline u64 wl_scan_scalar (char *buf, const u64 sz, const bool upper)
 {
-  char *ptr = buf;
+  for (u64 i = 0; i < sz; i++)
+  {
+    if (upper == true)
+    {
+      if ((buf[i] >= 'a') && (buf[i] <= 'z')) buf[i] -= 0x20;
+    }
 
-  for (u64 i = 0; i < sz; i++, ptr++)
+    if (buf[i] == '\n') return i;
+  }
+
+  return sz;
+}
+
+static inline void wl_line_end (const char *buf, const u64 sz, const u64 i, u64 *len, u64 *off)
+{
+  if (i == sz)
   {
-    if (*ptr >= 'a' && *ptr <= 'z') *ptr -= 0x20;
+    *off = sz;
+    *len = sz;
+
+    return;
+  }
+
+  *off = i + 1;
 
-    if (i == cutlen)
+  *len = ((i > 0) && (buf[i - 1] == '\r')) ? i - 1 : i;
+}
+
+#if defined (WL_SIMD_X86) || defined (WL_SIMD_NEON)
+
+static inline u32 wl_block_sse2 (char *buf, const bool upper)
+{
+  __m128i v = _mm_loadu_si128 ((const __m128i *) buf);
+
+  const u32 bits = (u32) _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, _mm_set1_epi8 ('\n')));
+
+  if (upper == true)
+  {
+    // bytes >= 0x80 are negative here, so they never match
+
+    __m128i m = _mm_and_si128 (_mm_cmpgt_epi8 (v, _mm_set1_epi8 ('a' - 1)), _mm_cmpgt_epi8 (_mm_set1_epi8 ('z' + 1), v));
+
+    // nothing behind the '\n'
+
+    if (bits)
     {
-      if (cutlen == 20) buf[i - 1]= ']'; // add ] in $HEX[] format
+      const __m128i idx = _mm_setr_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+      m = _mm_and_si128 (m, _mm_cmpgt_epi8 (_mm_set1_epi8 ((char) __builtin_ctz (bits)), idx));
+    }
 
-      *len = i;
+    // only store if something changed, a store would un-share the page of a private mapping
 
-      // but continue a loop to skip rest of the line
+    if (_mm_movemask_epi8 (m))
+    {
+      v = _mm_sub_epi8 (v, _mm_and_si128 (m, _mm_set1_epi8 (0x20)));
+
+      _mm_storeu_si128 ((__m128i *) buf, v);
     }
+  }
 
-    if (*ptr != '\n') continue;
+  return bits;
+}
+
+static inline u64 wl_scan_sse2 (char *buf, const u64 sz, const bool upper)
+{
+  u64 i = 0;
+
+  for ( ; (i + 16) <= sz; i += 16)
+  {
+    const u32 bits = wl_block_sse2 (buf + i, upper);
+
+    if (bits) return i + (u64) __builtin_ctz (bits);
+  }
+
+  return i + wl_scan_scalar (buf + i, sz - i, upper);
+}
+
+static void get_next_word_std_sse2 (char *buf, u64 sz, u64 *len, u64 *off)
+{
+  wl_line_end (buf, sz, wl_scan_sse2 (buf, sz, false), len, off);
+}
+
+static void get_next_word_uc_sse2 (char *buf, u64 sz, u64 *len, u64 *off)
+{
+  wl_line_end (buf, sz, wl_scan_sse2 (buf, sz, true), len, off);
+}
+
+#endif // WL_SIMD_X86 || WL_SIMD_NEON
+
+#if defined (WL_SIMD_X86)
+
+__attribute__ ((target ("avx2")))
+static inline u64 wl_scan_avx2 (char *buf, const u64 sz, const bool upper)
+{
+  const __m256i v_nl = _mm256_set1_epi8 ('\n');
+  const __m256i v_lo = _mm256_set1_epi8 ('a' - 1);
+  const __m256i v_hi = _mm256_set1_epi8 ('z' + 1);
+  const __m256i v_uc = _mm256_set1_epi8 (0x20);
+
+  const __m256i v_idx = _mm256_setr_epi8 ( 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+                                          16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+
+  // most words are short, so a single 16 byte probe finds the end of the line more often than not
+
+  if (sz >= 16)
+  {
+    const u32 bits = wl_block_sse2 (buf, upper);
+
+    if (bits) return (u64) __builtin_ctz (bits);
+  }
+
+  u64 i = (sz >= 16) ? 16 : 0;
+
+  for ( ; (i + 32) <= sz; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256 ((const __m256i *) (buf + i));
+
+    const u32 bits = (u32) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (v, v_nl));
+
+    if (upper == true)
+    {
+      __m256i m = _mm256_and_si256 (_mm256_cmpgt_epi8 (v, v_lo), _mm256_cmpgt_epi8 (v_hi, v));
+
+      if (bits) m = _mm256_and_si256 (m, _mm256_cmpgt_epi8 (_mm256_set1_epi8 ((char) __builtin_ctz (bits)), v_idx));
+
+      if (_mm256_movemask_epi8 (m))
+      {
+        v = _mm256_sub_epi8 (v, _mm256_and_si256 (m, v_uc));
+
+        _mm256_storeu_si256 ((__m256i *) (buf + i), v);
+      }
+    }
+
+    if (bits) return i + (u64) __builtin_ctz (bits);
+  }
+
+  return i + wl_scan_sse2 (buf + i, sz - i, upper);
+}
+
+__attribute__ ((target ("avx2")))
+static void get_next_word_std_avx2 (char *buf, u64 sz, u64 *len, u64 *off)
+{
+  wl_line_end (buf, sz, wl_scan_avx2 (buf, sz, false), len, off);
+}
+
+__attribute__ ((target ("avx2")))
+static void get_next_word_uc_avx2 (char *buf, u64 sz, u64 *len, u64 *off)
+{
+  wl_line_end (buf, sz, wl_scan_avx2 (buf, sz, true), len, off);
+}
+
+__attribute__ ((target ("avx512f,avx512bw")))
+static inline u64 wl_scan_avx512 (char *buf, const u64 sz, const bool upper)
+{
+  const __m512i v_nl = _mm512_set1_epi8 ('\n');
+  const __m512i v_lo = _mm512_set1_epi8 ('a');
+  const __m512i v_26 = _mm512_set1_epi8 (26);
+  const __m512i v_uc = _mm512_set1_epi8 (0x20);
+
+  // most words are short, so a single 16 byte probe finds the end of the line more often than not
+
+  if (sz >= 16)
+  {
+    const u32 bits = wl_block_sse2 (buf, upper);
+
+    if (bits) return (u64) __builtin_ctz (bits);
+  }
+
+  u64 i = (sz >= 16) ? 16 : 0;
+
+  for ( ; (i + 64) <= sz; i += 64)
+  {
+    __m512i v = _mm512_loadu_si512 ((const void *) (buf + i));
+
+    const u64 bits = (u64) _mm512_cmpeq_epi8_mask (v, v_nl);
+
+    if (upper == true)
+    {
+      __mmask64 m = _mm512_cmplt_epu8_mask (_mm512_sub_epi8 (v, v_lo), v_26);
+
+      // all lanes below the first '\n'
+
+      if (bits) m &= (bits & (0 - bits)) - 1;
+
+      if (m)
+      {
+        v = _mm512_mask_sub_epi8 (v, m, v, v_uc);
+
+        _mm512_storeu_si512 ((void *) (buf + i), v);
+      }
+    }
+
+    if (bits) return i + (u64) __builtin_ctzll (bits);
+  }
+
+  return i + wl_scan_sse2 (buf + i, sz - i, upper);
+}
+
+__attribute__ ((target ("avx512f,avx512bw")))
+static void get_next_word_std_avx512 (char *buf, u64 sz, u64 *len, u64 *off)
+{
+  wl_line_end (buf, sz, wl_scan_avx512 (buf, sz, false), len, off);
+}
+
+__attribute__ ((target ("avx512f,avx512bw")))
+static void get_next_word_uc_avx512 (char *buf, u64 sz, u64 *len, u64 *off)
+{
+  wl_line_end (buf, sz, wl_scan_avx512 (buf, sz, true), len, off);
+}
+
+#endif // WL_SIMD_X86
+
+void get_next_word_lm_gen (char *buf, u64 sz, u64 *len, u64 *off, u64 cutlen)
+{
+  #if defined (WL_SIMD_X86) || defined (WL_SIMD_NEON)
+  const u64 i = wl_scan_sse2 (buf, sz, true);
+  #else
+  const u64 i = wl_scan_scalar (buf, sz, true);
+  #endif
+
+  if (i < sz)
+  {
+    if (i >= cutlen)
+    {
+      if (cutlen == 20) buf[cutlen - 1] = ']'; // add ] in $HEX[] format
+
+      *len = cutlen;
+    }
 
     *off = i + 1;
 
-    if ((i > 0) && (buf[i - 1] == '\r')) i--;
+    const u64 end = ((i > 0) && (buf[i - 1] == '\r')) ? i - 1 : i;
 
-    if (i < cutlen + 1) *len = i;
+    if (end < cutlen + 1) *len = end;
 
     return;
   }
 
+  if (sz > cutlen)
+  {
+    if (cutlen == 20) buf[cutlen - 1] = ']'; // add ] in $HEX[] format
+
+    *len = cutlen;
+  }
+
   *off = sz;
 
   if (sz < cutlen) *len = sz;
@@ -319,7 +739,7 @@ void get_next_word (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, char **out_buf, u32
 
       memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-      const int rule_len_out = _old_apply_rule (user_options->rule_buf_l, user_options_extra->rule_len_l, ptr, (u32) len, rule_buf_out);
+      const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_l, ptr, (u32) len, rule_buf_out);
 
       if (rule_len_out < 0) continue;
     }
@@ -389,34 +809,39 @@ void pw_base_add (hc_device_param_t *device_param, pw_pre_t *pw_pre)
   }
 }
 
-void pw_add (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len)
+static bool pw_add_buf (pw_idx_t *pws_idx, u32 *pws_comp, u64 *pws_cnt, const u64 kernel_power, const u8 *pw_buf, const int pw_len)
 {
-  if (device_param->pws_cnt < device_param->kernel_power)
-  {
-    pw_idx_t *pw_idx = device_param->pws_idx + device_param->pws_cnt;
+  if (*pws_cnt >= kernel_power) return false;
 
-    const u32 pw_len4 = (pw_len + 3) & ~3; // round up to multiple of 4
+  pw_idx_t *pw_idx = pws_idx + *pws_cnt;
 
-    const u32 pw_len4_cnt = pw_len4 / 4;
+  const u32 pw_len4 = (pw_len + 3) & ~3; // round up to multiple of 4
 
-    pw_idx->cnt = pw_len4_cnt;
-    pw_idx->len = pw_len;
+  const u32 pw_len4_cnt = pw_len4 / 4;
 
-    u8 *dst = (u8 *) (device_param->pws_comp + pw_idx->off);
+  pw_idx->cnt = pw_len4_cnt;
+  pw_idx->len = pw_len;
 
-    memcpy (dst, pw_buf, pw_len);
+  u8 *dst = (u8 *) (pws_comp + pw_idx->off);
 
-    memset (dst + pw_len, 0, pw_len4 - pw_len);
+  memcpy (dst, pw_buf, pw_len);
 
-    // prepare next element
+  memset (dst + pw_len, 0, pw_len4 - pw_len);
 
-    pw_idx_t *pw_idx_next = pw_idx + 1;
+  // prepare next element
 
-    pw_idx_next->off = pw_idx->off + pw_idx->cnt;
+  pw_idx_t *pw_idx_next = pw_idx + 1;
 
-    device_param->pws_cnt++;
-  }
-  else
+  pw_idx_next->off = pw_idx->off + pw_idx->cnt;
+
+  *pws_cnt += 1;
+
+  return true;
+}
+
+void pw_add (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len)
+{
+  if (pw_add_buf (device_param->pws_idx, device_param->pws_comp, &device_param->pws_cnt, device_param->kernel_power, pw_buf, pw_len) == false)
   {
     fprintf (stderr, "BUG pw_add()!!\n");
 
@@ -424,59 +849,47 @@ void pw_add (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len
   }
 }
 
-int count_words (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, u64 *result)
+void pw_add_batch (hc_device_param_t *device_param, pws_batch_t *pws_batch, const u8 *pw_buf, const int pw_len)
 {
-  combinator_ctx_t     *combinator_ctx     = hashcat_ctx->combinator_ctx;
-  hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
-  straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
-  mask_ctx_t           *mask_ctx           = hashcat_ctx->mask_ctx;
-  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
-  user_options_t       *user_options       = hashcat_ctx->user_options;
-  wl_data_t            *wl_data            = hashcat_ctx->wl_data;
-
-  //hc_signal (NULL);
+  if (pw_add_buf (pws_batch->pws_idx, pws_batch->pws_comp, &pws_batch->pws_cnt, device_param->kernel_power, pw_buf, pw_len) == false)
+  {
+    fprintf (stderr, "BUG pw_add_batch()!!\n");
 
-  dictstat_t d;
+    return;
+  }
+}
 
-  memset (&d, 0, sizeof (d));
+static int wl_dictstat_key (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, dictstat_t *d)
+{
+  user_options_t *user_options = hashcat_ctx->user_options;
 
-  if (hc_fstat (fp, &d.stat))
-  {
-    *result = 0;
+  memset (d, 0, sizeof (dictstat_t));
 
-    return 0;
-  }
+  if (hc_fstat (fp, &d->stat)) return -1;
 
-  d.stat.st_mode    = 0;
-  d.stat.st_nlink   = 0;
-  d.stat.st_uid     = 0;
-  d.stat.st_gid     = 0;
-  d.stat.st_rdev    = 0;
-  d.stat.st_atime   = 0;
+  d->stat.st_mode    = 0;
+  d->stat.st_nlink   = 0;
+  d->stat.st_uid     = 0;
+  d->stat.st_gid     = 0;
+  d->stat.st_rdev    = 0;
+  d->stat.st_atime   = 0;
 
   #if defined (STAT_NANOSECONDS_ACCESS_TIME)
-  d.stat.STAT_NANOSECONDS_ACCESS_TIME = 0;
+  d->stat.STAT_NANOSECONDS_ACCESS_TIME = 0;
   #endif
 
   #if defined (_POSIX)
-  d.stat.st_blksize = 0;
-  d.stat.st_blocks  = 0;
+  d->stat.st_blksize = 0;
+  d->stat.st_blocks  = 0;
   #endif
 
-  memset (d.encoding_from, 0, sizeof (d.encoding_from));
-  memset (d.encoding_to,   0, sizeof (d.encoding_to));
+  memset (d->encoding_from, 0, sizeof (d->encoding_from));
+  memset (d->encoding_to,   0, sizeof (d->encoding_to));
 
-  strncpy (d.encoding_from, user_options->encoding_from, sizeof (d.encoding_from) - 1);
-  strncpy (d.encoding_to,   user_options->encoding_to,   sizeof (d.encoding_to)   - 1);
+  strncpy (d->encoding_from, user_options->encoding_from, sizeof (d->encoding_from) - 1);
+  strncpy (d->encoding_to,   user_options->encoding_to,   sizeof (d->encoding_to)   - 1);
 
-  if (d.stat.st_size == 0)
-  {
-    *result = 0;
-
-    return 0;
-  }
-
-  const size_t dictfile_len = strlen (dictfile);
+  const size_t dictfile_len = strlen (dictfile);
 
   u32 *dictfile_padded = (u32 *) hcmalloc (dictfile_len + 64); // padding required for sha1_update()
 
@@ -500,69 +913,158 @@ int count_words (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, u
 
   hcfree (dictfile_padded);
 
-  memcpy (d.hash_filename, sha1_ctx.h, 16);
+  memcpy (d->hash_filename, sha1_ctx.h, 16);
 
-  const u64 cached_cnt = dictstat_find (hashcat_ctx, &d);
+  return 0;
+}
 
-  if (run_rule_engine (user_options_extra->rule_len_l, user_options->rule_buf_l) == 0)
+static u32 wl_index_flags (hashcat_ctx_t *hashcat_ctx)
+{
+  const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  const user_options_t *user_options = hashcat_ctx->user_options;
+
+  // everything which changes the number of words returned by get_next_word ()
+
+  u32 flags = 0;
+
+  if (hashconfig->opts_type & OPTS_TYPE_PT_HEX)   flags |= 1u << 0;
+  if (hashconfig->opts_type & OPTS_TYPE_PT_UPPER) flags |= 1u << 1;
+  if (hashconfig->opts_type & OPTS_TYPE_PT_LM)    flags |= 1u << 2;
+
+  if (user_options->wordlist_autohex == true)     flags |= 1u << 3;
+
+  return flags;
+}
+
+void wl_data_index_load (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile)
+{
+  wl_data_t *wl_data = hashcat_ctx->wl_data;
+
+  hcfree (wl_data->idx_buf);
+
+  wl_data->idx_buf = NULL;
+  wl_data->idx_cnt = 0;
+
+  // offsets of compressed files are offsets into the decompressed stream, hc_fseek () gets there through
+  // the xz block index or the gzip checkpoints, zip has no random access at all
+
+  if (fp->ufp != NULL) return;
+
+  dictstat_t d;
+
+  if (wl_dictstat_key (hashcat_ctx, fp, dictfile, &d) == -1) return;
+
+  if ((fp->gfp != NULL) && (fp->gzidx == NULL))
   {
-    if (cached_cnt)
-    {
-      u64 keyspace = cached_cnt;
+    gzidx_t *gzidx = (gzidx_t *) hcmalloc (sizeof (gzidx_t));
 
-      if (user_options_extra->attack_kern == ATTACK_KERN_STRAIGHT)
-      {
-        if (overflow_check_u64_mul (keyspace, straight_ctx->kernel_rules_cnt) == false) return -1;
+    dictstat_gzidx_read (hashcat_ctx, &d, gzidx);
 
-        keyspace *= straight_ctx->kernel_rules_cnt;
-      }
-      else if (user_options_extra->attack_kern == ATTACK_KERN_COMBI)
-      {
-        if (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (user_options->attack_mode == ATTACK_MODE_HYBRID2))
-        {
-          if (overflow_check_u64_mul (keyspace, mask_ctx->bfs_cnt) == false) return -1;
+    if (gzidx->cnt == 0)
+    {
+      hcfree (gzidx);
+    }
+    else
+    {
+      hc_gzidx_attach (fp, gzidx);
+    }
+  }
 
-          keyspace *= mask_ctx->bfs_cnt;
-        }
-        else
-        {
-          if (overflow_check_u64_mul (keyspace, combinator_ctx->combs_cnt) == false) return -1;
+  dictstat_index_read (hashcat_ctx, &d, wl_index_flags (hashcat_ctx), &wl_data->idx_buf, &wl_data->idx_cnt);
+}
 
-          keyspace *= combinator_ctx->combs_cnt;
-        }
-      }
+u64 wl_data_seek (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const u64 words_cur, const u64 words_dst)
+{
+  wl_data_t *wl_data = hashcat_ctx->wl_data;
 
-      cache_hit_t cache_hit;
+  if (wl_data->idx_cnt == 0) return words_cur;
 
-      cache_hit.dictfile      = dictfile;
-      cache_hit.stat.st_size  = d.stat.st_size;
-      cache_hit.cached_cnt    = cached_cnt;
-      cache_hit.keyspace      = keyspace;
+  // find the last checkpoint at or before words_dst
 
-      EVENT_DATA (EVENT_WORDLIST_CACHE_HIT, &cache_hit, sizeof (cache_hit));
+  u64 lo = 0;
+  u64 hi = wl_data->idx_cnt;
 
-      *result = keyspace;
+  while (lo < hi)
+  {
+    const u64 mid = lo + ((hi - lo) / 2);
 
-      return 0;
+    if (wl_data->idx_buf[mid].word_pos <= words_dst)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
     }
   }
 
-  time_t rt_start;
+  if (lo == 0) return words_cur;
 
-  time (&rt_start);
+  const dictidx_t *idx = wl_data->idx_buf + lo - 1;
+
+  if (idx->word_pos <= words_cur) return words_cur;
+
+  if (hc_fseek (fp, (off_t) idx->byte_off, SEEK_SET) == -1) return words_cur;
+
+  // force get_next_word () to load a new segment from the new position
+
+  wl_data->pos = 0;
+  wl_data->cnt = 0;
+
+  return idx->word_pos;
+}
+
+static u64 wl_count_mult (hashcat_ctx_t *hashcat_ctx)
+{
+  const combinator_ctx_t     *combinator_ctx     = hashcat_ctx->combinator_ctx;
+  const hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
+  const straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
+  const mask_ctx_t           *mask_ctx           = hashcat_ctx->mask_ctx;
+  const user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+  const user_options_t       *user_options       = hashcat_ctx->user_options;
+
+  // number of candidates each word of the dictionary expands to
+
+  if (user_options_extra->attack_kern == ATTACK_KERN_STRAIGHT) return straight_ctx->kernel_rules_cnt;
+
+  if (user_options_extra->attack_kern == ATTACK_KERN_COMBI)
+  {
+    if (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (user_options->attack_mode == ATTACK_MODE_HYBRID2)) return mask_ctx->bfs_cnt;
+
+    return combinator_ctx->combs_cnt;
+  }
+
+  return 0;
+}
+
+static void count_words_range (wl_count_t *wc)
+{
+  hashcat_ctx_t        *hashcat_ctx        = wc->hashcat_ctx;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
+  wl_data_t            *wl_data            = hashcat_ctx->wl_data;
+
+  HCFILE *fp = wc->fp;
+
+  // remember where every DICTIDX_STEP'th word starts, so that --skip and --restore can seek instead of reading
+  // the ranges after the first one also record their first word, that's where their word numbers get rebased
+
+  const bool idx_enabled = (dictstat_index_enabled (hashcat_ctx) == true) && (fp->ufp == NULL);
+
+  const bool idx_rebase = (wc->wc_all == NULL);
 
   time_t now  = 0;
   time_t prev = 0;
 
-  u64 comp = 0;
-  u64 cnt  = 0;
-  u64 cnt2 = 0;
-
   while (!hc_feof (fp))
   {
+    const off_t seg_off = hc_ftell (fp);
+
+    if ((wc->ranged == true) && ((u64) seg_off >= wc->end)) break;
+
     load_segment (hashcat_ctx, fp);
 
-    comp += wl_data->cnt;
+    wc->comp += wl_data->cnt;
 
     u64 i = 0;
 
@@ -575,6 +1077,12 @@ int count_words (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, u
 
       wl_data->func (ptr, wl_data->cnt - i, &len, &off);
 
+      const u64 line_off = i;
+
+      // a line which starts at or behind the end of our range is counted by the next one
+
+      if ((wc->ranged == true) && (((u64) seg_off + line_off) >= wc->end)) break;
+
       i += off;
 
       // do the on-the-fly hex decode using original buffer
@@ -607,174 +1115,1048 @@ int count_words (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, u
 
         memset (rule_buf_out, 0, sizeof (rule_buf_out));
 
-        const int rule_len_out = _old_apply_rule (user_options->rule_buf_l, user_options_extra->rule_len_l, ptr, (u32) len, rule_buf_out);
+        const int rule_len_out = rp_cpu_apply (&user_options_extra->rule_cpu_l, ptr, (u32) len, rule_buf_out);
 
         if (rule_len_out < 0) continue;
       }
 
-      cnt2++;
+      wc->cnt2++;
 
       if (len > PW_MAX) continue;
 
-      d.cnt++;
-
-      if (user_options_extra->attack_kern == ATTACK_KERN_STRAIGHT)
-      {
-        if (overflow_check_u64_add (cnt, straight_ctx->kernel_rules_cnt) == false) return -1;
-
-        cnt += straight_ctx->kernel_rules_cnt;
-      }
-      else if (user_options_extra->attack_kern == ATTACK_KERN_COMBI)
+      if ((idx_enabled == true) && ((wc->words % DICTIDX_STEP) == 0) && ((wc->words > 0) || (idx_rebase == true)) && (seg_off != -1))
       {
-        if (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (user_options->attack_mode == ATTACK_MODE_HYBRID2))
+        if (wc->idx_cnt == wc->idx_avail)
         {
-          if (overflow_check_u64_add (cnt, mask_ctx->bfs_cnt) == false) return -1;
+          wc->idx_buf = (dictidx_t *) hcrealloc (wc->idx_buf, wc->idx_avail * sizeof (dictidx_t), 1024 * sizeof (dictidx_t));
 
-          cnt += mask_ctx->bfs_cnt;
+          wc->idx_avail += 1024;
         }
-        else
-        {
-          if (overflow_check_u64_add (cnt, combinator_ctx->combs_cnt) == false) return -1;
 
-          cnt += combinator_ctx->combs_cnt;
-        }
+        wc->idx_buf[wc->idx_cnt].word_pos = wc->words;
+        wc->idx_buf[wc->idx_cnt].byte_off = (u64) seg_off + line_off;
+
+        wc->idx_cnt++;
       }
+
+      wc->words++;
     }
 
+    // the range counted by the calling thread reports the progress of all of them
+
+    if (wc->wc_all == NULL) continue;
+
     time (&now);
 
     if ((now - prev) == 0) continue;
 
     time (&prev);
 
-    double percent = ((double) comp / (double) d.stat.st_size) * 100;
+    u64 comp  = 0;
+    u64 words = 0;
+    u64 cnt2  = 0;
+
+    for (u32 k = 0; k < wc->wc_cnt; k++)
+    {
+      comp  += wc->wc_all[k].comp;
+      words += wc->wc_all[k].words;
+      cnt2  += wc->wc_all[k].cnt2;
+    }
+
+    double percent = ((double) comp / (double) wc->size) * 100;
 
     if (percent < 100)
     {
       cache_generate_t cache_generate;
 
-      cache_generate.dictfile    = dictfile;
+      cache_generate.dictfile    = wc->dictfile;
       cache_generate.comp        = comp;
       cache_generate.percent     = percent;
-      cache_generate.cnt         = cnt;
+      cache_generate.cnt         = words * wl_count_mult (hashcat_ctx);
       cache_generate.cnt2        = cnt2;
 
       EVENT_DATA (EVENT_WORDLIST_CACHE_GENERATE, &cache_generate, sizeof (cache_generate));
     }
   }
+}
 
-  time_t rt_stop;
+static HC_API_CALL void *thread_count_words (void *p)
+{
+  wl_count_t *wc = (wl_count_t *) p;
 
-  time (&rt_stop);
+  count_words_range (wc);
 
-  cache_generate_t cache_generate;
+  return NULL;
+}
 
-  cache_generate.dictfile    = dictfile;
-  cache_generate.comp        = comp;
-  cache_generate.percent     = 100;
-  cache_generate.cnt         = cnt;
-  cache_generate.cnt2        = cnt2;
-  cache_generate.runtime     = rt_stop - rt_start;
+static HC_API_CALL void *thread_gzidx_build (void *p)
+{
+  wl_gzidx_t *wg = (wl_gzidx_t *) p;
 
-  EVENT_DATA (EVENT_WORDLIST_CACHE_GENERATE, &cache_generate, sizeof (cache_generate));
+  wg->rc = hc_gzidx_build (&wg->gzidx, wg->dictfile);
 
-  dictstat_append (hashcat_ctx, &d);
+  return NULL;
+}
 
-  //hc_signal (sigHandler_default);
+static void count_words_release (wl_count_t *wc)
+{
+  hcfree (wc->idx_buf);
 
-  *result = cnt;
+  wc->idx_buf = NULL;
 
-  return 0;
+  if (wc->fp != &wc->fp_own) return;
+
+  wl_data_destroy (wc->hashcat_ctx);
+
+  hcfree (wc->hashcat_ctx->wl_data);
+  hcfree (wc->hashcat_ctx);
+
+  hc_fclose (&wc->fp_own);
 }
 
-int wl_data_init (hashcat_ctx_t *hashcat_ctx)
+static u32 count_words_split (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, const u64 size, wl_count_t *wc_all, const u32 wc_max)
 {
-  wl_data_t      *wl_data      = hashcat_ctx->wl_data;
-  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
-  user_options_t *user_options = hashcat_ctx->user_options;
+  const off_t pos0 = hc_ftell (fp);
 
-  wl_data->enabled = false;
-
-  if (user_options->usage         > 0)    return 0;
-  if (user_options->backend_info  > 0)    return 0;
+  if (pos0 < 0) return 1;
 
-  if (user_options->benchmark    == true) return 0;
-  if (user_options->hash_info    == true) return 0;
-  if (user_options->left         == true) return 0;
-  if (user_options->version      == true) return 0;
+  u32 wc_cnt = 1;
 
-  wl_data->enabled = true;
+  for (u32 k = 1; k < wc_max; k++)
+  {
+    // move each cut forward to the start of the next line, starting one byte early keeps a cut which already is one
 
-  wl_data->buf     = (char *) hcmalloc (user_options->segment_size);
-  wl_data->avail   = user_options->segment_size;
-  wl_data->incr    = user_options->segment_size;
-  wl_data->cnt     = 0;
-  wl_data->pos     = 0;
+    const u64 cut = (size / wc_max) * k;
 
-  /**
-   * choose dictionary parser
-   */
+    if (cut <= wc_all[wc_cnt - 1].beg) continue;
 
-  wl_data->func = get_next_word_std;
+    if (hc_fseek (fp, (off_t) cut - 1, SEEK_SET) == -1) break;
 
-  if (hashconfig->opts_type & OPTS_TYPE_PT_UPPER)
-  {
-    wl_data->func = get_next_word_uc;
-  }
+    int c = EOF;
 
-  if (hashconfig->opts_type & OPTS_TYPE_PT_LM)
-  {
-    if (hashconfig->opts_type & OPTS_TYPE_PT_HEX)
+    while ((c = hc_fgetc (fp)) != EOF)
     {
-      wl_data->func = get_next_word_lm_hex;           // all hex in file
+      if (c == '\n') break;
     }
-    else
+
+    if (c == EOF) break;
+
+    const off_t beg = hc_ftell (fp);
+
+    if ((beg < 0) || ((u64) beg >= size)) break;
+
+    if ((u64) beg <= wc_all[wc_cnt - 1].beg) continue;
+
+    wl_count_t *wc = wc_all + wc_cnt;
+
+    if (hc_fopen (&wc->fp_own, dictfile, "rb") == false) break;
+
+    if (hc_fseek (&wc->fp_own, beg, SEEK_SET) == -1)
     {
-      if (user_options->wordlist_autohex == true)
-      {
-        wl_data->func = get_next_word_lm_hex_or_text; // might be $HEX[] notation
-      }
-      else
-      {
-        wl_data->func = get_next_word_lm_text;        // treat as normal text
-      }
+      hc_fclose (&wc->fp_own);
+
+      break;
     }
-  }
 
-  /**
-   * iconv
-   */
+    hashcat_ctx_t *hashcat_ctx_tmp = (hashcat_ctx_t *) hcmalloc (sizeof (hashcat_ctx_t));
 
-  if (strcmp (user_options->encoding_from, user_options->encoding_to) != 0)
-  {
-    wl_data->iconv_enabled = true;
+    memcpy (hashcat_ctx_tmp, hashcat_ctx, sizeof (hashcat_ctx_t)); // yes we actually want to copy these pointers
 
-    wl_data->iconv_ctx = iconv_open (user_options->encoding_to, user_options->encoding_from);
+    hashcat_ctx_tmp->wl_data = (wl_data_t *) hcmalloc (sizeof (wl_data_t));
 
-    if (wl_data->iconv_ctx == (iconv_t) -1) return -1;
+    if (wl_data_init (hashcat_ctx_tmp) == -1)
+    {
+      hcfree (hashcat_ctx_tmp->wl_data);
+      hcfree (hashcat_ctx_tmp);
 
-    wl_data->iconv_tmp = (char *) hcmalloc (HCBUFSIZ_TINY);
+      hc_fclose (&wc->fp_own);
+
+      break;
+    }
+
+    wc->hashcat_ctx = hashcat_ctx_tmp;
+    wc->fp          = &wc->fp_own;
+    wc->ranged      = true;
+    wc->beg         = (u64) beg;
+    wc->end         = size;
+
+    wc_all[wc_cnt - 1].ranged = true;
+    wc_all[wc_cnt - 1].end    = (u64) beg;
+
+    wc_cnt++;
   }
 
-  return 0;
+  hc_fseek (fp, pos0, SEEK_SET);
+
+  return wc_cnt;
 }
 
-void wl_data_destroy (hashcat_ctx_t *hashcat_ctx)
+int count_words (hashcat_ctx_t *hashcat_ctx, HCFILE *fp, const char *dictfile, u64 *result)
 {
-  wl_data_t *wl_data = hashcat_ctx->wl_data;
+  combinator_ctx_t     *combinator_ctx     = hashcat_ctx->combinator_ctx;
+  hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
+  straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
+  mask_ctx_t           *mask_ctx           = hashcat_ctx->mask_ctx;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
 
-  if (wl_data->enabled == false) return;
+  //hc_signal (NULL);
 
-  hcfree (wl_data->buf);
+  dictstat_t d;
 
-  if (wl_data->iconv_enabled == true)
+  if (wl_dictstat_key (hashcat_ctx, fp, dictfile, &d) == -1)
   {
-    iconv_close (wl_data->iconv_ctx);
+    *result = 0;
 
-    wl_data->iconv_enabled = false;
+    return 0;
+  }
 
-    hcfree (wl_data->iconv_tmp);
+  if (d.stat.st_size == 0)
+  {
+    *result = 0;
+
+    return 0;
   }
 
-  memset (wl_data, 0, sizeof (wl_data_t));
+  const u64 cached_cnt = dictstat_find (hashcat_ctx, &d);
+
+  // a wordlist counted before there were word offset indexes, or whose index got lost, is counted again to build it.
+  // with no more than DICTIDX_STEP words there is nothing to index
+
+  bool idx_missing = false;
+
+  if ((cached_cnt > DICTIDX_STEP) && (fp->ufp == NULL))
+  {
+    idx_missing = (dictstat_index_enabled (hashcat_ctx) == true) && (dictstat_index_exists (hashcat_ctx, &d, wl_index_flags (hashcat_ctx)) == false);
+  }
+
+  if (run_rule_engine (user_options_extra->rule_len_l, user_options->rule_buf_l) == 0)
+  {
+    if ((cached_cnt) && (idx_missing == false))
+    {
+      u64 keyspace = cached_cnt;
+
+      if (user_options_extra->attack_kern == ATTACK_KERN_STRAIGHT)
+      {
+        if (overflow_check_u64_mul (keyspace, straight_ctx->kernel_rules_cnt) == false) return -1;
+
+        keyspace *= straight_ctx->kernel_rules_cnt;
+      }
+      else if (user_options_extra->attack_kern == ATTACK_KERN_COMBI)
+      {
+        if (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (user_options->attack_mode == ATTACK_MODE_HYBRID2))
+        {
+          if (overflow_check_u64_mul (keyspace, mask_ctx->bfs_cnt) == false) return -1;
+
+          keyspace *= mask_ctx->bfs_cnt;
+        }
+        else
+        {
+          if (overflow_check_u64_mul (keyspace, combinator_ctx->combs_cnt) == false) return -1;
+
+          keyspace *= combinator_ctx->combs_cnt;
+        }
+      }
+
+      cache_hit_t cache_hit;
+
+      cache_hit.dictfile      = dictfile;
+      cache_hit.stat.st_size  = d.stat.st_size;
+      cache_hit.cached_cnt    = cached_cnt;
+      cache_hit.keyspace      = keyspace;
+
+      EVENT_DATA (EVENT_WORDLIST_CACHE_HIT, &cache_hit, sizeof (cache_hit));
+
+      *result = keyspace;
+
+      return 0;
+    }
+  }
+
+  time_t rt_start;
+
+  time (&rt_start);
+
+  // plain files are split into newline-aligned ranges of at least one segment which are counted in parallel
+  // compressed files can't be entered in the middle, they are counted in one go
+
+  const u64 size = (u64) d.stat.st_size;
+
+  // gzip lists get their seek checkpoints built on the side, in the time the counting needs to inflate them anyway
+
+  wl_gzidx_t wg;
+
+  memset (&wg, 0, sizeof (wg));
+
+  wg.dictfile = dictfile;
+
+  hc_thread_t gz_thread;
+
+  const bool gz_build = (fp->gfp != NULL) && ((cached_cnt == 0) || (idx_missing == true)) && (hashcat_ctx->dictstat_ctx->enabled == true);
+
+  if (gz_build == true) hc_thread_create (gz_thread, thread_gzidx_build, &wg);
+
+  u32 wc_max = 1;
+
+  if (fp->pfp != NULL)
+  {
+    const u64 segs_cnt = size / user_options->segment_size;
+
+    const int procs_cnt = hc_get_processor_count ();
+
+    wc_max = (u32) MIN ((u64) MAX (procs_cnt, 1), MAX (segs_cnt, 1));
+  }
+
+  wl_count_t *wc_all = (wl_count_t *) hccalloc (wc_max, sizeof (wl_count_t));
+
+  wc_all[0].hashcat_ctx = hashcat_ctx;
+  wc_all[0].fp          = fp;
+  wc_all[0].ranged      = false;
+  wc_all[0].beg         = 0;
+  wc_all[0].end         = size;
+  wc_all[0].dictfile    = dictfile;
+  wc_all[0].size        = size;
+
+  const u32 wc_cnt = (wc_max > 1) ? count_words_split (hashcat_ctx, fp, dictfile, size, wc_all, wc_max) : 1;
+
+  wc_all[0].wc_all = wc_all;
+  wc_all[0].wc_cnt = wc_cnt;
+
+  hc_thread_t *c_threads = (hc_thread_t *) hccalloc (wc_cnt, sizeof (hc_thread_t));
+
+  for (u32 k = 1; k < wc_cnt; k++)
+  {
+    hc_thread_create (c_threads[k], thread_count_words, &wc_all[k]);
+  }
+
+  count_words_range (&wc_all[0]);
+
+  hc_thread_wait ((int) wc_cnt - 1, c_threads + 1);
+
+  hcfree (c_threads);
+
+  if (gz_build == true)
+  {
+    hc_thread_wait (1, &gz_thread);
+
+    if (wg.rc == 0) dictstat_gzidx_write (hashcat_ctx, &d, &wg.gzidx);
+
+    hc_gzidx_free (&wg.gzidx);
+  }
+
+  // merge the ranges in file order, word numbers of the index entries are rebased on the way
+
+  u64 comp = 0;
+  u64 cnt2 = 0;
+
+  u64 idx_cnt = 0;
+
+  for (u32 k = 0; k < wc_cnt; k++) idx_cnt += wc_all[k].idx_cnt;
+
+  dictidx_t *idx_buf = (idx_cnt) ? (dictidx_t *) hccalloc (idx_cnt, sizeof (dictidx_t)) : NULL;
+
+  idx_cnt = 0;
+
+  for (u32 k = 0; k < wc_cnt; k++)
+  {
+    wl_count_t *wc = wc_all + k;
+
+    for (u64 j = 0; j < wc->idx_cnt; j++)
+    {
+      idx_buf[idx_cnt].word_pos = d.cnt + wc->idx_buf[j].word_pos;
+      idx_buf[idx_cnt].byte_off = wc->idx_buf[j].byte_off;
+
+      idx_cnt++;
+    }
+
+    d.cnt += wc->words;
+
+    comp += wc->comp;
+    cnt2 += wc->cnt2;
+
+    count_words_release (wc);
+  }
+
+  hcfree (wc_all);
+
+  const u64 mult = wl_count_mult (hashcat_ctx);
+
+  if (overflow_check_u64_mul (d.cnt, mult) == false)
+  {
+    hcfree (idx_buf);
+
+    return -1;
+  }
+
+  const u64 cnt = d.cnt * mult;
+
+  time_t rt_stop;
+
+  time (&rt_stop);
+
+  cache_generate_t cache_generate;
+
+  cache_generate.dictfile    = dictfile;
+  cache_generate.comp        = comp;
+  cache_generate.percent     = 100;
+  cache_generate.cnt         = cnt;
+  cache_generate.cnt2        = cnt2;
+  cache_generate.runtime     = rt_stop - rt_start;
+
+  EVENT_DATA (EVENT_WORDLIST_CACHE_GENERATE, &cache_generate, sizeof (cache_generate));
+
+  dictstat_append (hashcat_ctx, &d);
+
+  if (dictstat_index_enabled (hashcat_ctx) == true)
+  {
+    dictstat_index_write (hashcat_ctx, &d, wl_index_flags (hashcat_ctx), idx_buf, idx_cnt);
+  }
+
+  hcfree (idx_buf);
+
+  //hc_signal (sigHandler_default);
+
+  *result = cnt;
+
+  return 0;
+}
+
+int wl_data_init (hashcat_ctx_t *hashcat_ctx)
+{
+  wl_data_t      *wl_data      = hashcat_ctx->wl_data;
+  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  wl_data->enabled = false;
+
+  if (user_options->usage         > 0)    return 0;
+  if (user_options->backend_info  > 0)    return 0;
+
+  if (user_options->benchmark    == true) return 0;
+  if (user_options->hash_info    == true) return 0;
+  if (user_options->left         == true) return 0;
+  if (user_options->version      == true) return 0;
+
+  wl_data->enabled = true;
+
+  wl_data->buf_heap = (char *) hcmalloc (user_options->segment_size);
+  wl_data->buf      = wl_data->buf_heap;
+  wl_data->avail    = user_options->segment_size;
+  wl_data->incr    = user_options->segment_size;
+  wl_data->cnt     = 0;
+  wl_data->pos     = 0;
+
+  /**
+   * choose dictionary parser
+   */
+
+  wl_data->func = get_next_word_std;
+
+  if (hashconfig->opts_type & OPTS_TYPE_PT_UPPER)
+  {
+    wl_data->func = get_next_word_uc;
+  }
+
+  if (hashconfig->opts_type & OPTS_TYPE_PT_LM)
+  {
+    if (hashconfig->opts_type & OPTS_TYPE_PT_HEX)
+    {
+      wl_data->func = get_next_word_lm_hex;           // all hex in file
+    }
+    else
+    {
+      if (user_options->wordlist_autohex == true)
+      {
+        wl_data->func = get_next_word_lm_hex_or_text; // might be $HEX[] notation
+      }
+      else
+      {
+        wl_data->func = get_next_word_lm_text;        // treat as normal text
+      }
+    }
+  }
+
+  const bool is_lm = (hashconfig->opts_type & OPTS_TYPE_PT_LM) ? true : false;
+
+  /**
+   * vectorized line splitting, the widest one the cpu supports
+   */
+
+  if (is_lm == false)
+  {
+    const bool is_uc = (hashconfig->opts_type & OPTS_TYPE_PT_UPPER) ? true : false;
+
+    #if defined (WL_SIMD_X86)
+    if (cpu_supports_avx512bw ())
+    {
+      wl_data->func = (is_uc == true) ? get_next_word_uc_avx512 : get_next_word_std_avx512;
+    }
+    else if (cpu_supports_avx2 ())
+    {
+      wl_data->func = (is_uc == true) ? get_next_word_uc_avx2   : get_next_word_std_avx2;
+    }
+    else
+    {
+      wl_data->func = (is_uc == true) ? get_next_word_uc_sse2   : get_next_word_std_sse2;
+    }
+    #elif defined (WL_SIMD_NEON)
+    wl_data->func = (is_uc == true) ? get_next_word_uc_sse2 : get_next_word_std_sse2;
+    #else
+    (void) is_uc;
+    #endif
+  }
+
+  /**
+   * plain wordlists are mapped into memory and tokenized in-place,
+   * the LM parsers may look one byte past the segment so they stay on the copying path
+   */
+
+  #if defined (_POSIX)
+  if (is_lm == false)
+  {
+    wl_data->mmap_enabled = true;
+  }
+  #endif
+
+  /**
+   * iconv
+   */
+
+  if (strcmp (user_options->encoding_from, user_options->encoding_to) != 0)
+  {
+    wl_data->iconv_enabled = true;
+
+    wl_data->iconv_ctx = iconv_open (user_options->encoding_to, user_options->encoding_from);
+
+    if (wl_data->iconv_ctx == (iconv_t) -1) return -1;
+
+    wl_data->iconv_tmp = (char *) hcmalloc (HCBUFSIZ_TINY);
+  }
+
+  return 0;
+}
+
+void wl_data_destroy (hashcat_ctx_t *hashcat_ctx)
+{
+  wl_data_t *wl_data = hashcat_ctx->wl_data;
+
+  if (wl_data->enabled == false) return;
+
+  #if defined (_POSIX)
+  wl_data_unmap (wl_data);
+  #endif
+
+  hcfree (wl_data->buf_heap);
+  hcfree (wl_data->idx_buf);
+
+  if (wl_data->iconv_enabled == true)
+  {
+    iconv_close (wl_data->iconv_ctx);
+
+    wl_data->iconv_enabled = false;
+
+    hcfree (wl_data->iconv_tmp);
+  }
+
+  memset (wl_data, 0, sizeof (wl_data_t));
+}
+
+/**
+ * pipe mode: instead of every device thread taking turns to fgets () stdin line by line while holding
+ * mux_dispatcher, a single reader thread read ()s stdin in large blocks, splits the lines, applies hex,
+ * iconv and -j/-k handling and appends the finished candidates to a batch. full batches go into a small
+ * ring, wl_stdin_fill () copies them into the device buffers.
+ */
+
+static bool wl_stdin_running (const hashcat_ctx_t *hashcat_ctx)
+{
+  const status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+  const wl_shared_t  *wl_shared  = hashcat_ctx->wl_shared;
+
+  if (wl_shared->stdin_shutdown == true) return false;
+
+  if (status_ctx->run_thread_level1 == false) return false;
+
+  return true;
+}
+
+// returns the next free slot of the ring, it stays private to the reader until it's published
+
+static wl_stdin_batch_t *wl_stdin_batch_get (hashcat_ctx_t *hashcat_ctx)
+{
+  wl_shared_t *wl_shared = hashcat_ctx->wl_shared;
+
+  hc_thread_mutex_lock (wl_shared->mux_reader);
+
+  while (wl_shared->stdin_used == WL_STDIN_BATCHES)
+  {
+    if (wl_stdin_running (hashcat_ctx) == false)
+    {
+      hc_thread_mutex_unlock (wl_shared->mux_reader);
+
+      return NULL;
+    }
+
+    hc_thread_cond_wait (wl_shared->stdin_cond_free, wl_shared->mux_reader);
+  }
+
+  wl_stdin_batch_t *batch = wl_shared->stdin_batches + ((wl_shared->stdin_head + wl_shared->stdin_used) % WL_STDIN_BATCHES);
+
+  hc_thread_mutex_unlock (wl_shared->mux_reader);
+
+  batch->cnt         = 0;
+  batch->pos         = 0;
+  batch->buf_len     = 0;
+  batch->buf_off     = 0;
+  batch->words_extra = 0;
+
+  return batch;
+}
+
+static void wl_stdin_batch_put (hashcat_ctx_t *hashcat_ctx, const bool eof)
+{
+  wl_shared_t *wl_shared = hashcat_ctx->wl_shared;
+
+  hc_thread_mutex_lock (wl_shared->mux_reader);
+
+  wl_shared->stdin_used++;
+
+  if (eof == true) wl_shared->stdin_eof = true;
+
+  hc_thread_cond_wake (wl_shared->stdin_cond_used);
+
+  hc_thread_mutex_unlock (wl_shared->mux_reader);
+}
+
+static void wl_stdin_line (hashcat_ctx_t *hashcat_ctx, wl_stdin_batch_t *batch, char *line_buf, size_t line_len)
+{
+  const hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
+  const user_options_t       *user_options       = hashcat_ctx->user_options;
+  const user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+  const wl_shared_t          *wl_shared          = hashcat_ctx->wl_shared;
+
+  while (line_len)
+  {
+    if (line_buf[line_len - 1] != '\r') break;
+
+    line_len--;
+  }
+
+  line_len = convert_from_hex (hashcat_ctx, line_buf, line_len);
+
+  // do the on-the-fly encoding
+
+  if (wl_shared->stdin_iconv_enabled == true)
+  {
+    char  *iconv_ptr = wl_shared->stdin_iconv_tmp;
+    size_t iconv_sz  = HCBUFSIZ_TINY;
+
+    if (iconv (wl_shared->stdin_iconv_ctx, &line_buf, &line_len, &iconv_ptr, &iconv_sz) == (size_t) -1) return;
+
+    line_buf = wl_shared->stdin_iconv_tmp;
+    line_len = HCBUFSIZ_TINY - iconv_sz;
+  }
+
+  // post-process rule engine
+
+  char rule_buf_out[RP_PASSWORD_SIZE];
+
+  int   rule_jk_len = (int)    user_options_extra->rule_len_l;
+  const char *rule_jk_buf = user_options->rule_buf_l;
+
+  const rp_cpu_rule_t *rule_jk_cpu = &user_options_extra->rule_cpu_l;
+
+  if (user_options->attack_mode == ATTACK_MODE_HYBRID2)
+  {
+    rule_jk_len = (int)    user_options_extra->rule_len_r;
+    rule_jk_buf = user_options->rule_buf_r;
+
+    rule_jk_cpu = &user_options_extra->rule_cpu_r;
+  }
+
+  if (run_rule_engine (rule_jk_len, rule_jk_buf))
+  {
+    if (line_len >= RP_PASSWORD_SIZE) return;
+
+    memset (rule_buf_out, 0, sizeof (rule_buf_out));
+
+    const int rule_len_out = rp_cpu_apply (rule_jk_cpu, line_buf, (int) line_len, rule_buf_out);
+
+    if (rule_len_out < 0) return;
+
+    line_buf = rule_buf_out;
+    line_len = (size_t) rule_len_out;
+  }
+
+  if (line_len > PW_MAX) return;
+
+  if (user_options_extra->attack_kern == ATTACK_KERN_STRAIGHT)
+  {
+    if ((line_len < hashconfig->pw_min) || (line_len > hashconfig->pw_max))
+    {
+      batch->words_extra++;
+
+      return;
+    }
+  }
+
+  memcpy (batch->buf + batch->buf_len, line_buf, line_len);
+
+  batch->buf_len += line_len;
+
+  batch->len_buf[batch->cnt] = (u32) line_len;
+
+  batch->cnt++;
+}
+
+static HC_API_CALL void *thread_stdin_reader (void *p)
+{
+  hashcat_ctx_t *hashcat_ctx = (hashcat_ctx_t *) p;
+
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+  wl_shared_t  *wl_shared  = hashcat_ctx->wl_shared;
+
+  char *buf = wl_shared->stdin_buf;
+
+  u64 buf_len = 0;
+
+  bool skip_line = false;
+
+  bool eof = false;
+
+  wl_stdin_batch_t *batch = wl_stdin_batch_get (hashcat_ctx);
+
+  while ((batch != NULL) && (eof == false))
+  {
+    if (wl_stdin_running (hashcat_ctx) == false) break;
+
+    const int rc_select = select_read_timeout_console (1);
+
+    if (rc_select == -1) break;
+
+    if (rc_select == 0)
+    {
+      status_ctx->stdin_read_timeout_cnt++;
+
+      continue;
+    }
+
+    status_ctx->stdin_read_timeout_cnt = 0;
+
+    const ssize_t nread = read (fileno (stdin), buf + buf_len, WL_STDIN_READ_SIZE - buf_len);
+
+    if (nread <= 0)
+    {
+      eof = true;
+    }
+    else
+    {
+      buf_len += (u64) nread;
+    }
+
+    u64 pos = 0;
+
+    while (pos < buf_len)
+    {
+      char *next = (char *) memchr (buf + pos, '\n', buf_len - pos);
+
+      u64 line_end = buf_len;
+
+      if (next != NULL)
+      {
+        line_end = (u64) (next - buf);
+      }
+      else if (eof == false)
+      {
+        break;
+      }
+
+      // the batch always has room for one more candidate, a rule can't make it longer than RP_PASSWORD_SIZE
+
+      if ((batch->cnt == WL_STDIN_BATCH_WORDS) || ((batch->buf_len + RP_PASSWORD_SIZE) > WL_STDIN_BATCH_SIZE))
+      {
+        wl_stdin_batch_put (hashcat_ctx, false);
+
+        batch = wl_stdin_batch_get (hashcat_ctx);
+
+        if (batch == NULL) break;
+      }
+
+      buf[line_end] = 0;
+
+      if (skip_line == false) wl_stdin_line (hashcat_ctx, batch, buf + pos, (size_t) (line_end - pos));
+
+      skip_line = false;
+
+      pos = line_end + 1;
+    }
+
+    if (batch == NULL) break;
+
+    if (pos > buf_len) pos = buf_len;
+
+    buf_len -= pos;
+
+    memmove (buf, buf + pos, buf_len);
+
+    // a line which doesn't fit into the read buffer can't be a valid candidate anyway
+
+    if (buf_len == WL_STDIN_READ_SIZE)
+    {
+      buf_len = 0;
+
+      skip_line = true;
+    }
+
+    // make whatever was read available right away, a slow pipe should not hold back a device
+
+    if ((batch->cnt > 0) || (batch->words_extra > 0))
+    {
+      wl_stdin_batch_put (hashcat_ctx, false);
+
+      batch = wl_stdin_batch_get (hashcat_ctx);
+    }
+  }
+
+  if (batch != NULL)
+  {
+    wl_stdin_batch_put (hashcat_ctx, true);
+  }
+  else
+  {
+    hc_thread_mutex_lock (wl_shared->mux_reader);
+
+    wl_shared->stdin_eof = true;
+
+    hc_thread_cond_wake (wl_shared->stdin_cond_used);
+
+    hc_thread_mutex_unlock (wl_shared->mux_reader);
+  }
+
+  return NULL;
+}
+
+void wl_stdin_fill (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, u64 *words_extra)
+{
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+  wl_shared_t  *wl_shared  = hashcat_ctx->wl_shared;
+
+  hc_thread_mutex_lock (wl_shared->mux_reader);
+
+  while (device_param->pws_cnt < device_param->kernel_power)
+  {
+    if (wl_shared->stdin_used == 0)
+    {
+      if (wl_shared->stdin_eof == true) break;
+
+      if (status_ctx->run_thread_level1 == false) break;
+
+      // the reader notices a stop within its select () timeout and publishes eof on the way out
+
+      hc_thread_cond_wait (wl_shared->stdin_cond_used, wl_shared->mux_reader);
+
+      continue;
+    }
+
+    wl_stdin_batch_t *batch = wl_shared->stdin_batches + wl_shared->stdin_head;
+
+    while ((batch->pos < batch->cnt) && (device_param->pws_cnt < device_param->kernel_power))
+    {
+      const u32 line_len = batch->len_buf[batch->pos];
+
+      pw_add (device_param, (const u8 *) batch->buf + batch->buf_off, (const int) line_len);
+
+      batch->buf_off += line_len;
+
+      batch->pos++;
+    }
+
+    if (batch->pos < batch->cnt) break;
+
+    *words_extra += batch->words_extra;
+
+    wl_shared->stdin_head = (wl_shared->stdin_head + 1) % WL_STDIN_BATCHES;
+
+    wl_shared->stdin_used--;
+
+    hc_thread_cond_wake (wl_shared->stdin_cond_free);
+  }
+
+  hc_thread_mutex_unlock (wl_shared->mux_reader);
+}
+
+static int wl_stdin_init (hashcat_ctx_t *hashcat_ctx)
+{
+  const user_options_t *user_options = hashcat_ctx->user_options;
+        wl_shared_t    *wl_shared    = hashcat_ctx->wl_shared;
+
+  if (strcmp (user_options->encoding_from, user_options->encoding_to) != 0)
+  {
+    wl_shared->stdin_iconv_ctx = iconv_open (user_options->encoding_to, user_options->encoding_from);
+
+    if (wl_shared->stdin_iconv_ctx == (iconv_t) -1) return -1;
+
+    wl_shared->stdin_iconv_tmp = (char *) hcmalloc (HCBUFSIZ_TINY);
+
+    wl_shared->stdin_iconv_enabled = true;
+  }
+
+  wl_shared->stdin_buf = (char *) hcmalloc (WL_STDIN_READ_SIZE + 1);
+
+  wl_shared->stdin_batches = (wl_stdin_batch_t *) hccalloc (WL_STDIN_BATCHES, sizeof (wl_stdin_batch_t));
+
+  for (u32 batch_idx = 0; batch_idx < WL_STDIN_BATCHES; batch_idx++)
+  {
+    wl_stdin_batch_t *batch = wl_shared->stdin_batches + batch_idx;
+
+    batch->buf     = (char *) hcmalloc (WL_STDIN_BATCH_SIZE);
+    batch->len_buf = (u32 *)  hccalloc (WL_STDIN_BATCH_WORDS, sizeof (u32));
+  }
+
+  hc_thread_mutex_init (wl_shared->mux_reader);
+  hc_thread_cond_init  (wl_shared->stdin_cond_used);
+  hc_thread_cond_init  (wl_shared->stdin_cond_free);
+
+  wl_shared->stdin_enabled = true;
+
+  hc_thread_create (wl_shared->stdin_thread, thread_stdin_reader, hashcat_ctx);
+
+  return 0;
+}
+
+static void wl_stdin_destroy (hashcat_ctx_t *hashcat_ctx)
+{
+  wl_shared_t *wl_shared = hashcat_ctx->wl_shared;
+
+  hc_thread_mutex_lock (wl_shared->mux_reader);
+
+  wl_shared->stdin_shutdown = true;
+
+  hc_thread_cond_wake (wl_shared->stdin_cond_free);
+
+  hc_thread_mutex_unlock (wl_shared->mux_reader);
+
+  hc_thread_wait (1, &wl_shared->stdin_thread);
+
+  for (u32 batch_idx = 0; batch_idx < WL_STDIN_BATCHES; batch_idx++)
+  {
+    wl_stdin_batch_t *batch = wl_shared->stdin_batches + batch_idx;
+
+    hcfree (batch->buf);
+    hcfree (batch->len_buf);
+  }
+
+  hcfree (wl_shared->stdin_batches);
+  hcfree (wl_shared->stdin_buf);
+
+  if (wl_shared->stdin_iconv_enabled == true)
+  {
+    iconv_close (wl_shared->stdin_iconv_ctx);
+
+    hcfree (wl_shared->stdin_iconv_tmp);
+  }
+
+  hc_thread_cond_delete  (wl_shared->stdin_cond_used);
+  hc_thread_cond_delete  (wl_shared->stdin_cond_free);
+  hc_thread_mutex_delete (wl_shared->mux_reader);
+
+  memset (wl_shared, 0, sizeof (wl_shared_t));
+}
+
+int wl_shared_init (hashcat_ctx_t *hashcat_ctx)
+{
+  combinator_ctx_t     *combinator_ctx     = hashcat_ctx->combinator_ctx;
+  hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
+  straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+  wl_shared_t          *wl_shared          = hashcat_ctx->wl_shared;
+
+  wl_shared->enabled = false;
+
+  if (user_options_extra->wordlist_mode == WL_MODE_STDIN) return wl_stdin_init (hashcat_ctx);
+
+  if (user_options->slow_candidates == true) return 0;
+
+  const u32 attack_mode = user_options->attack_mode;
+
+  if (attack_mode == ATTACK_MODE_BF) return 0;
+
+  if (((hashconfig->opti_type & OPTI_TYPE_OPTIMIZED_KERNEL) == 0) && (attack_mode == ATTACK_MODE_HYBRID2)) return 0;
+
+  char *dictfile = straight_ctx->dict;
+
+  if (attack_mode == ATTACK_MODE_COMBI)
+  {
+    if (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT)
+    {
+      dictfile = combinator_ctx->dict1;
+    }
+    else
+    {
+      dictfile = combinator_ctx->dict2;
+    }
+  }
+
+  if (hc_fopen (&wl_shared->fp, dictfile, "rb") == false)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", dictfile, strerror (errno));
+
+    return -1;
+  }
+
+  hashcat_ctx_t *hashcat_ctx_tmp = (hashcat_ctx_t *) hcmalloc (sizeof (hashcat_ctx_t));
+
+  memcpy (hashcat_ctx_tmp, hashcat_ctx, sizeof (hashcat_ctx_t)); // yes we actually want to copy these pointers
+
+  hashcat_ctx_tmp->wl_data = (wl_data_t *) hcmalloc (sizeof (wl_data_t));
+
+  if (wl_data_init (hashcat_ctx_tmp) == -1)
+  {
+    hc_fclose (&wl_shared->fp);
+
+    hcfree (hashcat_ctx_tmp->wl_data);
+    hcfree (hashcat_ctx_tmp);
+
+    return -1;
+  }
+
+  wl_data_index_load (hashcat_ctx_tmp, &wl_shared->fp, dictfile);
+
+  wl_shared->hashcat_ctx_tmp = hashcat_ctx_tmp;
+
+  wl_shared->words_cur = 0;
+
+  hc_thread_mutex_init (wl_shared->mux_reader);
+
+  wl_shared->enabled = true;
+
+  return 0;
+}
+
+void wl_shared_destroy (hashcat_ctx_t *hashcat_ctx)
+{
+  wl_shared_t *wl_shared = hashcat_ctx->wl_shared;
+
+  if (wl_shared->stdin_enabled == true)
+  {
+    wl_stdin_destroy (hashcat_ctx);
+
+    return;
+  }
+
+  if (wl_shared->enabled == false) return;
+
+  hashcat_ctx_t *hashcat_ctx_tmp = wl_shared->hashcat_ctx_tmp;
+
+  wl_data_destroy (hashcat_ctx_tmp);
+
+  hcfree (hashcat_ctx_tmp->wl_data);
+  hcfree (hashcat_ctx_tmp);
+
+  hc_fclose (&wl_shared->fp);
+
+  hc_thread_mutex_delete (wl_shared->mux_reader);
+
+  memset (wl_shared, 0, sizeof (wl_shared_t));
 }
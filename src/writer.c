@@ -0,0 +1,409 @@
+/**
+ * Author......: See docs/credits.txt
+ * License.....: MIT
+ */
+
+#include "common.h"
+#include "types.h"
+#include "memory.h"
+#include "event.h"
+#include "timer.h"
+#include "thread.h"
+#include "outfile.h"
+#include "potfile.h"
+#include "writer.h"
+
+/**
+ * cracked hashes are written to the potfile and outfile from check_cracked (), which runs with mux_display held.
+ * with a lock, a write and a flush for every single line, a burst of cracks keeps the device threads waiting
+ * for the filesystem. instead, check_cracked () only appends the finished lines to a queue here and a writer
+ * thread writes them in batches, one lock and flush per batch.
+ *
+ * a batch is written when the oldest queued line is --cracked-flush-timer ms old, when --cracked-flush-lines
+ * lines are queued or when the queue holds WRITER_QUEUE_SIZE bytes. writer_flush () writes everything queued
+ * so far before the restore file moves on past the cracks, writer_stop () writes whatever is left, so the files
+ * are complete once the attack ends. --cracked-flush-timer=0 disables all of this.
+ */
+
+static void writer_queue_append (writer_queue_t *queue, const u8 *line_buf, const writer_line_t *line)
+{
+  if ((queue->buf_len + line->line_len) > queue->buf_size)
+  {
+    const size_t add = MAX ((size_t) line->line_len, (size_t) WRITER_QUEUE_SIZE / 4);
+
+    queue->buf = (u8 *) hcrealloc (queue->buf, queue->buf_size, add);
+
+    queue->buf_size += add;
+  }
+
+  if (queue->lines_cnt == queue->lines_avail)
+  {
+    queue->lines_buf = (writer_line_t *) hcrealloc (queue->lines_buf, queue->lines_avail * sizeof (writer_line_t), 1024 * sizeof (writer_line_t));
+
+    queue->lines_avail += 1024;
+  }
+
+  if (queue->lines_cnt == 0) hc_timer_set (&queue->timer_first);
+
+  memcpy (queue->buf + queue->buf_len, line_buf, line->line_len);
+
+  queue->buf_len += line->line_len;
+
+  queue->lines_buf[queue->lines_cnt] = *line;
+
+  queue->lines_cnt++;
+}
+
+static void writer_queue_free (writer_queue_t *queue)
+{
+  hcfree (queue->buf);
+  hcfree (queue->lines_buf);
+
+  memset (queue, 0, sizeof (writer_queue_t));
+}
+
+static bool writer_queue_due (const writer_ctx_t *writer_ctx, const writer_queue_t *queue)
+{
+  if (queue->lines_cnt == 0) return false;
+
+  if (writer_ctx->shutdown == true) return true;
+
+  if (writer_ctx->flush_done != writer_ctx->flush_posted) return true;
+
+  if (queue->buf_len >= WRITER_QUEUE_SIZE) return true;
+
+  if ((writer_ctx->flush_lines > 0) && (queue->lines_cnt >= writer_ctx->flush_lines)) return true;
+
+  if (hc_timer_get (queue->timer_first) >= (double) writer_ctx->flush_timer) return true;
+
+  return false;
+}
+
+// hands the buffers of a due queue to the writer thread and the (empty) buffers of the last batch back
+
+static bool writer_queue_swap (writer_ctx_t *writer_ctx, writer_queue_t *queue, writer_queue_t *flush)
+{
+  if (writer_queue_due (writer_ctx, queue) == false) return false;
+
+  writer_queue_t tmp = *flush;
+
+  *flush = *queue;
+  *queue = tmp;
+
+  queue->buf_len   = 0;
+  queue->lines_cnt = 0;
+
+  return true;
+}
+
+// milliseconds until the oldest line of a queue is due, (u32) -1 for an empty queue
+
+static u32 writer_queue_left (const writer_ctx_t *writer_ctx, const writer_queue_t *queue)
+{
+  if (queue->lines_cnt == 0) return (u32) -1;
+
+  const double msec = (double) writer_ctx->flush_timer - hc_timer_get (queue->timer_first);
+
+  if (msec < 1) return 1;
+
+  return (u32) msec + 1;
+}
+
+// same fallback as in check_cracked (), rather show the cracks than lose them. check_cracked () appends with
+// mux_display held, so it must not wait for room in a queue while the writer thread waits for mux_display
+
+static void writer_stdout (hashcat_ctx_t *hashcat_ctx, const u8 *buf, const size_t len)
+{
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+  writer_ctx_t *writer_ctx = hashcat_ctx->writer_ctx;
+
+  hc_thread_mutex_lock (writer_ctx->mux);
+
+  writer_ctx->display_wait = true;
+
+  hc_thread_cond_wake (writer_ctx->cond);
+
+  hc_thread_mutex_unlock (writer_ctx->mux);
+
+  hc_thread_mutex_lock (status_ctx->mux_display);
+
+  fwrite (buf, len, 1, stdout);
+
+  fflush (stdout);
+
+  hc_thread_mutex_unlock (status_ctx->mux_display);
+
+  hc_thread_mutex_lock (writer_ctx->mux);
+
+  writer_ctx->display_wait = false;
+
+  hc_thread_mutex_unlock (writer_ctx->mux);
+}
+
+// event_log_* () formats into a buffer shared by all threads, so the writer thread keeps the first failure
+// and writer_flush () or writer_stop () logs it on the calling thread
+
+__attribute__ ((format (printf, 2, 3)))
+static void writer_error (writer_ctx_t *writer_ctx, const char *fmt, ...)
+{
+  hc_thread_mutex_lock (writer_ctx->mux);
+
+  if (writer_ctx->error == false)
+  {
+    va_list ap;
+
+    va_start (ap, fmt);
+
+    vsnprintf (writer_ctx->error_buf, sizeof (writer_ctx->error_buf), fmt, ap);
+
+    va_end (ap);
+
+    writer_ctx->error = true;
+  }
+
+  hc_thread_mutex_unlock (writer_ctx->mux);
+}
+
+static void writer_error_log (hashcat_ctx_t *hashcat_ctx)
+{
+  writer_ctx_t *writer_ctx = hashcat_ctx->writer_ctx;
+
+  char error_buf[HCBUFSIZ_TINY];
+
+  hc_thread_mutex_lock (writer_ctx->mux);
+
+  const bool error = writer_ctx->error;
+
+  if (error == true) memcpy (error_buf, writer_ctx->error_buf, sizeof (error_buf));
+
+  writer_ctx->error = false;
+
+  hc_thread_mutex_unlock (writer_ctx->mux);
+
+  if (error == true) event_log_error (hashcat_ctx, "%s", error_buf);
+}
+
+static HC_API_CALL void *thread_writer (void *p)
+{
+  hashcat_ctx_t *hashcat_ctx = (hashcat_ctx_t *) p;
+
+  const outfile_ctx_t *outfile_ctx = hashcat_ctx->outfile_ctx;
+  const potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+        writer_ctx_t  *writer_ctx  = hashcat_ctx->writer_ctx;
+
+  while (true)
+  {
+    hc_thread_mutex_lock (writer_ctx->mux);
+
+    // a queue reaching its size or line limit, writer_flush () and writer_stop () wake us up, only the
+    // --cracked-flush-timer deadline of the oldest line is ours to watch
+
+    while ((writer_queue_due (writer_ctx, &writer_ctx->pot_queue) == false)
+        && (writer_queue_due (writer_ctx, &writer_ctx->out_queue) == false)
+        && (writer_ctx->flush_done == writer_ctx->flush_posted)
+        && (writer_ctx->shutdown   == false))
+    {
+      const u32 msec = MIN (writer_queue_left (writer_ctx, &writer_ctx->pot_queue), writer_queue_left (writer_ctx, &writer_ctx->out_queue));
+
+      if (msec == (u32) -1)
+      {
+        hc_thread_cond_wait (writer_ctx->cond, writer_ctx->mux);
+      }
+      else
+      {
+        hc_thread_cond_timedwait (&writer_ctx->cond, &writer_ctx->mux, msec);
+      }
+    }
+
+    const bool shutdown     = writer_ctx->shutdown;
+    const u32  flush_posted = writer_ctx->flush_posted;
+
+    const bool pot_due = writer_queue_swap (writer_ctx, &writer_ctx->pot_queue, &writer_ctx->pot_flush);
+    const bool out_due = writer_queue_swap (writer_ctx, &writer_ctx->out_queue, &writer_ctx->out_flush);
+
+    // the queues are empty again, in case a cracking thread waits for room
+
+    if ((pot_due == true) || (out_due == true)) hc_thread_cond_wake (writer_ctx->cond);
+
+    hc_thread_mutex_unlock (writer_ctx->mux);
+
+    if (pot_due == true)
+    {
+      writer_queue_t *flush = &writer_ctx->pot_flush;
+
+      if (potfile_write_batch (hashcat_ctx, flush->buf, flush->buf_len, flush->lines_buf, flush->lines_cnt) == -1)
+      {
+        writer_error (writer_ctx, "%s: Failed to update potfile.", potfile_ctx->filename);
+      }
+
+      flush->buf_len   = 0;
+      flush->lines_cnt = 0;
+    }
+
+    if (out_due == true)
+    {
+      writer_queue_t *flush = &writer_ctx->out_flush;
+
+      if (outfile_write_batch (hashcat_ctx, flush->buf, flush->buf_len) == -1)
+      {
+        writer_error (writer_ctx, "%s: %s", outfile_ctx->filename, strerror (errno));
+
+        writer_stdout (hashcat_ctx, flush->buf, flush->buf_len);
+      }
+
+      flush->buf_len   = 0;
+      flush->lines_cnt = 0;
+    }
+
+    // everything queued before the flush requests up to flush_posted is written now
+
+    if (flush_posted != writer_ctx->flush_done)
+    {
+      hc_thread_mutex_lock (writer_ctx->mux);
+
+      writer_ctx->flush_done = flush_posted;
+
+      hc_thread_cond_wake (writer_ctx->cond);
+
+      hc_thread_mutex_unlock (writer_ctx->mux);
+    }
+
+    // with shutdown set, everything queued so far was due and is written now
+
+    if (shutdown == true) break;
+  }
+
+  return NULL;
+}
+
+static void writer_append (hashcat_ctx_t *hashcat_ctx, writer_queue_t *queue, const u8 *line_buf, const writer_line_t *line)
+{
+  writer_ctx_t *writer_ctx = hashcat_ctx->writer_ctx;
+
+  hc_thread_mutex_lock (writer_ctx->mux);
+
+  // the queue is bounded, if the writer can't keep up the cracking threads have to wait after all
+
+  while ((queue->buf_len >= (2 * WRITER_QUEUE_SIZE)) && (writer_ctx->display_wait == false))
+  {
+    hc_thread_cond_wait (writer_ctx->cond, writer_ctx->mux);
+  }
+
+  writer_queue_append (queue, line_buf, line);
+
+  if (writer_queue_due (writer_ctx, queue) == true) hc_thread_cond_wake (writer_ctx->cond);
+
+  hc_thread_mutex_unlock (writer_ctx->mux);
+}
+
+void writer_potfile_append (hashcat_ctx_t *hashcat_ctx, const u8 *line_buf, const writer_line_t *line)
+{
+  writer_ctx_t *writer_ctx = hashcat_ctx->writer_ctx;
+
+  writer_append (hashcat_ctx, &writer_ctx->pot_queue, line_buf, line);
+}
+
+void writer_outfile_append (hashcat_ctx_t *hashcat_ctx, const u8 *line_buf, const u32 line_len)
+{
+  writer_ctx_t *writer_ctx = hashcat_ctx->writer_ctx;
+
+  writer_line_t line;
+
+  line.line_len = line_len;
+  line.hash_len = 0;
+
+  writer_append (hashcat_ctx, &writer_ctx->out_queue, line_buf, &line);
+}
+
+int writer_start (hashcat_ctx_t *hashcat_ctx)
+{
+  const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  const potfile_ctx_t  *potfile_ctx  = hashcat_ctx->potfile_ctx;
+  const user_options_t *user_options = hashcat_ctx->user_options;
+        outfile_ctx_t  *outfile_ctx  = hashcat_ctx->outfile_ctx;
+        writer_ctx_t   *writer_ctx   = hashcat_ctx->writer_ctx;
+
+  memset (writer_ctx, 0, sizeof (writer_ctx_t));
+
+  if (user_options->cracked_flush_timer == 0) return 0;
+
+  if (user_options->keyspace    == true) return 0;
+  if (user_options->stdout_flag == true) return 0;
+  if (user_options->speed_only  == true) return 0;
+
+  writer_ctx->potfile = (potfile_ctx->enabled == true) && (hashconfig->potfile_disable == false);
+
+  // a fifo stays open for the whole session anyway, there is nothing to save
+
+  writer_ctx->outfile = (outfile_ctx->filename != NULL) && (outfile_ctx->is_fifo == false);
+
+  if ((writer_ctx->potfile == false) && (writer_ctx->outfile == false)) return 0;
+
+  writer_ctx->flush_lines = user_options->cracked_flush_lines;
+  writer_ctx->flush_timer = user_options->cracked_flush_timer;
+
+  hc_thread_mutex_init (writer_ctx->mux);
+  hc_thread_cond_init  (writer_ctx->cond);
+
+  writer_ctx->enabled = true;
+
+  outfile_ctx->is_async = writer_ctx->outfile;
+
+  hc_thread_create (writer_ctx->thread, thread_writer, hashcat_ctx);
+
+  return 0;
+}
+
+void writer_stop (hashcat_ctx_t *hashcat_ctx)
+{
+  outfile_ctx_t *outfile_ctx = hashcat_ctx->outfile_ctx;
+  writer_ctx_t  *writer_ctx  = hashcat_ctx->writer_ctx;
+
+  if (writer_ctx->enabled == false) return;
+
+  hc_thread_mutex_lock (writer_ctx->mux);
+
+  writer_ctx->shutdown = true;
+
+  hc_thread_cond_wake (writer_ctx->cond);
+
+  hc_thread_mutex_unlock (writer_ctx->mux);
+
+  hc_thread_wait (1, &writer_ctx->thread);
+
+  writer_error_log (hashcat_ctx);
+
+  hc_thread_cond_delete  (writer_ctx->cond);
+  hc_thread_mutex_delete (writer_ctx->mux);
+
+  writer_queue_free (&writer_ctx->pot_queue);
+  writer_queue_free (&writer_ctx->out_queue);
+  writer_queue_free (&writer_ctx->pot_flush);
+  writer_queue_free (&writer_ctx->out_flush);
+
+  outfile_ctx->is_async = false;
+
+  memset (writer_ctx, 0, sizeof (writer_ctx_t));
+}
+
+void writer_flush (hashcat_ctx_t *hashcat_ctx)
+{
+  writer_ctx_t *writer_ctx = hashcat_ctx->writer_ctx;
+
+  if (writer_ctx->enabled == false) return;
+
+  hc_thread_mutex_lock (writer_ctx->mux);
+
+  const u32 ticket = ++writer_ctx->flush_posted;
+
+  hc_thread_cond_wake (writer_ctx->cond);
+
+  while (writer_ctx->flush_done < ticket)
+  {
+    hc_thread_cond_wait (writer_ctx->cond, writer_ctx->mux);
+  }
+
+  hc_thread_mutex_unlock (writer_ctx->mux);
+
+  writer_error_log (hashcat_ctx);
+}
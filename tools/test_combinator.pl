@@ -0,0 +1,114 @@
+#!/usr/bin/env perl
+
+##
+## Author......: See docs/credits.txt
+## License.....: MIT
+##
+
+use strict;
+use warnings;
+use Digest::MD5    qw (md5_hex);
+use File::Basename qw (dirname);
+use Test::More;
+
+# -a 1 with -j/-k on an optimized kernel uses the bigger dictionary as base. if that's the right one,
+# the rules are switched along with the dictionaries. the candidates from --stdout (which always keeps
+# the left one as base) are the reference, an optimized -m 0 run has to crack exactly those.
+
+my $hashcat     = "./hashcat";
+my $OPTS        = "--force --potfile-disable --quiet --runtime 60 --outfile-format 2";
+my $CURRENT_DIR = dirname (__FILE__);
+my $OUT_DIR     = $CURRENT_DIR . "/" . "combinator-test";
+
+mkdir $OUT_DIR || die $! unless -d $OUT_DIR;
+
+$SIG{INT} = \&cleanup_and_exit;
+
+my @left  = qw (ab abcd x1 pass);
+my @right = qw (xy z xyzw q 12 word 9999 long3);
+
+my @cases =
+(
+  [ "u",    "c"    ],
+  [ "c",    "u"    ],
+  [ "u",    ">3\$!" ],
+  [ ">3u",  "r"    ],
+  [ "\$1",  ""     ],
+  [ "",     "T0"   ],
+);
+
+for my $swap (0, 1)
+{
+  # $swap == 0: left smaller, the right dictionary is the base
+  # $swap == 1: left bigger, the left dictionary is the base
+
+  my $dict1 = write_file ("dict1", $swap ? \@right : \@left);
+  my $dict2 = write_file ("dict2", $swap ? \@left  : \@right);
+
+  for my $case (@cases)
+  {
+    my ($rule_l, $rule_r) = @{$case};
+
+    my $rules = "";
+
+    $rules .= " -j " . quotemeta ($rule_l) if length $rule_l;
+    $rules .= " -k " . quotemeta ($rule_r) if length $rule_r;
+
+    my $name = sprintf ("-j '%s' -k '%s', %s base", $rule_l, $rule_r, $swap ? "left" : "right");
+
+    my @expected = sort grep { length } split (/\n/, qx($hashcat --stdout --force -a 1 $rules $dict1 $dict2));
+
+    my %hashes = map { md5_hex ($_) => 1 } @expected;
+
+    my $hash_file = write_file ("hashes", [ sort keys %hashes ]);
+
+    my @actual = sort grep { length } split (/\n/, qx($hashcat $OPTS -m 0 -a 1 -O $rules $hash_file $dict1 $dict2));
+
+    my %expected = map { $_ => 1 } @expected;
+
+    is_deeply (\@actual, [ sort keys %expected ], $name . " - cracked");
+
+    # the keyspace is the number of base words the rule of their side doesn't reject
+
+    my $rule_base = $swap ? $rule_l : $rule_r;
+    my $dict_base = $swap ? $dict1  : $dict2;
+
+    my $rule_base_opt = length $rule_base ? "-j " . quotemeta ($rule_base) : "";
+
+    my $keyspace_ref = () = grep { length } split (/\n/, qx($hashcat --stdout --force -a 0 $rule_base_opt $dict_base));
+    my $keyspace_opt = qx($hashcat --keyspace --force -m 0 -a 1 -O $rules $dict1 $dict2);
+
+    is ($keyspace_opt * 1, $keyspace_ref, $name . " - keyspace");
+  }
+}
+
+cleanup ();
+
+done_testing ();
+
+sub write_file
+{
+  my $name  = shift;
+  my $lines = shift;
+
+  my $file_name = $OUT_DIR . "/" . $name . ".txt";
+
+  open my $fh, ">", $file_name || die $!;
+  print $fh join ("\n", @{$lines}) . "\n";
+  close $fh;
+
+  return $file_name;
+}
+
+sub cleanup
+{
+  unlink <$OUT_DIR/*.txt>;
+  rmdir $OUT_DIR;
+}
+
+sub cleanup_and_exit
+{
+  cleanup ();
+  done_testing ();
+  exit 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * Author......: See docs/credits.txt
+ * License.....: MIT
+ */
+
+/**
+ * restore file roundtrip: an old restore file without completed ranges is read, ranges are added, cycle_restore ()
+ * writes it and reading it back has to give the same ranges. build with "make test_restore", run from any directory
+ * you can write to, a non-zero exit code means failure.
+ */
+
+#include "common.h"
+#include "types.h"
+#include "memory.h"
+#include "hashcat.h"
+#include "folder.h"
+#include "user_options.h"
+#include "thread.h"
+#include "restore.h"
+
+#define RESTORE_TEST_FILE "test_restore.restore"
+
+static int failed = 0;
+
+static void check (const bool ok, const char *what)
+{
+  printf ("%s: %s\n", (ok == true) ? "ok    " : "FAILED", what);
+
+  if (ok == false) failed++;
+}
+
+static hashcat_ctx_t *test_ctx_init (char **argv, const int argc)
+{
+  hashcat_ctx_t *hashcat_ctx = (hashcat_ctx_t *) hcmalloc (sizeof (hashcat_ctx_t));
+
+  hashcat_init (hashcat_ctx, NULL);
+
+  folder_config_init (hashcat_ctx, NULL, NULL);
+
+  user_options_init (hashcat_ctx);
+
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  user_options->restore           = true;
+  user_options->restore_file_path = RESTORE_TEST_FILE;
+
+  hc_thread_mutex_init (hashcat_ctx->status_ctx->mux_dispatcher);
+
+  if (restore_ctx_init (hashcat_ctx, argc, argv) == -1) return NULL;
+
+  return hashcat_ctx;
+}
+
+static void test_ctx_destroy (hashcat_ctx_t *hashcat_ctx)
+{
+  hc_thread_mutex_delete (hashcat_ctx->status_ctx->mux_dispatcher);
+
+  restore_ctx_destroy (hashcat_ctx);
+
+  folder_config_destroy (hashcat_ctx);
+
+  hashcat_destroy (hashcat_ctx);
+
+  hcfree (hashcat_ctx);
+}
+
+int main (int argc, char **argv)
+{
+  // a restore file as written before RESTORE_VERSION_RANGES: the struct, the arguments and nothing else
+
+  char *args[] = { "hashcat", "-m", "0", "hash.txt", "dict.txt" };
+
+  restore_data_t rd;
+
+  memset (&rd, 0, sizeof (rd));
+
+  rd.version   = RESTORE_VERSION_RANGES - 1;
+  rd.argc      = 5;
+  rd.words_cur = 1000;
+
+  if (getcwd (rd.cwd, sizeof (rd.cwd) - 1) == NULL) return -1;
+
+  FILE *fp = fopen (RESTORE_TEST_FILE, "wb");
+
+  if (fp == NULL) return -1;
+
+  fwrite (&rd, sizeof (rd), 1, fp);
+
+  for (int i = 0; i < 5; i++) fprintf (fp, "%s\n", args[i]);
+
+  fclose (fp);
+
+  // read the old file, add ranges and write it again
+
+  hashcat_ctx_t *hashcat_ctx = test_ctx_init (argv, argc);
+
+  check (hashcat_ctx != NULL, "read old restore file");
+
+  if (hashcat_ctx == NULL) return -1;
+
+  check (hashcat_ctx->restore_ctx->ranges_cnt == 0, "old restore file has no ranges");
+
+  hashcat_ctx->status_ctx->words_cur = hashcat_ctx->restore_ctx->rd->words_cur;
+
+  restore_ranges_add (hashcat_ctx, 3000, 4000);
+  restore_ranges_add (hashcat_ctx, 1500, 2000);
+  restore_ranges_add (hashcat_ctx, 2000, 2500);
+  restore_ranges_add (hashcat_ctx,  500,  900); // below words_cur
+
+  check (cycle_restore (hashcat_ctx) == 0, "write restore file");
+
+  test_ctx_destroy (hashcat_ctx);
+
+  // and read it back
+
+  hashcat_ctx = test_ctx_init (argv, argc);
+
+  check (hashcat_ctx != NULL, "read new restore file");
+
+  if (hashcat_ctx == NULL) return -1;
+
+  const restore_ctx_t *restore_ctx = hashcat_ctx->restore_ctx;
+
+  check (restore_ctx->rd->version == RESTORE_VERSION_CUR, "new restore file has the current version");
+  check (restore_ctx->rd->words_cur == 1000, "words_cur survived");
+  check (restore_ctx->rd->argc == 5, "arguments survived");
+
+  check (restore_ctx->ranges_cnt == 2, "ranges survived");
+
+  if (restore_ctx->ranges_cnt == 2)
+  {
+    check ((restore_ctx->ranges_buf[0].off == 1500) && (restore_ctx->ranges_buf[0].fin == 2500), "first range");
+    check ((restore_ctx->ranges_buf[1].off == 3000) && (restore_ctx->ranges_buf[1].fin == 4000), "second range");
+  }
+
+  test_ctx_destroy (hashcat_ctx);
+
+  unlink (RESTORE_TEST_FILE);
+
+  return (failed == 0) ? 0 : -1;
+}